@@ -7,10 +7,16 @@
 #include <Wire.h>
 #include <PubSubClient.h>
 #include <WebSocketsClient.h>
+#include <Preferences.h>
 #include "DHT.h"
 
 // Include our configuration and other modules
 #include "src/config.h"
+#include "src/air_quality.h"
+#include "src/command_table.h"
+#include "src/time_service.h"
+#include "src/binary_telemetry.h"
+#include "src/trace_log.h"
 
 // Forward declarations for classes
 class WiFiManager;
@@ -26,7 +32,6 @@ class WiFiManager {
 private:
     const char* ssid;
     const char* password;
-    unsigned long connectionTimeout;
     bool isConnected;
 
 public:
@@ -42,31 +47,18 @@ public:
 WiFiManager::WiFiManager() {
     ssid = WIFI_SSID;
     password = WIFI_PASSWORD;
-    connectionTimeout = 20000; // 20 seconds
     isConnected = false;
 }
 
+// Starts association and returns; the driver finishes it (and re-associates
+// after a drop) in the background while the sketch keeps sampling.
 bool WiFiManager::connect() {
-    Serial.println("Connecting to WiFi...");
+    Serial.println("Connecting to WiFi in the background...");
 
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(true);
     WiFi.begin(ssid, password);
-
-    unsigned long startTime = millis();
-    while (WiFi.status() != WL_CONNECTED && millis() - startTime < connectionTimeout) {
-        delay(500);
-        Serial.print(".");
-    }
-
-    if (WiFi.status() == WL_CONNECTED) {
-        isConnected = true;
-        Serial.println("\nWiFi connected successfully!");
-        Serial.printf("IP Address: %s\n", WiFi.localIP().toString().c_str());
-        return true;
-    } else {
-        isConnected = false;
-        Serial.println("\nWiFi connection failed!");
-        return false;
-    }
+    return checkConnection();
 }
 
 bool WiFiManager::reconnect() {
@@ -131,8 +123,10 @@ public:
     void init();
     void initWithQuickWarmup();  // Alternative initialization with faster warmup
     void calibrate();            // Make calibration public so it can be called from setup
+    bool restoreR0();            // R0 of an earlier boot from NVS; false if none stored
+    void storeR0();
     float readPPM();
-    String getAirQuality(float ppm);
+    AirQuality getAirQuality(float ppm) const { return classifyAirQuality(ppm); }
     float getVoltage();
     float getResistance();
     float getR0();
@@ -223,6 +217,24 @@ void MQ2Sensor::calibrate() {
     Serial.printf("Calibration complete. R0: %.2f, RS: %.2f, Voltage: %.2fV\n", r0, rs, voltage);
 }
 
+// Kept across reboots so a power blip does not cost a warm-up and calibration
+bool MQ2Sensor::restoreR0() {
+    Preferences prefs;
+    if (!prefs.begin(GAS_CHANNELS[0].name, true)) return false;
+    const float stored = prefs.getFloat("r0", 0.0);
+    prefs.end();
+    if (!(stored > 0.1 && stored < 1000.0)) return false;
+    r0 = stored;
+    return true;
+}
+
+void MQ2Sensor::storeR0() {
+    Preferences prefs;
+    if (!prefs.begin(GAS_CHANNELS[0].name)) return;
+    prefs.putFloat("r0", r0);
+    prefs.end();
+}
+
 float MQ2Sensor::readPPM() {
     voltage = (analogRead(sensorPin) / 4095.0) * 3.3;
     rs = calculateResistance();
@@ -276,24 +288,6 @@ float MQ2Sensor::calculatePPM() {
     return ppm;
 }
 
-String MQ2Sensor::getAirQuality(float ppm) {
-    // Air quality categories based on LPG/Combustible gas detection (MQ-2 primary use)
-    // The MQ-2 is primarily sensitive to LPG, Propane, Hydrogen, etc.
-    if (ppm < 200) {
-        return "Excellent";  // Very low combustible gas concentration
-    } else if (ppm < 500) {
-        return "Good";       // Low levels of combustible gases
-    } else if (ppm < 1000) {
-        return "Moderate";   // Moderate levels of combustible gases
-    } else if (ppm < 2000) {
-        return "Poor";       // High levels, potential safety concern
-    } else if (ppm < 5000) {
-        return "Very Poor";  // Very high levels, immediate concern
-    } else {
-        return "Hazardous";  // Dangerous levels of combustible gases
-    }
-}
-
 float MQ2Sensor::getVoltage() {
     return voltage;
 }
@@ -579,7 +573,7 @@ public:
     bool init();
     void clear();
     void showWelcome();
-    void showAirQuality(float ppm, String quality, bool relayState);
+    void showAirQuality(float ppm, AirQuality quality, bool relayState);
     void showMessage(String message);
     void showCustomMessage(String message);
     void showWiFiStatus(String ip);
@@ -588,7 +582,10 @@ public:
     void update();
 };
 
-OLEDDisplay::OLEDDisplay() : display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1) {
+// Fast-mode I2C for the driver's transfers and after them (the library
+// otherwise drops the bus back to 100 kHz)
+OLEDDisplay::OLEDDisplay()
+    : display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1, OLED_I2C_CLOCK_HZ, OLED_I2C_CLOCK_HZ) {
     screenWidth = SCREEN_WIDTH;
     screenHeight = SCREEN_HEIGHT;
     sdaPin = OLED_SDA;
@@ -597,7 +594,7 @@ OLEDDisplay::OLEDDisplay() : display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1) {
 }
 
 bool OLEDDisplay::init() {
-    Wire.begin(sdaPin, sclPin);
+    Wire.begin(sdaPin, sclPin, OLED_I2C_CLOCK_HZ);
 
     if (!display.begin(SSD1306_SWITCHCAPVCC, OLED_ADDRESS)) {
         Serial.println("SSD1306 allocation failed");
@@ -639,7 +636,7 @@ void OLEDDisplay::showWelcome() {
     display.display();
 }
 
-void OLEDDisplay::showAirQuality(float ppm, String quality, bool relayState) {
+void OLEDDisplay::showAirQuality(float ppm, AirQuality quality, bool relayState) {
     if (!isInitialized) return;
 
     clear();
@@ -661,15 +658,7 @@ void OLEDDisplay::showAirQuality(float ppm, String quality, bool relayState) {
     display.setTextSize(1);
     display.setCursor(10, 40);
     display.print("Quality: ");
-
-    // Color coding based on quality
-    if (quality == "Excellent" || quality == "Good") {
-        display.println(quality);
-    } else if (quality == "Moderate") {
-        display.println(quality);
-    } else {
-        display.println(quality);
-    }
+    display.println(airQualityLabel(quality));
 
     // Relay Status (for devices controlled by relay)
     display.setCursor(10, 52);
@@ -846,7 +835,55 @@ void OLEDDisplay::update() {
     display.display();
 }
 
+// Wall clock for payload timestamps (SNTP, synced from loop())
+TimeService timeService;
+
 // IoT Protocol class
+// Boot timeline: start and end of each bring-up stage in us since boot, named
+// as in the PlatformIO build's status message; printed on serial and sent
+// with the first status message
+using BinaryTelemetry::BootStage;
+constexpr size_t BOOT_STAGES = static_cast<size_t>(BootStage::COUNT);
+int64_t bootStartUs[BOOT_STAGES];
+int64_t bootEndUs[BOOT_STAGES];
+
+void bootBegin(BootStage stage) {
+    bootStartUs[static_cast<size_t>(stage)] = TimeService::monotonicUs();
+    bootEndUs[static_cast<size_t>(stage)] = -1;
+}
+
+void bootEnd(BootStage stage) {
+    const size_t i = static_cast<size_t>(stage);
+    if (bootStartUs[i] >= 0 && bootEndUs[i] < 0) bootEndUs[i] = TimeService::monotonicUs();
+}
+
+bool bootStarted(BootStage stage) { return bootStartUs[static_cast<size_t>(stage)] >= 0; }
+bool bootFinished(BootStage stage) { return bootEndUs[static_cast<size_t>(stage)] >= 0; }
+
+void printBootTimeline() {
+    Serial.println("Boot timeline (us since boot):");
+    for (size_t i = 0; i < BOOT_STAGES; i++) {
+        if (bootStartUs[i] < 0) continue;
+        if (bootEndUs[i] < 0) {
+            Serial.printf("  %-14s %10lld ..    running\n", BinaryTelemetry::BOOT_STAGE_NAMES[i], bootStartUs[i]);
+        } else {
+            Serial.printf("  %-14s %10lld .. %10lld\n", BinaryTelemetry::BOOT_STAGE_NAMES[i], bootStartUs[i],
+                          bootEndUs[i]);
+        }
+    }
+}
+
+void addBootTimeline(JsonDocument& doc) {
+    JsonArray boot = doc.createNestedArray("boot");
+    for (size_t i = 0; i < BOOT_STAGES; i++) {
+        if (bootStartUs[i] < 0) continue;
+        JsonObject stage = boot.createNestedObject();
+        stage["stage"] = BinaryTelemetry::BOOT_STAGE_NAMES[i];
+        stage["start_us"] = bootStartUs[i];
+        if (bootEndUs[i] >= 0) stage["end_us"] = bootEndUs[i];
+    }
+}
+
 class IoTProtocol {
 private:
     WiFiClient espClient;
@@ -871,11 +908,12 @@ public:
     IoTProtocol();
     bool init(int protocol, String server = "", String deviceId = "esp32_01");
     bool connect();
-    bool sendSensorData(float ppm, String quality, bool relayState);
+    bool sendSensorData(float ppm, AirQuality quality, bool relayState);
     String getCommands();
-    String createSensorData(float ppm, String quality, bool relayState);
-    bool updateDeviceStatus(bool online);
+    String createSensorData(float ppm, AirQuality quality, bool relayState);
+    bool updateDeviceStatus(bool online, bool withBootTimeline = false);
     bool isConnectedToServer();
+    bool hasConnected() const { return isConnected; }
     void loop();  // Call this in your main loop for MQTT and WebSocket
 };
 
@@ -920,26 +958,28 @@ bool IoTProtocol::init(int protocol, String server, String devId) {
 }
 
 String IoTProtocol::getCurrentTimestamp() {
-    // Get current time from NTP server
-    configTime(0, 0, "pool.ntp.org", "time.nist.gov");
-
-    struct tm timeinfo;
-    if (!getLocalTime(&timeinfo)) {
-        // Fallback to timestamp in seconds
+    // No network round trip here: the time service keeps the clock in sync
+    const uint64_t epochUs = timeService.nowEpochUs();
+    if (epochUs == 0) {
+        // Not synced yet; fall back to uptime in milliseconds
         return String(millis());
     }
 
-    char buffer[64];
-    strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &timeinfo);
+    const time_t seconds = static_cast<time_t>(epochUs / 1000000ULL);
+    struct tm timeinfo;
+    gmtime_r(&seconds, &timeinfo);
+    char buffer[32];
+    const size_t n = strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &timeinfo);
+    snprintf(buffer + n, sizeof(buffer) - n, ".%03uZ", static_cast<unsigned>(epochUs / 1000ULL % 1000ULL));
     return String(buffer);
 }
 
-bool IoTProtocol::sendSensorData(float ppm, String quality, bool relayState) {
+bool IoTProtocol::sendSensorData(float ppm, AirQuality quality, bool relayState) {
     // Create JSON payload
     DynamicJsonDocument doc(512);
     doc["device_id"] = deviceId;
     doc["ppm"] = ppm;
-    doc["quality"] = quality;
+    doc["quality"] = airQualityLabel(quality);
     doc["relay_state"] = relayState ? "ON" : "OFF";
     doc["alarm_state"] = alarm.getAlarmState() ? "ACTIVE" : "INACTIVE";  // LED/buzzer alarm state
     doc["temperature"] = currentTemperature;
@@ -953,8 +993,7 @@ bool IoTProtocol::sendSensorData(float ppm, String quality, bool relayState) {
         case COMM_PROTOCOL_MQTT:
             if (mqttClient.connected()) {
                 bool success = mqttClient.publish(MQTT_DEVICE_TOPIC, jsonString.c_str());
-                Serial.printf("MQTT Publish result: %s\n", success ? "Success" : "Failed");
-                Serial.printf("Published JSON: %s\n", jsonString.c_str()); // Debug output
+                TRACE(BROKER_PUBLISH, success ? "OK" : "FAIL");
                 return success;
             } else {
                 Serial.println("MQTT not connected when trying to publish");
@@ -963,9 +1002,7 @@ bool IoTProtocol::sendSensorData(float ppm, String quality, bool relayState) {
 
         case COMM_PROTOCOL_WEBSOCKET:
             if (isConnected) {
-                bool success = webSocket.sendTXT(jsonString);
-                Serial.printf("WebSocket Send result: %s\n", success ? "Success" : "Failed");
-                return success;
+                return webSocket.sendTXT(jsonString);
             }
             break;
 
@@ -1024,11 +1061,11 @@ String IoTProtocol::getCommands() {
     return command;
 }
 
-String IoTProtocol::createSensorData(float ppm, String quality, bool relayState) {
+String IoTProtocol::createSensorData(float ppm, AirQuality quality, bool relayState) {
     DynamicJsonDocument doc(512);
     doc["device_id"] = deviceId;
     doc["ppm"] = ppm;
-    doc["quality"] = quality;
+    doc["quality"] = airQualityLabel(quality);
     doc["relay_state"] = relayState ? "ON" : "OFF";
     doc["alarm_state"] = alarm.getAlarmState() ? "ACTIVE" : "INACTIVE";
     doc["temperature"] = currentTemperature;
@@ -1041,11 +1078,12 @@ String IoTProtocol::createSensorData(float ppm, String quality, bool relayState)
 }
 
 
-bool IoTProtocol::updateDeviceStatus(bool online) {
-    DynamicJsonDocument doc(256);
+bool IoTProtocol::updateDeviceStatus(bool online, bool withBootTimeline) {
+    DynamicJsonDocument doc(1024);
     doc["device_id"] = deviceId;
     doc["status"] = online ? "online" : "offline";
     doc["timestamp"] = getCurrentTimestamp();
+    if (withBootTimeline) addBootTimeline(doc);
 
     String jsonString;
     serializeJson(doc, jsonString);
@@ -1087,9 +1125,17 @@ private:
     float temperature;
     float humidity;
 
+    // Incremental averaging window used by update()
+    float windowTemp;
+    float windowHumidity;
+    int windowTaken;
+    int windowValid;
+    unsigned long lastSampleTime;
+
 public:
     DHTSensor();
     void init();
+    bool update(float& outTemp, float& outHumidity);  // Non-blocking, one bus read per call
     float readTemperature();
     float readHumidity();
     float readTemperatureWithAveraging(int samples = DHT_READING_SAMPLES);
@@ -1104,10 +1150,16 @@ DHTSensor::DHTSensor() : dht(DHT_PIN, DHT_TYPE) {
     sensorPin = DHT_PIN;
     temperature = 0.0;
     humidity = 0.0;
+    windowTemp = 0.0;
+    windowHumidity = 0.0;
+    windowTaken = 0;
+    windowValid = 0;
+    lastSampleTime = 0;
 }
 
 void DHTSensor::init() {
     dht.begin();
+    lastSampleTime = millis() - DHT_SAMPLE_INTERVAL_MS;   // First update() reads at once
     Serial.println("DHT sensor initialized");
 }
 
@@ -1372,6 +1424,47 @@ bool DHTSensor::readBothWithAveragingAndRetry(float& outTemp, float& outHumidity
     return false;
 }
 
+bool DHTSensor::update(float& outTemp, float& outHumidity) {
+    // Take at most one sample per DHT_SAMPLE_INTERVAL_MS instead of blocking
+    // for the whole averaging window; report once the window is complete.
+    // The interval holds across windows too: a read sooner than that would
+    // get the driver's cached frame.
+    unsigned long now = millis();
+    if (now - lastSampleTime < DHT_SAMPLE_INTERVAL_MS) {
+        return false;
+    }
+    lastSampleTime = now;
+
+    float temp = dht.readTemperature();
+    float hum = dht.readHumidity();  // Served from the driver's cached frame
+    windowTaken++;
+
+    if (!isnan(temp) && !isnan(hum) && hum != 0) {
+        windowTemp += temp + DHT_TEMP_OFFSET_C;
+        windowHumidity += constrain(hum + DHT_HUMID_OFFSET_PCT, 0.0, 100.0);
+        windowValid++;
+    }
+
+    if (windowTaken < DHT_READING_SAMPLES) {
+        return false;
+    }
+
+    bool ready = windowValid > 0;
+    if (ready) {
+        temperature = windowTemp / windowValid;
+        humidity = windowHumidity / windowValid;
+        outTemp = temperature;
+        outHumidity = humidity;
+        TRACE(DHT_READING, temperature, humidity, windowValid);
+    }
+
+    windowTemp = 0.0;
+    windowHumidity = 0.0;
+    windowTaken = 0;
+    windowValid = 0;
+    return ready;
+}
+
 bool DHTSensor::isValidReading() {
     // Check if the last readings were valid and within reasonable ranges
     // DHT11/DHT22 can sometimes return extreme values in case of communication errors
@@ -1396,7 +1489,7 @@ unsigned long lastMQTTUpdate = 0;
 unsigned long lastCommandCheck = 0;
 unsigned long customMessageTime = 0;
 float currentPPM = 0;
-String currentQuality = "";
+AirQuality currentQuality = AirQuality::EXCELLENT;
 bool relayState = false;
 bool alarmState = false;  // Track alarm state separately
 int samplingInterval = 5; // seconds
@@ -1408,72 +1501,105 @@ void setup() {
     Serial.begin(115200);
     Serial.println("ESP32 Air Quality Monitor Starting...");
 
+    for (size_t i = 0; i < BOOT_STAGES; i++) {
+        bootStartUs[i] = -1;
+        bootEndUs[i] = -1;
+    }
+
     // Initialize components
+    bootBegin(BootStage::OLED);
     display.init();
     display.showWelcome();
+    bootEnd(BootStage::OLED);
+
+    // WiFi first: association runs in the driver while the sensors come up
+    // below, and the broker is dialled from the loop once it has an address
+    bootBegin(BootStage::WIFI);
+    wifiManager.connect();
 
+    bootBegin(BootStage::ALERT);
     alarm.init();  // Initialize alarm controller first (LED/buzzer)
+    bootEnd(BootStage::ALERT);
+    bootBegin(BootStage::RELAY);
     relay.init();  // Initialize relay for other devices (independent of alarm)
+    bootEnd(BootStage::RELAY);
 
-    // Start sensor initialization with improved quick warmup
-    Serial.println("MQ-2 sensor initializing with quick warmup...");
-    display.showMessage("Sensor Warmup");
+    bootBegin(BootStage::MQ2);
+    pinMode(MQ2_PIN, INPUT);
 
-    pinMode(MQ2_PIN, INPUT);  // Direct pin setup before the warmup
+    // R0 from an earlier boot: no warmup wait, readings settle as the heater warms
+    if (sensor.restoreR0()) {
+        Serial.println("MQ-2 R0 restored from NVS");
+    } else {
+        // Start sensor initialization with improved quick warmup
+        Serial.println("MQ-2 sensor initializing with quick warmup...");
+        display.showMessage("Sensor Warmup");
+
+        // Shorter warmup to reduce initial delay, with visual feedback
+        Serial.println("Warming up sensor (3 seconds)...");
+        for (int i = 0; i < 3; i++) {
+            delay(1000);
+            Serial.print(".");
+
+            // Update display with progress during warmup
+            String progress = "Warmup: " + String(3 - i) + "s";
+            display.showMessage(progress);
+        }
+        Serial.println("\nSensor warmup complete!");
 
-    // Shorter warmup to reduce initial delay, with visual feedback
-    Serial.println("Warming up sensor (3 seconds)...");
-    for (int i = 0; i < 3; i++) {
-        delay(1000);
-        Serial.print(".");
+        // Calibrate sensor in clean air
+        Serial.println("Calibrating MQ-2 sensor in clean air...");
+        display.showMessage("Calibrating...");
 
-        // Update display with progress during warmup
-        String progress = "Warmup: " + String(3 - i) + "s";
-        display.showMessage(progress);
+        sensor.calibrate();  // Call calibration method directly with visual feedback
+        sensor.storeR0();
     }
-    Serial.println("\nSensor warmup complete!");
-
-    // Calibrate sensor in clean air
-    Serial.println("Calibrating MQ-2 sensor in clean air...");
-    display.showMessage("Calibrating...");
-
-    sensor.calibrate();  // Call calibration method directly with visual feedback
+    bootEnd(BootStage::MQ2);
 
     Serial.printf("MQ-2 sensor initialized. R0: %.2f\n", sensor.getR0());
 
+    bootBegin(BootStage::DHT);
     dhtSensor.init();  // Initialize DHT temperature/humidity sensor
+    bootEnd(BootStage::DHT);
 
-    // Connect to WiFi
-    display.showMessage("WiFi Connect");
-    if (!wifiManager.connect()) {
-        Serial.println("WiFi connection failed!");
-        display.showMessage("WiFi Failed");
-        ESP.restart();
-    }
+    timeService.begin();
 
-    // Initialize IoT Protocol (using MQTT for dashboard communication)
-    display.showMessage("MQTT Connect");
+    // Initialize IoT Protocol (using MQTT for dashboard communication); the
+    // connection itself is made from the loop as soon as WiFi is up
     if (!iotProtocol.init(COMM_PROTOCOL_MQTT, MQTT_SERVER)) {
         Serial.println("IoT Protocol initialization failed!");
         display.showMessage("IoT Protocol Error");
-    } else {
-        // Attempt to connect to the MQTT broker
-        if (iotProtocol.connect()) {
-            Serial.println("MQTT connected successfully");
-            // Update device status to online
-            iotProtocol.updateDeviceStatus(true);
-        } else {
-            Serial.println("MQTT connection failed");
-        }
     }
 
     display.showMessage("System Ready");
-    delay(2000);
 }
 
 void loop() {
     unsigned long currentMillis = millis();
 
+    timeService.update();
+
+    // Bring-up: dial the broker the moment WiFi has an address, and publish
+    // the first reading as soon as the broker takes it
+    if (!bootFinished(BootStage::WIFI) && WiFi.status() == WL_CONNECTED) {
+        bootEnd(BootStage::WIFI);
+        bootBegin(BootStage::BROKER);
+        iotProtocol.connect();
+    }
+    if (bootStarted(BootStage::BROKER) && !bootFinished(BootStage::BROKER) && iotProtocol.hasConnected()) {
+        bootEnd(BootStage::BROKER);
+        bootBegin(BootStage::FIRST_PUBLISH);
+        lastSensorRead = currentMillis - samplingInterval * 1000;   // Read and publish this pass
+        lastMQTTUpdate = currentMillis - MQTT_UPDATE_INTERVAL;
+    }
+
+    // Sample the DHT one reading per pass; averaged values arrive every few passes
+    float temp, humidity;
+    if (dhtSensor.update(temp, humidity)) {
+        currentTemperature = temp;
+        currentHumidity = humidity;
+    }
+
     // Check for message timeout (10 seconds as requested)
     if (customMessage.length() > 0 && currentMillis - customMessageTime > 10000) {
         customMessage = "";
@@ -1490,16 +1616,7 @@ void loop() {
         currentPPM = sensor.readPPM();
         currentQuality = sensor.getAirQuality(currentPPM);
 
-        // Read temperature and humidity with averaging and retry for maximum accuracy
-        float temp, humidity;
-        if (dhtSensor.readBothWithAveragingAndRetry(temp, humidity)) {
-            currentTemperature = temp;
-            currentHumidity = humidity;
-        } else {
-            // Fallback to basic read if advanced method fails
-            currentTemperature = dhtSensor.readTemperature();
-            currentHumidity = dhtSensor.readHumidity();
-        }
+        // Temperature and humidity are sampled incrementally at the top of loop()
 
         // Additional validation to detect invalid readings like 717.50°C, 1741.50% humidity
         if (currentTemperature > 100 || currentTemperature < -50 || currentHumidity > 150 || currentHumidity < 0) {
@@ -1510,21 +1627,20 @@ void loop() {
             currentHumidity = 0.0;
         }
 
-        Serial.printf("PPM: %.2f, Quality: %s\n", currentPPM, currentQuality.c_str());
-        Serial.printf("Temperature: %.2f°C, Humidity: %.2f%%\n", currentTemperature, currentHumidity);
+        TRACE(PPM_READING, currentPPM, airQualityLabel(currentQuality));
 
         // Check if PPM has reached dangerous level (1000) to activate alarm
         if (currentPPM >= 1000 && !alarmState) {
             // Activate alarm if PPM reaches 1000 and it's not already active
             alarmState = true;
             alarm.enableAlarm();
-            Serial.println("ALARM ACTIVATED: PPM reached dangerous level!");
+            TRACE(ALERT_ACTIVATED);
         } else if (currentPPM < 500 && alarmState) {
             // Deactivate alarm when PPM returns to normal levels
             // Using 500 as the return threshold to avoid oscillation around the threshold
             alarmState = false;
             alarm.disableAlarm();
-            Serial.println("ALARM DEACTIVATED: PPM returned to normal levels");
+            TRACE(ALERT_DEACTIVATED);
         }
 
         // The alarm now operates independently of the relay
@@ -1552,10 +1668,16 @@ void loop() {
         lastMQTTUpdate = currentMillis;
 
         if (iotProtocol.sendSensorData(currentPPM, currentQuality, relayState)) {
-            Serial.println("Data sent to MQTT broker successfully");
+
+            // The first status after boot carries the boot timeline
+            const bool firstPublish = bootStarted(BootStage::FIRST_PUBLISH) && !bootFinished(BootStage::FIRST_PUBLISH);
+            if (firstPublish) {
+                bootEnd(BootStage::FIRST_PUBLISH);
+                printBootTimeline();
+            }
 
             // Also update device status periodically to maintain presence
-            iotProtocol.updateDeviceStatus(true);
+            iotProtocol.updateDeviceStatus(true, firstPublish);
         } else {
             Serial.println("Failed to send data to MQTT broker");
         }
@@ -1574,23 +1696,21 @@ void loop() {
     // Update alarm state (handles LED blinking and buzzer beeping)
     alarm.update();
 
+    // Routine lines wait in the trace ring; write what the UART takes now
+    traceLog.drain(Serial);
+
     delay(100);
 }
 
 // Forward declaration for processCommands function
-void processCommands(String commandsJson);
+void processCommands(const char* json, size_t length);
 
 // MQTT callback function
 void IoTProtocol::mqttCallback(char* topic, byte* payload, unsigned int length) {
-    // This would handle incoming MQTT messages
-    String message = "";
-    for (unsigned int i = 0; i < length; i++) {
-        message += (char)payload[i];
-    }
-    Serial.printf("MQTT Message received on topic %s: %s\n", topic, message.c_str());
+    Serial.printf("MQTT Message received on topic %s: %.*s\n", topic, (int)length, (const char*)payload);
 
     // Process the command
-    processCommands(message);
+    processCommands((const char*)payload, length);
 }
 
 // WebSocket event handler function
@@ -1607,7 +1727,7 @@ void IoTProtocol::webSocketEvent(WStype_t type, uint8_t * payload, size_t length
         case WStype_TEXT:
             Serial.printf("[WSc] Received text: %s\n", payload);
             // Process the command
-            processCommands((char*)payload);
+            processCommands((const char*)payload, length);
             break;
         case WStype_BIN:
             Serial.printf("[WSc] Got binary length: %u\n", length);
@@ -1691,8 +1811,8 @@ void IoTProtocol::loop() {
         case COMM_PROTOCOL_MQTT:
             if (mqttClient.connected()) {
                 mqttClient.loop();
-            } else {
-                // Try to reconnect with exponential backoff
+            } else if (WiFi.status() == WL_CONNECTED) {
+                // Broker retries only once there is a link to retry over
                 static unsigned long lastReconnectAttempt = 0;
                 if (millis() - lastReconnectAttempt > 10000) {  // Try reconnect every 10 seconds
                     lastReconnectAttempt = millis();
@@ -1707,57 +1827,68 @@ void IoTProtocol::loop() {
     }
 }
 
-void processCommands(String commandsJson) {
-    Serial.printf("Processing command: %s\n", commandsJson.c_str());
-    
-    DynamicJsonDocument doc(1024);
-    DeserializationError error = deserializeJson(doc, commandsJson);
+// Command actions for the keys this sketch supports; the key table and the
+// parser are shared with the PlatformIO build (src/command_table.h)
+bool applyRelayState(const CommandArgs& args) {
+    const char* value = args.getString(CommandKey::RELAY_STATE);
+    bool newState = (strcmp(value, "ON") == 0);
+    if (!newState && strcmp(value, "OFF") != 0) return false;
+    if (newState != relayState) {
+        relayState = newState;
+        relay.setState(relayState);
+        Serial.printf("Relay state changed to: %s\n", relayState ? "ON" : "OFF");
 
-    if (error) {
-        Serial.printf("Failed to parse commands JSON: %s\n", error.c_str());
-        return;
+        // Relay is now independent of alarm - no longer turn off alarm when relay is OFF
     }
+    return true;
+}
 
-    Serial.println("Commands JSON parsed successfully");
+bool applySamplingInterval(const CommandArgs& args) {
+    int newInterval = args.getInt(CommandKey::SAMPLING_INTERVAL);
+    if (newInterval < 1 || newInterval > 300) return false;
+    samplingInterval = newInterval;
+    Serial.printf("Sampling interval changed to: %d seconds\n", samplingInterval);
+    return true;
+}
 
-    // Process relay command
-    if (doc.containsKey("relay_state")) {
-        String newRelayState = doc["relay_state"];
-        bool newState = (newRelayState == "ON");
-        if (newState != relayState) {
-            relayState = newState;
-            relay.setState(relayState);
-            Serial.printf("Relay state changed to: %s\n", relayState ? "ON" : "OFF");
+bool applyOledMessage(const CommandArgs& args) {
+    customMessage = args.getString(CommandKey::OLED_MESSAGE);
+    customMessageTime = millis(); // Record when message was set
+    Serial.printf("OLED message set to: '%s'\n", customMessage.c_str());
 
-            // Relay is now independent of alarm - no longer turn off alarm when relay is OFF
-        }
-    }
+    // Update display immediately
+    display.showCustomMessage(customMessage);
 
-    // Process sampling interval command
-    if (doc.containsKey("sampling_interval")) {
-        int newInterval = doc["sampling_interval"];
-        if (newInterval >= 1 && newInterval <= 300) {
-            samplingInterval = newInterval;
-            Serial.printf("Sampling interval changed to: %d seconds\n", samplingInterval);
-        }
+    // Handle CLEAR command immediately
+    if (customMessage == "CLEAR") {
+        customMessage = "";
+        customMessageTime = 0;
+        Serial.println("OLED message cleared");
+        display.showAirQuality(currentPPM, currentQuality, relayState);
     }
+    return true;
+}
 
-    // Process OLED message command
-    if (doc.containsKey("oled_message")) {
-        String newMessage = doc["oled_message"];
-        customMessage = newMessage;
-        customMessageTime = millis(); // Record when message was set
-        Serial.printf("OLED message set to: '%s'\n", customMessage.c_str());
-        
-        // Update display immediately
-        display.showCustomMessage(customMessage);
-
-        // Handle CLEAR command immediately
-        if (customMessage == "CLEAR") {
-            customMessage = "";
-            customMessageTime = 0;
-            Serial.println("OLED message cleared");
-            display.showAirQuality(currentPPM, currentQuality, relayState);
-        }
+// Recalibrate in clean air (e.g. after moving the device); replaces the stored R0
+bool applyCalibrate(const CommandArgs& args) {
+    if (!args.getBool(CommandKey::CALIBRATE)) return true;
+    sensor.calibrate();
+    sensor.storeR0();
+    return true;
+}
+
+const CommandBinding commandBindings[] = {
+    {CommandKey::RELAY_STATE, applyRelayState},
+    {CommandKey::SAMPLING_INTERVAL, applySamplingInterval},
+    {CommandKey::OLED_MESSAGE, applyOledMessage},
+    {CommandKey::CALIBRATE, applyCalibrate},
+};
+CommandDispatcher commandDispatcher(commandBindings, sizeof(commandBindings) / sizeof(commandBindings[0]));
+
+void processCommands(const char* json, size_t length) {
+    Serial.printf("Processing command: %.*s\n", (int)length, json);
+
+    if (!commandDispatcher.dispatch(json, length)) {
+        Serial.println("Failed to parse commands JSON");
     }
 }
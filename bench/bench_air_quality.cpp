@@ -0,0 +1,138 @@
+// Air-quality bands: the threshold count against the if-chain with String
+// labels it replaces (same band for every reading, thresholds and NaN
+// included), the cost of both, and the sample path from the ADC read through
+// classification, trace, display and publish running without a single heap
+// allocation.
+
+#include <WiFi.h>
+#include <cmath>
+#include <cstring>
+#include "air_quality.h"
+#include "gas_channel.h"
+#include "iot_protocol.h"
+#include "native_bench.h"
+#include "native_hal.h"
+#include "oled_display.h"
+#include "trace_log.h"
+
+namespace {
+
+// The previous String getAirQuality of the MQ-2 sensor
+const String legacyAirQuality(float ppm) {
+    if (ppm < 25.0F) return F("Excellent");
+    if (ppm < 50.0F) return F("Good");
+    if (ppm < 200.0F) return F("Moderate");
+    if (ppm < 500.0F) return F("Poor");
+    if (ppm < 1000.0F) return F("Very Poor");
+    if (ppm < 5000.0F) return F("Hazardous");
+    return F("Critical");
+}
+
+// Noisy readings over every band, in no order a predictor could follow
+float readingAt(uint32_t i) {
+    static float readings[4096];
+    static bool filled = false;
+    if (!filled) {
+        uint32_t seed = 7;
+        for (float& r : readings) {
+            seed = seed * 1103515245U + 12345U;
+            r = std::pow(10.0F, static_cast<float>(seed >> 8 & 0xFFFF) / 65536.0F * 4.0F);   // 1-10000 ppm
+        }
+        filled = true;
+    }
+    return readings[i & 4095];
+}
+
+// Clean air while the sensor warms up and calibrates, then slow sweeps from
+// below it up through every band
+int adcAt(uint32_t nowMs) {
+    static uint32_t startMs = UINT32_MAX;
+    if (startMs == UINT32_MAX) startMs = nowMs;
+    const uint32_t ms = nowMs - startMs;
+    return ms < 120000 ? 800 : static_cast<int>(300 + (ms - 120000) / 140 % 3700);
+}
+
+}  // namespace
+
+NATIVE_BENCH(air_quality_classify) {
+    bool same = true;
+    for (float ppm = 0.0F; ppm <= 10000.0F && same; ppm += 0.25F) {
+        same = strcmp(airQualityLabel(classifyAirQuality(ppm)), legacyAirQuality(ppm).c_str()) == 0;
+    }
+    for (float threshold : AQ_THRESHOLDS) {
+        for (float ppm : {std::nextafter(threshold, 0.0F), threshold, std::nextafter(threshold, 1e9F)}) {
+            same = same && strcmp(airQualityLabel(classifyAirQuality(ppm)), legacyAirQuality(ppm).c_str()) == 0;
+        }
+    }
+    same = same && classifyAirQuality(NAN) == AirQuality::CRITICAL && legacyAirQuality(NAN) == "Critical";
+    NativeBench::check(same, "every reading lands in the band the if-chain gave it");
+
+    // Both hand back the label the display and the JSON frame print
+    readingAt(0);
+    uintptr_t sink = 0;
+    const double legacyCycles = NativeBench::cyclesPerCall(1000000, [&](uint32_t i) {
+        const String label = legacyAirQuality(readingAt(i));
+        sink += static_cast<uintptr_t>(label.c_str()[0]);
+    });
+    const double enumCycles = NativeBench::cyclesPerCall(1000000, [&](uint32_t i) {
+        sink += static_cast<uintptr_t>(airQualityLabel(classifyAirQuality(readingAt(i)))[0]);
+    });
+    NativeBench::doNotOptimize(sink);
+    printf("classify      : %.1f cycles enum + label vs %.1f cycles String if-chain\n", enumCycles, legacyCycles);
+}
+
+NATIVE_BENCH(air_quality_sample_path) {
+    static ConfiguredGasChannel<0> sensor(GAS_CHANNELS[0]);
+    static OLEDDisplay display;
+    static IoTProtocol protocol;
+    static TraceLog log;
+
+    NativeHal::setAnalogSource(MQ2_PIN, adcAt);
+    sensor.init();
+    for (uint32_t ms = 0; ms < 300000 && (sensor.isWarming() || sensor.isCalibrating()); ms += MQ2_UPDATE_MS) {
+        sensor.update(0, 21.5F, 47.0F);
+        if (sensor.isCalibrating()) sensor.readPPM();
+        delay(MQ2_UPDATE_MS);
+    }
+    NativeBench::check(sensor.isCalibrated(), "the MQ-2 calibrates in clean air");
+    if (!NativeBench::check(display.init(), "display initialises")) return;
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    delay(NativeHal::costs().wifiScanConnectMs);
+    protocol.init(ProtocolType::MQTT);
+    if (!NativeBench::check(WiFi.status() == WL_CONNECTED && protocol.connect(), "simulated broker connects")) {
+        return;
+    }
+
+    // One tick as runSample/runDisplay/runPublish do it, minus the scheduler
+    constexpr uint32_t TICKS = 5000;
+    uint32_t published = 0;
+    uint32_t bands = 0;
+    const NativeHal::HeapStats h0 = NativeHal::heapStats();
+    for (uint32_t i = 0; i < TICKS; ++i) {
+        const float ppm = sensor.readPPM();
+        const AirQuality quality = classifyAirQuality(ppm);
+        bands |= 1U << static_cast<unsigned>(quality);
+        log.write<TraceEvent::PPM_READING>(ppm, airQualityLabel(quality));
+        display.showAirQuality(ppm, quality, (i & 8) != 0);
+
+        TelemetrySample sample;
+        sample.timestamp = NativeHal::nowMicros();
+        sample.ppm = ppm;
+        sample.temperature = 21.5F;
+        sample.humidity = 47.0F;
+        sample.quality = static_cast<uint8_t>(quality);
+        sample.flags = 0;
+        published += protocol.publishSamples(&sample, 1, false);
+        while (log.drain(Serial)) NativeHal::advanceMicros(TRACE_DRAIN_RETRY_MS * 1000UL);
+        delay(100);
+    }
+    const NativeHal::HeapStats h1 = NativeHal::heapStats();
+
+    NativeBench::check(bands == (1U << AIR_QUALITY_COUNT) - 1, "the readings cross every band");
+    NativeBench::check(published == TICKS, "every tick is published");
+    NativeBench::check(h1.allocations == h0.allocations, "acquisition, display and publish never allocate");
+    printf("sample path   : %u ticks, %u bands seen, %llu allocations, %llu bytes\n", static_cast<unsigned>(TICKS),
+           static_cast<unsigned>(__builtin_popcount(bands)),
+           static_cast<unsigned long long>(h1.allocations - h0.allocations),
+           static_cast<unsigned long long>(h1.bytesAllocated - h0.bytesAllocated));
+}
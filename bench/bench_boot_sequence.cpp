@@ -0,0 +1,130 @@
+// Boot sequence: the firmware's stage graph with modelled stage times (WiFi
+// association 3 s, MQ-2 warm-up 30 s). Independent stages overlap, so the
+// first publish follows WiFi and the broker rather than the heater; a stage
+// starts in the same pass its dependencies finish; update() never waits; a
+// failed stage skips only the stages that depend on it.
+
+#include <Arduino.h>
+#include "binary_telemetry.h"
+#include "boot_sequence.h"
+#include "native_bench.h"
+#include "native_hal.h"
+
+namespace {
+
+using BinaryTelemetry::BootStage;
+
+constexpr uint32_t LOOP_MS = 100;
+constexpr uint32_t ALERT_MS = 200;
+constexpr uint32_t MQ2_MS = 30000;
+constexpr uint32_t WIFI_MS = 3000;
+constexpr uint32_t CLOCK_MS = 500;
+constexpr uint32_t BROKER_MS = 250;
+
+constexpr size_t idx(BootStage stage) { return static_cast<size_t>(stage); }
+constexpr uint16_t afterStage(BootStage stage) { return bootBit(idx(stage)); }
+
+// Virtual ms each stage was started at
+uint32_t startedMs[idx(BootStage::COUNT)];
+bool storageFails = false;
+
+template <BootStage S>
+bool startStage() {
+    startedMs[idx(S)] = millis();
+    return S != BootStage::STORAGE || !storageFails;
+}
+
+template <BootStage S, uint32_t MS>
+bool readyAfter() {
+    return millis() - startedMs[idx(S)] >= MS;
+}
+
+const BootStep STEPS[] = {
+    {"oled", 0, startStage<BootStage::OLED>, nullptr},
+    {"relay", 0, startStage<BootStage::RELAY>, nullptr},
+    {"alert", afterStage(BootStage::RELAY), startStage<BootStage::ALERT>, readyAfter<BootStage::ALERT, ALERT_MS>},
+    {"mq2", 0, startStage<BootStage::MQ2>, readyAfter<BootStage::MQ2, MQ2_MS>},
+    {"dht", 0, startStage<BootStage::DHT>, nullptr},
+    {"storage", 0, startStage<BootStage::STORAGE>, nullptr},
+    {"wifi", 0, startStage<BootStage::WIFI>, readyAfter<BootStage::WIFI, WIFI_MS>},
+    {"clock", afterStage(BootStage::WIFI), startStage<BootStage::CLOCK>, readyAfter<BootStage::CLOCK, CLOCK_MS>},
+    {"broker", afterStage(BootStage::WIFI), startStage<BootStage::BROKER>, readyAfter<BootStage::BROKER, BROKER_MS>},
+    {"first_publish", afterStage(BootStage::BROKER), nullptr, nullptr},
+};
+constexpr size_t STEP_COUNT = sizeof(STEPS) / sizeof(STEPS[0]);
+
+struct BootRun {
+    uint64_t worstUpdateUs = 0;
+    uint32_t completions = 0;
+    uint32_t elapsedMs = 0;
+};
+
+// The loop's cadence: update() every pass, the first publish reported as
+// soon as the broker is up.
+BootRun runBoot(BootSequence& boot, uint32_t limitMs) {
+    BootRun run;
+    const uint32_t start = millis();
+    while (millis() - start < limitMs) {
+        const uint64_t t0 = micros();
+        if (boot.update()) ++run.completions;
+        const uint64_t took = micros() - t0;
+        if (took > run.worstUpdateUs) run.worstUpdateUs = took;
+        if (boot.isFinished(idx(BootStage::BROKER))) boot.finish(idx(BootStage::FIRST_PUBLISH));
+        delay(LOOP_MS);
+    }
+    run.elapsedMs = millis() - start;
+    return run;
+}
+
+double stageMs(const BootSequence& boot, BootStage stage, bool end) {
+    const size_t i = idx(stage);
+    return (end ? boot.getEndUs(i) : boot.getStartUs(i)) / 1000.0;
+}
+
+}  // namespace
+
+NATIVE_BENCH(boot_sequence_overlap) {
+    storageFails = false;
+    delay(LOOP_MS);   // let earlier serial output drain
+    const uint64_t bootUs = micros();
+    static BootSequence boot(STEPS, STEP_COUNT);
+    const BootRun run = runBoot(boot, 40000);
+
+    NativeBench::check(boot.isComplete() && run.completions == 1, "boot completes, reported once");
+    NativeBench::check(run.worstUpdateUs < 1000, "update() never waits on a stage");
+    NativeBench::check(boot.getStartUs(idx(BootStage::WIFI)) - bootUs < 1000 &&
+                           boot.getStartUs(idx(BootStage::MQ2)) - bootUs < 1000,
+                       "WiFi and the MQ-2 heater start together at boot");
+    NativeBench::check(boot.getStartUs(idx(BootStage::BROKER)) == boot.getEndUs(idx(BootStage::WIFI)) &&
+                           boot.getStartUs(idx(BootStage::CLOCK)) == boot.getEndUs(idx(BootStage::WIFI)),
+                       "dependants start in the pass their dependency finishes");
+    const uint64_t firstPublishUs = boot.getEndUs(idx(BootStage::FIRST_PUBLISH)) - bootUs;
+    NativeBench::check(firstPublishUs < (WIFI_MS + BROKER_MS + 2 * LOOP_MS) * 1000ULL,
+                       "first publish follows WiFi and the broker, not the warm-up");
+    NativeBench::check(boot.getEndUs(idx(BootStage::MQ2)) > boot.getEndUs(idx(BootStage::FIRST_PUBLISH)),
+                       "the heater is still warming at the first publish");
+
+    const uint32_t serialMs = ALERT_MS + MQ2_MS + WIFI_MS + CLOCK_MS + BROKER_MS;
+    printf("boot timeline : wifi %.0f-%.0f ms, broker %.0f-%.0f ms, mq2 %.0f-%.0f ms (virtual)\n",
+           stageMs(boot, BootStage::WIFI, false), stageMs(boot, BootStage::WIFI, true),
+           stageMs(boot, BootStage::BROKER, false), stageMs(boot, BootStage::BROKER, true),
+           stageMs(boot, BootStage::MQ2, false), stageMs(boot, BootStage::MQ2, true));
+    printf("first publish : %.2f s after boot (one after another: %.2f s), worst update() %.1f us\n",
+           firstPublishUs / 1e6, serialMs / 1000.0, static_cast<double>(run.worstUpdateUs));
+}
+
+NATIVE_BENCH(boot_sequence_failure) {
+    // The failed stage's dependants are skipped, the others carry on
+    static const BootStep steps[] = {
+        {"storage", 0, startStage<BootStage::STORAGE>, nullptr},
+        {"replay", bootBit(0), startStage<BootStage::OLED>, nullptr},
+        {"wifi", 0, startStage<BootStage::WIFI>, readyAfter<BootStage::WIFI, WIFI_MS>},
+    };
+    storageFails = true;
+    static BootSequence boot(steps, 3);
+    const BootRun run = runBoot(boot, 5000);
+    NativeBench::check(boot.isFailed(0) && boot.isFailed(1), "a failed stage skips its dependants");
+    NativeBench::check(!boot.isFailed(2) && boot.isComplete() && run.completions == 1,
+                       "independent stages still finish");
+    storageFails = false;
+}
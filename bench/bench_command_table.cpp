@@ -0,0 +1,133 @@
+// Command dispatch: typed parsing of dashboard payloads through the
+// compile-time table, error accounting, heap use, and the cost of a key
+// lookup by binary search vs. the linear key-by-key scan the old
+// containsKey chain amounted to.
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include "command_table.h"
+#include "native_bench.h"
+#include "native_hal.h"
+
+namespace {
+
+struct Seen {
+    bool buzzerOverride = false;
+    bool buzzerState = false;
+    int32_t interval = 0;
+    float deadband = 0.0F;
+    float deadbandPct = 0.0F;
+    std::string oled;
+    std::string order;
+} seen;
+
+bool onBuzzer(const CommandArgs& args) {
+    seen.buzzerOverride = args.getBool(CommandKey::BUZZER_OVERRIDE);
+    seen.buzzerState = args.getBool(CommandKey::BUZZER_STATE);
+    seen.order += 'b';
+    return true;
+}
+bool onInterval(const CommandArgs& args) {
+    seen.interval = args.getInt(CommandKey::SAMPLING_INTERVAL);
+    seen.order += 'i';
+    return seen.interval >= 1 && seen.interval <= 300;
+}
+bool onDeadband(const CommandArgs& args) {
+    seen.deadband = args.getFloat(CommandKey::REPORT_DEADBAND_PPM);
+    seen.deadbandPct = args.getFloat(CommandKey::REPORT_DEADBAND_PCT, -1.0F);
+    seen.order += 'd';
+    return true;
+}
+bool onOled(const CommandArgs& args) {
+    seen.oled.assign(args.getString(CommandKey::OLED_MESSAGE), args.getLength(CommandKey::OLED_MESSAGE));
+    seen.order += 'o';
+    return true;
+}
+bool onRelay(const CommandArgs&) {
+    seen.order += 'r';
+    return true;
+}
+
+const CommandBinding BINDINGS[] = {
+    {CommandKey::BUZZER_OVERRIDE, onBuzzer},   {CommandKey::SAMPLING_INTERVAL, onInterval},
+    {CommandKey::REPORT_DEADBAND_PPM, onDeadband}, {CommandKey::OLED_MESSAGE, onOled},
+    {CommandKey::RELAY_STATE, onRelay},
+};
+
+bool dispatch(CommandDispatcher& d, const char* json) { return d.dispatch(json, strlen(json)); }
+
+const CommandSpec* linearFind(const char* name) {
+    for (const CommandSpec& spec : COMMAND_TABLE) {
+        if (strcmp(spec.name, name) == 0) return &spec;
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+NATIVE_BENCH(command_table) {
+    static CommandDispatcher d(BINDINGS, sizeof(BINDINGS) / sizeof(BINDINGS[0]));
+
+    // The control panel's full command object, plus keys this build ignores
+    const char* panel =
+        "{\"relay_state\":\"ON\",\"sampling_interval\":5,\"oled_message\":\"Caf\\u00e9 \\\"open\\\"\","
+        "\"buzzer_state\":false,\"buzzer_override\":true,\"device_id\":\"esp32_01\",\"meta\":{\"a\":[1,2]}}";
+
+    const NativeHal::HeapStats h0 = NativeHal::heapStats();
+    const bool parsed = dispatch(d, panel);
+    const NativeHal::HeapStats h1 = NativeHal::heapStats();
+
+    NativeBench::check(parsed, "a full control-panel command parses");
+    NativeBench::check(h1.allocations == h0.allocations, "parse and dispatch do not allocate");
+    NativeBench::check(seen.order == "riob", "actions run once each, in payload order");
+    NativeBench::check(seen.buzzerOverride && !seen.buzzerState, "arguments of a command arrive with it");
+    NativeBench::check(seen.interval == 5, "integers arrive typed");
+    NativeBench::check(seen.oled == "Caf\xc3\xa9 \"open\"", "strings are unescaped");
+    NativeBench::check(d.getUnknownKeys() == 2, "unknown keys are counted and skipped");
+
+    seen.order.clear();
+    NativeBench::check(dispatch(d, "{\"report_deadband_ppm\":2.5e1,\"report_deadband_pct\":-0.5}") &&
+                           std::fabs(seen.deadband - 25.0F) < 1e-4F && std::fabs(seen.deadbandPct + 0.5F) < 1e-6F,
+                       "floats with exponent and sign arrive typed");
+
+    // Errors: out of range, wrong type, malformed
+    dispatch(d, "{\"sampling_interval\":900}");
+    dispatch(d, "{\"sampling_interval\":\"fast\"}");
+    const uint32_t parseBefore = d.getParseErrors();
+    seen.order.clear();
+    const bool rejected = !dispatch(d, "{\"relay_state\":\"ON\",\"sampling_interval\":") &&
+                          !dispatch(d, "{\"relay_state\":\"ON\"} trailing") && !dispatch(d, "[]");
+    NativeBench::check(rejected && seen.order.empty() && d.getParseErrors() == parseBefore + 3,
+                       "malformed payloads run nothing and are counted");
+    const CommandStats& interval = d.getStats(CommandKey::SAMPLING_INTERVAL);
+    NativeBench::check(interval.calls == 2 && interval.errors == 2,
+                       "range and type errors are counted per command");
+
+    // Steady-state cost of one typical command, and of key lookup alone
+    const char* relay = "{\"relay_state\":\"OFF\"}";
+    const size_t relayLength = strlen(relay);
+    const double perCommand = NativeBench::cyclesPerCall(20000, [&](uint32_t) {
+        NativeBench::doNotOptimize(d.dispatch(relay, relayLength));
+    });
+    const char* first = COMMAND_TABLE[0].name;
+    const char* last = COMMAND_TABLE[COMMAND_KEY_COUNT - 1].name;
+    const size_t lastLength = strlen(last);
+    const double binaryLast = NativeBench::cyclesPerCall(200000, [&](uint32_t) {
+        NativeBench::doNotOptimize(CommandDispatcher::find(last, lastLength));
+    });
+    const double linearLast = NativeBench::cyclesPerCall(200000, [&](uint32_t) {
+        NativeBench::doNotOptimize(linearFind(last));
+    });
+    NativeBench::check(CommandDispatcher::find(first, strlen(first)) == &COMMAND_TABLE[0] &&
+                           CommandDispatcher::find(last, lastLength) == &COMMAND_TABLE[COMMAND_KEY_COUNT - 1] &&
+                           !CommandDispatcher::find("relay", 5) && !CommandDispatcher::find("relay_states", 12),
+                       "lookup finds exact keys only");
+
+    printf("dispatch      : %.0f cycles for {\"relay_state\":\"OFF\"}\n", perCommand);
+    printf("key lookup    : %.0f cycles binary vs %.0f linear for the last of %zu keys\n", binaryLast, linearLast,
+           COMMAND_KEY_COUNT);
+    printf("errors        : %u parse, %u unknown keys, sampling_interval %u/%u rejected\n",
+           static_cast<unsigned>(d.getParseErrors()), static_cast<unsigned>(d.getUnknownKeys()),
+           static_cast<unsigned>(interval.errors), static_cast<unsigned>(interval.calls));
+}
@@ -0,0 +1,233 @@
+// Gas channel registry: the cost of one scan from one to eight channels
+// (linear: each channel adds an ADC read, a curve and a filter), the scan
+// order against plain pin order when the ADC's sample capacitor carries part
+// of the last channel over, and every configured channel (with the MQ-2's
+// per-gas estimates) leaving in one message, JSON and binary.
+
+#include <Preferences.h>
+#include <WiFi.h>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include "binary_telemetry.h"
+#include "gas_channel.h"
+#include "iot_protocol.h"
+#include "mq2_gases.h"
+#include "native_bench.h"
+#include "native_hal.h"
+
+namespace {
+
+// Eight copies of the MQ-2 line, one on each ADC1 pin
+constexpr GasChannelSpec benchSpec(const char* name, int pin) {
+    return {name, pin, MQ2_LOAD_RESISTANCE_KOHM, MQ2_CURVE_A, MQ2_CURVE_B, MQ2_BASELINE_PPM, SmoothingFilter::ADAPTIVE,
+            MQ2_SMOOTHING_SAMPLES, &MQ2_COMPENSATION};
+}
+
+constexpr GasChannelSpec SPECS[ADC1_CHANNELS] = {
+    benchSpec("ch0", 36), benchSpec("ch1", 37), benchSpec("ch2", 38), benchSpec("ch3", 39),
+    benchSpec("ch4", 32), benchSpec("ch5", 33), benchSpec("ch6", 34), benchSpec("ch7", 35),
+};
+
+// Clean air and gas, in no order the pins follow
+constexpr int LEVELS[ADC1_CHANNELS] = {3400, 700, 2900, 1200, 3900, 400, 2300, 1700};
+
+template <size_t>
+using BenchChannel = ConfiguredGasChannel<0>;
+
+template <typename Sequence>
+struct Registry;
+
+template <size_t... I>
+struct Registry<std::index_sequence<I...>> {
+    using type = GasChannelRegistry<BenchChannel<I>...>;
+};
+
+template <size_t N>
+using RegistryOf = typename Registry<std::make_index_sequence<N>>::type;
+
+// A stored R0, so every reading goes through the curve
+void storeR0(const char* name, float r0) {
+    Preferences prefs;
+    prefs.begin(name);
+    const GasCalibration cal = {r0, 21.5F, 47.0F, 0};
+    prefs.putBytes("cal", &cal, sizeof(cal));
+    prefs.end();
+}
+
+void installLevels(int noise) {
+    for (size_t i = 0; i < ADC1_CHANNELS; ++i) {
+        NativeHal::setAnalogSource(SPECS[i].pin, [i, noise](uint32_t) {
+            return LEVELS[i] + (noise > 0 ? rand() % (2 * noise + 1) - noise : 0);
+        });
+    }
+}
+
+// One run of scans; kept at its best by the caller
+template <size_t N>
+double scanCycles(bool first) {
+    static RegistryOf<N> registry(SPECS);
+    if (first) {
+        registry.init();
+        for (int i = 0; i < 100; ++i) registry.scan();
+    }
+    const double cycles = NativeBench::cyclesPerCall(20000, [&](uint32_t) { registry.scan(); });
+    NativeBench::doNotOptimize(registry.getPPM(N - 1));
+    return cycles;
+}
+
+// Best of seven runs, each over every channel count in turn, so a burst of
+// host noise costs one run of each count rather than all runs of one
+template <size_t... N>
+void measureScans(double* cycles, std::index_sequence<N...>) {
+    for (int run = 0; run < 7; ++run) {
+        const double sample[] = {scanCycles<N + 1>(run == 0)...};
+        for (size_t i = 0; i < sizeof...(N); ++i) {
+            if (run == 0 || sample[i] < cycles[i]) cycles[i] = sample[i];
+        }
+    }
+}
+
+}  // namespace
+
+NATIVE_BENCH(gas_channel_scan) {
+    NativeHal::eraseNvs();
+    for (const GasChannelSpec& spec : SPECS) storeR0(spec.name, 10.0F);
+    installLevels(8);
+
+    double cycles[ADC1_CHANNELS];
+    measureScans(cycles, std::make_index_sequence<ADC1_CHANNELS>());
+
+    // Least-squares line through cost against channel count
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    for (size_t i = 0; i < ADC1_CHANNELS; ++i) {
+        const double x = static_cast<double>(i + 1);
+        sx += x;
+        sy += cycles[i];
+        sxx += x * x;
+        sxy += x * cycles[i];
+    }
+    const double n = ADC1_CHANNELS;
+    const double slope = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+    const double intercept = (sy - slope * sx) / n;
+    double worst = 0.0;
+    for (size_t i = 0; i < ADC1_CHANNELS; ++i) {
+        const double residual = std::fabs(cycles[i] - (intercept + slope * (i + 1))) / cycles[i];
+        if (residual > worst) worst = residual;
+    }
+
+    printf("scan cost     :");
+    for (size_t i = 0; i < ADC1_CHANNELS; ++i) {
+        printf(" %zu ch %.0f%s", i + 1, cycles[i], i + 1 < ADC1_CHANNELS ? "," : "");
+    }
+    printf(" cycles\n");
+    printf("scaling       : %.0f cycles per channel + %.0f fixed, worst point %.1f%% off the line; ADC %u us per "
+           "channel\n",
+           slope, intercept, worst * 100.0, static_cast<unsigned>(NativeHal::costs().analogReadUs));
+    NativeBench::check(slope > 0.0 && worst < 0.15, "scan cost grows linearly with the channel count");
+}
+
+NATIVE_BENCH(gas_channel_scan_order) {
+    NativeHal::eraseNvs();
+    for (const GasChannelSpec& spec : SPECS) storeR0(spec.name, 10.0F);
+    installLevels(0);
+    static RegistryOf<ADC1_CHANNELS> registry(SPECS);
+    registry.init();
+
+    constexpr int SCANS = 1000;
+    const float carryover = NativeHal::costs().adcCarryover;
+
+    // One read per pin, GPIO order, as a plain loop would do it
+    double pinOrderError = 0.0;
+    for (int s = 0; s < SCANS; ++s) {
+        for (size_t i = 0; i < ADC1_CHANNELS; ++i) pinOrderError += std::abs(analogRead(SPECS[i].pin) - LEVELS[i]);
+    }
+
+    // The registry's order, learnt from the first scan
+    registry.scan();
+    double sortedError = 0.0;
+    for (int s = 0; s < SCANS; ++s) {
+        registry.scan();
+        for (size_t i = 0; i < ADC1_CHANNELS; ++i) sortedError += std::abs(registry.getAdc(i) - LEVELS[i]);
+    }
+
+    const double perRead = 1.0 / (SCANS * ADC1_CHANNELS);
+    printf("scan order    : mean carry-over error %.1f LSB in pin order vs %.1f LSB sorted (%.0f%% of the last "
+           "channel carried)\n",
+           pinOrderError * perRead, sortedError * perRead, carryover * 100.0);
+    NativeBench::check(sortedError * 2.0 < pinOrderError, "sorted scans at least halve the settling error");
+}
+
+NATIVE_BENCH(gas_channel_frame) {
+    static GasChannels channels;
+    static IoTProtocol protocol;
+
+    NativeHal::eraseNvs();
+    for (size_t c = 0; c < GAS_CHANNEL_COUNT; ++c) {
+        storeR0(GAS_CHANNELS[c].name, 10.0F);
+        NativeHal::setAnalogSource(GAS_CHANNELS[c].pin, [c](uint32_t) { return 1500 + 700 * static_cast<int>(c); });
+    }
+    channels.init();
+    for (int i = 0; i < 20; ++i) channels.scan();
+
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    delay(NativeHal::costs().wifiScanConnectMs);
+    protocol.init(ProtocolType::MQTT);
+    if (!NativeBench::check(WiFi.status() == WL_CONNECTED && protocol.connect(), "simulated broker connects")) {
+        return;
+    }
+
+    // As runSample() fills it
+    TelemetrySample sample;
+    sample.timestamp = NativeHal::nowMicros();
+    sample.ppm = channels.getPPM(0);
+    sample.temperature = 21.5F;
+    sample.humidity = 47.0F;
+    sample.quality = static_cast<uint8_t>(classifyAirQuality(sample.ppm));
+    sample.flags = 0;
+    sample.gasChannels = GAS_CHANNEL_COUNT;
+    for (size_t c = 1; c < GAS_CHANNEL_COUNT; ++c) sample.gasPpm[c - 1] = channels.getPPM(c);
+    channels.sensor(0).estimate(MQ2_GAS_SET, sample.gasEstimate);
+    sample.gasEstimates = MQ2_GAS_COUNT;
+
+    std::string json;
+    std::string binary;
+    uint32_t messages = 0;
+    NativeHal::setPublishHook([&](const char*, const uint8_t* payload, size_t length) {
+        ++messages;
+        (payload[0] == '{' ? json : binary).assign(reinterpret_cast<const char*>(payload), length);
+    });
+    protocol.setPayloadFormat(PayloadFormat::JSON);
+    protocol.publishSamples(&sample, 1, false);
+    protocol.setPayloadFormat(PayloadFormat::BINARY);
+    protocol.publishSamples(&sample, 1, false);
+    NativeHal::setPublishHook(nullptr);
+
+    // Only listed with further channels configured
+    bool named = (json.find("\"gas_channels\":[") != std::string::npos) == (GAS_CHANNEL_COUNT > 1);
+    for (size_t c = 1; c < GAS_CHANNEL_COUNT; ++c) {
+        named = named && json.find(std::string("\"") + GAS_CHANNELS[c].name + "\":") != std::string::npos;
+    }
+    bool gases = json.find("\"gases\":{") != std::string::npos;
+    for (const GasCurveSpec& curve : MQ2_GAS_CURVES) {
+        gases = gases && json.find(std::string("\"") + curve.name + "\":") != std::string::npos;
+    }
+    BinaryTelemetry::BatchHeader header;
+    BinaryTelemetry::SampleRecord record;
+    const uint8_t* frame = reinterpret_cast<const uint8_t*>(binary.data());
+    bool decoded = BinaryTelemetry::decode(frame, binary.size(), header) == BinaryTelemetry::DecodeError::NONE &&
+                   BinaryTelemetry::decodeRecord(frame, binary.size(), 0, record) ==
+                       BinaryTelemetry::DecodeError::NONE &&
+                   header.gasChannels == GAS_CHANNEL_COUNT && record.ppm == sample.ppm;
+    for (size_t c = 1; c < GAS_CHANNEL_COUNT && decoded; ++c) decoded = record.gasPpm[c - 1] == sample.gasPpm[c - 1];
+    decoded = decoded && header.gasEstimates == MQ2_GAS_COUNT;
+    for (size_t g = 0; g < MQ2_GAS_COUNT && decoded; ++g) decoded = header.gasEstimate[g] == sample.gasEstimate[g];
+
+    NativeBench::check(messages == 2, "one message per format");
+    NativeBench::check(named, "the JSON frame names every further channel");
+    NativeBench::check(gases, "the JSON frame carries every MQ-2 gas estimate");
+    NativeBench::check(decoded, "the binary frame carries every channel's ppm and every gas estimate");
+    printf("one frame     : %u channels, JSON %zu B, binary %zu B\n", static_cast<unsigned>(GAS_CHANNEL_COUNT),
+           json.size(), binary.size());
+}
@@ -0,0 +1,145 @@
+// Temperature/humidity compensation: the grid lookup against the datasheet
+// nodes it was built from (exact on every node, continuous between them,
+// clamped beyond), its cost, and an MQ-2 in steady gas through a day of HVAC
+// swings, raw against compensated.
+
+#include <Preferences.h>
+#include <cmath>
+#include "gas_channel.h"
+#include "gas_compensation.h"
+#include "native_bench.h"
+#include "native_hal.h"
+
+namespace {
+
+constexpr double HOUR_MS = 3600.0 * 1000.0;
+constexpr double TWO_PI = 6.283185307179586;
+
+// The sensor's own Rs(T, RH) / Rs(20 °C, 33 %RH): smooth, near the
+// datasheet chart but not the grid
+double trueRsFactor(double temperature, double humidity) {
+    const double u = (temperature - 20.0) / 10.0;
+    return (1.0 - 0.065 * u + 0.01 * u * u) * (1.0 - 0.0016 * (humidity - 33.0));
+}
+
+// Rs/RL -> the ADC reading of the divider
+int adcFor(double rsOverRl) { return static_cast<int>(std::lround(MQ2_ADC_RESOLUTION / (1.0 + rsOverRl))); }
+
+// Conditioned room: the cooling cycles every 40 minutes, the air dries as it
+// cools
+float roomTemperature(double ms) { return 23.0F + 5.0F * static_cast<float>(std::sin(TWO_PI * ms / 2400000.0)); }
+float roomHumidity(double ms) { return 45.0F + 15.0F * static_cast<float>(std::sin(TWO_PI * ms / 2400000.0)); }
+
+}  // namespace
+
+NATIVE_BENCH(gas_compensation_grid) {
+    const CompensationGrid& grid = MQ2_COMPENSATION;
+    bool nodes = true;
+    for (size_t r = 0; r < grid.rows; ++r) {
+        for (size_t c = 0; c < grid.columns; ++c) {
+            const float t = grid.temperatureMin + grid.temperatureStep * c;
+            const float rh = grid.humidityMin + grid.humidityStep * r;
+            nodes = nodes && compensationFactor(grid, t, rh) == grid.factors[r * grid.columns + c];
+        }
+    }
+    NativeBench::check(nodes, "every grid node reads back its datasheet value");
+
+    // No step anywhere larger than the slope allows, edges included
+    const float steepest = 0.2F;   // per °C, well above the chart's
+    float worstStep = 0.0F;
+    for (float rh = 0.0F; rh <= 100.0F; rh += 0.5F) {
+        float last = compensationFactor(grid, -30.0F, rh);
+        for (float t = -30.0F; t <= 70.0F; t += 0.01F) {
+            const float f = compensationFactor(grid, t, rh);
+            worstStep = std::max(worstStep, std::fabs(f - last));
+            last = f;
+        }
+    }
+    NativeBench::check(worstStep < steepest * 0.01F, "the factor is continuous across cells");
+
+    const float corner = grid.factors[0];
+    const float farCorner = grid.factors[grid.rows * grid.columns - 1];
+    NativeBench::check(compensationFactor(grid, -40.0F, 0.0F) == corner &&
+                           compensationFactor(grid, 90.0F, 100.0F) == farCorner,
+                       "outside the grid the nearest edge applies");
+
+    // Varying conditions, so no lookup repeats the last
+    float temperatures[1024];
+    float humidities[1024];
+    for (size_t i = 0; i < 1024; ++i) {
+        temperatures[i] = -15.0F + 70.0F * static_cast<float>((i * 37) % 1024) / 1024.0F;
+        humidities[i] = 10.0F + 85.0F * static_cast<float>((i * 91) % 1024) / 1024.0F;
+    }
+    float sink = 0.0F;
+    double best = 0.0;
+    for (int run = 0; run < 5; ++run) {
+        const double cycles = NativeBench::cyclesPerCall(1000000, [&](uint32_t i) {
+            sink += compensationFactor(grid, temperatures[i & 1023], humidities[i & 1023]);
+        });
+        if (run == 0 || cycles < best) best = cycles;
+    }
+    NativeBench::doNotOptimize(sink);
+    printf("grid lookup   : %.1f cycles, once per DHT window; a reading pays one multiply\n", best);
+    printf("grid steps    : largest %.5f per 0.01 °C over -30..70 °C, 0..100 %%RH\n", worstStep);
+}
+
+NATIVE_BENCH(gas_compensation_hvac) {
+    static ConfiguredGasChannel<0> sensor(GAS_CHANNELS[0]);
+
+    // R0 from clean air at 21 °C/40 %RH
+    constexpr float CAL_T = 21.0F;
+    constexpr float CAL_RH = 40.0F;
+    constexpr double R0_OVER_RL = 2.0;
+    NativeHal::eraseNvs();
+    {
+        Preferences prefs;
+        prefs.begin(GAS_CHANNELS[0].name);
+        const GasCalibration cal = {static_cast<float>(R0_OVER_RL * MQ2_LOAD_RESISTANCE_KOHM), CAL_T, CAL_RH, 0};
+        prefs.putBytes("cal", &cal, sizeof(cal));
+        prefs.end();
+    }
+    sensor.init();
+
+    // A steady leak at Rs/R0 0.4 in the calibration air, through 24 hours of
+    // cooling cycles, one reading a second and new conditions every DHT window
+    constexpr double GAS_RATIO = 0.4;
+    const float truePpm = sensor.toPPM(static_cast<float>(GAS_RATIO));
+    const double calFactor = trueRsFactor(CAL_T, CAL_RH);
+    float rawMin = 1e9F, rawMax = 0.0F, compMin = 1e9F, compMax = 0.0F;
+    double rawSum = 0.0, compSum = 0.0;
+    uint32_t readings = 0;
+    bool rawKept = true;
+    for (double ms = 0.0; ms < 24.0 * HOUR_MS; ms += 1000.0) {
+        const float t = roomTemperature(ms);
+        const float rh = roomHumidity(ms);
+        if (static_cast<uint32_t>(ms) % 10000 == 0) sensor.setConditions(t, rh);
+        const double rs = GAS_RATIO * R0_OVER_RL * trueRsFactor(t, rh) / calFactor;
+        sensor.sample(adcFor(rs));
+        const float raw = sensor.getRawPPM();
+        const float compensated = sensor.toPPM(sensor.getRatio());
+        rawKept = rawKept && sensor.getRatio() == sensor.getRawRatio() * sensor.getCompensation();
+        rawMin = std::min(rawMin, raw);
+        rawMax = std::max(rawMax, raw);
+        compMin = std::min(compMin, compensated);
+        compMax = std::max(compMax, compensated);
+        rawSum += raw;
+        compSum += compensated;
+        ++readings;
+    }
+    const double rawSwing = (rawMax - rawMin) / (rawSum / readings);
+    const double compSwing = (compMax - compMin) / (compSum / readings);
+    const double compError = std::max(std::fabs(compMax - truePpm), std::fabs(compMin - truePpm)) / truePpm;
+
+    // Unknown conditions leave the reading as measured
+    sensor.setConditions(NAN, NAN);
+    sensor.sample(adcFor(GAS_RATIO * R0_OVER_RL));
+    const bool unknownRaw = sensor.getCompensation() == 1.0F && sensor.getRatio() == sensor.getRawRatio();
+
+    printf("hvac day      : %.0f ppm of gas, 18-28 °C and 30-60 %%RH: raw %.0f-%.0f ppm (swing %.0f%%), "
+           "compensated %.0f-%.0f ppm (swing %.1f%%, worst %.1f%% off)\n",
+           truePpm, rawMin, rawMax, rawSwing * 100.0, compMin, compMax, compSwing * 100.0, compError * 100.0);
+    NativeBench::check(compSwing * 4.0 < rawSwing, "compensation takes out most of the temperature/humidity swing");
+    NativeBench::check(compError < 0.08, "compensated readings stay within 8% of the gas level");
+    NativeBench::check(rawKept, "the raw and the compensated Rs/R0 are both kept");
+    NativeBench::check(unknownRaw, "without conditions the reading stays uncorrected");
+}
@@ -0,0 +1,100 @@
+// Loop metrics: bucket edges line up with no gaps or overlaps up to the
+// clamp, histogram percentiles against exact ones from the sorted samples
+// (within one bucket, 12.5%), the cost of recording a sample (histogram
+// alone and with the clock read), and no allocation on the record path.
+
+#include <algorithm>
+#include <vector>
+#include "loop_metrics.h"
+#include "native_bench.h"
+#include "native_hal.h"
+
+namespace {
+
+// Mostly short passes with a long tail, like the loop's: 0.1-50 ms, now and
+// then a blocking connect of seconds
+std::vector<uint32_t> passDurations(size_t n) {
+    std::vector<uint32_t> out;
+    out.reserve(n);
+    uint32_t seed = 2024;
+    for (size_t i = 0; i < n; ++i) {
+        seed = seed * 1103515245U + 12345U;
+        const uint32_t r = seed >> 8;
+        if (r % 500 == 0) out.push_back(2000000 + r % 1500000);
+        else if (r % 10 == 0) out.push_back(20000 + r % 30000);
+        else out.push_back(100 + r % 3000);
+    }
+    return out;
+}
+
+}  // namespace
+
+NATIVE_BENCH(metrics_bucket_edges) {
+    bool contiguous = true;
+    for (size_t i = 0; i + 1 < LatencyHistogram::BUCKETS; ++i) {
+        const uint32_t top = LatencyHistogram::bucketTop(i);
+        if (LatencyHistogram::bucketOf(top) != i || LatencyHistogram::bucketOf(top + 1) != i + 1) contiguous = false;
+    }
+    NativeBench::check(contiguous, "every value up to the clamp has exactly one bucket");
+    NativeBench::check(LatencyHistogram::bucketOf(UINT32_MAX) == LatencyHistogram::BUCKETS - 1,
+                       "longer durations land in the last bucket");
+    // Relative width of the widest bucket above the exact range
+    double widest = 0.0;
+    for (size_t i = LatencyHistogram::SUB_BUCKETS; i + 1 < LatencyHistogram::BUCKETS; ++i) {
+        const double bottom = LatencyHistogram::bucketTop(i - 1) + 1.0;
+        widest = std::max(widest, (LatencyHistogram::bucketTop(i) + 1.0 - bottom) / bottom);
+    }
+    NativeBench::check(widest <= 1.0 / LatencyHistogram::SUB_BUCKETS + 1e-9, "buckets are at most 12.5% wide");
+    printf("buckets       : %u x 4 B = %u B per stage, exact below %u us, clamp at %.1f s, widest %.1f%%\n",
+           static_cast<unsigned>(LatencyHistogram::BUCKETS), static_cast<unsigned>(sizeof(LatencyHistogram)),
+           static_cast<unsigned>(LatencyHistogram::SUB_BUCKETS), (1UL << LatencyHistogram::MAX_BITS) / 1e6,
+           widest * 100.0);
+}
+
+NATIVE_BENCH(metrics_percentiles) {
+    static LatencyHistogram h;
+    h.reset();
+    std::vector<uint32_t> samples = passDurations(200000);
+    uint64_t total = 0;
+    for (uint32_t us : samples) {
+        h.record(us);
+        total += us;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    bool close = true;
+    static constexpr float FRACTIONS[] = {0.50F, 0.90F, 0.99F, 0.999F};
+    printf("percentiles   :");
+    for (float f : FRACTIONS) {
+        const uint32_t exact = samples[static_cast<size_t>(f * samples.size()) - 1];
+        const uint32_t estimate = h.percentile(f);
+        // A bucket's top is at most one bucket width above any value in it
+        if (estimate < exact || estimate > exact + exact / LatencyHistogram::SUB_BUCKETS + 1) close = false;
+        printf(" p%g %u/%u", f * 100.0F, static_cast<unsigned>(estimate), static_cast<unsigned>(exact));
+    }
+    printf(" us (histogram/exact)\n");
+    NativeBench::check(close, "percentiles are within one bucket of the exact value");
+    NativeBench::check(h.max() == samples.back() && h.count() == samples.size() && h.mean() == total / samples.size(),
+                       "count, mean and max are exact");
+}
+
+NATIVE_BENCH(metrics_record_cost) {
+    static LatencyHistogram h;
+    static LoopMetrics metrics;
+    const std::vector<uint32_t> samples = passDurations(4096);
+    const uint64_t startUs = NativeHal::nowMicros();
+
+    const NativeHal::HeapStats h0 = NativeHal::heapStats();
+    const double histogramCycles = NativeBench::cyclesPerCall(1000000, [&](uint32_t i) { h.record(samples[i & 4095]); });
+    const double stageCycles = NativeBench::cyclesPerCall(1000000, [&](uint32_t i) {
+        metrics.record(static_cast<MetricStage>(i % LoopMetrics::STAGE_COUNT), startUs);
+    });
+    const NativeHal::HeapStats h1 = NativeHal::heapStats();
+    NativeBench::doNotOptimize(h);
+
+    NativeBench::check(h1.allocations == h0.allocations, "recording never allocates");
+    NativeBench::check(stageCycles < 300.0, "a stage sample costs less than 300 cycles");
+    printf("record        : %.1f cycles histogram, %.1f cycles stage (with clock read); %u B for %u stages\n",
+           histogramCycles, stageCycles, static_cast<unsigned>(sizeof(LoopMetrics)),
+           static_cast<unsigned>(LoopMetrics::STAGE_COUNT));
+}
@@ -0,0 +1,208 @@
+// MQ-2 boot and calibration: a first boot warms up and calibrates in the
+// background, a reboot reuses the R0 stored in NVS at once, short gas events
+// never pass for drift, a lasting baseline shift recalibrates on its own, and
+// air that never settles fails calibration after a few backed-off attempts:
+// without an R0 the sensor keeps trying, with one it keeps that R0.
+
+#include <cmath>
+#include <cstdlib>
+#include "native_bench.h"
+#include "native_hal.h"
+#include "gas_channel.h"
+
+namespace {
+
+using MQ2Sensor = ConfiguredGasChannel<0>;
+
+constexpr uint32_t LOOP_MS = 100;
+constexpr uint32_t READ_MS = 5000;
+
+struct Air {
+    uint32_t bootMs = 0;
+    int cleanAdc = 1500;
+    bool leaks = false;   // 10 minutes of gas every two hours, from an hour after boot
+    int noise = 8;        // ADC LSB either side
+};
+
+Air air;
+
+// Heater settling after power-up, ADC noise, optional leaks
+void installAir() {
+    NativeHal::setAnalogSource(MQ2_PIN, [](uint32_t nowMs) {
+        const double sinceBoot = static_cast<double>(nowMs - air.bootMs);
+        int adc = static_cast<int>(air.cleanAdc * (1.0 - 0.5 * std::exp(-sinceBoot / 10000.0)));
+        const uint32_t phase = (nowMs - air.bootMs) % (2 * 3600000UL);
+        if (air.leaks && phase >= 3600000UL && phase < 3600000UL + 10 * 60000UL) adc += 1500;
+        return adc + (rand() % (2 * air.noise + 1)) - air.noise;
+    });
+}
+
+void powerUp(MQ2Sensor& sensor) {
+    air.bootMs = millis();
+    sensor.init();
+}
+
+// The loop's cadence: update() every pass, a reading every READ_MS.
+// Returns the number of readings taken while warming.
+uint32_t run(MQ2Sensor& sensor, uint32_t ms, bool (*until)(const MQ2Sensor&) = nullptr) {
+    uint32_t warmingReads = 0;
+    for (uint32_t t = 0; t < ms; t += LOOP_MS) {
+        sensor.update(NativeHal::referenceEpochMicros(NativeHal::nowMicros()), 21.5F, 47.0F);
+        if (t % READ_MS == 0) {
+            sensor.readPPM();
+            if (sensor.isWarming()) ++warmingReads;
+        }
+        if (until && until(sensor)) break;
+        delay(LOOP_MS);
+    }
+    return warmingReads;
+}
+
+bool settled(const MQ2Sensor& s) { return !s.isWarming() && !s.isCalibrating() && s.isCalibrated(); }
+
+}  // namespace
+
+NATIVE_BENCH(mq2_boot) {
+    NativeHal::eraseNvs();
+    air = Air();
+    installAir();
+
+    // First boot: nothing stored, calibration follows the warm-up
+    MQ2Sensor first(GAS_CHANNELS[0]);
+    const uint32_t writes0 = NativeHal::nvsWrites();
+    delay(LOOP_MS);   // let earlier serial output drain
+    const uint64_t t0 = micros();
+    powerUp(first);
+    const uint64_t initUs = micros() - t0;
+    NativeBench::check(initUs < 10000 && first.isWarming() && !first.isCalibrated(), "init() returns at once, warming");
+    const uint32_t start = millis();
+    const uint32_t warmingReads = run(first, 120000, settled);
+    const uint32_t firstReadyMs = millis() - start;
+    const GasCalibration& cal = first.getCalibration();
+    NativeBench::check(settled(first) && first.getCalibrationCount() == 1 && NativeHal::nvsWrites() == writes0 + 1,
+                       "first boot calibrates once and stores R0");
+    NativeBench::check(warmingReads > 0, "readings during warm-up are flagged");
+    NativeBench::check(cal.temperature == 21.5F && cal.humidity == 47.0F && cal.epochUs > 0,
+                       "R0 is stored with its conditions and time");
+    run(first, 60000);
+    const float cleanPpm = first.readPPM();
+
+    // Reboot: R0 from NVS before the first reading, no calibration
+    MQ2Sensor second(GAS_CHANNELS[0]);
+    const uint32_t writes1 = NativeHal::nvsWrites();
+    powerUp(second);
+    NativeBench::check(second.isCalibrated() && second.getR0() == first.getR0() && !second.isCalibrating(),
+                       "reboot reuses the stored R0");
+    const uint32_t rebootStart = millis();
+    run(second, 120000, settled);
+    const uint32_t rebootWarmMs = millis() - rebootStart;
+    run(second, 60000);
+    const float rebootPpm = second.readPPM();
+    NativeBench::check(second.getCalibrationCount() == 0 && NativeHal::nvsWrites() == writes1,
+                       "reboot does not recalibrate or write NVS");
+    NativeBench::check(std::fabs(rebootPpm - cleanPpm) < 1.0F, "reboot reads the same clean air");
+
+    printf("first boot    : init %.2f ms, warm + calibrated after %.1f s, R0 %.2f kOhm\n", initUs / 1000.0,
+           firstReadyMs / 1000.0, first.getR0());
+    printf("reboot        : R0 from NVS at init, warm after %.1f s, clean air %.1f ppm (was %.1f)\n",
+           rebootWarmMs / 1000.0, rebootPpm, cleanPpm);
+}
+
+NATIVE_BENCH(mq2_drift) {
+    NativeHal::eraseNvs();
+    air = Air();
+    air.leaks = true;
+    installAir();
+
+    MQ2Sensor sensor(GAS_CHANNELS[0]);
+    powerUp(sensor);
+    run(sensor, 120000, settled);
+    const float r0 = sensor.getR0();
+
+    // Six hours of clean air with a leak every two hours: no drift
+    run(sensor, 6 * 3600000UL);
+    NativeBench::check(sensor.getCalibrationCount() == 1 && !sensor.isCalibrating(), "gas events are not drift");
+
+    // The sensor ages: clean air now reads ~30% higher Rs
+    air.cleanAdc = 1250;
+    const uint32_t shiftMs = millis();
+    run(sensor, 6 * 3600000UL, [](const MQ2Sensor& s) { return s.getCalibrationCount() == 2 && !s.isCalibrating(); });
+    const uint32_t detectMs = millis() - shiftMs;
+    const float expected = MQ2_LOAD_RESISTANCE_KOHM * (static_cast<float>(MQ2_ADC_RESOLUTION) / 1250.0F - 1.0F);
+    NativeBench::check(sensor.getCalibrationCount() == 2, "a lasting baseline shift recalibrates");
+    NativeBench::check(detectMs <= (MQ2_DRIFT_WINDOWS + 1) * MQ2_DRIFT_WINDOW_MS, "within the drift windows");
+    NativeBench::check(std::fabs(sensor.getR0() - expected) / expected < 0.02F, "new R0 matches the shifted air");
+
+    // On request, without waiting for drift
+    sensor.requestCalibration();
+    run(sensor, 30000, [](const MQ2Sensor& s) { return s.getCalibrationCount() == 3 && !s.isCalibrating(); });
+    NativeBench::check(sensor.getCalibrationCount() == 3, "a requested calibration runs in the background");
+
+    printf("drift         : R0 %.2f -> %.2f kOhm (expected %.2f), detected after %.1f h\n", r0, sensor.getR0(),
+           expected, detectMs / 3600000.0);
+}
+
+NATIVE_BENCH(mq2_calibration_gives_up) {
+    NativeHal::eraseNvs();
+    air = Air();
+    air.noise = 400;   // A floating pin, or a sensor that never settles
+    installAir();
+
+    // First boot: no R0 to fall back on, so the failure is flagged and the
+    // sensor keeps trying at the longest wait
+    MQ2Sensor sensor(GAS_CHANNELS[0]);
+    powerUp(sensor);
+    const uint32_t start = millis();
+    uint32_t samplingMs = 0;
+    for (uint32_t t = 0; t < 3600000UL && !sensor.isCalibrationFailed(); t += LOOP_MS) {
+        sensor.update(0, 21.5F, 47.0F);
+        if (sensor.isSampling()) samplingMs += LOOP_MS;
+        delay(LOOP_MS);
+    }
+    const uint32_t failedMs = millis() - start;
+    NativeBench::check(sensor.isCalibrationFailed() && !sensor.isCalibrated(), "no R0 is taken from unsteady air");
+    NativeBench::check(sensor.isCalibrating(), "without an R0 the sensor keeps trying");
+    const uint32_t longestWaitMs = MQ2_CALIBRATION_RETRY_MS << (MQ2_CALIBRATION_ATTEMPTS - 1);
+    const uint32_t sampledBefore = samplingMs;
+    for (uint32_t t = 0; t < 10 * longestWaitMs; t += LOOP_MS) {
+        sensor.update(0, 21.5F, 47.0F);
+        if (sensor.isSampling()) samplingMs += LOOP_MS;
+        delay(LOOP_MS);
+    }
+    const uint32_t retrySamplingMs = samplingMs - sampledBefore;
+    const uint32_t attemptMs = MQ2_CALIBRATION_SAMPLES * LOOP_MS;   // One sample per update()
+    NativeBench::check(retrySamplingMs > 0 && retrySamplingMs <= 11 * attemptMs, "retries at the longest wait");
+
+    // Once the air settles it calibrates on its own
+    air.noise = 8;
+    const uint32_t settleStart = millis();
+    run(sensor, 2 * longestWaitMs, settled);
+    const uint32_t recoveredMs = millis() - settleStart;
+    NativeBench::check(settled(sensor) && !sensor.isCalibrationFailed(), "settled air calibrates without a request");
+
+    // With an R0 the sensor gives up, keeps it and stays idle
+    const float r0 = sensor.getR0();
+    air.noise = 400;
+    sensor.requestCalibration();
+    run(sensor, 3600000UL, [](const MQ2Sensor& s) { return s.isCalibrationFailed(); });
+    NativeBench::check(sensor.isCalibrationFailed() && !sensor.isCalibrating() && sensor.getR0() == r0,
+                       "a failed recalibration keeps the last R0");
+    const uint32_t idleBefore = samplingMs;
+    for (uint32_t t = 0; t < 600000; t += LOOP_MS) {
+        sensor.update(0, 21.5F, 47.0F);
+        if (sensor.isSampling()) samplingMs += LOOP_MS;
+        delay(LOOP_MS);
+    }
+    NativeBench::check(!sensor.isCalibrating() && samplingMs == idleBefore, "and then stays idle");
+
+    // Once the air settles, a request starts over
+    air.noise = 8;
+    sensor.requestCalibration();
+    run(sensor, 60000, settled);
+    NativeBench::check(settled(sensor) && !sensor.isCalibrationFailed(), "a request after the failure calibrates");
+
+    printf("unsteady air  : failed after %u attempts in %.0f s, then %.0f s of sampling per %.0f s until the air "
+           "settles (%.0f s after); with an R0 it gives up\n",
+           static_cast<unsigned>(MQ2_CALIBRATION_ATTEMPTS), failedMs / 1000.0, retrySamplingMs / 10000.0,
+           longestWaitMs / 1000.0, recoveredMs / 1000.0);
+}
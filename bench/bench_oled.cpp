@@ -0,0 +1,122 @@
+// OLED flush: bus bytes and blocking time of a sensor-tick redraw with the
+// dirty-page flush at the fast clock vs. the driver's full-frame display()
+// at the Wire default, checked against the panel model's display RAM; and
+// message text written a line at a time against the per-character original.
+
+#include <Wire.h>
+#include <cstring>
+#include "native_bench.h"
+#include "native_hal.h"
+#include "oled_display.h"
+
+namespace {
+
+constexpr size_t FRAME_BYTES = SCREEN_WIDTH * SCREEN_HEIGHT / 8;
+
+bool panelMatches(OLEDDisplay& display) {
+    return memcmp(NativeHal::oledPanelRam(), display.getFrame(), FRAME_BYTES) == 0;
+}
+
+// The previous showMessage body: cursor + print per character.
+void legacyMessage(Adafruit_SSD1306& gfx, const String& message) {
+    gfx.clearDisplay();
+    gfx.setTextSize(1);
+    int line = 0, col = 0;
+    for (size_t i = 0; i < message.length() && line < 8; ++i) {
+        char c = message.charAt(i);
+        if (c == '\n' || col > 20) {
+            line++;
+            col = 0;
+            if (c == '\n') continue;
+        }
+        gfx.setCursor(col * 6, line * 8);
+        gfx.print(c);
+        col++;
+    }
+}
+
+}  // namespace
+
+NATIVE_BENCH(oled_flush) {
+    static OLEDDisplay display;
+    if (!NativeBench::check(display.init(), "display initialises")) return;
+    NativeBench::check(Wire.getClock() == OLED_I2C_CLOCK_HZ, "bus runs at the configured fast clock");
+
+    const AirQuality quality = AirQuality::EXCELLENT;
+    display.showAirQuality(15.2F, quality, true);
+    const uint32_t fullBytes = display.getLastFlushBytes();
+    NativeBench::check(panelMatches(display), "first flush writes the whole frame");
+
+    // A day's worth of typical ticks: only the ppm digits move
+    constexpr int TICKS = 500;
+    uint64_t bytes = 0;
+    uint64_t busUs = 0;
+    bool matches = true;
+    const NativeHal::HeapStats h0 = NativeHal::heapStats();
+    for (int i = 0; i < TICKS; ++i) {
+        const float ppm = 15.0F + static_cast<float>((i * 7) % 23) * 0.1F;
+        const uint64_t b0 = NativeHal::i2cBytes();
+        const uint64_t t0 = NativeHal::nowMicros();
+        display.showAirQuality(ppm, quality, true);
+        busUs += NativeHal::nowMicros() - t0;
+        bytes += NativeHal::i2cBytes() - b0;
+        matches = matches && panelMatches(display);
+    }
+    const NativeHal::HeapStats h1 = NativeHal::heapStats();
+    NativeBench::check(matches, "the panel shows every frame exactly after an incremental flush");
+    NativeBench::check(h1.allocations == h0.allocations, "redraw and flush do not allocate");
+
+    const uint64_t b0 = NativeHal::i2cBytes();
+    display.showAirQuality(15.0F + static_cast<float>((TICKS - 1) * 7 % 23) * 0.1F, quality, true);
+    NativeBench::check(display.getLastFlushBytes() == 0 && NativeHal::i2cBytes() == b0,
+                       "an unchanged frame sends nothing");
+
+    display.showAirQuality(480.0F, AirQuality::POOR, false);
+    NativeBench::check(panelMatches(display), "a band and relay change still lands exactly");
+
+    // The driver's full-frame push at the Wire default clock
+    static Adafruit_SSD1306 legacy(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire);
+    legacy.begin(SSD1306_SWITCHCAPVCC, OLED_ADDRESS);
+    Wire.setClock(100000);
+    const uint64_t lb0 = NativeHal::i2cBytes();
+    const uint64_t lt0 = NativeHal::nowMicros();
+    legacy.display();
+    const uint64_t legacyUs = NativeHal::nowMicros() - lt0;
+    const uint64_t legacyBytes = NativeHal::i2cBytes() - lb0;
+    Wire.setClock(OLED_I2C_CLOCK_HZ);
+
+    const double tickBytes = static_cast<double>(bytes) / TICKS;
+    const double tickUs = static_cast<double>(busUs) / TICKS;
+    NativeBench::check(tickBytes * 10 < legacyBytes, "a ppm tick moves under a tenth of the full frame");
+    NativeBench::check(tickUs * 20 < legacyUs, "a ppm tick blocks under a twentieth of the full push");
+
+    printf("full frame    : %llu bus bytes, %.2f ms at 100 kHz (driver display())\n",
+           static_cast<unsigned long long>(legacyBytes), legacyUs / 1000.0);
+    printf("first flush   : %u bytes written\n", static_cast<unsigned>(fullBytes));
+    printf("ppm tick      : %.1f bus bytes, %.3f ms at %u kHz\n", tickBytes, tickUs / 1000.0,
+           static_cast<unsigned>(OLED_I2C_CLOCK_HZ / 1000));
+}
+
+NATIVE_BENCH(oled_message) {
+    static OLEDDisplay display;
+    display.init();
+    static Adafruit_SSD1306 reference(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire);
+    reference.begin(SSD1306_SWITCHCAPVCC, 0x3D);
+
+    static const char* const MESSAGES[] = {
+        "System Ready", "Window open\nVentilating", "A message long enough to wrap over several lines of the panel",
+        "\n\nblank lines", "x\ny\nz\nw\nv\nu\nt\ns\nr\nq (past the last line)", ""};
+    bool same = true;
+    for (const char* text : MESSAGES) {
+        const String message(text);
+        display.showMessage(message);
+        legacyMessage(reference, message);
+        same = same && memcmp(display.getFrame(), reference.getBuffer(), FRAME_BYTES) == 0;
+    }
+    NativeBench::check(same, "line-at-a-time text renders the same pixels");
+
+    display.showMessage(String(MESSAGES[0]));
+    display.showMessage(String(MESSAGES[1]));
+    printf("message       : %u bus bytes to switch between two short messages\n",
+           static_cast<unsigned>(display.getLastFlushBytes()));
+}
@@ -0,0 +1,197 @@
+// Core pipeline: the sample ring under a free-running producer and consumer
+// on separate host threads (every record arrives whole and in order, a full
+// ring is counted, never overwritten); and alarm latency on the virtual
+// clock while the broker connect fails over and over (3 s each), with the
+// network work on its own task as in the firmware vs. on the loop task.
+
+#include <Arduino.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "config.h"
+#include "native_bench.h"
+#include "native_hal.h"
+#include "scheduler.h"
+#include "spsc_ring.h"
+#include "telemetry_batch.h"
+
+namespace {
+
+// Every field follows from the sequence number, so a torn record shows
+TelemetrySample record(uint32_t seq) {
+    TelemetrySample s;
+    s.timestamp = seq;
+    s.ppm = seq * 0.25F;
+    s.temperature = static_cast<float>(seq % 1000);
+    s.humidity = static_cast<float>(seq % 977);
+    s.quality = static_cast<uint8_t>(seq);
+    s.flags = static_cast<uint8_t>(seq >> 8);
+    return s;
+}
+
+bool intact(const TelemetrySample& s) {
+    const TelemetrySample e = record(static_cast<uint32_t>(s.timestamp));
+    return s.ppm == e.ppm && s.temperature == e.temperature && s.humidity == e.humidity && s.quality == e.quality &&
+           s.flags == e.flags;
+}
+
+constexpr uint32_t SAMPLE_MS = 1000;
+constexpr uint32_t BROKER_RETRY_MS = 2000;
+constexpr uint32_t RUN_S = 60;
+constexpr uint32_t LEAK_AT_MS = 20500;   // Mid sampling period
+
+// One run of the pipeline: a sample job that raises the alarm and hands
+// readings over, a broker job whose connect blocks, and a publish job that
+// takes the readings off the ring.
+struct PipelineRun {
+    Scheduler* loopSide = nullptr;
+    Scheduler* networkSide = nullptr;
+    JobId sampleJob = Scheduler::NO_JOB;
+    JobId publishJob = Scheduler::NO_JOB;
+    SpscRing<TelemetrySample, 16> ring;
+    uint64_t leakUs = 0;
+    uint64_t alarmUs = 0;
+    uint32_t taken = 0;
+    uint32_t delivered = 0;
+    bool ordered = true;
+    std::atomic<bool> running{false};
+};
+
+PipelineRun* active = nullptr;
+
+void sampleJob() {
+    PipelineRun& run = *active;
+    const uint64_t now = NativeHal::nowMicros();
+    const float ppm = now >= run.leakUs ? 1500.0F : 20.0F;
+    if (ppm >= AQ_ALERT_THRESHOLD && run.alarmUs == 0) {
+        digitalWrite(LED_PIN, HIGH);
+        run.alarmUs = now;
+    }
+    run.ring.push(record(run.taken++));
+    run.networkSide->post(run.publishJob);
+}
+
+void publishJob() {
+    PipelineRun& run = *active;
+    TelemetrySample s;
+    while (run.ring.pop(s)) {
+        if (s.timestamp != run.delivered || !intact(s)) run.ordered = false;
+        ++run.delivered;
+    }
+}
+
+// PubSubClient::connect() against a broker that does not answer
+void brokerJob() { NativeHal::advanceMicros(NativeHal::costs().mqttConnectFailUs); }
+
+void networkTask(void* arg) {
+    PipelineRun& run = *static_cast<PipelineRun*>(arg);
+    while (run.running.load()) {
+        run.networkSide->runDue();
+        run.networkSide->sleep();
+    }
+}
+
+void runPipeline(PipelineRun& run, Scheduler& loopSide, Scheduler& networkSide) {
+    active = &run;
+    run.loopSide = &loopSide;
+    run.networkSide = &networkSide;
+    run.sampleJob = loopSide.add("sample", sampleJob);
+    run.publishJob = networkSide.add("publish", publishJob);
+    const JobId broker = networkSide.add("broker", brokerJob);
+    loopSide.every(run.sampleJob, SAMPLE_MS);
+    networkSide.every(broker, BROKER_RETRY_MS);
+
+    const bool split = &loopSide != &networkSide;
+    if (split) {
+        run.running = true;
+        xTaskCreatePinnedToCore(networkTask, "network", NETWORK_TASK_STACK_BYTES, &run, NETWORK_TASK_PRIORITY, nullptr,
+                                NETWORK_TASK_CORE);
+    }
+    digitalWrite(LED_PIN, LOW);
+    const uint64_t start = NativeHal::nowMicros();
+    run.leakUs = start + LEAK_AT_MS * 1000ULL;
+    while (NativeHal::nowMicros() < start + RUN_S * 1000000ULL) {
+        loopSide.runDue();
+        loopSide.sleep();
+    }
+    loopSide.cancel(run.sampleJob);
+    networkSide.cancel(broker);
+    if (split) {
+        // The network task sees the flag once its connect returns, drains
+        // the ring and ends
+        run.running = false;
+        networkSide.post(run.publishJob);
+        delay(NativeHal::costs().mqttConnectFailUs / 1000 + 1);
+    } else {
+        networkSide.runDue();
+    }
+    active = nullptr;
+}
+
+}  // namespace
+
+NATIVE_BENCH(pipeline_ring_stress) {
+    static SpscRing<TelemetrySample, 32> ring;
+    constexpr uint32_t RECORDS = 200000;
+    uint32_t received = 0;
+    uint32_t torn = 0;
+    bool ordered = true;
+
+    using Clock = std::chrono::steady_clock;
+    const auto t0 = Clock::now();
+    std::thread consumer([&] {
+        TelemetrySample s;
+        while (received < RECORDS) {
+            if (!ring.pop(s)) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (!intact(s)) ++torn;
+            if (s.timestamp != received) ordered = false;
+            ++received;
+            // Now and then the consumer stalls, as a network task would
+            if ((received & 0x3FFF) == 0) std::this_thread::yield();
+        }
+    });
+    // The producer retries a full ring, so every record crosses
+    for (uint32_t seq = 0; seq < RECORDS; ++seq) {
+        const TelemetrySample s = record(seq);
+        while (!ring.push(s)) std::this_thread::yield();
+    }
+    consumer.join();
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+
+    NativeBench::check(torn == 0, "no record is read half-written");
+    NativeBench::check(ordered, "records arrive in the order pushed");
+    NativeBench::check(ring.empty() && ring.getHighWater() <= ring.capacity(), "a full ring rejects, never overwrites");
+    printf("ring stress   : %u records across threads, %.1f ns/record, full on %u pushes, high water %u/%u\n",
+           static_cast<unsigned>(RECORDS), ns / RECORDS, static_cast<unsigned>(ring.getDropped()),
+           static_cast<unsigned>(ring.getHighWater()), static_cast<unsigned>(ring.capacity()));
+}
+
+NATIVE_BENCH(pipeline_alarm_latency) {
+    static Scheduler single;
+    static PipelineRun singleRun;
+    runPipeline(singleRun, single, single);
+
+    static Scheduler loopSide;
+    static Scheduler networkSide;
+    static PipelineRun splitRun;
+    runPipeline(splitRun, loopSide, networkSide);
+
+    const uint64_t splitLatencyUs = splitRun.alarmUs - splitRun.leakUs;
+    const uint64_t singleLatencyUs = singleRun.alarmUs - singleRun.leakUs;
+    NativeBench::check(splitRun.alarmUs != 0 && splitLatencyUs <= SAMPLE_MS * 1000ULL,
+                       "the alarm follows the next sample, whatever the broker does");
+    NativeBench::check(loopSide.getMaxLateUs(splitRun.sampleJob) < 1000, "samples stay on their deadlines");
+    NativeBench::check(splitRun.ordered && splitRun.delivered == splitRun.taken && splitRun.ring.getDropped() == 0,
+                       "every reading reaches the network task, in order");
+
+    const uint32_t connectMs = NativeHal::costs().mqttConnectFailUs / 1000;
+    printf("alarm latency : %.1f ms split, %.1f ms on one task (broker connect %u ms, sample every %u ms)\n",
+           splitLatencyUs / 1000.0, singleLatencyUs / 1000.0, static_cast<unsigned>(connectMs),
+           static_cast<unsigned>(SAMPLE_MS));
+    printf("sample late   : max %.1f ms split, %.1f ms on one task; ring high water %u\n",
+           loopSide.getMaxLateUs(splitRun.sampleJob) / 1000.0, single.getMaxLateUs(singleRun.sampleJob) / 1000.0,
+           static_cast<unsigned>(splitRun.ring.getHighWater()));
+}
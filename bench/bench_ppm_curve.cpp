@@ -0,0 +1,111 @@
+// PPM curve: compile-time table vs. the pow() formula it replaces, and the
+// MQ-2 per-gas set (every datasheet curve from one ratio) against one pow().
+
+#include <cmath>
+#include <vector>
+#include "native_bench.h"
+#include "gas_channel.h"
+#include "mq2_gases.h"
+
+namespace {
+
+using MQ2CurveTable = ConfiguredGasChannel<0>::CurveTable;
+
+float powCurve(float ratio) {
+    return MQ2_CURVE_A * powf(ratio, MQ2_CURVE_B);
+}
+
+}  // namespace
+
+NATIVE_BENCH(ppm_curve) {
+    // Ratios spanning the clamped 0-10000 ppm output range.
+    const float ratioAt10000 = std::pow(10000.0F / MQ2_CURVE_A, 1.0F / MQ2_CURVE_B);
+    constexpr int POINTS = 4096;
+    std::vector<float> ratios(POINTS);
+    for (int i = 0; i < POINTS; ++i) {
+        ratios[i] = ratioAt10000 * std::pow(200.0F, static_cast<float>(i) / (POINTS - 1));
+    }
+
+    double maxRelError = 0.0;
+    float worstRatio = 0.0F;
+    for (float r = ratioAt10000; r < ratioAt10000 * 200.0F; r *= 1.0001F) {
+        const double exact = MQ2_CURVE_A * std::pow(static_cast<double>(r), static_cast<double>(MQ2_CURVE_B));
+        const double err = std::fabs(MQ2CurveTable::eval(r) - exact) / exact;
+        if (err > maxRelError) {
+            maxRelError = err;
+            worstRatio = r;
+        }
+    }
+
+    constexpr uint32_t ITERATIONS = 4000000;
+    float sink = 0.0F;
+    const double powCycles = NativeBench::cyclesPerCall(ITERATIONS, [&](uint32_t i) {
+        sink += powCurve(ratios[i & (POINTS - 1)]);
+        NativeBench::doNotOptimize(sink);
+    });
+    const double tableCycles = NativeBench::cyclesPerCall(ITERATIONS, [&](uint32_t i) {
+        sink += MQ2CurveTable::eval(ratios[i & (POINTS - 1)]);
+        NativeBench::doNotOptimize(sink);
+    });
+
+    printf("ratio range     : %.4f .. %.2f (%.0f .. %.3f ppm)\n", ratioAt10000, ratioAt10000 * 200.0F,
+           powCurve(ratioAt10000), powCurve(ratioAt10000 * 200.0F));
+    printf("max rel. error  : %.5f%% at ratio %.4f (bound %.5f%%)\n", maxRelError * 100.0, worstRatio,
+           MQ2CurveTable::MAX_RELATIVE_ERROR * 100.0);
+    printf("powf()          : %.1f cycles/conversion\n", powCycles);
+    printf("table           : %.1f cycles/conversion (%.1fx)\n", tableCycles, powCycles / tableCycles);
+}
+
+NATIVE_BENCH(mq2_gas_set) {
+    // Clean air down to well into gas, as the calibrated Rs/R0 runs
+    constexpr int POINTS = 4096;
+    std::vector<float> ratios(POINTS);
+    for (int i = 0; i < POINTS; ++i) ratios[i] = 0.02F * std::pow(60.0F, static_cast<float>(i) / (POINTS - 1));
+
+    // Against the double-precision curves, where they are inside the clamp
+    double maxRelError = 0.0;
+    float estimates[MQ2_GAS_COUNT];
+    for (float r = 0.02F; r < 1.2F; r *= 1.0001F) {
+        MQ2_GAS_SET.eval(r, estimates);
+        for (size_t g = 0; g < MQ2_GAS_COUNT; ++g) {
+            const GasCurveSpec& curve = MQ2_GAS_CURVES[g];
+            const double exact = curve.a * std::pow(static_cast<double>(r) * MQ2_DATASHEET_CLEAN_AIR_RATIO,
+                                                    static_cast<double>(curve.b));
+            if (exact > 10000.0 || exact < 1e-3) continue;
+            const double err = std::fabs(estimates[g] - exact) / exact;
+            if (err > maxRelError) maxRelError = err;
+        }
+    }
+    MQ2_GAS_SET.eval(0.001F, estimates);
+    bool clamped = true;
+    for (float ppm : estimates) clamped = clamped && ppm == 10000.0F;
+    MQ2_GAS_SET.eval(0.0F, estimates);
+    for (float ppm : estimates) clamped = clamped && ppm == 0.0F;
+
+    // Best of five runs each, against host noise
+    constexpr uint32_t ITERATIONS = 1000000;
+    float sink = 0.0F;
+    double powCycles = 0.0;
+    double setCycles = 0.0;
+    for (int run = 0; run < 5; ++run) {
+        const double p = NativeBench::cyclesPerCall(ITERATIONS, [&](uint32_t i) {
+            sink += powCurve(ratios[i & (POINTS - 1)]);
+            NativeBench::doNotOptimize(sink);
+        });
+        const double s = NativeBench::cyclesPerCall(ITERATIONS, [&](uint32_t i) {
+            MQ2_GAS_SET.eval(ratios[i & (POINTS - 1)], estimates);
+            NativeBench::doNotOptimize(estimates);
+        });
+        if (run == 0 || p < powCycles) powCycles = p;
+        if (run == 0 || s < setCycles) setCycles = s;
+    }
+
+    NativeBench::check(maxRelError <= MQ2_GAS_SET.getMaxRelativeError() * 1.01,
+                       "every gas within the table's bound of its datasheet curve");
+    NativeBench::check(clamped, "estimates clamp to 0-10000 ppm");
+    NativeBench::check(setCycles < powCycles, "all gases together cost less than one powf()");
+    printf("gas set         : %zu gases, max rel. error %.5f%% (bound %.5f%%)\n", MQ2_GAS_COUNT, maxRelError * 100.0,
+           MQ2_GAS_SET.getMaxRelativeError() * 100.0);
+    printf("one powf()      : %.1f cycles/conversion\n", powCycles);
+    printf("all gases       : %.1f cycles/reading (%.1f per gas)\n", setCycles, setCycles / MQ2_GAS_COUNT);
+}
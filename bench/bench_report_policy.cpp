@@ -0,0 +1,121 @@
+// Report-by-exception on top of the fixed 30 s batch publish: every reading
+// still reaches the backend, a dangerous ppm jump leaves the device at once
+// instead of at the end of the window, and quiet hours cost little more than
+// the window itself.
+
+#include <WiFi.h>
+#include <cmath>
+#include "binary_telemetry.h"
+#include "iot_protocol.h"
+#include "native_bench.h"
+#include "native_hal.h"
+#include "report_policy.h"
+#include "telemetry_batch.h"
+
+namespace {
+
+constexpr uint32_t SAMPLE_MS = 5000;
+constexpr uint32_t HOUR_MS = 3600UL * 1000UL;
+constexpr uint32_t LEAK_START_MS = 3 * HOUR_MS + SAMPLE_MS;  // just after a 30 s flush
+constexpr uint32_t LEAK_END_MS = LEAK_START_MS + 10 * 60 * 1000;
+
+// Clean air with a little sensor noise, a slow temperature/humidity cycle,
+// and a gas leak that jumps from 40 to 900 ppm between two samples.
+TelemetrySample sampleAt(uint32_t t) {
+    const float noise = static_cast<float>(static_cast<int>((t / SAMPLE_MS) * 2654435761U % 31) - 15) * 0.1F;
+    float ppm = 15.0F + noise;
+    if (t >= LEAK_START_MS - 60000 && t < LEAK_START_MS) ppm = 40.0F + noise;
+    if (t >= LEAK_START_MS && t < LEAK_END_MS) ppm = 900.0F + noise * 10.0F;
+    const float phase = 6.283185F * static_cast<float>(t) / (24.0F * HOUR_MS);
+    const float temperature = 24.0F + 3.0F * std::sin(phase) + noise * 0.1F;
+    const float humidity = 50.0F + 10.0F * std::cos(phase) + noise * 0.3F;
+    const float bands[] = {AQ_THRESHOLD_EXCELLENT, AQ_THRESHOLD_GOOD, AQ_THRESHOLD_MODERATE,
+                           AQ_THRESHOLD_POOR, AQ_THRESHOLD_VERY_POOR, AQ_THRESHOLD_HAZARDOUS};
+    uint8_t quality = 0;
+    while (quality < 6 && ppm >= bands[quality]) ++quality;
+    const uint8_t flags = ppm >= AQ_ALERT_THRESHOLD * 0.8F ? BinaryTelemetry::RECORD_FLAG_ALERT : 0;
+    return {t * 1000ULL, ppm, temperature, humidity, quality,
+            static_cast<uint8_t>(flags | BinaryTelemetry::RECORD_FLAG_RELAY_ON)};
+}
+
+struct Result {
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    uint64_t readings = 0;
+    uint64_t samples = 0;
+    uint64_t quietMessages = 0;   // published outside the leak window
+    uint32_t leakLatencyMs = UINT32_MAX;
+};
+
+Result run(IoTProtocol& protocol, bool byException) {
+    Result r;
+    uint32_t t = 0;
+    uint32_t leakSeenAt = UINT32_MAX;
+    NativeHal::setPublishHook([&](const char*, const uint8_t*, size_t length) {
+        r.messages++;
+        r.bytes += length;
+        if (t < LEAK_START_MS - 60000 || t >= LEAK_END_MS + 60000) r.quietMessages++;
+        if (leakSeenAt != UINT32_MAX && r.leakLatencyMs == UINT32_MAX) r.leakLatencyMs = t - leakSeenAt;
+    });
+
+    TelemetryBatch batch;
+    ReportPolicy policy;
+    for (t = 0; t < 6 * HOUR_MS; t += SAMPLE_MS) {
+        const TelemetrySample s = sampleAt(t);
+        if (s.ppm >= 500.0F && leakSeenAt == UINT32_MAX) leakSeenAt = t;
+
+        batch.add(s);
+        r.samples++;
+        const bool reportNow = byException && policy.evaluate(s, t) != ReportReason::NONE;
+        const size_t queued = batch.size();
+        if ((reportNow && !batch.empty()) || batch.shouldFlush(millis())) {
+            batch.consume(protocol.publishSensorBatch(batch), millis());
+            r.readings += queued - batch.size();
+        }
+        delay(SAMPLE_MS);
+    }
+    r.readings += batch.size();   // Still waiting for the next window
+    NativeHal::setPublishHook(nullptr);
+    return r;
+}
+
+void print(const char* label, const Result& r) {
+    printf("%-16s: %5llu msgs, %7llu bytes, %5llu readings, %.1f msgs/h quiet, leak latency %.1f s\n", label,
+           static_cast<unsigned long long>(r.messages), static_cast<unsigned long long>(r.bytes),
+           static_cast<unsigned long long>(r.readings), r.quietMessages / 5.5,
+           r.leakLatencyMs == UINT32_MAX ? -1.0 : r.leakLatencyMs / 1000.0);
+}
+
+}  // namespace
+
+NATIVE_BENCH(report_by_exception) {
+    static IoTProtocol protocol;
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    delay(NativeHal::costs().wifiScanConnectMs);
+    protocol.init(ProtocolType::MQTT);
+    if (!NativeBench::check(WiFi.status() == WL_CONNECTED && protocol.connect(), "simulated broker connects")) {
+        return;
+    }
+
+    const Result fixed = run(protocol, false);
+    const Result exception = run(protocol, true);
+    print("fixed 30 s batch", fixed);
+    print("by exception", exception);
+
+    NativeBench::check(exception.leakLatencyMs < SAMPLE_MS, "a band crossing is published within one sample");
+    NativeBench::check(exception.readings == exception.samples && fixed.readings == fixed.samples,
+                       "every reading reaches the backend");
+    NativeBench::check(exception.quietMessages / 5.5 <=
+                           3600000.0 / MQTT_UPDATE_INTERVAL_MS + 3600000.0 / REPORT_HEARTBEAT_MS + 4,
+                       "quiet hours publish little more than the batch window");
+
+    // Slow drift adds up against the last published value.
+    ReportPolicy drift;
+    TelemetrySample s = sampleAt(0);
+    uint32_t reports = 0;
+    for (uint32_t i = 0; i < 60; ++i) {
+        s.temperature += 0.05F;
+        reports += drift.evaluate(s, i * SAMPLE_MS) != ReportReason::NONE ? 1 : 0;
+    }
+    NativeBench::check(reports >= 5, "slow drift is reported once it exceeds the dead-band");
+}
@@ -0,0 +1,211 @@
+// Scheduler: the firmware's job periods against the delay(100) loop it
+// replaced, as wakeups per minute and deadline lateness on the virtual clock;
+// a WiFi event wakes the sleeping loop when it arrives, not at the next
+// deadline; deadline order holds through reschedules and cancels; runDue()
+// and sleep() never allocate.
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "native_bench.h"
+#include "native_hal.h"
+#include "scheduler.h"
+
+namespace {
+
+constexpr uint32_t POLL_MS = 100;      // The loop's old delay()
+constexpr uint32_t DHT_READ_US = 23000;
+constexpr uint32_t RUN_MINUTES = 10;
+constexpr uint32_t TICK_MS = 30000;    // Deadline the event wake must beat
+
+struct Lateness {
+    uint32_t runs = 0;
+    uint32_t maxUs = 0;
+    uint64_t lastDueUs = 0;
+    bool ordered = true;
+};
+
+Lateness lateness[Scheduler::MAX_JOBS];
+
+void recordRun(JobId id, const char* name, uint32_t lateUs) {
+    (void)name;
+    Lateness& l = lateness[id];
+    ++l.runs;
+    if (lateUs > l.maxUs) l.maxUs = lateUs;
+}
+
+void resetLateness() {
+    for (Lateness& l : lateness) l = Lateness();
+}
+
+// The firmware's periodic jobs; the DHT read blocks for its bus frame
+void dhtRead() { NativeHal::advanceMicros(DHT_READ_US); }
+void idleJob() {}
+
+uint32_t eventRuns = 0;
+uint64_t eventUs = 0;      // When the event task delivered the event
+uint64_t eventRunUs = 0;
+void eventJob() {
+    if (eventRuns++ == 0) eventRunUs = NativeHal::nowMicros();
+}
+
+Scheduler* listening = nullptr;
+JobId eventJobId = Scheduler::NO_JOB;
+
+// Deadline order: every run's deadline, in run order, must not go backwards
+uint64_t lastDueUs = 0;
+bool inOrder = true;
+uint32_t ranMask = 0;
+
+void recordOrder(JobId id, const char* name, uint32_t lateUs) {
+    (void)name;
+    const uint64_t due = NativeHal::nowMicros() - lateUs;
+    if (due < lastDueUs) inOrder = false;
+    lastDueUs = due;
+    ranMask |= 1UL << id;
+}
+
+}  // namespace
+
+NATIVE_BENCH(scheduler_wakeups) {
+    static Scheduler scheduler;
+    // Same periods and registration order as the firmware's loop
+    const JobId dht = scheduler.add("dht", dhtRead);
+    const JobId sample = scheduler.add("sample", idleJob);
+    const JobId broker = scheduler.add("broker", idleJob);
+    const JobId display = scheduler.add("display", idleJob);
+    scheduler.every(dht, 2000);
+    scheduler.every(sample, 5000);
+    scheduler.every(broker, 2000);
+    scheduler.every(display, 10000);
+
+    resetLateness();
+    Scheduler::setRunHook(recordRun);
+    const uint64_t start = NativeHal::nowMicros();
+    const uint64_t end = start + RUN_MINUTES * 60ULL * 1000000ULL;
+    const NativeHal::HeapStats h0 = NativeHal::heapStats();
+    uint64_t worstPassUs = 0;
+    while (NativeHal::nowMicros() < end) {
+        const uint64_t t0 = NativeHal::nowMicros();
+        scheduler.runDue();
+        const uint64_t took = NativeHal::nowMicros() - t0;
+        if (took > worstPassUs) worstPassUs = took;
+        scheduler.sleep();
+    }
+    const NativeHal::HeapStats h1 = NativeHal::heapStats();
+    Scheduler::setRunHook(nullptr);
+
+    const double minutes = (NativeHal::nowMicros() - start) / 60e6;
+    const double perMinute = scheduler.getWakeups() / minutes;
+    NativeBench::check(h1.allocations == h0.allocations, "runDue() and sleep() never allocate");
+    // One grid point either way, depending on where the window falls
+    const auto nearly = [](uint32_t runs, uint32_t expected) { return runs + 1 >= expected && runs <= expected + 1; };
+    NativeBench::check(nearly(lateness[dht].runs, RUN_MINUTES * 30) && nearly(lateness[sample].runs, RUN_MINUTES * 12),
+                       "periodic jobs keep their rate");
+    // Grid points per minute: every 2 s, plus the 5 s ones that are odd
+    NativeBench::check(perMinute <= 36.5, "jobs on related periods share wakeups");
+    NativeBench::check(lateness[dht].maxUs < 1000, "the first job of a wakeup starts on its deadline");
+    NativeBench::check(lateness[broker].maxUs <= DHT_READ_US + 1000, "later jobs wait only for the ones before them");
+
+    printf("wakeups       : %.1f per minute (delay(%u) loop: %.0f), worst pass %.1f ms\n", perMinute,
+           static_cast<unsigned>(POLL_MS), 60000.0 / POLL_MS, worstPassUs / 1000.0);
+    printf("max lateness  : dht %.3f ms, sample %.3f ms, broker %.3f ms, display %.3f ms\n",
+           lateness[dht].maxUs / 1000.0, lateness[sample].maxUs / 1000.0, lateness[broker].maxUs / 1000.0,
+           lateness[display].maxUs / 1000.0);
+}
+
+NATIVE_BENCH(scheduler_event_wake) {
+    static Scheduler scheduler;
+    const JobId tick = scheduler.add("tick", idleJob);
+    eventJobId = scheduler.add("event", eventJob);
+    listening = &scheduler;
+    static bool registered = false;
+    if (!registered) {
+        // Called from the event task, as the firmware's WiFi wake is
+        WiFi.onEvent([](arduino_event_id_t event, arduino_event_info_t info) {
+            (void)event;
+            (void)info;
+            if (!listening) return;
+            if (eventUs == 0) eventUs = NativeHal::nowMicros();
+            listening->post(eventJobId);
+        });
+        registered = true;
+    }
+
+    NativeHal::setWiFiAvailable(true);
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_STA);
+    delay(POLL_MS);
+    scheduler.runDue();   // the disconnect's own event
+    scheduler.schedule(tick, TICK_MS);
+    eventRuns = 0;
+    eventUs = 0;
+    const uint64_t beganUs = NativeHal::nowMicros();
+    WiFi.begin("bench");
+    while (eventRuns == 0 && NativeHal::nowMicros() < beganUs + 20000000ULL) {
+        scheduler.runDue();
+        scheduler.sleep();
+    }
+    NativeBench::check(eventRuns > 0 && eventRunUs >= eventUs && eventRunUs - eventUs < 1000, "an event wakes the loop when it arrives");
+    NativeBench::check(scheduler.getRuns(tick) == 0, "no deadline came first");
+
+    // A post from the loop task itself is picked up without blocking
+    scheduler.post(eventJobId);
+    const uint64_t t0 = NativeHal::nowMicros();
+    scheduler.sleep();
+    NativeBench::check(NativeHal::nowMicros() == t0, "sleep() returns at once with a post pending");
+    scheduler.runDue();
+
+    printf("event wake    : %.3f ms after the event, %.1f s before the next deadline\n",
+           (eventRunUs - eventUs) / 1000.0, (beganUs + TICK_MS * 1000ULL - eventUs) / 1e6);
+    listening = nullptr;
+    scheduler.cancel(tick);
+    WiFi.disconnect(true);
+}
+
+NATIVE_BENCH(scheduler_order) {
+    static Scheduler scheduler;
+    for (size_t i = 0; i < Scheduler::MAX_JOBS; ++i) scheduler.add("job", idleJob);
+    NativeBench::check(scheduler.add("full", idleJob) == Scheduler::NO_JOB, "add() fails once full");
+
+    // Deterministic shuffle of deadlines, then cancels and reschedules
+    uint32_t seed = 12345;
+    auto next = [&seed](uint32_t range) {
+        seed = seed * 1103515245U + 12345U;
+        return (seed >> 16) % range;
+    };
+    for (JobId id = 0; id < Scheduler::MAX_JOBS; ++id) scheduler.schedule(id, 1 + next(1000));
+    uint32_t cancelled = 0;
+    for (int i = 0; i < 4; ++i) {
+        const JobId id = static_cast<JobId>(next(Scheduler::MAX_JOBS));
+        scheduler.cancel(id);
+        cancelled |= 1UL << id;
+    }
+    for (int i = 0; i < 8; ++i) {
+        const JobId id = static_cast<JobId>(next(Scheduler::MAX_JOBS));
+        scheduler.schedule(id, 1 + next(1000));
+        cancelled &= ~(1UL << id);
+    }
+
+    inOrder = true;
+    lastDueUs = 0;
+    ranMask = 0;
+    Scheduler::setRunHook(recordOrder);
+    auto armed = [] {
+        for (JobId id = 0; id < Scheduler::MAX_JOBS; ++id) {
+            if (scheduler.isScheduled(id)) return true;
+        }
+        return false;
+    };
+    while (armed()) {
+        scheduler.runDue();
+        scheduler.sleep();
+    }
+    Scheduler::setRunHook(nullptr);
+
+    bool allRun = true;
+    for (JobId id = 0; id < Scheduler::MAX_JOBS; ++id) {
+        if (!(cancelled & (1UL << id)) && scheduler.getRuns(id) != 1) allRun = false;
+    }
+    NativeBench::check(inOrder, "jobs run in deadline order");
+    NativeBench::check(allRun && (ranMask & cancelled) == 0, "one-shots run once, cancelled jobs never");
+}
@@ -0,0 +1,126 @@
+// Smoothing filters: step response and noise of StreamingWindow filters vs.
+// the legacy MQ2Sensor::applySmoothing (10-sample ring + 30% adaptive blend).
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include "native_bench.h"
+#include "streaming_window.h"
+
+namespace {
+
+// Verbatim behaviour of the pre-StreamingWindow MQ2Sensor::applySmoothing.
+class LegacySmoother {
+private:
+    static constexpr int SAMPLES = 10;
+    float readings[SAMPLES] = {0};
+    int readIndex = 0;
+    float total = 0.0F;
+    bool initialized = false;
+
+public:
+    float apply(float current) {
+        total -= readings[readIndex];
+        readings[readIndex] = current;
+        total += readings[readIndex];
+        readIndex = (readIndex + 1) % SAMPLES;
+        if (!initialized) {
+            if (readIndex == 0) initialized = true;
+            return current;
+        }
+        const float average = total / SAMPLES;
+        const float diff = std::fabs(current - average);
+        return (diff > average * 0.3F) ? (average * 0.3F + current * 0.7F) : average;
+    }
+};
+
+struct Trace {
+    const char* name;
+    std::vector<float> ppm;
+    int stepAt;
+    float before;
+    float after;
+};
+
+// Clean-air baseline with ADC-like noise, a single-sample spike, then a step.
+Trace makeTrace(const char* name, float before, float after, float noise, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> n(0.0F, noise);
+    Trace t{name, {}, 200, before, after};
+    for (int i = 0; i < 400; ++i) {
+        float v = (i < t.stepAt ? before : after) * (1.0F + n(rng));
+        if (i == 120) v = before * 8.0F;  // isolated spike
+        t.ppm.push_back(v);
+    }
+    return t;
+}
+
+struct Result {
+    int latency90;    // samples after the step to reach 90% of it
+    float noise;      // stddev of output over the settled pre-step region
+    float spike;      // peak output deviation caused by the spike, ppm
+};
+
+template <typename Filter>
+Result measure(const Trace& t, Filter&& filter) {
+    std::vector<float> out;
+    for (float v : t.ppm) out.push_back(filter(v));
+
+    Result r{-1, 0.0F, 0.0F};
+    const float target = t.before + 0.9F * (t.after - t.before);
+    for (int i = t.stepAt; i < static_cast<int>(out.size()); ++i) {
+        if ((t.after > t.before) ? out[i] >= target : out[i] <= target) {
+            r.latency90 = i - t.stepAt;
+            break;
+        }
+    }
+    double sum = 0.0, sq = 0.0;
+    int n = 0;
+    for (int i = 30; i < 110; ++i, ++n) {
+        sum += out[i];
+        sq += out[i] * out[i];
+    }
+    const double mean = sum / n;
+    r.noise = static_cast<float>(std::sqrt(std::max(0.0, sq / n - mean * mean)));
+    for (int i = 120; i < 140; ++i) r.spike = std::max(r.spike, std::fabs(out[i] - t.before));
+    return r;
+}
+
+void report(const char* label, const Result& r) {
+    printf("  %-22s latency90 %3d samples  noise %7.3f ppm  spike %8.2f ppm\n", label, r.latency90, r.noise, r.spike);
+}
+
+}  // namespace
+
+NATIVE_BENCH(smoothing_step_response) {
+    const Trace traces[] = {
+        makeTrace("clean->leak 15->900", 15.0F, 900.0F, 0.05F, 1),
+        makeTrace("clean->mild 15->60", 15.0F, 60.0F, 0.05F, 2),
+        makeTrace("leak->clean 900->15", 900.0F, 15.0F, 0.05F, 3),
+    };
+    const SmoothingFilter filters[] = {SmoothingFilter::MOVING_AVERAGE, SmoothingFilter::EWMA,
+                                       SmoothingFilter::MEDIAN, SmoothingFilter::ADAPTIVE};
+    const char* names[] = {"moving average (N=10)", "ewma (a=0.3)", "median (5)", "adaptive (30%)"};
+
+    for (const Trace& t : traces) {
+        printf("%s\n", t.name);
+        LegacySmoother legacy;
+        report("legacy applySmoothing", measure(t, [&](float v) { return legacy.apply(v); }));
+        for (size_t f = 0; f < 4; ++f) {
+            StreamingWindow<float, 10> window;
+            report(names[f], measure(t, [&](float v) {
+                window.push(v);
+                return window.filtered(filters[f]);
+            }));
+        }
+    }
+
+    StreamingWindow<float, 10> window;
+    float sink = 0.0F;
+    const double cycles = NativeBench::cyclesPerCall(2000000, [&](uint32_t i) {
+        window.push(static_cast<float>(i & 1023));
+        sink += window.filtered(SmoothingFilter::ADAPTIVE) + window.variance() + window.max();
+        NativeBench::doNotOptimize(sink);
+    });
+    printf("push + stats    : %.1f cycles/sample\n", cycles);
+}
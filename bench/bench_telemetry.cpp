@@ -0,0 +1,315 @@
+// Telemetry frames: JsonWriter into the preallocated TX buffer vs. the
+// DynamicJsonDocument + String path it replaces, the binary frame, and batch
+// delivery across broker outages. Also checks that IoTProtocol publishing
+// performs no heap allocation in either payload format.
+
+#include <ArduinoJson.h>
+#include <WiFi.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "binary_telemetry.h"
+#include "iot_protocol.h"
+#include "json_writer.h"
+#include "native_bench.h"
+#include "native_hal.h"
+
+namespace {
+
+struct Sample {
+    float ppm;
+    const char* quality;
+    bool relay;
+    float temperature;
+    float humidity;
+    uint32_t timestamp;
+};
+
+// The pre-JsonWriter serialization from IoTProtocol::publishSensorData.
+size_t legacyFrame(const Sample& s, String& json) {
+    DynamicJsonDocument doc(512);
+    doc["device_id"] = "esp32_01";
+    doc["ppm"] = s.ppm;
+    doc["quality"] = String(s.quality);
+    doc["relay_state"] = s.relay ? "ON" : "OFF";
+    doc["temperature"] = s.temperature;
+    doc["humidity"] = s.humidity;
+    doc["timestamp"] = s.timestamp;
+    json = String();
+    serializeJson(doc, json);
+    return json.length();
+}
+
+size_t writerFrame(const Sample& s, char* buffer, size_t capacity) {
+    JsonWriter frame(buffer, capacity);
+    frame.beginObject();
+    frame.add("device_id", DEVICE_ID);
+    frame.add("ppm", s.ppm, 2);
+    frame.add("quality", s.quality);
+    frame.add("relay_state", s.relay ? "ON" : "OFF");
+    frame.add("temperature", s.temperature, 1);
+    frame.add("humidity", s.humidity, 1);
+    frame.add("timestamp", s.timestamp);
+    frame.endObject();
+    return frame.ok() ? frame.size() : 0;
+}
+
+size_t binaryFrame(const Sample& s, uint8_t* buffer, size_t capacity) {
+    BinaryTelemetry::SensorFrame f;
+    f.sequence = static_cast<uint16_t>(s.timestamp);
+    f.timestamp = s.timestamp;
+    f.ppm = s.ppm;
+    f.temperature = s.temperature;
+    f.humidity = s.humidity;
+    f.quality = BinaryTelemetry::qualityIndex(s.quality);
+    f.relayOn = s.relay;
+    return BinaryTelemetry::encode(f, buffer, capacity);
+}
+
+Sample sampleAt(uint32_t i) {
+    static const char* const QUALITIES[] = {"Excellent", "Good", "Moderate", "Poor"};
+    return {15.0F + static_cast<float>(i % 997) * 0.37F, QUALITIES[i & 3], (i & 1) != 0,
+            -5.25F + static_cast<float>(i % 50), 35.5F + static_cast<float>(i % 40), i * 30000U};
+}
+
+}  // namespace
+
+NATIVE_BENCH(telemetry_frame) {
+    char buffer[TELEMETRY_TX_BUFFER_SIZE];
+
+    // Output must parse and carry the same values.
+    bool parsed = true;
+    for (uint32_t i = 0; i < 1000 && parsed; ++i) {
+        const Sample s = sampleAt(i);
+        const size_t n = writerFrame(s, buffer, sizeof(buffer));
+        DynamicJsonDocument doc(512);
+        parsed = n > 0 && !deserializeJson(doc, buffer, n) &&
+                 std::fabs(doc["ppm"].as<float>() - s.ppm) <= 0.0051F &&
+                 std::fabs(doc["temperature"].as<float>() - s.temperature) <= 0.051F &&
+                 std::fabs(doc["humidity"].as<float>() - s.humidity) <= 0.051F &&
+                 doc["quality"] == s.quality && doc["timestamp"].as<uint32_t>() == s.timestamp;
+    }
+    NativeBench::check(parsed, "JsonWriter frame round-trips through deserializeJson");
+
+    char tiny[32];
+    NativeBench::check(writerFrame(sampleAt(0), tiny, sizeof(tiny)) == 0, "overflowing frame is rejected");
+
+    constexpr uint32_t ITERATIONS = 200000;
+    String json;
+    size_t sink = 0;
+    NativeHal::HeapStats h0 = NativeHal::heapStats();
+    const double legacyCycles = NativeBench::cyclesPerCall(ITERATIONS, [&](uint32_t i) {
+        sink += legacyFrame(sampleAt(i), json);
+        NativeBench::doNotOptimize(sink);
+    });
+    NativeHal::HeapStats h1 = NativeHal::heapStats();
+    const double legacyAllocs = static_cast<double>(h1.allocations - h0.allocations) / ITERATIONS;
+
+    h0 = NativeHal::heapStats();
+    const double writerCycles = NativeBench::cyclesPerCall(ITERATIONS, [&](uint32_t i) {
+        sink += writerFrame(sampleAt(i), buffer, sizeof(buffer));
+        NativeBench::doNotOptimize(sink);
+    });
+    h1 = NativeHal::heapStats();
+    const double writerAllocs = static_cast<double>(h1.allocations - h0.allocations) / ITERATIONS;
+    NativeBench::check(h1.allocations == h0.allocations, "JsonWriter frame allocates nothing");
+
+    uint8_t binary[BinaryTelemetry::SENSOR_FRAME_SIZE];
+    const double binaryCycles = NativeBench::cyclesPerCall(ITERATIONS, [&](uint32_t i) {
+        sink += binaryFrame(sampleAt(i), binary, sizeof(binary));
+        NativeBench::doNotOptimize(sink);
+    });
+
+    const Sample s = sampleAt(1);
+    const size_t jsonBytes = writerFrame(s, buffer, sizeof(buffer));
+    printf("frame           : %u bytes  %s\n", static_cast<unsigned>(jsonBytes), buffer);
+    printf("ArduinoJson     : %.0f cycles/frame, %.1f allocs/frame\n", legacyCycles, legacyAllocs);
+    printf("JsonWriter      : %.0f cycles/frame, %.1f allocs/frame (%.1fx)\n", writerCycles, writerAllocs,
+           legacyCycles / writerCycles);
+    printf("binary          : %.0f cycles/frame, %u bytes (%.0f%% of JSON)\n", binaryCycles,
+           static_cast<unsigned>(BinaryTelemetry::SENSOR_FRAME_SIZE),
+           100.0 * BinaryTelemetry::SENSOR_FRAME_SIZE / jsonBytes);
+}
+
+NATIVE_BENCH(telemetry_binary_roundtrip) {
+    using namespace BinaryTelemetry;
+    uint8_t buffer[SENSOR_FRAME_SIZE];
+
+    bool roundTrip = true;
+    for (uint32_t i = 0; i < 5000 && roundTrip; ++i) {
+        Sample s = sampleAt(i);
+        if (i % 7 == 0) s.temperature = NAN;
+        if (i % 11 == 0) s.humidity = NAN;
+        SensorFrame f;
+        roundTrip = binaryFrame(s, buffer, sizeof(buffer)) == SENSOR_FRAME_SIZE &&
+                    decode(buffer, sizeof(buffer), f) == DecodeError::NONE && f.ppm == s.ppm &&
+                    f.timestamp == s.timestamp && f.relayOn == s.relay &&
+                    !strcmp(qualityName(f.quality), s.quality) &&
+                    (std::isnan(s.temperature) ? std::isnan(f.temperature)
+                                               : std::fabs(f.temperature - s.temperature) <= 0.0051F) &&
+                    (std::isnan(s.humidity) ? std::isnan(f.humidity) : std::fabs(f.humidity - s.humidity) <= 0.0051F);
+    }
+    NativeBench::check(roundTrip, "binary sensor frame round-trips");
+
+    StatusFrame status{42, 123456, true, 0, {}};
+    uint8_t statusBuffer[STATUS_FRAME_SIZE];
+    StatusFrame decoded{};
+    NativeBench::check(encode(status, statusBuffer, sizeof(statusBuffer)) == STATUS_FRAME_SIZE &&
+                           decode(statusBuffer, sizeof(statusBuffer), decoded) == DecodeError::NONE &&
+                           decoded.sequence == 42 && decoded.timestamp == 123456 && decoded.online,
+                       "binary status frame round-trips");
+
+    StatusFrame booted{43, 5000, true, 2, {}};
+    booted.boot[0] = {static_cast<uint8_t>(BootStage::WIFI), 12000, 3093000};
+    booted.boot[1] = {static_cast<uint8_t>(BootStage::MQ2) | BOOT_SPAN_FAILED, 100, BOOT_SPAN_RUNNING};
+    uint8_t bootBuffer[STATUS_BOOT_HEADER_SIZE + 2 * BOOT_SPAN_SIZE];
+    StatusFrame bootDecoded{};
+    NativeBench::check(encode(booted, bootBuffer, sizeof(bootBuffer)) == sizeof(bootBuffer) &&
+                           decode(bootBuffer, sizeof(bootBuffer), bootDecoded) == DecodeError::NONE &&
+                           bootDecoded.bootSpans == 2 && bootDecoded.boot[0].endUs == 3093000 &&
+                           !strcmp(bootStageName(bootDecoded.boot[0].stage), "wifi") &&
+                           bootDecoded.boot[1].stage == (static_cast<uint8_t>(BootStage::MQ2) | BOOT_SPAN_FAILED) &&
+                           bootDecoded.boot[1].endUs == BOOT_SPAN_RUNNING,
+                       "status frame with boot timeline round-trips");
+    NativeBench::check(decode(bootBuffer, sizeof(bootBuffer) - 1, bootDecoded) == DecodeError::BAD_LENGTH,
+                       "truncated boot timeline rejected");
+
+    // Validator rejects corrupted frames.
+    binaryFrame(sampleAt(3), buffer, sizeof(buffer));
+    SensorFrame f;
+    uint8_t bad[SENSOR_FRAME_SIZE];
+    memcpy(bad, buffer, sizeof(bad));
+    bad[0] = '{';
+    NativeBench::check(decode(bad, sizeof(bad), f) == DecodeError::BAD_MAGIC, "bad magic rejected");
+    memcpy(bad, buffer, sizeof(bad));
+    bad[1] = VERSION + 1;
+    NativeBench::check(decode(bad, sizeof(bad), f) == DecodeError::UNSUPPORTED_VERSION, "future version rejected");
+    NativeBench::check(decode(buffer, sizeof(buffer) - 1, f) == DecodeError::BAD_LENGTH, "short frame rejected");
+    NativeBench::check(decode(statusBuffer, sizeof(statusBuffer), f) == DecodeError::UNKNOWN_SCHEMA,
+                       "status frame is not a sensor frame");
+    memcpy(bad, buffer, sizeof(bad));
+    bad[18] = QUALITY_COUNT;
+    NativeBench::check(decode(bad, sizeof(bad), f) == DecodeError::BAD_VALUE, "out-of-range quality rejected");
+
+    printf("sensor frame    : %u bytes, status frame %u bytes\n", static_cast<unsigned>(SENSOR_FRAME_SIZE),
+           static_cast<unsigned>(STATUS_FRAME_SIZE));
+}
+
+NATIVE_BENCH(telemetry_publish_allocations) {
+    static IoTProtocol protocol;
+
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    delay(NativeHal::costs().wifiScanConnectMs);
+    protocol.init(ProtocolType::MQTT);
+    if (!NativeBench::check(WiFi.status() == WL_CONNECTED && protocol.connect(), "simulated broker connects")) {
+        return;
+    }
+
+    uint64_t published = 0;
+    uint64_t bytes = 0;
+    NativeHal::setPublishHook([&](const char*, const uint8_t*, size_t length) {
+        published++;
+        bytes += length;
+    });
+
+    for (PayloadFormat format : {PayloadFormat::JSON, PayloadFormat::BINARY}) {
+        protocol.setPayloadFormat(format);
+        published = 0;
+        bytes = 0;
+
+        constexpr uint32_t PUBLISHES = 10000;
+        const NativeHal::HeapStats h0 = NativeHal::heapStats();
+        for (uint32_t i = 0; i < PUBLISHES; ++i) {
+            const Sample s = sampleAt(i);
+            const AirQuality quality = static_cast<AirQuality>(BinaryTelemetry::qualityIndex(s.quality));
+            protocol.publishSensorData(s.ppm, quality, s.relay, s.temperature, s.humidity);
+        }
+        protocol.updateDeviceStatus(true);
+        const NativeHal::HeapStats h1 = NativeHal::heapStats();
+
+        printf("%-16s: %llu of %u delivered, %.1f bytes/publish, %llu allocations\n",
+               format == PayloadFormat::JSON ? "json publishes" : "binary publishes",
+               static_cast<unsigned long long>(published), PUBLISHES + 1, static_cast<double>(bytes) / published,
+               static_cast<unsigned long long>(h1.allocations - h0.allocations));
+        NativeBench::check(published == PUBLISHES + 1, "every publish reaches the broker");
+        NativeBench::check(h1.allocations == h0.allocations, "publishing allocates nothing");
+    }
+    NativeHal::setPublishHook(nullptr);
+}
+
+NATIVE_BENCH(telemetry_batch_delivery) {
+    using namespace BinaryTelemetry;
+    static IoTProtocol protocol;
+
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    delay(NativeHal::costs().wifiScanConnectMs);
+    protocol.init(ProtocolType::MQTT);
+    if (!NativeBench::check(WiFi.status() == WL_CONNECTED && protocol.connect(), "simulated broker connects")) {
+        return;
+    }
+    protocol.setPayloadFormat(PayloadFormat::BINARY);
+
+    // Decode every published batch and collect the sample timestamps.
+    std::vector<uint32_t> delivered;
+    bool framesValid = true;
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    NativeHal::setPublishHook([&](const char*, const uint8_t* payload, size_t length) {
+        BatchHeader header;
+        SampleRecord record;
+        messages++;
+        bytes += length;
+        if (decode(payload, length, header) != DecodeError::NONE) {
+            framesValid = false;
+            return;
+        }
+        for (size_t i = 0; i < header.count; ++i) {
+            decodeRecord(payload, length, i, record);
+            delivered.push_back(record.timestamp);
+        }
+    });
+
+    // One reading every 2 s for an hour, with the broker down for 20 s
+    // (inside the ring's capacity) and later for 10 minutes (beyond it).
+    TelemetryBatch batch;
+    constexpr uint32_t SAMPLE_MS = 2000;
+    constexpr uint32_t READINGS = 1800;
+    std::vector<uint32_t> taken;
+    for (uint32_t i = 0; i < READINGS; ++i) {
+        const uint32_t now = millis();
+        const uint32_t minute = i * SAMPLE_MS / 60000;
+        NativeHal::setBrokerAvailable(!(i >= 300 && i < 310) && !(minute >= 30 && minute < 40));
+        if (!protocol.isConnectedToServer()) protocol.connect();
+
+        const Sample s = sampleAt(i);
+        batch.add({now, s.ppm, s.temperature, s.humidity, qualityIndex(s.quality),
+                   static_cast<uint8_t>(s.relay ? RECORD_FLAG_RELAY_ON : 0)});
+        taken.push_back(now);
+        if (batch.shouldFlush(now)) batch.consume(protocol.publishSensorBatch(batch), now);
+        delay(SAMPLE_MS);
+    }
+    NativeHal::setBrokerAvailable(true);
+    protocol.connect();
+    batch.consume(protocol.publishSensorBatch(batch), millis());
+    NativeHal::setPublishHook(nullptr);
+
+    // Everything not overwritten during the long outage arrives once, in order.
+    bool ordered = true;
+    for (size_t i = 1; i < delivered.size(); ++i) ordered = ordered && delivered[i] > delivered[i - 1];
+    NativeBench::check(framesValid, "published batches decode");
+    NativeBench::check(ordered, "samples arrive once, in order");
+    NativeBench::check(delivered.size() + batch.getDropped() == taken.size(), "every reading is delivered or counted as dropped");
+    bool shortOutageKept = true;
+    for (uint32_t i = 295; i < 315; ++i) {
+        shortOutageKept = shortOutageKept && std::find(delivered.begin(), delivered.end(), taken[i]) != delivered.end();
+    }
+    NativeBench::check(shortOutageKept, "readings taken during a short outage are delivered late, not lost");
+    NativeBench::check(batch.getDropped() > 0, "a long outage overflows the ring");
+
+    printf("readings        : %u taken, %u delivered, %u dropped\n", static_cast<unsigned>(taken.size()),
+           static_cast<unsigned>(delivered.size()), static_cast<unsigned>(batch.getDropped()));
+    printf("messages        : %llu (%.1f readings/message, %.1f bytes/reading)\n",
+           static_cast<unsigned long long>(messages), static_cast<double>(delivered.size()) / messages,
+           static_cast<double>(bytes) / delivered.size());
+}
@@ -0,0 +1,281 @@
+// Store-and-forward log: recovery after power loss (torn tail, stale or
+// corrupt cursor), drop-oldest at the size cap, and end-to-end delivery of
+// readings across an outage longer than the RAM batch can hold, replayed in
+// order and rate limited behind live traffic.
+
+#include <LittleFS.h>
+#include <WiFi.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "binary_telemetry.h"
+#include "iot_protocol.h"
+#include "native_bench.h"
+#include "native_hal.h"
+#include "telemetry_batch.h"
+#include "telemetry_log.h"
+
+namespace {
+
+TelemetrySample sampleAt(uint32_t i) {
+    return {i * 5000U, 15.0F + static_cast<float>(i % 97), 21.5F, 48.0F, static_cast<uint8_t>(i % 3),
+            static_cast<uint8_t>(i & BinaryTelemetry::RECORD_FLAG_RELAY_ON)};
+}
+
+void wipe(const char* dir) {
+    LittleFS.begin(true);
+    File root = LittleFS.open(dir, FILE_READ);
+    if (root && root.isDirectory()) {
+        char path[64];
+        for (File entry = root.openNextFile(); entry; entry = root.openNextFile()) {
+            snprintf(path, sizeof(path), "%s/%s", dir, entry.name());
+            entry.close();
+            LittleFS.remove(path);
+        }
+    }
+    root.close();
+    LittleFS.rmdir(dir);
+}
+
+uint32_t appendRange(TelemetryLog& log, uint32_t first, uint32_t count) {
+    TelemetrySample samples[TELEMETRY_BATCH_CAPACITY];
+    uint32_t stored = 0;
+    while (stored < count) {
+        const uint32_t n = std::min<uint32_t>(count - stored, TELEMETRY_BATCH_CAPACITY);
+        for (uint32_t i = 0; i < n; ++i) samples[i] = sampleAt(first + stored + i);
+        const size_t written = log.append(samples, n);
+        stored += written;
+        if (written < n) break;
+    }
+    return stored;
+}
+
+// Replays everything pending and returns the sample indices in replay order.
+std::vector<uint32_t> drain(TelemetryLog& log, size_t limit = SIZE_MAX) {
+    std::vector<uint32_t> seen;
+    TelemetrySample chunk[TELEMETRY_REPLAY_BATCH];
+    while (seen.size() < limit) {
+        const size_t n = log.peek(chunk, std::min(TELEMETRY_REPLAY_BATCH, limit - seen.size()));
+        if (n == 0) break;
+        for (size_t i = 0; i < n; ++i) seen.push_back(static_cast<uint32_t>(chunk[i].timestamp / 5000U));
+        log.consume(n);
+    }
+    return seen;
+}
+
+bool isSequence(const std::vector<uint32_t>& seen, uint32_t first, uint32_t count) {
+    if (seen.size() != count) return false;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (seen[i] != first + i) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+NATIVE_BENCH(telemetry_log_recovery) {
+    static const char* const DIR = "/bench_recovery";
+    wipe(DIR);
+
+    {
+        TelemetryLog log(DIR);
+        NativeBench::check(log.begin(LittleFS), "log mounts on empty flash");
+        NativeBench::check(appendRange(log, 0, 300) == 300, "300 readings appended");
+        NativeBench::check(isSequence(drain(log, 100), 0, 100), "first 100 replay in order");
+    }
+
+    // Reboot: the cursor survives, and the replayed part is not sent again.
+    {
+        TelemetryLog log(DIR);
+        log.begin(LittleFS);
+        NativeBench::check(log.pending() == 200, "cursor persists across reboot");
+        NativeBench::check(appendRange(log, 300, 20) == 20, "appends after reboot");
+    }
+
+    // Power cut mid-write: a partial record at the tail of the newest segment.
+    {
+        File root = LittleFS.open(DIR, FILE_READ);
+        std::string newest;
+        for (File entry = root.openNextFile(); entry; entry = root.openNextFile()) {
+            if (strstr(entry.name(), ".seg") && entry.name() > newest) newest = entry.name();
+        }
+        root.close();
+        newest = std::string(DIR) + "/" + newest;
+        File torn = LittleFS.open(newest.c_str(), FILE_APPEND);
+        const uint8_t garbage[9] = {0xA5, 0x5A, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
+        torn.write(garbage, sizeof(garbage));
+        torn.close();
+    }
+    {
+        TelemetryLog log(DIR);
+        log.begin(LittleFS);
+        NativeBench::check(log.pending() == 220, "torn tail is ignored, no valid reading lost");
+        NativeBench::check(appendRange(log, 320, 10) == 10, "appends after a torn tail");
+        NativeBench::check(isSequence(drain(log), 100, 230), "everything replays once, in order");
+        NativeBench::check(log.pending() == 0 && log.getDropped() == 0, "drained without drops");
+    }
+
+    // A corrupt cursor falls back to the start of the oldest segment:
+    // readings may be sent twice, never skipped.
+    {
+        TelemetryLog log(DIR);
+        log.begin(LittleFS);
+        appendRange(log, 400, 40);
+        drain(log, 10);
+        char path[64];
+        snprintf(path, sizeof(path), "%s/cursor", DIR);
+        File cursor = LittleFS.open(path, FILE_WRITE);
+        cursor.write(reinterpret_cast<const uint8_t*>("garbage!"), 8);
+        cursor.close();
+    }
+    {
+        TelemetryLog log(DIR);
+        log.begin(LittleFS);
+        NativeBench::check(isSequence(drain(log), 400, 40), "corrupt cursor replays the segment again");
+    }
+    wipe(DIR);
+}
+
+NATIVE_BENCH(telemetry_log_overflow) {
+    static const char* const DIR = "/bench_overflow";
+    wipe(DIR);
+
+    const uint32_t capacity = TELEMETRY_LOG_SEGMENT_RECORDS * TELEMETRY_LOG_MAX_SEGMENTS;
+    const uint32_t total = capacity + 3 * TELEMETRY_LOG_SEGMENT_RECORDS + 17;
+    TelemetryLog log(DIR);
+    log.begin(LittleFS);
+
+    const uint64_t t0 = NativeHal::nowMicros();
+    appendRange(log, 0, total);
+    const double usPerReading = static_cast<double>(NativeHal::nowMicros() - t0) / total;
+
+    NativeBench::check(log.pending() + log.getDropped() == total, "every reading is pending or counted as dropped");
+    NativeBench::check(log.pending() <= capacity, "log stays within its segment cap");
+    NativeBench::check(LittleFS.usedBytes() <= (TELEMETRY_LOG_MAX_SEGMENTS + 4) * 4096, "flash use is bounded");
+    const uint32_t dropped = log.getDropped();
+    const std::vector<uint32_t> seen = drain(log);
+    NativeBench::check(isSequence(seen, dropped, total - dropped), "oldest readings are the ones dropped");
+
+    printf("capacity        : %u readings in %u segments (%u KB)\n", static_cast<unsigned>(capacity),
+           static_cast<unsigned>(TELEMETRY_LOG_MAX_SEGMENTS),
+           static_cast<unsigned>(capacity * (BinaryTelemetry::recordSize(GAS_CHANNEL_COUNT) + 2) / 1024));
+    printf("overflow        : %u appended, %u dropped, %u replayed\n", static_cast<unsigned>(total),
+           static_cast<unsigned>(dropped), static_cast<unsigned>(seen.size()));
+    printf("append cost     : %.1f us/reading (flash model, 16-reading batches)\n", usPerReading);
+    wipe(DIR);
+}
+
+NATIVE_BENCH(telemetry_log_outage_replay) {
+    using namespace BinaryTelemetry;
+    static const char* const DIR = "/bench_replay";
+    static IoTProtocol protocol;
+    wipe(DIR);
+
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    delay(NativeHal::costs().wifiScanConnectMs);
+    protocol.init(ProtocolType::MQTT);
+    if (!NativeBench::check(WiFi.status() == WL_CONNECTED && protocol.connect(), "simulated broker connects")) {
+        return;
+    }
+    protocol.setPayloadFormat(PayloadFormat::BINARY);
+
+    struct Delivery {
+        uint32_t index;
+        uint32_t atMs;
+        bool replay;
+    };
+    std::vector<Delivery> delivered;
+    std::vector<uint32_t> replayMessageMs;
+    bool framesValid = true;
+    NativeHal::setPublishHook([&](const char*, const uint8_t* payload, size_t length) {
+        BatchHeader header;
+        SampleRecord record;
+        if (decode(payload, length, header) != DecodeError::NONE) {
+            framesValid = false;
+            return;
+        }
+        if (header.replay) replayMessageMs.push_back(millis());
+        for (size_t i = 0; i < header.count; ++i) {
+            decodeRecord(payload, length, i, record);
+            delivered.push_back({static_cast<uint32_t>(record.timestamp / 5000U), static_cast<uint32_t>(millis()), header.replay});
+        }
+    });
+
+    // The main loop's publish path: one reading every 5 s for two hours with
+    // the broker down for 30 minutes, far beyond the RAM batch.
+    TelemetryBatch batch;
+    TelemetryLog log(DIR);
+    log.begin(LittleFS);
+    constexpr uint32_t READINGS = 1440;
+    constexpr uint32_t OUTAGE_FIRST = 360;
+    constexpr uint32_t OUTAGE_LAST = 720;
+    uint32_t lastReplay = 0;
+    uint32_t lastRead = 0;
+    uint32_t taken = 0;
+    const uint32_t start = millis();
+    while (taken < READINGS || log.pending() > 0 || !batch.empty()) {
+        NativeHal::setBrokerAvailable(!(taken >= OUTAGE_FIRST && taken < OUTAGE_LAST));
+        if (!protocol.isConnectedToServer() && NativeHal::brokerAvailable()) protocol.connect();
+        const uint32_t now = millis();
+
+        if (taken < READINGS && now - lastRead >= 5000) {
+            lastRead = now;
+            TelemetrySample s = sampleAt(taken++);
+            batch.add(s);
+        }
+        if (batch.shouldFlush(now) || (taken == READINGS && !batch.empty())) {
+            size_t sent = protocol.publishSensorBatch(batch);
+            if (sent == 0) sent = log.append(batch.data(), batch.size());
+            batch.consume(sent, now);
+        }
+        if (log.pending() > 0 && now - lastReplay >= TELEMETRY_REPLAY_INTERVAL_MS && protocol.isConnectedToServer()) {
+            lastReplay = now;
+            TelemetrySample chunk[TELEMETRY_REPLAY_BATCH];
+            const size_t n = log.peek(chunk, TELEMETRY_REPLAY_BATCH);
+            log.consume(protocol.publishSamples(chunk, n, true));
+        }
+        delay(100);
+        if (millis() - start > 4 * 3600UL * 1000UL) break;
+    }
+    NativeHal::setPublishHook(nullptr);
+    NativeHal::setBrokerAvailable(true);
+
+    std::vector<uint32_t> indices;
+    for (const Delivery& d : delivered) indices.push_back(d.index);
+    std::vector<uint32_t> sorted = indices;
+    std::sort(sorted.begin(), sorted.end());
+    bool replayOrdered = true;
+    uint32_t lastReplayed = 0;
+    bool liveLate = false;
+    for (const Delivery& d : delivered) {
+        if (d.replay) {
+            replayOrdered = replayOrdered && d.index >= lastReplayed;
+            lastReplayed = d.index;
+        } else if (d.index >= OUTAGE_LAST + 2 && d.atMs - start > d.index * 5000U + MQTT_UPDATE_INTERVAL_MS + 5000U) {
+            liveLate = true;  // replay must not hold back live readings
+        }
+    }
+    uint32_t minReplayGap = UINT32_MAX;
+    for (size_t i = 1; i < replayMessageMs.size(); ++i) {
+        minReplayGap = std::min(minReplayGap, replayMessageMs[i] - replayMessageMs[i - 1]);
+    }
+    uint32_t replayed = 0;
+    for (const Delivery& d : delivered) replayed += d.replay ? 1 : 0;
+
+    NativeBench::check(framesValid, "published batches decode");
+    NativeBench::check(isSequence(sorted, 0, READINGS), "every reading delivered exactly once");
+    NativeBench::check(log.getDropped() == 0 && batch.getDropped() == 0, "nothing dropped");
+    NativeBench::check(replayed >= OUTAGE_LAST - OUTAGE_FIRST - TELEMETRY_BATCH_CAPACITY, "outage readings replayed");
+    NativeBench::check(replayOrdered, "replay is in order");
+    // Send times include the flash read before each message, hence the slack.
+    NativeBench::check(minReplayGap + 50 >= TELEMETRY_REPLAY_INTERVAL_MS, "replay is rate limited");
+    NativeBench::check(!liveLate, "live readings are not delayed by replay");
+
+    const uint32_t replaySpan = replayMessageMs.empty() ? 0 : replayMessageMs.back() - replayMessageMs.front();
+    printf("readings        : %u taken, %u delivered, %u replayed from flash\n", static_cast<unsigned>(READINGS),
+           static_cast<unsigned>(delivered.size()), static_cast<unsigned>(replayed));
+    printf("replay          : %u messages over %.1f s after reconnect, min gap %u ms\n",
+           static_cast<unsigned>(replayMessageMs.size()), replaySpan / 1000.0, static_cast<unsigned>(minReplayGap));
+    wipe(DIR);
+}
@@ -0,0 +1,126 @@
+// Time service: first sync after WiFi comes up, stamp accuracy against the
+// reference clock with an asymmetric path and a crystal running 40 ppm fast,
+// drift estimation across a resync, retry when the server stays silent, and
+// what update() costs the loop (virtual time and heap).
+
+#include <WiFi.h>
+#include <cmath>
+#include <cstdlib>
+#include "native_bench.h"
+#include "native_hal.h"
+#include "time_service.h"
+
+namespace {
+
+constexpr uint32_t LOOP_MS = 100;
+
+int64_t stampError(const TimeService& clock) {
+    const uint64_t mono = TimeService::monotonicUs();
+    return static_cast<int64_t>(clock.toEpochUs(mono) - NativeHal::referenceEpochMicros(mono));
+}
+
+// Runs the loop's update() cadence for ms of virtual time; returns the
+// longest time a single update() took.
+uint64_t runFor(TimeService& clock, uint32_t ms, uint32_t* syncsSeen = nullptr) {
+    uint64_t worst = 0;
+    for (uint32_t t = 0; t < ms; t += LOOP_MS) {
+        const uint64_t start = micros();
+        const bool synced = clock.update();
+        const uint64_t took = micros() - start;
+        if (took > worst) worst = took;
+        if (synced && syncsSeen) ++*syncsSeen;
+        delay(LOOP_MS);
+    }
+    return worst;
+}
+
+}  // namespace
+
+NATIVE_BENCH(time_service_sync) {
+    NativeHal::NtpServer& ntp = NativeHal::ntpServer();
+    ntp.available = true;
+    ntp.clockErrorPpm = 40.0;
+    ntp.uplinkUs = 4000;
+    ntp.downlinkUs = 14000;   // 5 ms of unavoidable asymmetry error
+    const uint32_t requests0 = ntp.requests;
+
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    delay(NativeHal::costs().wifiScanConnectMs);
+    if (!NativeBench::check(WiFi.status() == WL_CONNECTED, "simulated WiFi connects")) return;
+
+    static TimeService clock;
+    clock.begin();
+    NativeBench::check(!clock.isSynced() && clock.nowEpochUs() == 0 && clock.timestampUs(1234) == 1234,
+                       "unsynced clock reports uptime");
+
+    uint32_t completed = 0;
+    const uint64_t firstWorst = runFor(clock, 1000, &completed);
+    const int64_t firstError = stampError(clock);
+    NativeBench::check(clock.isSynced() && completed == 1 && ntp.requests == requests0 + 1,
+                       "one request, synced within a second of WiFi");
+    NativeBench::check(std::llabs(firstError) <= 6000, "first stamp within the path asymmetry");
+    NativeBench::check(firstWorst <= NativeHal::costs().dnsLookupUs + 1000,
+                       "update() never waits for the network beyond the one DNS lookup");
+
+    // An hour free-running on the first anchor: 40 ppm adds up
+    const NativeHal::HeapStats h0 = NativeHal::heapStats();
+    runFor(clock, 3600UL * 1000UL - 1000, &completed);
+    const NativeHal::HeapStats h1 = NativeHal::heapStats();
+    const int64_t beforeResync = stampError(clock);
+    runFor(clock, 1000, &completed);
+    const int64_t afterResync = stampError(clock);
+    const int32_t drift = clock.getDriftPpb();
+    NativeBench::check(h1.allocations == h0.allocations, "an hour of update() does not allocate");
+    NativeBench::check(completed == 2 && std::abs(drift - 40000) <= 500,
+                       "the resync measures the crystal error");
+
+    // Second hour with drift correction
+    const NativeHal::HeapStats h2 = NativeHal::heapStats();
+    runFor(clock, 3600UL * 1000UL - 1000, &completed);
+    const NativeHal::HeapStats h3 = NativeHal::heapStats();
+    const int64_t corrected = stampError(clock);
+    NativeBench::check(h3.allocations == h2.allocations, "a resync does not allocate");
+    NativeBench::check(std::llabs(corrected) <= 8000, "drift-corrected stamps stay within 8 ms after an hour");
+
+    uint64_t previous = clock.nowEpochUs();
+    bool monotonic = true;
+    for (int i = 0; i < 1000 && monotonic; ++i) {
+        delayMicroseconds(37);
+        const uint64_t t = clock.nowEpochUs();
+        monotonic = t >= previous;
+        previous = t;
+    }
+    NativeBench::check(monotonic, "nowEpochUs() never steps back");
+
+    printf("first sync    : %+.2f ms, round trip %.2f ms, worst update() %.2f ms\n", firstError / 1000.0,
+           clock.getLastRoundTripUs() / 1000.0, firstWorst / 1000.0);
+    printf("hour 1 (raw)  : %+.2f ms before resync, %+.2f ms after, drift %.1f ppm\n", beforeResync / 1000.0,
+           afterResync / 1000.0, drift / 1000.0);
+    printf("hour 2 (trim) : %+.2f ms before resync\n", corrected / 1000.0);
+    ntp.clockErrorPpm = 0.0;
+    ntp.uplinkUs = ntp.downlinkUs = 6000;
+}
+
+NATIVE_BENCH(time_service_retry) {
+    NativeHal::NtpServer& ntp = NativeHal::ntpServer();
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    delay(NativeHal::costs().wifiScanConnectMs);
+
+    // A silent server: every attempt times out and is retried after the
+    // retry interval, without ever holding up the loop
+    ntp.available = false;
+    static TimeService clock;
+    clock.begin();
+    const uint32_t requests0 = ntp.requests;
+    const uint64_t worst = runFor(clock, 60UL * 1000UL);
+    const uint32_t expected = 60000 / (NTP_REPLY_TIMEOUT_MS + NTP_RETRY_INTERVAL_MS) + 1;
+    NativeBench::check(!clock.isSynced() && clock.getFailures() >= expected - 1 && clock.getFailures() <= expected,
+                       "timeouts are counted and retried at the retry interval");
+    NativeBench::check(worst <= NativeHal::costs().dnsLookupUs + 1000, "a silent server never blocks the loop");
+
+    ntp.available = true;
+    runFor(clock, NTP_REPLY_TIMEOUT_MS + NTP_RETRY_INTERVAL_MS + 1000);   // the last request may still be out
+    NativeBench::check(clock.isSynced() && std::llabs(stampError(clock)) <= 1000, "sync recovers with the server");
+    printf("retry         : %u failures in 60 s, %u requests, worst update() %.2f ms\n",
+           static_cast<unsigned>(clock.getFailures()), static_cast<unsigned>(ntp.requests - requests0), worst / 1000.0);
+}
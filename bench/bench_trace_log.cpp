@@ -0,0 +1,183 @@
+// Deferred trace log: a packed record formats back to exactly what printf
+// would have printed, the cost of a log site (host cycles, virtual time
+// spent blocked on the UART) against the Serial.printf_P it replaces, the
+// drain only writing what the FIFO takes and reporting drops, and the
+// multi-producer ring with two producer threads (no record torn, lost or
+// reordered per producer).
+
+#include <Arduino.h>
+#include <cstring>
+#include <thread>
+#include "native_bench.h"
+#include "native_hal.h"
+#include "trace_log.h"
+
+namespace {
+
+char expected[160];
+char decoded[160];
+
+template <TraceEvent E, typename... Args>
+bool roundTrips(Args... args) {
+    const TraceRecord r = TraceLog::record<E>(args...);
+    TraceWire::format(r.id, r.args, r.length, decoded, sizeof(decoded));
+    snprintf(expected, sizeof(expected), TRACE_EVENT_TABLE[static_cast<size_t>(E)].format, args...);
+    if (strcmp(expected, decoded) == 0) return true;
+    printf("  mismatch: \"%s\" vs \"%s\"\n", decoded, expected);
+    return false;
+}
+
+// Producer index in the top bit, sequence below; the payload repeats it
+TraceRecord stressRecord(uint32_t producer, uint32_t seq) {
+    TraceRecord r = {};
+    r.timestampUs = producer << 31 | seq;
+    r.id = static_cast<uint16_t>(TraceEvent::LOG_FULL);
+    r.length = TraceWire::MAX_ARG_BYTES;
+    for (size_t i = 0; i < TraceWire::MAX_ARG_BYTES; ++i) r.args[i] = static_cast<uint8_t>(seq + i);
+    return r;
+}
+
+bool intact(const TraceRecord& r) {
+    const uint32_t seq = r.timestampUs & 0x7FFFFFFFUL;
+    for (size_t i = 0; i < TraceWire::MAX_ARG_BYTES; ++i) {
+        if (r.args[i] != static_cast<uint8_t>(seq + i)) return false;
+    }
+    return r.length == TraceWire::MAX_ARG_BYTES;
+}
+
+}  // namespace
+
+NATIVE_BENCH(trace_round_trip) {
+    bool same = true;
+    same &= roundTrips<TraceEvent::DHT_READING>(22.5F, 64.96F, 5);
+    same &= roundTrips<TraceEvent::PPM_READING>(1234.56F, "Moderate");
+    same &= roundTrips<TraceEvent::WIFI_CONNECTED>(3016U, uint8_t{192}, uint8_t{168}, uint8_t{1}, uint8_t{50});
+    same &= roundTrips<TraceEvent::BROKER_FAILED>(-2);
+    same &= roundTrips<TraceEvent::BROKER_BATCH>("replay", "OK", 20U, 1432U);
+    same &= roundTrips<TraceEvent::TIME_SYNCED>(12.0F, -3.25F, 7U);
+    same &= roundTrips<TraceEvent::ALERT_RAISED>(1000.0F, AQ_ALERT_THRESHOLD);
+    same &= roundTrips<TraceEvent::FRAME_TOO_BIG>();
+    NativeBench::check(same, "a decoded record reads exactly as printf would print it");
+
+    // Longer than the record holds: cut short, never written past
+    const TraceRecord r = TraceLog::record<TraceEvent::BROKER_PUBLISH>("a status string much longer than a record");
+    TraceWire::format(r.id, r.args, r.length, decoded, sizeof(decoded));
+    NativeBench::check(r.length == TraceWire::MAX_ARG_BYTES && strlen(decoded) == strlen("MQTT publish ") + r.length - 1,
+                       "a long string is truncated to the record");
+
+    static const uint8_t CHECK[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    NativeBench::check(TraceWire::crc8(CHECK, sizeof(CHECK)) == 0xF4, "CRC-8 matches the reference check value");
+    printf("round trip    : %u events, %u B record, frame %u-%u B\n", static_cast<unsigned>(TRACE_EVENT_COUNT),
+           static_cast<unsigned>(sizeof(TraceRecord)), static_cast<unsigned>(TraceWire::HEADER_SIZE + 1),
+           static_cast<unsigned>(TraceWire::MAX_FRAME_SIZE));
+}
+
+NATIVE_BENCH(trace_call_cost) {
+    static TraceLog log;
+    constexpr uint32_t LINES = 200;
+    const float ppm = 431.7F;
+    const char* quality = "Moderate";
+    NativeHal::advanceMicros(100000);   // Whatever earlier benches left in the UART FIFO
+
+    // Same line both ways
+    const uint64_t printfStartUs = NativeHal::nowMicros();
+    const double printfCycles = NativeBench::cyclesPerCall(LINES, [&](uint32_t) {
+        Serial.printf_P(PSTR("PPM: %.1f, Quality: %s\n"), ppm, quality);
+    });
+    const uint64_t printfUs = NativeHal::nowMicros() - printfStartUs;
+
+    // Writes timed in ring-sized bursts; draining between them is not
+    const NativeHal::HeapStats h0 = NativeHal::heapStats();
+    uint64_t traceCycles = 0;
+    uint64_t traceUs = 0;
+    constexpr uint32_t BURSTS = 2000;
+    for (uint32_t b = 0; b < BURSTS; ++b) {
+        const uint64_t startUs = NativeHal::nowMicros();
+        const uint64_t start = NativeBench::cycles();
+        for (uint32_t i = 0; i < TRACE_RING_SLOTS; ++i) log.write<TraceEvent::PPM_READING>(ppm, quality);
+        traceCycles += NativeBench::cycles() - start;
+        traceUs += NativeHal::nowMicros() - startUs;
+        while (log.drain(Serial)) NativeHal::advanceMicros(TRACE_DRAIN_RETRY_MS * 1000UL);
+    }
+    const NativeHal::HeapStats h1 = NativeHal::heapStats();
+    NativeBench::check(h1.allocations == h0.allocations, "logging never allocates");
+    NativeBench::check(traceUs == 0, "a log site never waits for the UART");
+    printf("call cost     : %.0f cycles TRACE vs %.0f cycles Serial.printf_P; caller blocked %.1f ms per %u lines "
+           "vs %.1f ms\n",
+           static_cast<double>(traceCycles) / (BURSTS * TRACE_RING_SLOTS), printfCycles,
+           traceUs * static_cast<double>(LINES) / (BURSTS * TRACE_RING_SLOTS) / 1000.0, static_cast<unsigned>(LINES),
+           printfUs / 1000.0);
+}
+
+NATIVE_BENCH(trace_drain) {
+    static TraceLog log;
+    constexpr uint32_t EXTRA = 6;
+    for (uint32_t i = 0; i < TRACE_RING_SLOTS + EXTRA; ++i) log.write<TraceEvent::LOG_FULL>(i);
+    NativeBench::check(log.getDropped() == EXTRA, "a full ring counts what it turns away");
+
+    NativeHal::advanceMicros(100000);
+    const uint64_t bytes0 = NativeHal::serialBytes();
+    const uint64_t start = NativeHal::nowMicros();
+    uint32_t passes = 0;
+    bool neverBlocked = true;
+    while (passes < 1000) {
+        const uint64_t before = NativeHal::nowMicros();
+        const bool more = log.drain(Serial);
+        if (NativeHal::nowMicros() != before) neverBlocked = false;
+        ++passes;
+        if (!more) break;
+        NativeHal::advanceMicros(TRACE_DRAIN_RETRY_MS * 1000UL);
+    }
+    const uint64_t elapsedUs = NativeHal::nowMicros() - start;
+    const uint64_t bytes = NativeHal::serialBytes() - bytes0;
+
+    // Every record plus one drop report, all LOG_FULL-sized (one u32)
+    const size_t frame = TraceWire::HEADER_SIZE + 4 + 1;
+    NativeBench::check(neverBlocked, "the drain only writes what the UART FIFO takes");
+    NativeBench::check(log.pendingRecords() == 0 && bytes == (TRACE_RING_SLOTS + 1) * frame,
+                       "every record goes out, with one report of the drops");
+    printf("drain         : %u records in %u passes over %.1f ms, %u B on the line\n",
+           static_cast<unsigned>(TRACE_RING_SLOTS + 1), static_cast<unsigned>(passes), elapsedUs / 1000.0,
+           static_cast<unsigned>(bytes));
+}
+
+NATIVE_BENCH(trace_ring_stress) {
+    static MpscRing<TraceRecord, TRACE_RING_SLOTS> ring;
+    constexpr uint32_t PER_PRODUCER = 50000;
+    uint32_t received = 0;
+    uint32_t torn = 0;
+    uint32_t next[2] = {0, 0};
+    bool ordered = true;
+
+    std::thread consumer([&] {
+        TraceRecord r;
+        while (received < 2 * PER_PRODUCER) {
+            if (!ring.pop(r)) {
+                std::this_thread::yield();
+                continue;
+            }
+            const uint32_t producer = r.timestampUs >> 31;
+            const uint32_t seq = r.timestampUs & 0x7FFFFFFFUL;
+            if (!intact(r)) ++torn;
+            if (seq != next[producer]) ordered = false;
+            next[producer] = seq + 1;
+            ++received;
+        }
+    });
+    auto produce = [&](uint32_t producer) {
+        for (uint32_t seq = 0; seq < PER_PRODUCER; ++seq) {
+            const TraceRecord r = stressRecord(producer, seq);
+            while (!ring.push(r)) std::this_thread::yield();
+        }
+    };
+    std::thread second(produce, 1);
+    produce(0);
+    second.join();
+    consumer.join();
+
+    NativeBench::check(torn == 0, "no record is read half-written");
+    NativeBench::check(ordered && next[0] == PER_PRODUCER && next[1] == PER_PRODUCER,
+                       "each producer's records all arrive, in order");
+    printf("ring stress   : 2 x %u records, full on %u pushes\n", static_cast<unsigned>(PER_PRODUCER),
+           static_cast<unsigned>(ring.getDropped()));
+}
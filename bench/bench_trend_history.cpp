@@ -0,0 +1,106 @@
+// Trend history: every column's min/max against a brute-force pass over the
+// raw readings (a day at 5 s with a one-sample spike and an outage), RAM
+// footprint, and the cost of drawing a range, which must not depend on how
+// much time it covers.
+
+#include <cmath>
+#include <vector>
+#include "native_bench.h"
+#include "native_hal.h"
+#include "oled_display.h"
+#include "trend_history.h"
+
+namespace {
+
+struct Reading {
+    uint64_t ms;
+    float ppm;
+};
+
+// Column extremes straight from the raw readings.
+bool matchesRaw(const TrendHistory& history, TrendRange range, const std::vector<Reading>& raw, uint64_t nowMs) {
+    const uint64_t span = TrendHistory::columnSpanMs(range);
+    const uint64_t newest = nowMs / span;
+    for (size_t x = 0; x < TREND_COLUMNS; ++x) {
+        const uint64_t back = TREND_COLUMNS - 1 - x;
+        float lo = INFINITY, hi = -INFINITY;
+        if (back <= newest) {
+            const uint64_t bucket = newest - back;
+            for (const Reading& r : raw) {
+                if (r.ms / span != bucket) continue;
+                lo = std::fmin(lo, r.ppm);
+                hi = std::fmax(hi, r.ppm);
+            }
+        }
+        const TrendColumn& c = history.column(range, x);
+        if (lo > hi ? !c.empty() : (c.empty() || c.min != lo || c.max != hi)) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+NATIVE_BENCH(trend_history) {
+    static TrendHistory history;
+    std::vector<Reading> raw;
+    constexpr uint64_t SAMPLE_MS = 5000;
+    constexpr uint64_t DAY_MS = 24ULL * 3600 * 1000;
+    const uint64_t start = 3 * DAY_MS + 1234;   // not on a bucket boundary
+    const uint64_t spikeMs = start + DAY_MS / 2;
+    const uint64_t outageStart = start + DAY_MS - 3 * 3600 * 1000;
+    const uint64_t outageEnd = outageStart + 40 * 60 * 1000;
+
+    for (uint64_t now = start; now < start + DAY_MS; now += SAMPLE_MS) {
+        if (now >= outageStart && now < outageEnd) continue;
+        const float ppm = now == spikeMs ? 950.0F : 20.0F + 5.0F * std::sin(static_cast<float>(now) * 1e-6F);
+        raw.push_back({now, ppm});
+    }
+    const NativeHal::HeapStats h0 = NativeHal::heapStats();
+    for (const Reading& r : raw) history.add(r.ms, r.ppm);
+    const NativeHal::HeapStats h1 = NativeHal::heapStats();
+    const uint64_t last = raw.back().ms;
+
+    NativeBench::check(h1.allocations == h0.allocations, "adding readings does not allocate");
+    NativeBench::check(matchesRaw(history, TrendRange::HOUR, raw, last), "hour columns hold the exact min/max");
+    NativeBench::check(matchesRaw(history, TrendRange::DAY, raw, last), "day columns hold the exact min/max");
+    float lo = 0.0F, hi = 0.0F;
+    NativeBench::check(history.bounds(TrendRange::DAY, lo, hi) && hi == 950.0F,
+                       "a single-sample spike survives 135:1 decimation");
+
+    // An idle stretch ages the hour range out entirely
+    history.advanceTo(last + 2 * 3600 * 1000);
+    NativeBench::check(!history.bounds(TrendRange::HOUR, lo, hi) && history.bounds(TrendRange::DAY, lo, hi),
+                       "time without readings leaves empty columns");
+    history.add(last + 2 * 3600 * 1000, 30.0F);
+
+    // Drawing: one pass over the columns, same cost for an hour or a day
+    static OLEDDisplay display;
+    display.init();
+    const NativeHal::HeapStats h2 = NativeHal::heapStats();
+    const double hourCycles = NativeBench::cyclesPerCall(2000, [&](uint32_t) {
+        NativeBench::doNotOptimize(history.bounds(TrendRange::HOUR, lo, hi));
+        for (size_t x = 0; x < TREND_COLUMNS; ++x) NativeBench::doNotOptimize(history.column(TrendRange::HOUR, x));
+    });
+    const double dayCycles = NativeBench::cyclesPerCall(2000, [&](uint32_t) {
+        NativeBench::doNotOptimize(history.bounds(TrendRange::DAY, lo, hi));
+        for (size_t x = 0; x < TREND_COLUMNS; ++x) NativeBench::doNotOptimize(history.column(TrendRange::DAY, x));
+    });
+    const uint64_t t0 = NativeHal::nowMicros();
+    display.showTrend(history, TrendRange::DAY, 30.0F);
+    const uint64_t switchUs = NativeHal::nowMicros() - t0;
+    const uint32_t switchBytes = display.getLastFlushBytes();
+    const double renderCycles = NativeBench::cyclesPerCall(500, [&](uint32_t) {
+        display.showTrend(history, TrendRange::DAY, 30.0F);
+    });
+    const NativeHal::HeapStats h3 = NativeHal::heapStats();
+    NativeBench::check(h3.allocations == h2.allocations, "drawing the trend does not allocate");
+    NativeBench::check(sizeof(TrendHistory) <= 2 * TREND_COLUMNS * sizeof(TrendColumn) + 64,
+                       "footprint is the column buckets plus a few words");
+
+    printf("footprint     : %zu B for %zu columns x 2 ranges (%.0f min / %.0f h)\n", sizeof(TrendHistory),
+           TREND_COLUMNS, TREND_COLUMNS * TREND_HOUR_COLUMN_MS / 60000.0, TREND_COLUMNS * TREND_DAY_COLUMN_MS / 3.6e6);
+    printf("column scan   : %.0f cycles hour vs %.0f day (%zu readings behind the day)\n", hourCycles, dayCycles,
+           raw.size());
+    printf("trend screen  : %.0f cycles draw + flush; switching to it sends %u bytes (%.1f ms)\n", renderCycles,
+           static_cast<unsigned>(switchBytes), switchUs / 1000.0);
+}
@@ -0,0 +1,164 @@
+// WiFi manager: cold boot (full scan) against a reboot with the AP cached in
+// NVS (fast connect), an AP that moved channel (fast attempt fails over to a
+// scan and the cache is rewritten), and an AP outage: jittered exponential
+// backoff, bounded retry rate, update() never blocking or allocating, and
+// recovery once the AP is back.
+
+#include <WiFi.h>
+#include <vector>
+#include "config.h"
+#include "native_bench.h"
+#include "native_hal.h"
+#include "wifi_manager.h"
+
+namespace {
+
+constexpr uint32_t LOOP_MS = 100;
+
+struct RunResult {
+    uint64_t worstUpdateUs = 0;
+    uint32_t elapsedMs = 0;
+};
+
+// Runs the loop's update() cadence until the link is up or limitMs passes.
+RunResult runUntilConnected(WiFiManager& wifi, uint32_t limitMs) {
+    RunResult result;
+    const uint32_t start = millis();
+    while (millis() - start < limitMs) {
+        const uint64_t t0 = micros();
+        const bool up = wifi.update();
+        const uint64_t took = micros() - t0;
+        if (took > result.worstUpdateUs) result.worstUpdateUs = took;
+        if (up) break;
+        delay(LOOP_MS);
+    }
+    result.elapsedMs = millis() - start;
+    return result;
+}
+
+// Powers the radio down between scenarios, as a reboot would.
+void reboot() {
+    WiFi.disconnect(true);
+    delay(LOOP_MS);
+}
+
+}  // namespace
+
+NATIVE_BENCH(wifi_fast_reconnect) {
+    NativeHal::eraseNvs();
+    NativeHal::setWiFiAvailable(true);
+    reboot();
+
+    static WiFiManager cold;
+    const uint32_t writes0 = NativeHal::nvsWrites();
+    cold.begin();
+    const RunResult first = runUntilConnected(cold, 30000);
+    NativeBench::check(cold.isConnectedToWiFi() && cold.getFastConnectCount() == 0, "cold boot connects by scanning");
+    NativeBench::check(NativeHal::nvsWrites() == writes0 + 1, "the new AP is cached once");
+
+    reboot();
+    static WiFiManager warm;
+    const uint32_t writes1 = NativeHal::nvsWrites();
+    warm.begin();
+    const RunResult second = runUntilConnected(warm, 30000);
+    NativeBench::check(warm.isConnectedToWiFi() && warm.getFastConnectCount() == 1,
+                       "reboot connects straight to the cached BSSID/channel");
+    NativeBench::check(NativeHal::nvsWrites() == writes1, "an unchanged AP is not written again");
+    NativeBench::check(second.elapsedMs * 4 < first.elapsedMs, "fast reconnect beats a scan by 4x");
+    // The one NVS commit is the only wait
+    const uint64_t budget = NativeHal::costs().nvsCommitUs + 1000;
+    NativeBench::check(first.worstUpdateUs <= budget && second.worstUpdateUs <= budget, "update() never waits on the radio");
+
+    printf("cold boot     : %u ms to IP (scan), worst update() %.2f ms\n", static_cast<unsigned>(cold.getLastConnectMs()),
+           first.worstUpdateUs / 1000.0);
+    printf("reboot        : %u ms to IP (cached AP), worst update() %.2f ms\n",
+           static_cast<unsigned>(warm.getLastConnectMs()), second.worstUpdateUs / 1000.0);
+}
+
+NATIVE_BENCH(wifi_ap_moved) {
+    static const uint8_t original[6] = {0x24, 0x0A, 0xC4, 0x12, 0x34, 0x56};
+    static const uint8_t moved[6] = {0x24, 0x0A, 0xC4, 0x65, 0x43, 0x21};
+    NativeHal::setWiFiAvailable(true);
+    reboot();
+
+    // Cache the original AP, then replace it
+    static WiFiManager before;
+    before.begin();
+    runUntilConnected(before, 30000);
+    reboot();
+    NativeHal::setWiFiAccessPoint(moved, 11);
+
+    static WiFiManager after;
+    const uint32_t writes0 = NativeHal::nvsWrites();
+    after.begin();
+    const RunResult run = runUntilConnected(after, 30000);
+    NativeBench::check(after.isConnectedToWiFi() && after.getFastConnectCount() == 0 && after.getFailedAttempts() == 1,
+                       "a stale cache costs one failed fast attempt, then a scan");
+    NativeBench::check(run.elapsedMs < NativeHal::costs().wifiScanConnectMs + WIFI_FAST_CONNECT_TIMEOUT_MS,
+                       "the fallback scan starts without a backoff wait");
+    NativeBench::check(NativeHal::nvsWrites() == writes0 + 1 && WiFi.channel() == 11, "the cache follows the AP");
+    printf("AP moved      : %u ms to IP (fast attempt failed, rescanned)\n", static_cast<unsigned>(after.getLastConnectMs()));
+
+    reboot();
+    NativeHal::setWiFiAccessPoint(original, 6);
+}
+
+NATIVE_BENCH(wifi_outage_backoff) {
+    NativeHal::setWiFiAvailable(true);
+    reboot();
+    static WiFiManager wifi;
+    wifi.begin();
+    runUntilConnected(wifi, 30000);
+
+    // Ten minutes without the AP: every failed scan waits within
+    // [backoff/2, backoff], backoff doubling up to the cap
+    NativeHal::setWiFiAvailable(false);
+    std::vector<uint32_t> delays;
+    delays.reserve(64);
+    uint32_t failures = wifi.getFailedAttempts();
+    uint64_t worst = 0;
+    const NativeHal::HeapStats h0 = NativeHal::heapStats();
+    for (uint32_t t = 0; t < 10 * 60 * 1000; t += LOOP_MS) {
+        const uint64_t t0 = micros();
+        wifi.update();
+        const uint64_t took = micros() - t0;
+        if (took > worst) worst = took;
+        if (wifi.getFailedAttempts() != failures && wifi.getState() == WiFiManager::State::BACKOFF) {
+            failures = wifi.getFailedAttempts();
+            if (delays.size() < delays.capacity()) delays.push_back(wifi.getRetryDelayMs());
+        }
+        delay(LOOP_MS);
+    }
+    const NativeHal::HeapStats h1 = NativeHal::heapStats();
+
+    bool inWindow = true;
+    bool jittered = false;
+    uint32_t backoff = WIFI_BACKOFF_MIN_MS;
+    for (size_t i = 0; i < delays.size(); ++i) {
+        inWindow = inWindow && delays[i] >= backoff / 2 && delays[i] <= backoff;
+        jittered = jittered || (i > 0 && delays[i] != delays[i - 1] && backoff == WIFI_BACKOFF_MAX_MS);
+        backoff = backoff * 2 > WIFI_BACKOFF_MAX_MS ? WIFI_BACKOFF_MAX_MS : backoff * 2;
+    }
+    NativeBench::check(!delays.empty() && inWindow, "retry delays stay within [backoff/2, backoff]");
+    NativeBench::check(jittered, "retries at the cap are jittered");
+    NativeBench::check(delays.size() <= 25, "an outage costs a bounded number of scans");
+    NativeBench::check(worst <= 2000, "update() never blocks during the outage");
+    NativeBench::check(h1.allocations == h0.allocations, "reconnecting does not allocate");
+
+    NativeHal::setWiFiAvailable(true);
+    const RunResult back = runUntilConnected(wifi, 2 * WIFI_BACKOFF_MAX_MS);
+    NativeBench::check(wifi.isConnectedToWiFi() && back.elapsedMs <= WIFI_BACKOFF_MAX_MS + WIFI_FAST_CONNECT_TIMEOUT_MS +
+                                                                      NativeHal::costs().wifiScanConnectMs,
+                       "the link returns within one capped backoff");
+    NativeBench::check(wifi.getRetryDelayMs() == 0, "backoff resets on connect");
+
+    printf("outage        : %u scans in 10 min, delays", static_cast<unsigned>(delays.size()));
+    for (uint32_t d : delays) printf(" %u", static_cast<unsigned>(d));
+    printf(" ms\n");
+    printf("recovery      : %u ms after the AP returned, worst update() %.2f ms\n",
+           static_cast<unsigned>(back.elapsedMs), worst / 1000.0);
+
+    // Leave the radio as the other benches expect it
+    reboot();
+    WiFi.setAutoReconnect(true);
+}
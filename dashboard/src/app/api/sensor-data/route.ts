@@ -31,14 +31,18 @@ export async function POST(request: NextRequest) {
       );
     }
 
-    // Update current reading
-    currentReading = {
+    const reading = {
       ...data,
       timestamp: data.timestamp || new Date().toISOString(),
     };
 
+    // Readings replayed from the device's outage log are history only
+    if (!data.replayed) {
+      currentReading = reading;
+    }
+
     // Add to historical data
-    sensorData.push(currentReading);
+    sensorData.push(reading);
 
     // Keep only the last 1000 readings to prevent memory issues
     if (sensorData.length > 1000) {
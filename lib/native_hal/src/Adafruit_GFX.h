@@ -0,0 +1,46 @@
+#ifndef NATIVE_ADAFRUIT_GFX_H
+#define NATIVE_ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+
+// Minimal monochrome GFX canvas: text in the classic 6x8 cell, lines,
+// rectangles and circles. Glyph bitmaps are synthesised per character, which
+// is enough for framebuffer-level measurements; they are not the real font.
+class Adafruit_GFX : public Print {
+protected:
+    int16_t canvasWidth;
+    int16_t canvasHeight;
+    int16_t cursorX = 0;
+    int16_t cursorY = 0;
+    uint8_t textSize = 1;
+    uint16_t textColor = 1;
+
+public:
+    Adafruit_GFX(int16_t w, int16_t h) : canvasWidth(w), canvasHeight(h) {}
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { fillRect(x, y, w, 1, color); }
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { fillRect(x, y, 1, h, color); }
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+    void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size);
+
+    void setCursor(int16_t x, int16_t y) { cursorX = x; cursorY = y; }
+    void setTextSize(uint8_t size) { textSize = size > 0 ? size : 1; }
+    void setTextColor(uint16_t color) { textColor = color; }
+    void setTextColor(uint16_t color, uint16_t bg) { (void)bg; textColor = color; }
+    void setTextWrap(bool wrap) { (void)wrap; }
+    int16_t getCursorX() const { return cursorX; }
+    int16_t getCursorY() const { return cursorY; }
+    int16_t width() const { return canvasWidth; }
+    int16_t height() const { return canvasHeight; }
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+};
+
+#endif
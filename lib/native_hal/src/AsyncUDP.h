@@ -0,0 +1,53 @@
+#ifndef NATIVE_ASYNCUDP_H
+#define NATIVE_ASYNCUDP_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <functional>
+
+class AsyncUDPPacket {
+private:
+    uint8_t* payload;
+    size_t size;
+    IPAddress remote;
+    uint16_t port;
+
+public:
+    AsyncUDPPacket(uint8_t* payload, size_t size, const IPAddress& remote, uint16_t port)
+        : payload(payload), size(size), remote(remote), port(port) {}
+    uint8_t* data() { return payload; }
+    size_t length() { return size; }
+    IPAddress remoteIP() { return remote; }
+    uint16_t remotePort() { return port; }
+};
+
+typedef std::function<void(AsyncUDPPacket& packet)> AuPacketHandlerFunction;
+
+// Connected UDP socket stand-in. Datagrams to port 123 are answered by the
+// NTP stand-in (NativeHal::ntpServer()); replies are delivered through
+// onPacket() at their arrival time on the virtual clock, the way the lwIP
+// task would call it on the board. Nothing is sent while WiFi is down.
+class AsyncUDP {
+private:
+    AuPacketHandlerFunction handler;
+    IPAddress remote;
+    uint16_t remotePort = 0;
+    bool isConnected = false;
+
+public:
+    AsyncUDP() = default;
+    ~AsyncUDP();
+    AsyncUDP(const AsyncUDP&) = delete;
+    AsyncUDP& operator=(const AsyncUDP&) = delete;
+
+    void onPacket(AuPacketHandlerFunction cb) { handler = cb; }
+    bool connect(const IPAddress addr, uint16_t port);
+    size_t write(const uint8_t* data, size_t len);
+    void close();
+    bool connected() const { return isConnected; }
+
+    // Called by the simulation when a datagram for this socket arrives.
+    void deliver(uint8_t* data, size_t len, const IPAddress& from, uint16_t port);
+};
+
+#endif
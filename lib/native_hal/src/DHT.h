@@ -0,0 +1,32 @@
+#ifndef NATIVE_DHT_H
+#define NATIVE_DHT_H
+
+#include <Arduino.h>
+
+#define DHT11 11
+#define DHT12 12
+#define DHT21 21
+#define DHT22 22
+
+// DHT stand-in. Like the Adafruit driver, a bus transaction happens at most
+// once per NativeHal::costs().dhtMinIntervalMs; reads inside that window
+// return the cached frame without touching the bus.
+class DHT {
+private:
+    uint8_t pin;
+    uint8_t type;
+    bool hasFrame = false;
+    uint32_t lastReadMs = 0;
+    float temperature = NAN;
+    float humidity = NAN;
+
+    void read(bool force);
+
+public:
+    DHT(uint8_t pin, uint8_t type, uint8_t count = 6) : pin(pin), type(type) { (void)count; }
+    void begin(uint8_t usec = 55) { (void)usec; }
+    float readTemperature(bool fahrenheit = false, bool force = false);
+    float readHumidity(bool force = false);
+};
+
+#endif
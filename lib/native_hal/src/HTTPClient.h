@@ -0,0 +1,23 @@
+#ifndef NATIVE_HTTPCLIENT_H
+#define NATIVE_HTTPCLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+
+// HTTP stand-in: every request fails with a refused connection.
+class HTTPClient {
+public:
+    bool begin(const String& url) { (void)url; return true; }
+    bool begin(WiFiClient& client, const String& url) { (void)client; (void)url; return true; }
+    void addHeader(const String& name, const String& value) { (void)name; (void)value; }
+    int GET() { return HTTPC_ERROR_CONNECTION_REFUSED; }
+    int POST(const String& payload) { (void)payload; return HTTPC_ERROR_CONNECTION_REFUSED; }
+    int POST(const uint8_t* payload, size_t size) { (void)payload; (void)size; return HTTPC_ERROR_CONNECTION_REFUSED; }
+    int PUT(const String& payload) { (void)payload; return HTTPC_ERROR_CONNECTION_REFUSED; }
+    String getString() { return String(); }
+    void end() {}
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+#include <Arduino.h>
+
+// NVS key/value stand-in. Entries live for the whole process (they survive a
+// new Preferences object, as NVS survives a reboot) until
+// NativeHal::eraseNvs(). Every committed write costs costs().nvsCommitUs.
+class Preferences {
+private:
+    char ns[16] = {};
+    bool opened = false;
+    bool readOnly = false;
+
+    size_t put(const char* key, const void* value, size_t length);
+    size_t get(const char* key, void* buf, size_t length) const;
+
+public:
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end() { opened = false; }
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key) const;
+
+    size_t putBytes(const char* key, const void* value, size_t length) { return put(key, value, length); }
+    size_t getBytes(const char* key, void* buf, size_t maxLength) const;
+    size_t getBytesLength(const char* key) const;
+
+    size_t putUChar(const char* key, uint8_t value) { return put(key, &value, sizeof(value)); }
+    size_t putUInt(const char* key, uint32_t value) { return put(key, &value, sizeof(value)); }
+    size_t putULong64(const char* key, uint64_t value) { return put(key, &value, sizeof(value)); }
+    size_t putFloat(const char* key, float value) { return put(key, &value, sizeof(value)); }
+
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0) const {
+        get(key, &defaultValue, sizeof(defaultValue));
+        return defaultValue;
+    }
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) const {
+        get(key, &defaultValue, sizeof(defaultValue));
+        return defaultValue;
+    }
+    uint64_t getULong64(const char* key, uint64_t defaultValue = 0) const {
+        get(key, &defaultValue, sizeof(defaultValue));
+        return defaultValue;
+    }
+    float getFloat(const char* key, float defaultValue = NAN) const {
+        get(key, &defaultValue, sizeof(defaultValue));
+        return defaultValue;
+    }
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef NATIVE_PUBSUBCLIENT_H
+#define NATIVE_PUBSUBCLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <functional>
+
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECTION_LOST -3
+#define MQTT_CONNECT_FAILED -2
+#define MQTT_DISCONNECTED -1
+#define MQTT_CONNECTED 0
+
+#define MQTT_MAX_PACKET_SIZE 256
+
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+
+// Broker stand-in: connects when WiFi is up and NativeHal::brokerAvailable()
+// holds, reports publishes through NativeHal's publish hook and delivers
+// messages queued with NativeHal::injectMqttMessage() from loop().
+class PubSubClient {
+private:
+    MQTT_CALLBACK_SIGNATURE;
+    int currentState = MQTT_DISCONNECTED;
+    uint16_t bufferSize = MQTT_MAX_PACKET_SIZE;
+    char subscribed[128] = {0};
+    uint8_t rxBuffer[1024];
+
+public:
+    explicit PubSubClient(WiFiClient& client) { (void)client; }
+
+    PubSubClient& setServer(const char* domain, uint16_t port) { (void)domain; (void)port; return *this; }
+    PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE) { this->callback = callback; return *this; }
+    PubSubClient& setKeepAlive(uint16_t keepAlive) { (void)keepAlive; return *this; }
+    PubSubClient& setSocketTimeout(uint16_t timeout) { (void)timeout; return *this; }
+    bool setBufferSize(uint16_t size) { bufferSize = size; return true; }
+    uint16_t getBufferSize() const { return bufferSize; }
+
+    bool connect(const char* id);
+    bool connect(const char* id, const char* willTopic, uint8_t willQos, bool willRetain, const char* willMessage);
+    void disconnect() { currentState = MQTT_DISCONNECTED; }
+
+    bool publish(const char* topic, const char* payload) { return publish(topic, payload, false); }
+    bool publish(const char* topic, const char* payload, bool retained);
+    bool publish(const char* topic, const uint8_t* payload, unsigned int length) { return publish(topic, payload, length, false); }
+    bool publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained);
+
+    bool subscribe(const char* topic);
+    bool loop();
+    bool connected();
+    int state() const { return currentState; }
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef NATIVE_WSTRING_H
+#define NATIVE_WSTRING_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Flash strings are ordinary RAM strings on the host.
+class __FlashStringHelper;
+
+class String {
+private:
+    std::string buffer;
+
+public:
+    String() = default;
+    String(const char* s) : buffer(s ? s : "") {}
+    String(const char* s, size_t length) : buffer(s, length) {}
+    String(const __FlashStringHelper* s) : String(reinterpret_cast<const char*>(s)) {}
+    String(const String&) = default;
+    String(String&&) noexcept = default;
+    explicit String(char c) : buffer(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10) : String(static_cast<unsigned long>(value), base) {}
+    explicit String(int value, unsigned char base = 10) : String(static_cast<long>(value), base) {}
+    explicit String(unsigned int value, unsigned char base = 10) : String(static_cast<unsigned long>(value), base) {}
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(float value, unsigned int decimalPlaces = 2) : String(static_cast<double>(value), decimalPlaces) {}
+    explicit String(double value, unsigned int decimalPlaces = 2);
+
+    String& operator=(const String&) = default;
+    String& operator=(String&&) noexcept = default;
+    String& operator=(const char* s) { buffer = s ? s : ""; return *this; }
+    String& operator=(const __FlashStringHelper* s) { return *this = reinterpret_cast<const char*>(s); }
+
+    bool reserve(unsigned int size) { buffer.reserve(size); return true; }
+    unsigned int length() const { return static_cast<unsigned int>(buffer.size()); }
+    bool isEmpty() const { return buffer.empty(); }
+    const char* c_str() const { return buffer.c_str(); }
+    char charAt(unsigned int index) const { return index < buffer.size() ? buffer[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return buffer[index]; }
+
+    bool concat(const String& s) { buffer += s.buffer; return true; }
+    bool concat(const char* s) { if (s) buffer += s; return s != nullptr; }
+    bool concat(const char* s, unsigned int length) { buffer.append(s, length); return true; }
+    bool concat(char c) { buffer += c; return true; }
+    String& operator+=(const String& s) { concat(s); return *this; }
+    String& operator+=(const char* s) { concat(s); return *this; }
+    String& operator+=(const __FlashStringHelper* s) { concat(reinterpret_cast<const char*>(s)); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+
+    bool equals(const String& s) const { return buffer == s.buffer; }
+    bool equals(const char* s) const { return s && buffer == s; }
+    bool operator==(const String& s) const { return equals(s); }
+    bool operator==(const char* s) const { return equals(s); }
+    bool operator!=(const String& s) const { return !equals(s); }
+    bool operator!=(const char* s) const { return !equals(s); }
+    bool startsWith(const String& prefix) const { return buffer.compare(0, prefix.buffer.size(), prefix.buffer) == 0; }
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const char* s, unsigned int from = 0) const;
+    String substring(unsigned int from) const { return substring(from, length()); }
+    String substring(unsigned int from, unsigned int to) const;
+    void trim();
+    void toUpperCase();
+    void toLowerCase();
+    long toInt() const { return std::strtol(buffer.c_str(), nullptr, 10); }
+    float toFloat() const { return std::strtof(buffer.c_str(), nullptr); }
+
+    friend String operator+(const String& lhs, const String& rhs) { String r(lhs); r += rhs; return r; }
+    friend String operator+(const String& lhs, const char* rhs) { String r(lhs); r += rhs; return r; }
+    friend String operator+(const char* lhs, const String& rhs) { String r(lhs); r += rhs; return r; }
+    friend String operator+(const String& lhs, char rhs) { String r(lhs); r += rhs; return r; }
+};
+
+// ArduinoJson's String adapter is specialised on this type.
+class StringSumHelper : public String {
+public:
+    using String::String;
+    StringSumHelper(const String& s) : String(s) {}
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef NATIVE_WEBSOCKETSCLIENT_H
+#define NATIVE_WEBSOCKETSCLIENT_H
+
+#include <Arduino.h>
+#include <functional>
+
+typedef enum {
+    WStype_ERROR,
+    WStype_DISCONNECTED,
+    WStype_CONNECTED,
+    WStype_TEXT,
+    WStype_BIN,
+    WStype_FRAGMENT_TEXT_START,
+    WStype_FRAGMENT_BIN_START,
+    WStype_FRAGMENT,
+    WStype_FRAGMENT_FIN,
+    WStype_PING,
+    WStype_PONG,
+} WStype_t;
+
+// WebSocket stand-in: never connects. Present so the WEBSOCKET protocol
+// branch compiles in the native build.
+class WebSocketsClient {
+public:
+    typedef std::function<void(WStype_t type, uint8_t* payload, size_t length)> WebSocketClientEvent;
+
+    void begin(const char* host, uint16_t port, const char* url = "/") { (void)host; (void)port; (void)url; }
+    void begin(const String& host, uint16_t port, const String& url = "/") { (void)host; (void)port; (void)url; }
+    void onEvent(WebSocketClientEvent cbEvent) { event = cbEvent; }
+    void loop() {}
+    bool sendTXT(const char* payload, size_t length = 0) { (void)payload; (void)length; return false; }
+    bool sendTXT(const String& payload) { return sendTXT(payload.c_str(), payload.length()); }
+    bool sendBIN(const uint8_t* payload, size_t length) { (void)payload; (void)length; return false; }
+
+private:
+    WebSocketClientEvent event;
+};
+
+#endif
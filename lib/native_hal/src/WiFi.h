@@ -0,0 +1,134 @@
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+#include <Arduino.h>
+#include <functional>
+#include <utility>
+#include <vector>
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+// Station events and payloads as delivered by the ESP32 core's event task
+typedef enum {
+    ARDUINO_EVENT_WIFI_STA_START = 2,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED = 4,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED = 5,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP = 7,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP = 8,
+    ARDUINO_EVENT_MAX = 40
+} arduino_event_id_t;
+
+typedef enum {
+    WIFI_REASON_ASSOC_LEAVE = 8,
+    WIFI_REASON_BEACON_TIMEOUT = 200,
+    WIFI_REASON_NO_AP_FOUND = 201,
+    WIFI_REASON_AUTH_FAIL = 202
+} wifi_err_reason_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t reason;
+    int8_t rssi;
+} wifi_event_sta_disconnected_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t channel;
+} wifi_event_sta_connected_t;
+
+typedef union {
+    wifi_event_sta_disconnected_t wifi_sta_disconnected;
+    wifi_event_sta_connected_t wifi_sta_connected;
+} arduino_event_info_t;
+
+typedef std::function<void(arduino_event_id_t event, arduino_event_info_t info)> WiFiEventFuncCb;
+typedef size_t wifi_event_id_t;
+
+class IPAddress {
+private:
+    uint8_t octets[4];
+
+public:
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : octets{a, b, c, d} {}
+    uint8_t operator[](int index) const { return octets[index]; }
+    bool operator==(const IPAddress& other) const {
+        return octets[0] == other.octets[0] && octets[1] == other.octets[1] && octets[2] == other.octets[2] &&
+               octets[3] == other.octets[3];
+    }
+    bool operator!=(const IPAddress& other) const { return !(*this == other); }
+    String toString() const;
+};
+
+class WiFiClient {
+public:
+    bool connected() { return false; }
+    void stop() {}
+};
+
+// Station-mode stand-in. An association attempt resolves a modelled delay
+// after begin(): a full scan, or the fast path when BSSID and channel are
+// supplied. It succeeds if NativeHal::wifiAvailable() holds and, on the fast
+// path, the AP is still at that BSSID/channel; otherwise the attempt ends
+// with a disconnect event (NO_AP_FOUND). Losing the AP while connected ends
+// the link (BEACON_TIMEOUT). Events are delivered from the virtual clock, as
+// the event task would, to the handlers registered with onEvent(). With auto
+// reconnect on (the core's default) every loss starts a new full scan.
+class WiFiClass {
+private:
+    enum class Link : uint8_t { IDLE, ASSOCIATING, CONNECTED };
+
+    wifi_mode_t currentMode = WIFI_OFF;
+    Link link = Link::IDLE;
+    bool fastPath = false;
+    char ssidName[33] = {};
+    uint8_t targetBssid[6] = {};
+    int32_t targetChannel = 0;
+    uint64_t resolveAtUs = 0;
+    uint8_t linkBssid[6] = {};
+    int32_t linkChannel = 0;
+    bool autoReconnect = true;
+    std::vector<std::pair<WiFiEventFuncCb, arduino_event_id_t>> handlers;
+
+    bool linkUp() const;
+    void startAttempt(int32_t channel, const uint8_t* bssid);
+    void fire(arduino_event_id_t event, uint8_t reason);
+
+public:
+    bool mode(wifi_mode_t mode) { currentMode = mode; return true; }
+    wifi_mode_t getMode() const { return currentMode; }
+    wl_status_t begin(const char* ssid, const char* passphrase = nullptr, int32_t channel = 0,
+                      const uint8_t* bssid = nullptr, bool connect = true);
+    wl_status_t status();
+    bool disconnect(bool wifioff = false, bool eraseap = false);
+    bool setAutoReconnect(bool enable) { autoReconnect = enable; return true; }
+    bool getAutoReconnect() const { return autoReconnect; }
+    bool persistent(bool persistent) { (void)persistent; return true; }
+    wifi_event_id_t onEvent(WiFiEventFuncCb callback, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+    IPAddress localIP();
+    int hostByName(const char* host, IPAddress& result);  // blocks for costs().dnsLookupUs
+    int8_t RSSI();
+    uint8_t* BSSID();
+    int32_t channel();
+
+    // Simulation: the next pending link event, delivered by advanceMicros()
+    bool nextEventDue(uint64_t& atUs) const;
+    void deliverEvent();
+};
+
+extern WiFiClass WiFi;
+
+#endif
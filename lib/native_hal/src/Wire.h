@@ -0,0 +1,32 @@
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include <Arduino.h>
+
+// I2C master stand-in. Every transmission is charged to the virtual clock at
+// the configured bus speed, counted by NativeHal::i2cBytes() and handed to
+// the device models (the SSD1306 panel). Like the ESP32 core, a transmission
+// holds at most I2C_BUFFER_LENGTH bytes; writes beyond that are refused.
+#define I2C_BUFFER_LENGTH 128
+
+class TwoWire {
+private:
+    uint32_t clockHz = 100000;
+    uint8_t address = 0;
+    uint8_t txBuffer[I2C_BUFFER_LENGTH];
+    size_t pending = 0;
+    bool transmitting = false;
+
+public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+    void setClock(uint32_t frequency) { clockHz = frequency; }
+    uint32_t getClock() const { return clockHz; }
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t length);
+    uint8_t endTransmission(bool sendStop = true);
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,26 @@
+#include <DHT.h>
+
+void DHT::read(bool force) {
+    const uint32_t now = millis();
+    if (!force && hasFrame && now - lastReadMs < NativeHal::costs().dhtMinIntervalMs) return;
+    NativeHal::advanceMicros(NativeHal::costs().dhtReadUs);
+    lastReadMs = now;
+    hasFrame = true;
+    temperature = NativeHal::sampleTemperature();
+    humidity = NativeHal::sampleHumidity();
+    if (type == DHT11) {
+        // DHT11 frames carry whole degrees / percent only.
+        temperature = std::round(temperature);
+        humidity = std::round(humidity);
+    }
+}
+
+float DHT::readTemperature(bool fahrenheit, bool force) {
+    read(force);
+    return fahrenheit ? temperature * 1.8F + 32.0F : temperature;
+}
+
+float DHT::readHumidity(bool force) {
+    read(force);
+    return humidity;
+}
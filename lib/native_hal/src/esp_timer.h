@@ -0,0 +1,9 @@
+#ifndef NATIVE_ESP_TIMER_H
+#define NATIVE_ESP_TIMER_H
+
+#include <cstdint>
+
+// Microseconds since boot from the virtual clock (monotonic, 64-bit).
+int64_t esp_timer_get_time();
+
+#endif
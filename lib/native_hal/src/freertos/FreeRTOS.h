@@ -0,0 +1,21 @@
+#ifndef NATIVE_FREERTOS_H
+#define NATIVE_FREERTOS_H
+
+#include <cstdint>
+
+// FreeRTOS types and constants for the native build, 1 kHz tick as on the
+// ESP32 Arduino core.
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define portTICK_PERIOD_MS 1
+#define configTICK_RATE_HZ 1000
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(ms))
+#define portYIELD_FROM_ISR(...) ((void)0)
+
+#endif
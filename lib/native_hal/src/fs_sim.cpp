@@ -0,0 +1,265 @@
+#include <FS.h>
+#include <LittleFS.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "native_hal.h"
+
+fs::LittleFSFS LittleFS;
+
+namespace {
+
+// Default ESP32 "spiffs" data partition.
+constexpr size_t PARTITION_BYTES = 0x160000;
+constexpr size_t BLOCK_BYTES = 4096;
+
+std::string& rootPath() {
+    static std::string root;
+    return root;
+}
+
+std::string hostPath(const char* path) {
+    std::string p = NativeHal::filesystemRoot();
+    if (!path || path[0] != '/') p += '/';
+    if (path) p += path;
+    return p;
+}
+
+bool isDir(const std::string& host) {
+    struct stat st;
+    return stat(host.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+size_t usedBlocks(const std::string& host) {
+    DIR* dir = opendir(host.c_str());
+    if (!dir) return 0;
+    size_t blocks = 1;
+    while (dirent* e = readdir(dir)) {
+        if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) continue;
+        const std::string child = host + "/" + e->d_name;
+        struct stat st;
+        if (stat(child.c_str(), &st) != 0) continue;
+        blocks += S_ISDIR(st.st_mode) ? usedBlocks(child)
+                                      : (static_cast<size_t>(st.st_size) + BLOCK_BYTES - 1) / BLOCK_BYTES;
+    }
+    closedir(dir);
+    return blocks;
+}
+
+void removeTree(const std::string& host, bool keepRoot) {
+    DIR* dir = opendir(host.c_str());
+    if (!dir) return;
+    while (dirent* e = readdir(dir)) {
+        if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) continue;
+        const std::string child = host + "/" + e->d_name;
+        if (isDir(child)) {
+            removeTree(child, false);
+        } else {
+            unlink(child.c_str());
+        }
+    }
+    closedir(dir);
+    if (!keepRoot) ::rmdir(host.c_str());
+}
+
+}  // namespace
+
+namespace NativeHal {
+
+void setFilesystemRoot(const char* path) { rootPath() = path ? path : ""; }
+
+const char* filesystemRoot() {
+    std::string& root = rootPath();
+    if (root.empty()) {
+        char tmpl[] = "/tmp/native_fs_XXXXXX";
+        const char* dir = mkdtemp(tmpl);
+        root = dir ? dir : ".";
+        if (dir) atexit([] { removeTree(rootPath(), false); });
+    }
+    return root.c_str();
+}
+
+void noteFlashOp() { advanceMicros(costs().flashOpUs); }
+
+void noteFlashWrite(size_t bytes) {
+    advanceMicros((static_cast<uint64_t>(bytes) * costs().flashWriteNsPerByte + 999) / 1000);
+}
+
+}  // namespace NativeHal
+
+// ============================================================================
+// File
+// ============================================================================
+namespace fs {
+
+struct FileImpl {
+    std::string path;
+    std::string hostPath;
+    FILE* file = nullptr;
+    DIR* dir = nullptr;
+
+    ~FileImpl() {
+        if (file) fclose(file);
+        if (dir) closedir(dir);
+    }
+};
+
+size_t File::write(uint8_t c) { return write(&c, 1); }
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    if (!impl || !impl->file) return 0;
+    const size_t n = fwrite(buffer, 1, size, impl->file);
+    NativeHal::noteFlashWrite(n);
+    return n;
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    if (!impl || !impl->file) return 0;
+    return fread(buffer, 1, size, impl->file);
+}
+
+int File::available() {
+    if (!impl || !impl->file) return 0;
+    return static_cast<int>(size() - position());
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!impl || !impl->file) return false;
+    const int whence = mode == SeekCur ? SEEK_CUR : mode == SeekEnd ? SEEK_END : SEEK_SET;
+    return fseek(impl->file, static_cast<long>(pos), whence) == 0;
+}
+
+size_t File::position() const {
+    if (!impl || !impl->file) return 0;
+    const long pos = ftell(impl->file);
+    return pos < 0 ? 0 : static_cast<size_t>(pos);
+}
+
+size_t File::size() const {
+    if (!impl || !impl->file) return 0;
+    fflush(impl->file);
+    struct stat st;
+    return fstat(fileno(impl->file), &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+}
+
+void File::flush() {
+    if (impl && impl->file) fflush(impl->file);
+}
+
+void File::close() { impl.reset(); }
+
+const char* File::name() const {
+    if (!impl) return nullptr;
+    const size_t slash = impl->path.rfind('/');
+    return impl->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+const char* File::path() const { return impl ? impl->path.c_str() : nullptr; }
+
+bool File::isDirectory() const { return impl && impl->dir; }
+
+File File::openNextFile(const char* mode) {
+    if (!impl || !impl->dir) return File();
+    while (dirent* e = readdir(impl->dir)) {
+        if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) continue;
+        std::string child = impl->path;
+        if (child.empty() || child.back() != '/') child += '/';
+        child += e->d_name;
+        return LittleFS.open(child.c_str(), mode);
+    }
+    return File();
+}
+
+void File::rewindDirectory() {
+    if (impl && impl->dir) rewinddir(impl->dir);
+}
+
+File::operator bool() const { return impl && (impl->file || impl->dir); }
+
+// ============================================================================
+// FS
+// ============================================================================
+File FS::open(const char* path, const char* mode, bool create) {
+    (void)create;
+    if (!mounted || !path) return File();
+    NativeHal::noteFlashOp();
+
+    auto impl = std::make_shared<FileImpl>();
+    impl->path = path;
+    impl->hostPath = hostPath(path);
+    if (isDir(impl->hostPath)) {
+        impl->dir = opendir(impl->hostPath.c_str());
+    } else {
+        std::string hostMode = mode ? mode : FILE_READ;
+        hostMode += 'b';
+        impl->file = fopen(impl->hostPath.c_str(), hostMode.c_str());
+    }
+    if (!impl->file && !impl->dir) return File();
+    return File(impl);
+}
+
+bool FS::exists(const char* path) {
+    if (!mounted) return false;
+    struct stat st;
+    return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+    if (!mounted) return false;
+    NativeHal::noteFlashOp();
+    return unlink(hostPath(path).c_str()) == 0;
+}
+
+// Atomic replace, as LittleFS guarantees.
+bool FS::rename(const char* from, const char* to) {
+    if (!mounted) return false;
+    NativeHal::noteFlashOp();
+    return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+    if (!mounted) return false;
+    NativeHal::noteFlashOp();
+    return ::mkdir(hostPath(path).c_str(), 0755) == 0 || isDir(hostPath(path));
+}
+
+bool FS::rmdir(const char* path) {
+    if (!mounted) return false;
+    NativeHal::noteFlashOp();
+    return ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+// ============================================================================
+// LittleFS
+// ============================================================================
+bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    (void)basePath;
+    (void)maxOpenFiles;
+    (void)partitionLabel;
+    const char* root = NativeHal::filesystemRoot();
+    if (!isDir(root) && (!formatOnFail || ::mkdir(root, 0755) != 0)) return false;
+    NativeHal::noteFlashOp();
+    mounted = true;
+    return true;
+}
+
+bool LittleFSFS::format() {
+    removeTree(NativeHal::filesystemRoot(), true);
+    NativeHal::advanceMicros(static_cast<uint64_t>(NativeHal::costs().flashOpUs) * 50);
+    return true;
+}
+
+size_t LittleFSFS::totalBytes() { return PARTITION_BYTES; }
+
+size_t LittleFSFS::usedBytes() { return mounted ? usedBlocks(NativeHal::filesystemRoot()) * BLOCK_BYTES : 0; }
+
+}  // namespace fs
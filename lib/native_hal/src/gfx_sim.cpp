@@ -0,0 +1,148 @@
+#include <Adafruit_SSD1306.h>
+#include <cstdlib>
+
+void Adafruit_GFX::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    const int16_t dx = std::abs(x1 - x0);
+    const int16_t dy = -std::abs(y1 - y0);
+    const int16_t sx = x0 < x1 ? 1 : -1;
+    const int16_t sy = y0 < y1 ? 1 : -1;
+    int16_t err = dx + dy;
+    for (;;) {
+        drawPixel(x0, y0, color);
+        if (x0 == x1 && y0 == y1) break;
+        const int16_t e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+}
+
+void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y, h, color);
+    drawFastVLine(x + w - 1, y, h, color);
+}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    for (int16_t j = y; j < y + h; ++j) {
+        for (int16_t i = x; i < x + w; ++i) drawPixel(i, j, color);
+    }
+}
+
+void Adafruit_GFX::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    int16_t x = r, y = 0, err = 1 - r;
+    while (x >= y) {
+        drawPixel(x0 + x, y0 + y, color); drawPixel(x0 - x, y0 + y, color);
+        drawPixel(x0 + x, y0 - y, color); drawPixel(x0 - x, y0 - y, color);
+        drawPixel(x0 + y, y0 + x, color); drawPixel(x0 - y, y0 + x, color);
+        drawPixel(x0 + y, y0 - x, color); drawPixel(x0 - y, y0 - x, color);
+        ++y;
+        if (err < 0) {
+            err += 2 * y + 1;
+        } else {
+            --x;
+            err += 2 * (y - x) + 1;
+        }
+    }
+}
+
+void Adafruit_GFX::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    for (int16_t dy = -r; dy <= r; ++dy) {
+        for (int16_t dx = -r; dx <= r; ++dx) {
+            if (dx * dx + dy * dy <= r * r) drawPixel(x0 + dx, y0 + dy, color);
+        }
+    }
+}
+
+void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size) {
+    (void)bg;
+    if (c == ' ') return;
+    for (int col = 0; col < 5; ++col) {
+        // Deterministic per-character pattern standing in for the 5x7 font.
+        const uint8_t bits = static_cast<uint8_t>((c * 37u + col * 101u) ^ (c >> 1)) | 0x01;
+        for (int row = 0; row < 7; ++row) {
+            if (bits & (1 << row)) fillRect(x + col * size, y + row * size, size, size, color);
+        }
+    }
+}
+
+size_t Adafruit_GFX::write(uint8_t c) {
+    if (c == '\n') {
+        cursorX = 0;
+        cursorY += 8 * textSize;
+    } else if (c != '\r') {
+        drawChar(cursorX, cursorY, c, textColor, 0, textSize);
+        cursorX += 6 * textSize;
+    }
+    return 1;
+}
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* twi, int8_t rstPin,
+                                   uint32_t clkDuring, uint32_t clkAfter)
+    : Adafruit_GFX(w, h), wire(twi) {
+    (void)rstPin;
+    (void)clkDuring;
+    (void)clkAfter;
+}
+
+Adafruit_SSD1306::~Adafruit_SSD1306() { free(buffer); }
+
+bool Adafruit_SSD1306::begin(uint8_t switchvcc, uint8_t i2caddr, bool reset, bool periphBegin) {
+    (void)switchvcc;
+    (void)reset;
+    (void)periphBegin;
+    if (!buffer) buffer = static_cast<uint8_t*>(malloc(canvasWidth * ((canvasHeight + 7) / 8)));
+    if (!buffer) return false;
+    if (i2caddr) i2cAddress = i2caddr;
+    clearDisplay();
+    return true;
+}
+
+void Adafruit_SSD1306::ssd1306_command(uint8_t c) {
+    wire->beginTransmission(i2cAddress);
+    wire->write(static_cast<uint8_t>(0x00));
+    wire->write(c);
+    wire->endTransmission();
+}
+
+void Adafruit_SSD1306::display() {
+    if (!buffer) return;
+    static const uint8_t addressing[] = {SSD1306_PAGEADDR, 0, 0xFF, SSD1306_COLUMNADDR, 0};
+    wire->beginTransmission(i2cAddress);
+    wire->write(static_cast<uint8_t>(0x00));
+    wire->write(addressing, sizeof(addressing));
+    wire->write(static_cast<uint8_t>(canvasWidth - 1));
+    wire->endTransmission();
+
+    const size_t total = canvasWidth * ((canvasHeight + 7) / 8);
+    constexpr size_t WIRE_MAX = 32;
+    for (size_t sent = 0; sent < total;) {
+        const size_t chunk = std::min(WIRE_MAX - 1, total - sent);
+        wire->beginTransmission(i2cAddress);
+        wire->write(static_cast<uint8_t>(0x40));
+        wire->write(buffer + sent, chunk);
+        wire->endTransmission();
+        sent += chunk;
+    }
+}
+
+void Adafruit_SSD1306::clearDisplay() {
+    if (buffer) memset(buffer, 0, canvasWidth * ((canvasHeight + 7) / 8));
+}
+
+void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (!buffer || x < 0 || y < 0 || x >= canvasWidth || y >= canvasHeight) return;
+    uint8_t& cell = buffer[x + (y / 8) * canvasWidth];
+    const uint8_t bit = static_cast<uint8_t>(1 << (y & 7));
+    switch (color) {
+        case SSD1306_WHITE: cell |= bit; break;
+        case SSD1306_BLACK: cell &= static_cast<uint8_t>(~bit); break;
+        case SSD1306_INVERSE: cell ^= bit; break;
+        default: break;
+    }
+}
+
+bool Adafruit_SSD1306::getPixel(int16_t x, int16_t y) const {
+    if (!buffer || x < 0 || y < 0 || x >= canvasWidth || y >= canvasHeight) return false;
+    return buffer[x + (y / 8) * canvasWidth] & (1 << (y & 7));
+}
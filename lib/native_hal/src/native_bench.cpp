@@ -0,0 +1,62 @@
+#include "native_bench.h"
+#include <chrono>
+#include <cstring>
+#include "native_hal.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+
+struct Entry {
+    const char* name;
+    NativeBench::BenchFn fn;
+};
+
+constexpr int MAX_BENCHES = 64;
+Entry entries[MAX_BENCHES];
+int entryCount = 0;
+int failedChecks = 0;
+
+}  // namespace
+
+namespace NativeBench {
+
+Registration::Registration(const char* name, BenchFn fn) {
+    if (entryCount < MAX_BENCHES) entries[entryCount++] = {name, fn};
+}
+
+int runAll(const char* filter) {
+    // The simulation state is built on first use; its allocations must not
+    // land in the first bench that counts heap traffic
+    NativeHal::nowMicros();
+    int ran = 0;
+    for (int i = 0; i < entryCount; ++i) {
+        if (filter && !strstr(entries[i].name, filter)) continue;
+        printf("=== bench: %s ===\n", entries[i].name);
+        entries[i].fn();
+        ran++;
+    }
+    if (ran == 0) printf("no benchmark matches '%s'\n", filter ? filter : "");
+    if (failedChecks > 0) printf("%d check(s) FAILED\n", failedChecks);
+    return (ran > 0 && failedChecks == 0) ? 0 : 1;
+}
+
+bool check(bool condition, const char* what) {
+    if (!condition) {
+        printf("CHECK FAILED: %s\n", what);
+        failedChecks++;
+    }
+    return condition;
+}
+
+uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+}  // namespace NativeBench
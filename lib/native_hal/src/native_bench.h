@@ -0,0 +1,46 @@
+#ifndef NATIVE_BENCH_H
+#define NATIVE_BENCH_H
+
+#include <cstdint>
+#include <cstdio>
+
+// Host microbenchmarks for the native build. Benchmarks register themselves
+// with NATIVE_BENCH and run via `program --bench [name-substring]`.
+namespace NativeBench {
+
+using BenchFn = void (*)();
+
+struct Registration {
+    Registration(const char* name, BenchFn fn);
+};
+
+int runAll(const char* filter);
+
+// Records a failed expectation; runAll() then exits non-zero.
+bool check(bool condition, const char* what);
+
+// Host cycle counter (TSC on x86, nanoseconds elsewhere).
+uint64_t cycles();
+
+// Keeps the optimiser from discarding a benchmarked result.
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Average cycles per call of fn(i) over iterations calls.
+template <typename Fn>
+double cyclesPerCall(uint32_t iterations, Fn&& fn) {
+    const uint64_t start = cycles();
+    for (uint32_t i = 0; i < iterations; ++i) fn(i);
+    return static_cast<double>(cycles() - start) / iterations;
+}
+
+}  // namespace NativeBench
+
+#define NATIVE_BENCH(name)                                                   \
+    static void bench_##name();                                              \
+    static NativeBench::Registration bench_reg_##name(#name, bench_##name);  \
+    static void bench_##name()
+
+#endif
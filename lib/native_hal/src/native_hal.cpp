@@ -0,0 +1,645 @@
+#include "native_hal.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+
+// ============================================================================
+// Heap accounting
+// ============================================================================
+namespace {
+
+struct HeapCounters {
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    uint64_t bytesAllocated = 0;
+    uint64_t liveBytes = 0;
+    uint64_t peakLiveBytes = 0;
+};
+
+HeapCounters& heapCounters() {
+    static HeapCounters counters;
+    return counters;
+}
+
+// Every block carries its size so frees can be accounted without a map.
+constexpr size_t HEADER_BYTES = alignof(std::max_align_t);
+
+void* countedAlloc(size_t size) {
+    auto* block = static_cast<unsigned char*>(std::malloc(size + HEADER_BYTES));
+    if (!block) throw std::bad_alloc();
+    *reinterpret_cast<size_t*>(block) = size;
+    HeapCounters& c = heapCounters();
+    c.allocations++;
+    c.bytesAllocated += size;
+    c.liveBytes += size;
+    if (c.liveBytes > c.peakLiveBytes) c.peakLiveBytes = c.liveBytes;
+    return block + HEADER_BYTES;
+}
+
+void countedFree(void* ptr) {
+    if (!ptr) return;
+    auto* block = static_cast<unsigned char*>(ptr) - HEADER_BYTES;
+    HeapCounters& c = heapCounters();
+    c.frees++;
+    c.liveBytes -= *reinterpret_cast<size_t*>(block);
+    std::free(block);
+}
+
+}  // namespace
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void* ptr) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { countedFree(ptr); }
+
+// ============================================================================
+// Simulation state
+// ============================================================================
+namespace {
+
+struct MqttMessage {
+    std::string topic;
+    std::string payload;
+};
+
+struct SimState {
+    uint64_t clockUs = 0;
+    NativeHal::CostModel costs;
+    std::map<int, NativeHal::AnalogSource> analogSources;
+    std::map<int, int> pinLevels;
+    int lastAnalogPin = -1;
+    int lastAnalogValue = 0;
+    NativeHal::EnvSource temperature;
+    NativeHal::EnvSource humidity;
+    bool wifiAvailable = true;
+    bool brokerAvailable = true;
+    NativeHal::PublishHook publishHook;
+    std::deque<MqttMessage> inbound;
+    bool serialEcho = false;
+    uint64_t serialBytes = 0;
+    uint64_t uartDrainUs = 0;
+    uint64_t i2cBytes = 0;
+    bool delivering = false;
+    bool woke = false;   // A waiting task was notified while the clock advanced
+    std::mt19937 rng{1};
+};
+
+SimState& sim() {
+    static SimState state;
+    return state;
+}
+
+}  // namespace
+
+// ============================================================================
+// Tasks
+//
+// Each FreeRTOS task is a std::thread, the loop task being the main thread.
+// Exactly one of them holds the baton at a time, so the simulation state
+// needs no locks: a task runs until it blocks (delay(), a modelled cost, a
+// notification wait) and the baton passes to the task that is due first,
+// with the clock advanced to that time. A task busy in a modelled cost does
+// not hold up the others, as with one task per core on the board.
+// ============================================================================
+struct NativeTask {
+    const char* name;
+    TaskFunction_t fn;
+    void* arg;
+    uint32_t stackBytes;
+    std::condition_variable turn;
+    uint64_t readyAtUs;      // Blocked until then
+    bool waiting;            // In a notification wait, which a notify ends
+    bool finished;
+    uint32_t notifications;
+    uint64_t delayedUs;      // Clock spent in delay() or a notification wait
+
+    NativeTask(const char* name, TaskFunction_t fn, void* arg, uint32_t stackBytes)
+        : name(name)
+        , fn(fn)
+        , arg(arg)
+        , stackBytes(stackBytes)
+        , readyAtUs(0)
+        , waiting(false)
+        , finished(false)
+        , notifications(0)
+        , delayedUs(0) {}
+};
+
+namespace {
+
+constexpr size_t MAX_TASKS = 8;
+
+struct TaskSwitch {
+    std::mutex lock;
+    NativeTask* tasks[MAX_TASKS];
+    size_t count = 0;
+    NativeTask* running = nullptr;
+};
+
+NativeTask loopTask("loopTask", nullptr, nullptr, 8192);     // arduino-esp32's loop stack
+NativeTask eventTask("eventTask", nullptr, nullptr, 4096);   // Delivers WiFi events and datagrams
+thread_local NativeTask* self = &loopTask;
+
+// Never destroyed: task threads may still be parked in it at exit
+TaskSwitch& taskSwitch() {
+    alignas(TaskSwitch) static unsigned char storage[sizeof(TaskSwitch)];
+    static TaskSwitch* ts = [] {
+        TaskSwitch* t = new (storage) TaskSwitch;
+        t->tasks[t->count++] = &loopTask;
+        t->running = &loopTask;
+        return t;
+    }();
+    return *ts;
+}
+
+uint64_t readyAt(const NativeTask* task) {
+    return task->waiting && task->notifications > 0 ? 0 : task->readyAtUs;
+}
+
+// Due soonest; on a tie the task created first
+NativeTask* nextTask() {
+    TaskSwitch& ts = taskSwitch();
+    NativeTask* next = nullptr;
+    for (size_t i = 0; i < ts.count; ++i) {
+        NativeTask* task = ts.tasks[i];
+        if (!task->finished && (!next || readyAt(task) < readyAt(next))) next = task;
+    }
+    return next;
+}
+
+// Hands the baton over and, unless the caller has finished, waits for it to
+// come back
+void switchTo(NativeTask* next) {
+    TaskSwitch& ts = taskSwitch();
+    std::unique_lock<std::mutex> guard(ts.lock);
+    ts.running = next;
+    next->turn.notify_one();
+    if (self->finished) return;
+    NativeTask* const me = self;
+    me->turn.wait(guard, [&ts, me] { return ts.running == me; });
+}
+
+}  // namespace
+
+namespace NativeHal {
+
+uint64_t nowMicros() { return sim().clockUs; }
+
+namespace {
+
+// Datagrams and WiFi link events due by target are delivered first, earliest
+// first, with the clock at their due time, as the network and event tasks
+// would preempt the running task. The clock stops at the first event that
+// notified a waiting task.
+void advanceTo(uint64_t target) {
+    SimState& s = sim();
+    s.woke = false;
+    while (!s.delivering) {
+        uint64_t datagramAt = 0;
+        uint64_t wifiAt = 0;
+        const bool datagram = nextDatagramDue(datagramAt) && datagramAt <= target;
+        const bool wifi = WiFi.nextEventDue(wifiAt) && wifiAt <= target;
+        if (!datagram && !wifi) break;
+        const bool wifiFirst = wifi && (!datagram || wifiAt <= datagramAt);
+        const uint64_t due = wifiFirst ? wifiAt : datagramAt;
+        if (due > s.clockUs) s.clockUs = due;
+        s.delivering = true;
+        if (wifiFirst) {
+            WiFi.deliverEvent();
+        } else {
+            deliverNextDatagram();
+        }
+        s.delivering = false;
+        if (s.woke) return;
+    }
+    s.clockUs = target;
+}
+
+// Blocks the calling task until untilUs, or with `waiting` until it is
+// notified, running the other tasks that are due meanwhile
+void block(uint64_t untilUs, bool waiting) {
+    SimState& s = sim();
+    self->readyAtUs = untilUs;
+    self->waiting = waiting;
+    for (;;) {
+        NativeTask* next = nextTask();
+        const uint64_t at = readyAt(next);
+        if (at > s.clockUs) {
+            advanceTo(at);
+            continue;
+        }
+        if (next != self) switchTo(next);
+        break;
+    }
+    self->waiting = false;
+}
+
+}  // namespace
+
+void advanceMicros(uint64_t us) {
+    SimState& s = sim();
+    if (s.delivering) {
+        s.clockUs += us;
+        return;
+    }
+    block(s.clockUs + us, false);
+}
+
+void delayMicros(uint64_t us) {
+    self->delayedUs += us;
+    advanceMicros(us);
+}
+
+void notifyTask(NativeTask* task) {
+    task->notifications++;
+    if (task->waiting) sim().woke = true;
+}
+
+uint32_t waitNotification(bool clearOnExit, uint64_t timeoutUs) {
+    SimState& s = sim();
+    NativeTask* const task = self;
+    const uint64_t start = s.clockUs;
+    if (task->notifications == 0) block(start + timeoutUs, true);
+    task->delayedUs += s.clockUs - start;
+    const uint32_t count = task->notifications;
+    if (count > 0) task->notifications = clearOnExit ? 0 : count - 1;
+    return count;
+}
+
+void startTask(NativeTask* task) {
+    TaskSwitch& ts = taskSwitch();
+    if (ts.count >= MAX_TASKS) {
+        fprintf(stderr, "native_hal: more than %u tasks\n", static_cast<unsigned>(MAX_TASKS));
+        abort();
+    }
+    task->readyAtUs = sim().clockUs;
+    ts.tasks[ts.count++] = task;
+    std::thread([task] {
+        self = task;
+        {
+            TaskSwitch& t = taskSwitch();
+            std::unique_lock<std::mutex> guard(t.lock);
+            task->turn.wait(guard, [&t, task] { return t.running == task; });
+        }
+        task->fn(task->arg);
+        // A task function that returns is deleted, as vTaskDelete(nullptr)
+        // would be
+        task->finished = true;
+        block(UINT64_MAX, false);
+    }).detach();
+}
+
+void resetClock() {
+    SimState& s = sim();
+    s.clockUs = 0;
+    s.uartDrainUs = 0;
+    TaskSwitch& ts = taskSwitch();
+    for (size_t i = 0; i < ts.count; ++i) {
+        ts.tasks[i]->readyAtUs = 0;
+        ts.tasks[i]->delayedUs = 0;
+        ts.tasks[i]->notifications = 0;
+    }
+}
+uint64_t delayedMicros() { return self->delayedUs; }
+
+CostModel& costs() { return sim().costs; }
+
+void setAnalogSource(int pin, AnalogSource source) { sim().analogSources[pin] = std::move(source); }
+int pinLevel(int pin) { return sim().pinLevels[pin]; }
+void setPinLevel(int pin, int level) { sim().pinLevels[pin] = level; }
+
+void setTemperatureSource(EnvSource source) { sim().temperature = std::move(source); }
+void setHumiditySource(EnvSource source) { sim().humidity = std::move(source); }
+
+float sampleTemperature() {
+    const uint32_t now = static_cast<uint32_t>(nowMicros() / 1000);
+    return sim().temperature ? sim().temperature(now) : 24.0F;
+}
+
+float sampleHumidity() {
+    const uint32_t now = static_cast<uint32_t>(nowMicros() / 1000);
+    return sim().humidity ? sim().humidity(now) : 50.0F;
+}
+
+void setWiFiAvailable(bool available) { sim().wifiAvailable = available; }
+bool wifiAvailable() { return sim().wifiAvailable; }
+void setBrokerAvailable(bool available) { sim().brokerAvailable = available; }
+bool brokerAvailable() { return sim().brokerAvailable; }
+
+void setPublishHook(PublishHook hook) { sim().publishHook = std::move(hook); }
+
+void notifyPublish(const char* topic, const uint8_t* payload, size_t length) {
+    if (sim().publishHook) sim().publishHook(topic, payload, length);
+}
+
+void injectMqttMessage(const char* topic, const char* payload) {
+    sim().inbound.push_back({topic, payload});
+}
+
+bool takeMqttMessage(char* topic, size_t topicSize, uint8_t* payload, size_t payloadSize, size_t& length) {
+    if (sim().inbound.empty()) return false;
+    const MqttMessage& msg = sim().inbound.front();
+    snprintf(topic, topicSize, "%s", msg.topic.c_str());
+    length = std::min(msg.payload.size(), payloadSize);
+    memcpy(payload, msg.payload.data(), length);
+    sim().inbound.pop_front();
+    return true;
+}
+
+void setSerialEcho(bool echo) { sim().serialEcho = echo; }
+
+// UART model: bytes drain at the configured baud rate through a 128-byte TX
+// FIFO; a write only blocks once the FIFO is full, as on the ESP32.
+namespace {
+
+constexpr uint64_t UART_FIFO_BYTES = 128;
+
+uint64_t uartByteUs() { return 10ULL * 1000000ULL / sim().costs.serialBaud; }
+
+// Bytes still waiting in the TX FIFO
+uint64_t uartQueued() {
+    const SimState& s = sim();
+    return s.uartDrainUs > s.clockUs ? (s.uartDrainUs - s.clockUs) / uartByteUs() : 0;
+}
+
+}  // namespace
+
+void serialWrite(const uint8_t* data, size_t length) {
+    SimState& s = sim();
+    s.serialBytes += length;
+    if (s.serialEcho) fwrite(data, 1, length, stdout);
+
+    const uint64_t byteUs = uartByteUs();
+    const uint64_t queued = uartQueued();
+    const uint64_t drainAt = std::max(s.uartDrainUs, s.clockUs);
+    if (queued + length > UART_FIFO_BYTES) advanceMicros((queued + length - UART_FIFO_BYTES) * byteUs);
+    s.uartDrainUs = drainAt + length * byteUs;
+}
+
+size_t serialWritable() {
+    const uint64_t queued = uartQueued();
+    return queued >= UART_FIFO_BYTES ? 0 : static_cast<size_t>(UART_FIFO_BYTES - queued);
+}
+
+uint64_t serialBytes() { return sim().serialBytes; }
+
+HeapStats heapStats() {
+    const HeapCounters& c = heapCounters();
+    return {c.allocations, c.frees, c.bytesAllocated, c.liveBytes, c.peakLiveBytes};
+}
+
+void noteI2CTransfer(size_t bytes, uint32_t clockHz) {
+    sim().i2cBytes += bytes;
+    // 8 data bits + ACK per byte
+    if (clockHz > 0) advanceMicros(static_cast<uint64_t>(bytes) * 9ULL * 1000000ULL / clockHz);
+}
+
+uint64_t i2cBytes() { return sim().i2cBytes; }
+
+}  // namespace NativeHal
+
+// ============================================================================
+// Arduino core
+// ============================================================================
+HardwareSerial Serial;
+EspClass ESP;
+
+unsigned long millis() { return static_cast<unsigned long>(NativeHal::nowMicros() / 1000); }
+unsigned long micros() { return static_cast<unsigned long>(NativeHal::nowMicros()); }
+int64_t esp_timer_get_time() { return static_cast<int64_t>(NativeHal::nowMicros()); }
+void delay(uint32_t ms) { NativeHal::delayMicros(static_cast<uint64_t>(ms) * 1000); }
+void delayMicroseconds(uint32_t us) { NativeHal::delayMicros(us); }
+void yield() {}
+
+// ============================================================================
+// FreeRTOS tasks (see Tasks above)
+// ============================================================================
+namespace {
+// A wait without timeout that nothing can end would never return
+constexpr uint64_t MAX_WAIT_US = 3600ULL * 1000000ULL;
+}  // namespace
+
+// Core and priority are not modelled: every task runs as if on a core of its
+// own. The stack is the host thread's.
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackBytes, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* created, BaseType_t core) {
+    (void)priority;
+    (void)core;
+    NativeTask* task = new NativeTask(name, fn, arg, stackBytes);
+    NativeHal::startTask(task);
+    if (created) *created = task;
+    return pdPASS;
+}
+
+// Stack use is not measured on the host: the whole stack reads as free
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    return (task ? task : self)->stackBytes;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() { return sim().delivering ? &eventTask : self; }
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait) {
+    const uint64_t timeoutUs = ticksToWait == portMAX_DELAY ? MAX_WAIT_US
+                                                            : static_cast<uint64_t>(ticksToWait) * portTICK_PERIOD_MS * 1000ULL;
+    return NativeHal::waitNotification(clearCountOnExit != pdFALSE, timeoutUs);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    if (task && task != &eventTask) NativeHal::notifyTask(task);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken) {
+    xTaskNotifyGive(task);
+    if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdTRUE;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+void digitalWrite(uint8_t pin, uint8_t value) { sim().pinLevels[pin] = value ? HIGH : LOW; }
+int digitalRead(uint8_t pin) { return sim().pinLevels[pin]; }
+
+uint16_t analogRead(uint8_t pin) {
+    NativeHal::advanceMicros(sim().costs.analogReadUs);
+    auto it = sim().analogSources.find(pin);
+    if (it == sim().analogSources.end()) return 0;
+    int value = constrain(it->second(millis()), 0, 4095);
+    // The sample capacitor does not fully recharge after a channel switch
+    if (sim().lastAnalogPin >= 0 && sim().lastAnalogPin != pin) {
+        value += static_cast<int>(std::lround((sim().lastAnalogValue - value) * sim().costs.adcCarryover));
+    }
+    sim().lastAnalogPin = pin;
+    sim().lastAnalogValue = value;
+    return static_cast<uint16_t>(value);
+}
+
+long random(long max) { return max > 0 ? random(0, max) : 0; }
+
+long random(long min, long max) {
+    if (max <= min) return min;
+    std::uniform_int_distribution<long> dist(min, max - 1);
+    return dist(sim().rng);
+}
+
+void randomSeed(unsigned long seed) { sim().rng.seed(static_cast<uint32_t>(seed)); }
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    NativeHal::serialWrite(buffer, size);
+    return size;
+}
+
+int HardwareSerial::availableForWrite() { return static_cast<int>(NativeHal::serialWritable()); }
+
+uint32_t EspClass::getHeapSize() { return NativeHal::SIMULATED_HEAP_BYTES; }
+
+uint32_t EspClass::getFreeHeap() {
+    const uint64_t live = NativeHal::heapStats().liveBytes;
+    return live >= NativeHal::SIMULATED_HEAP_BYTES ? 0 : NativeHal::SIMULATED_HEAP_BYTES - static_cast<uint32_t>(live);
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    const uint64_t peak = NativeHal::heapStats().peakLiveBytes;
+    return peak >= NativeHal::SIMULATED_HEAP_BYTES ? 0 : NativeHal::SIMULATED_HEAP_BYTES - static_cast<uint32_t>(peak);
+}
+
+uint32_t EspClass::getMaxAllocHeap() { return getFreeHeap(); }
+
+uint32_t EspClass::getCycleCount() {
+    return static_cast<uint32_t>(NativeHal::nowMicros() * getCpuFreqMHz());
+}
+
+void EspClass::restart() {
+    fflush(stdout);
+    fprintf(stderr, "ESP.restart() called at %lu ms\n", millis());
+    std::exit(3);
+}
+
+// ============================================================================
+// WString / Print
+// ============================================================================
+String::String(long value, unsigned char base) {
+    if (value < 0 && base == 10) {
+        buffer = "-" + String(static_cast<unsigned long>(-value), base).buffer;
+    } else {
+        *this = String(static_cast<unsigned long>(value), base);
+    }
+}
+
+String::String(unsigned long value, unsigned char base) {
+    char tmp[8 * sizeof(unsigned long) + 1];
+    char* p = tmp + sizeof(tmp) - 1;
+    *p = '\0';
+    if (base < 2) base = 10;
+    do {
+        const unsigned digit = value % base;
+        *--p = static_cast<char>(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        value /= base;
+    } while (value);
+    buffer = p;
+}
+
+String::String(double value, unsigned int decimalPlaces) {
+    char tmp[48];
+    snprintf(tmp, sizeof(tmp), "%.*f", static_cast<int>(decimalPlaces), value);
+    buffer = tmp;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    const size_t pos = buffer.find(c, from);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+int String::indexOf(const char* s, unsigned int from) const {
+    const size_t pos = buffer.find(s, from);
+    return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= buffer.size()) return String();
+    return String(buffer.substr(from, to - from).c_str());
+}
+
+void String::trim() {
+    const size_t first = buffer.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) { buffer.clear(); return; }
+    const size_t last = buffer.find_last_not_of(" \t\r\n");
+    buffer = buffer.substr(first, last - first + 1);
+}
+
+void String::toUpperCase() { for (char& c : buffer) c = static_cast<char>(toupper(c)); }
+void String::toLowerCase() { for (char& c : buffer) c = static_cast<char>(tolower(c)); }
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+}
+
+size_t Print::vprintf(const char* format, va_list args) {
+    char local[256];
+    va_list copy;
+    va_copy(copy, args);
+    const int len = vsnprintf(local, sizeof(local), format, copy);
+    va_end(copy);
+    if (len < 0) return 0;
+    if (static_cast<size_t>(len) < sizeof(local)) return write(local, len);
+    std::string big(len + 1, '\0');
+    vsnprintf(&big[0], big.size(), format, args);
+    return write(big.data(), len);
+}
+
+size_t Print::printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    const size_t n = vprintf(format, args);
+    va_end(args);
+    return n;
+}
+
+size_t Print::printf_P(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    const size_t n = vprintf(format, args);
+    va_end(args);
+    return n;
+}
+
+// Formatted on the stack like the ESP32 core, so printing never shows up as heap churn.
+size_t Print::print(long value, int base) {
+    if (value < 0 && base == DEC) {
+        const size_t n = print('-');
+        return n + print(static_cast<unsigned long>(-value), base);
+    }
+    return print(static_cast<unsigned long>(value), base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+    char tmp[8 * sizeof(unsigned long) + 1];
+    char* p = tmp + sizeof(tmp);
+    if (base < 2) base = DEC;
+    do {
+        const unsigned digit = value % base;
+        *--p = static_cast<char>(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        value /= base;
+    } while (value);
+    return write(p, static_cast<size_t>(tmp + sizeof(tmp) - p));
+}
+
+size_t Print::print(double value, int digits) {
+    char tmp[48];
+    const int len = snprintf(tmp, sizeof(tmp), "%.*f", digits, value);
+    return write(tmp, static_cast<size_t>(len));
+}
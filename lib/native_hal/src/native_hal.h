@@ -0,0 +1,148 @@
+#ifndef NATIVE_HAL_H
+#define NATIVE_HAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+struct NativeTask;
+
+// ============================================================================
+// Host simulation control for the native build.
+//
+// All time in the native build comes from a single virtual clock. delay()
+// advances it directly, and every stand-in that blocks on real hardware
+// (DHT bus transaction, I2C transfer, MQTT connect, ...) charges its modelled
+// cost to the clock, so loop() timing measured here matches what the board
+// would see, without waiting for it.
+// ============================================================================
+namespace NativeHal {
+
+// Virtual clock
+uint64_t nowMicros();
+void advanceMicros(uint64_t us);
+void resetClock();
+void delayMicros(uint64_t us);   // delay(): advances the clock, counted as blocked
+uint64_t delayedMicros();  // calling task's share of the clock spent inside delay() or a task wait
+
+// Tasks (FreeRTOS stand-in). Every task is a host thread, and only one runs
+// at a time: advanceMicros() and the waits block the calling task and run the
+// others that are due meanwhile, so a modelled cost on one task does not
+// delay another. A wait returns early, at the time of the event, once another
+// task or an event handler has called notifyTask(). Returns the count taken.
+void startTask(NativeTask* task);
+void notifyTask(NativeTask* task);
+uint32_t waitNotification(bool clearOnExit, uint64_t timeoutUs);
+
+// Blocking cost model (microseconds of virtual time per operation)
+struct CostModel {
+    uint32_t analogReadUs = 10;
+    uint32_t dhtReadUs = 23000;          // 18 ms start pulse + 40 bit frame
+    uint32_t dhtMinIntervalMs = 2000;    // DHT library caches within this window
+    uint32_t mqttPublishUs = 800;
+    uint32_t mqttConnectUs = 250000;
+    uint32_t mqttConnectFailUs = 3000000;
+    uint32_t wifiScanConnectMs = 3000;   // full scan + association
+    uint32_t wifiFastConnectMs = 300;    // known BSSID/channel
+    uint32_t dnsLookupUs = 25000;        // WiFi.hostByName() round trip
+    uint32_t flashOpUs = 1000;           // LittleFS open/rename/remove (metadata commit)
+    uint32_t flashWriteNsPerByte = 3000; // program + erase amortised over the block
+    uint32_t nvsCommitUs = 2500;         // Preferences put/remove/clear
+    uint32_t serialBaud = 115200;
+    float adcCarryover = 0.02F;          // Share of the previous ADC channel left on the sample cap after a switch
+};
+CostModel& costs();
+
+// GPIO / ADC
+using AnalogSource = std::function<int(uint32_t nowMs)>;
+void setAnalogSource(int pin, AnalogSource source);
+int pinLevel(int pin);
+void setPinLevel(int pin, int level);
+
+// DHT environment
+using EnvSource = std::function<float(uint32_t nowMs)>;
+void setTemperatureSource(EnvSource source);
+void setHumiditySource(EnvSource source);
+float sampleTemperature();
+float sampleHumidity();
+
+// Network environment
+void setWiFiAvailable(bool available);
+bool wifiAvailable();
+void setBrokerAvailable(bool available);
+bool brokerAvailable();
+void setWiFiAccessPoint(const uint8_t* bssid, int32_t channel);  // AP moved: stale fast-connect data fails
+
+// Station link events (association result, AP loss) are delivered by
+// advanceMicros() at the time they occur; see WiFiClass.
+
+using PublishHook = std::function<void(const char* topic, const uint8_t* payload, size_t length)>;
+void setPublishHook(PublishHook hook);
+void notifyPublish(const char* topic, const uint8_t* payload, size_t length);
+void injectMqttMessage(const char* topic, const char* payload);
+bool takeMqttMessage(char* topic, size_t topicSize, uint8_t* payload, size_t payloadSize, size_t& length);
+
+// NTP stand-in, answering AsyncUDP datagrams sent to port 123. The device
+// clock (the virtual clock) runs clockErrorPpm fast against the reference
+// clock the server reports.
+struct NtpServer {
+    bool available = true;
+    uint64_t epochAtBootUs = 1767225600000000ULL;  // 2026-01-01T00:00:00Z at virtual time 0
+    double clockErrorPpm = 0.0;
+    uint32_t uplinkUs = 6000;
+    uint32_t downlinkUs = 6000;
+    uint32_t processingUs = 50;
+    uint8_t stratum = 2;
+    uint32_t requests = 0;
+};
+NtpServer& ntpServer();
+uint64_t referenceEpochMicros(uint64_t deviceUs);  // reference UTC at a device clock reading
+
+// Datagrams in flight are delivered by advanceMicros() at their arrival time.
+bool nextDatagramDue(uint64_t& atUs);
+void deliverNextDatagram();
+
+// Serial sink
+void setSerialEcho(bool echo);
+void serialWrite(const uint8_t* data, size_t length);
+// Free space in the UART TX FIFO right now
+size_t serialWritable();
+uint64_t serialBytes();
+
+// Heap accounting (fed by the global operator new/delete replacement)
+struct HeapStats {
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t bytesAllocated;
+    uint64_t liveBytes;
+    uint64_t peakLiveBytes;
+};
+HeapStats heapStats();
+constexpr uint32_t SIMULATED_HEAP_BYTES = 320 * 1024;
+
+// Filesystem: LittleFS paths map onto this host directory. Defaults to a
+// fresh temporary directory per process, so runs start from an empty flash.
+void setFilesystemRoot(const char* path);
+const char* filesystemRoot();
+void noteFlashOp();
+void noteFlashWrite(size_t bytes);
+
+// NVS (Preferences): process-lifetime store, so it persists across a
+// re-created object the way NVS persists across a reboot.
+void eraseNvs();
+uint32_t nvsWrites();
+
+// I2C accounting
+void noteI2CTransfer(size_t bytes, uint32_t clockHz);
+uint64_t i2cBytes();
+
+// SSD1306 panel model at 0x3C/0x3D: decodes the command/data stream into
+// display RAM (128 columns x 8 pages, same layout as the driver's buffer),
+// so a flush can be checked against what the panel would show.
+const uint8_t* oledPanelRam();
+uint64_t oledPanelDataBytes();
+uint64_t oledPanelCommandBytes();
+
+}  // namespace NativeHal
+
+#endif
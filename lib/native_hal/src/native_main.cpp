@@ -0,0 +1,332 @@
+// Entry point for the native build: runs the firmware's setup()/loop() against
+// the virtual clock for a simulated duration and reports per-iteration
+// latency, jitter and heap churn of the real loop code, and how often the
+// loop task wakes and how late its jobs start against their deadlines.
+//
+//   .pio/build/native/program [--hours H] [--seed N] [--echo] [--no-outages] [--fs DIR]
+//   .pio/build/native/program --bench [name]
+
+#include <Arduino.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "config.h"
+#include "native_bench.h"
+#include "scheduler.h"
+
+void setup();
+void loop();
+
+namespace {
+
+// Log-linear histogram: 16 sub-buckets per power of two, fixed memory.
+class Histogram {
+private:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB = 1 << SUB_BITS;
+    uint64_t counts[64 * SUB] = {0};
+    uint64_t total = 0;
+    uint64_t minValue = UINT64_MAX;
+    uint64_t maxValue = 0;
+    double sum = 0.0;
+    double sumSquares = 0.0;
+
+    static int bucketOf(uint64_t v) {
+        if (v < SUB) return static_cast<int>(v);
+        const int exp = 63 - __builtin_clzll(v);
+        const int sub = static_cast<int>((v >> (exp - SUB_BITS)) & (SUB - 1));
+        return (exp - SUB_BITS + 1) * SUB + sub;
+    }
+
+    static uint64_t upperBoundOf(int bucket) {
+        if (bucket < SUB) return static_cast<uint64_t>(bucket);
+        const int exp = bucket / SUB + SUB_BITS - 1;
+        const uint64_t sub = static_cast<uint64_t>(bucket % SUB);
+        return ((SUB + sub + 1) << (exp - SUB_BITS)) - 1;
+    }
+
+public:
+    void record(uint64_t v) {
+        counts[bucketOf(v)]++;
+        total++;
+        if (v < minValue) minValue = v;
+        if (v > maxValue) maxValue = v;
+        sum += static_cast<double>(v);
+        sumSquares += static_cast<double>(v) * static_cast<double>(v);
+    }
+
+    uint64_t percentile(double p) const {
+        const uint64_t target = static_cast<uint64_t>(std::ceil(p / 100.0 * total));
+        uint64_t seen = 0;
+        for (int i = 0; i < 64 * SUB; ++i) {
+            seen += counts[i];
+            if (seen >= target && counts[i] > 0) return std::min(upperBoundOf(i), maxValue);
+        }
+        return maxValue;
+    }
+
+    double mean() const { return total ? sum / total : 0.0; }
+
+    double stddev() const {
+        if (total < 2) return 0.0;
+        const double m = mean();
+        return std::sqrt(std::max(0.0, sumSquares / total - m * m));
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total ? minValue : 0; }
+    uint64_t max() const { return maxValue; }
+
+    void print(const char* label, double scale, const char* unit) const {
+        printf("%-16s: min %.3f  mean %.3f  p50 %.3f  p99 %.3f  p99.9 %.3f  max %.3f  stddev %.3f %s\n",
+               label, min() / scale, mean() / scale, percentile(50) / scale, percentile(99) / scale,
+               percentile(99.9) / scale, max() / scale, stddev() / scale, unit);
+    }
+};
+
+// Lateness of every scheduled job run, overall and per job. Jobs are told
+// apart by name: each task's scheduler numbers its own from 0.
+struct JobLateness {
+    const char* name = nullptr;
+    uint64_t runs = 0;
+    uint64_t totalUs = 0;
+    uint32_t maxUs = 0;
+};
+
+Histogram jobLateUs;
+JobLateness lateByJob[2 * Scheduler::MAX_JOBS];
+
+void recordJobRun(JobId id, const char* name, uint32_t lateUs) {
+    (void)id;
+    jobLateUs.record(lateUs);
+    JobLateness* slot = nullptr;
+    for (JobLateness& job : lateByJob) {
+        if (!job.name || !strcmp(job.name, name)) {
+            slot = &job;
+            break;
+        }
+    }
+    if (!slot) return;
+    JobLateness& job = *slot;
+    job.name = name;
+    job.runs++;
+    job.totalUs += lateUs;
+    if (lateUs > job.maxUs) job.maxUs = lateUs;
+}
+
+struct Options {
+    double hours = 24.0;
+    unsigned long seed = 1;
+    bool echo = false;
+    bool outages = true;
+    bool bench = false;
+    const char* benchFilter = nullptr;
+    const char* fsRoot = nullptr;
+};
+
+Options parseOptions(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--hours") && i + 1 < argc) {
+            opt.hours = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            opt.seed = strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--echo")) {
+            opt.echo = true;
+        } else if (!strcmp(argv[i], "--no-outages")) {
+            opt.outages = false;
+        } else if (!strcmp(argv[i], "--fs") && i + 1 < argc) {
+            opt.fsRoot = argv[++i];
+        } else if (!strcmp(argv[i], "--bench")) {
+            opt.bench = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') opt.benchFilter = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--hours H] [--seed N] [--echo] [--no-outages] [--fs DIR] | --bench [name]\n", argv[0]);
+            exit(2);
+        }
+    }
+    return opt;
+}
+
+constexpr uint32_t HOUR_MS = 3600UL * 1000UL;
+constexpr double TWO_PI = 6.283185307179586;
+
+float ambientTemperature(uint32_t nowMs) {
+    return 24.0F + 3.0F * static_cast<float>(std::sin(TWO_PI * nowMs / (24.0 * HOUR_MS)));
+}
+
+float ambientHumidity(uint32_t nowMs) {
+    return 50.0F + 10.0F * static_cast<float>(std::cos(TWO_PI * nowMs / (24.0 * HOUR_MS)));
+}
+
+// MQ-2 Rs against Rs at 20 °C/33 %RH: a smooth fit near the datasheet chart,
+// not the grid the firmware corrects with
+double mq2RsFactor(uint32_t nowMs) {
+    const double u = (ambientTemperature(nowMs) - 20.0) / 10.0;
+    return (1.0 - 0.065 * u + 0.01 * u * u) * (1.0 - 0.0016 * (ambientHumidity(nowMs) - 33.0));
+}
+
+// Default scenario: clean air with ADC noise and a 10-minute gas leak every
+// six hours, a daily temperature/humidity cycle, and (optionally) a WiFi drop
+// and a broker outage twice a day.
+void installScenario(const Options& opt) {
+    randomSeed(opt.seed);
+    srand(static_cast<unsigned>(opt.seed));
+
+    // The heater reaches temperature within the first minute: the output
+    // starts at half and settles exponentially. Rs follows the room's
+    // temperature and humidity (1500 in the air it starts in).
+    NativeHal::setAnalogSource(34, [](uint32_t nowMs) {
+        const uint32_t phase = nowMs % (6 * HOUR_MS);
+        const double rs = (4095.0 / 1500.0 - 1.0) * mq2RsFactor(nowMs) / mq2RsFactor(0);
+        const double heater = 1.0 - 0.5 * std::exp(-static_cast<double>(nowMs) / 10000.0);
+        int adc = static_cast<int>(4095.0 / (1.0 + rs) * heater);
+        const uint32_t leakStart = 3 * HOUR_MS;
+        const uint32_t leakLength = 10 * 60 * 1000;
+        if (phase >= leakStart && phase < leakStart + leakLength) {
+            const uint32_t t = phase - leakStart;
+            const uint32_t ramp = 60 * 1000;
+            adc += static_cast<int>(1800.0 * std::min<uint32_t>(t, ramp) / ramp);
+        }
+        return adc + (rand() % 17) - 8;
+    });
+
+    // MQ-7 (CO) and MQ-135 (NH3) beside it, read once enabled in GAS_CHANNELS:
+    // same heater settling at their own clean-air levels, the MQ-7 picking up
+    // part of each leak
+    NativeHal::setAnalogSource(35, [](uint32_t nowMs) {
+        const uint32_t phase = nowMs % (6 * HOUR_MS);
+        int adc = static_cast<int>(900.0 * (1.0 - 0.5 * std::exp(-static_cast<double>(nowMs) / 10000.0)));
+        if (phase >= 3 * HOUR_MS && phase < 3 * HOUR_MS + 10 * 60 * 1000) adc += 400;
+        return adc + (rand() % 17) - 8;
+    });
+    NativeHal::setAnalogSource(32, [](uint32_t nowMs) {
+        const int adc = static_cast<int>(2200.0 * (1.0 - 0.5 * std::exp(-static_cast<double>(nowMs) / 10000.0)));
+        return adc + (rand() % 17) - 8;
+    });
+
+    NativeHal::setTemperatureSource(ambientTemperature);
+    NativeHal::setHumiditySource(ambientHumidity);
+}
+
+void applyOutages(uint32_t nowMs) {
+    const uint32_t phase = nowMs % (12 * HOUR_MS);
+    const bool wifiDown = phase >= 5 * HOUR_MS && phase < 5 * HOUR_MS + 5 * 60 * 1000;
+    const bool brokerDown = phase >= 9 * HOUR_MS && phase < 9 * HOUR_MS + 2 * 60 * 1000;
+    NativeHal::setWiFiAvailable(!wifiDown);
+    NativeHal::setBrokerAvailable(!brokerDown);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const Options opt = parseOptions(argc, argv);
+    if (opt.fsRoot) NativeHal::setFilesystemRoot(opt.fsRoot);
+    if (opt.bench) return NativeBench::runAll(opt.benchFilter);
+
+    NativeHal::setSerialEcho(opt.echo);
+    installScenario(opt);
+
+    uint64_t publishes = 0;
+    uint64_t publishedBytes = 0;
+    uint64_t metricsReports = 0;
+    static char lastMetrics[TELEMETRY_TX_BUFFER_SIZE + 1];   // Not on the heap the report measures
+    size_t lastMetricsLength = 0;
+    NativeHal::setPublishHook([&](const char* topic, const uint8_t* payload, size_t length) {
+        publishes++;
+        publishedBytes += length;
+        if (strcmp(topic, MQTT_METRICS_TOPIC) == 0) {
+            metricsReports++;
+            lastMetricsLength = length < TELEMETRY_TX_BUFFER_SIZE ? length : TELEMETRY_TX_BUFFER_SIZE;
+            memcpy(lastMetrics, payload, lastMetricsLength);
+            lastMetrics[lastMetricsLength] = '\0';
+        }
+    });
+
+    Scheduler::setRunHook(recordJobRun);
+
+    using Clock = std::chrono::steady_clock;
+    const auto wallStart = Clock::now();
+
+    const NativeHal::HeapStats bootHeap0 = NativeHal::heapStats();
+    setup();
+    const uint64_t bootUs = NativeHal::nowMicros();
+    const NativeHal::HeapStats bootHeap1 = NativeHal::heapStats();
+
+    const uint64_t endUs = bootUs + static_cast<uint64_t>(opt.hours * 3600.0 * 1e6);
+    Histogram loopVirtualUs;
+    Histogram loopBusyUs;
+    Histogram loopHostNs;
+    Histogram loopAllocs;
+    uint64_t iterations = 0;
+    uint64_t wakeups = 0;
+    uint64_t allocationsInLoop = 0;
+    uint64_t bytesInLoop = 0;
+
+    while (NativeHal::nowMicros() < endUs) {
+        if (opt.outages) applyOutages(millis());
+
+        const uint64_t v0 = NativeHal::nowMicros();
+        const uint64_t d0 = NativeHal::delayedMicros();
+        const NativeHal::HeapStats h0 = NativeHal::heapStats();
+        const auto t0 = Clock::now();
+        loop();
+        const auto t1 = Clock::now();
+        const NativeHal::HeapStats h1 = NativeHal::heapStats();
+        uint64_t v1 = NativeHal::nowMicros();
+        const uint64_t blockedUs = NativeHal::delayedMicros() - d0;
+        const uint64_t busyUs = (v1 - v0) - blockedUs;
+        if (blockedUs > 0) wakeups++;   // the next pass starts from a wait
+
+        // A loop() that never blocks still has to let simulated time pass.
+        if (v1 == v0) {
+            NativeHal::advanceMicros(1000);
+            v1 = NativeHal::nowMicros();
+        }
+
+        loopVirtualUs.record(v1 - v0);
+        loopBusyUs.record(busyUs);
+        loopHostNs.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+        loopAllocs.record(h1.allocations - h0.allocations);
+        allocationsInLoop += h1.allocations - h0.allocations;
+        bytesInLoop += h1.bytesAllocated - h0.bytesAllocated;
+        iterations++;
+    }
+
+    const double wallSeconds = std::chrono::duration<double>(Clock::now() - wallStart).count();
+    const double simSeconds = (NativeHal::nowMicros() - bootUs) / 1e6;
+    const NativeHal::HeapStats heap = NativeHal::heapStats();
+
+    printf("=== native simulation: %.2f h simulated in %.2f s wall (%.0fx) ===\n",
+           simSeconds / 3600.0, wallSeconds, wallSeconds > 0 ? simSeconds / wallSeconds : 0.0);
+    printf("%-16s: %.3f s virtual, %llu allocations, %llu bytes\n", "setup()", bootUs / 1e6,
+           static_cast<unsigned long long>(bootHeap1.allocations - bootHeap0.allocations),
+           static_cast<unsigned long long>(bootHeap1.bytesAllocated - bootHeap0.bytesAllocated));
+    printf("%-16s: %llu\n", "loop iterations", static_cast<unsigned long long>(iterations));
+    printf("%-16s: %llu, %.1f per minute\n", "wakeups", static_cast<unsigned long long>(wakeups),
+           simSeconds > 0 ? wakeups * 60.0 / simSeconds : 0.0);
+    loopVirtualUs.print("loop (virtual)", 1000.0, "ms");
+    loopBusyUs.print("  excl. delay()", 1000.0, "ms");
+    loopHostNs.print("loop (host cpu)", 1000.0, "us");
+    loopAllocs.print("allocs/iter", 1.0, "");
+    jobLateUs.print("job lateness", 1000.0, "ms");
+    for (const JobLateness& job : lateByJob) {
+        if (job.runs == 0) continue;
+        printf("  %-14s: %8llu runs, mean %.3f  max %.3f ms late\n", job.name, static_cast<unsigned long long>(job.runs),
+               job.totalUs / 1000.0 / job.runs, job.maxUs / 1000.0);
+    }
+    printf("%-16s: %.3f allocs/iter, %.1f bytes/iter, peak live %llu B, live at exit %llu B\n", "heap churn",
+           iterations ? static_cast<double>(allocationsInLoop) / iterations : 0.0,
+           iterations ? static_cast<double>(bytesInLoop) / iterations : 0.0,
+           static_cast<unsigned long long>(heap.peakLiveBytes), static_cast<unsigned long long>(heap.liveBytes));
+    printf("%-16s: %llu publishes, %llu payload bytes\n", "mqtt", static_cast<unsigned long long>(publishes),
+           static_cast<unsigned long long>(publishedBytes));
+    printf("%-16s: %llu reports, last %u bytes\n", "metrics topic", static_cast<unsigned long long>(metricsReports),
+           static_cast<unsigned>(lastMetricsLength));
+    if (lastMetricsLength > 0) printf("  %s\n", lastMetrics);
+    printf("%-16s: %llu bytes\n", "serial", static_cast<unsigned long long>(NativeHal::serialBytes()));
+    printf("%-16s: %llu bytes\n", "i2c", static_cast<unsigned long long>(NativeHal::i2cBytes()));
+    return 0;
+}
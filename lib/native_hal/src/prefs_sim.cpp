@@ -0,0 +1,103 @@
+#include <Preferences.h>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include "native_hal.h"
+
+namespace {
+
+constexpr size_t NVS_KEY_MAX = 15;
+
+struct NvsState {
+    std::map<std::string, std::vector<uint8_t>> entries;   // "namespace/key"
+    uint32_t writes = 0;
+};
+
+NvsState& nvs() {
+    static NvsState state;
+    return state;
+}
+
+std::string entryKey(const char* ns, const char* key) {
+    std::string k = ns;
+    k += '/';
+    k += key;
+    return k;
+}
+
+const std::vector<uint8_t>* find(const char* ns, const char* key) {
+    auto it = nvs().entries.find(entryKey(ns, key));
+    return it == nvs().entries.end() ? nullptr : &it->second;
+}
+
+}  // namespace
+
+namespace NativeHal {
+
+void eraseNvs() { nvs().entries.clear(); }
+uint32_t nvsWrites() { return nvs().writes; }
+
+}  // namespace NativeHal
+
+bool Preferences::begin(const char* name, bool readOnlyMode, const char* partitionLabel) {
+    (void)partitionLabel;
+    if (!name || strlen(name) > NVS_KEY_MAX) return false;
+    snprintf(ns, sizeof(ns), "%s", name);
+    readOnly = readOnlyMode;
+    opened = true;
+    return true;
+}
+
+bool Preferences::clear() {
+    if (!opened || readOnly) return false;
+    const std::string prefix = entryKey(ns, "");
+    auto& entries = nvs().entries;
+    for (auto it = entries.lower_bound(prefix); it != entries.end() && it->first.compare(0, prefix.size(), prefix) == 0;) {
+        it = entries.erase(it);
+    }
+    ++nvs().writes;
+    NativeHal::advanceMicros(NativeHal::costs().nvsCommitUs);
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!opened || readOnly || !key) return false;
+    if (nvs().entries.erase(entryKey(ns, key)) == 0) return false;
+    ++nvs().writes;
+    NativeHal::advanceMicros(NativeHal::costs().nvsCommitUs);
+    return true;
+}
+
+bool Preferences::isKey(const char* key) const {
+    return opened && key && find(ns, key) != nullptr;
+}
+
+size_t Preferences::put(const char* key, const void* value, size_t length) {
+    if (!opened || readOnly || !key || strlen(key) > NVS_KEY_MAX || (!value && length > 0)) return 0;
+    const uint8_t* bytes = static_cast<const uint8_t*>(value);
+    nvs().entries[entryKey(ns, key)].assign(bytes, bytes + length);
+    ++nvs().writes;
+    NativeHal::advanceMicros(NativeHal::costs().nvsCommitUs);
+    return length;
+}
+
+// Typed reads only accept an entry of exactly the requested size
+size_t Preferences::get(const char* key, void* buf, size_t length) const {
+    const std::vector<uint8_t>* entry = opened && key ? find(ns, key) : nullptr;
+    if (!entry || entry->size() != length) return 0;
+    memcpy(buf, entry->data(), length);
+    return length;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLength) const {
+    const std::vector<uint8_t>* entry = opened && key ? find(ns, key) : nullptr;
+    if (!entry || !buf || entry->size() > maxLength) return 0;
+    memcpy(buf, entry->data(), entry->size());
+    return entry->size();
+}
+
+size_t Preferences::getBytesLength(const char* key) const {
+    const std::vector<uint8_t>* entry = opened && key ? find(ns, key) : nullptr;
+    return entry ? entry->size() : 0;
+}
@@ -0,0 +1,65 @@
+#include <PubSubClient.h>
+
+bool PubSubClient::connect(const char* id) {
+    return connect(id, nullptr, 0, false, nullptr);
+}
+
+bool PubSubClient::connect(const char* id, const char* willTopic, uint8_t willQos, bool willRetain,
+                           const char* willMessage) {
+    (void)id;
+    (void)willTopic;
+    (void)willQos;
+    (void)willRetain;
+    (void)willMessage;
+    if (WiFi.status() != WL_CONNECTED || !NativeHal::brokerAvailable()) {
+        NativeHal::advanceMicros(NativeHal::costs().mqttConnectFailUs);
+        currentState = MQTT_CONNECT_FAILED;
+        return false;
+    }
+    NativeHal::advanceMicros(NativeHal::costs().mqttConnectUs);
+    currentState = MQTT_CONNECTED;
+    return true;
+}
+
+bool PubSubClient::publish(const char* topic, const char* payload, bool retained) {
+    return publish(topic, reinterpret_cast<const uint8_t*>(payload),
+                   payload ? static_cast<unsigned int>(strlen(payload)) : 0, retained);
+}
+
+bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained) {
+    (void)retained;
+    if (!connected()) return false;
+    // Fixed header + topic length prefix + topic + payload must fit the buffer.
+    if (5 + 2 + strlen(topic) + length > bufferSize) return false;
+    NativeHal::advanceMicros(NativeHal::costs().mqttPublishUs);
+    NativeHal::notifyPublish(topic, payload, length);
+    return true;
+}
+
+bool PubSubClient::subscribe(const char* topic) {
+    if (!connected()) return false;
+    snprintf(subscribed, sizeof(subscribed), "%s", topic);
+    return true;
+}
+
+// Like the real client, at most one inbound packet is handled per loop() call.
+bool PubSubClient::loop() {
+    if (!connected()) return false;
+    char topic[128];
+    size_t length = 0;
+    if (NativeHal::takeMqttMessage(topic, sizeof(topic), rxBuffer, sizeof(rxBuffer), length)) {
+        if (callback && strcmp(topic, subscribed) == 0) {
+            callback(topic, rxBuffer, static_cast<unsigned int>(length));
+        }
+    }
+    return true;
+}
+
+bool PubSubClient::connected() {
+    if (currentState != MQTT_CONNECTED) return false;
+    if (WiFi.status() != WL_CONNECTED || !NativeHal::brokerAvailable()) {
+        currentState = MQTT_CONNECTION_LOST;
+        return false;
+    }
+    return true;
+}
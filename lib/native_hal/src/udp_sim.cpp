@@ -0,0 +1,136 @@
+#include <AsyncUDP.h>
+#include <esp_timer.h>
+
+namespace {
+
+constexpr uint16_t NTP_PORT = 123;
+constexpr size_t NTP_PACKET_SIZE = 48;
+constexpr uint64_t NTP_UNIX_OFFSET_S = 2208988800ULL;  // 1900-01-01 to 1970-01-01
+
+struct Datagram {
+    bool used = false;
+    uint64_t atUs = 0;
+    AsyncUDP* socket = nullptr;
+    uint8_t data[NTP_PACKET_SIZE];
+    size_t length = 0;
+    IPAddress from;
+    uint16_t port = 0;
+};
+
+// Fixed pool: the stand-in never allocates on the simulated device's behalf.
+Datagram inFlight[8];
+
+NativeHal::NtpServer& server() {
+    static NativeHal::NtpServer state;
+    return state;
+}
+
+void putNtpTimestamp(uint8_t* p, uint64_t unixUs) {
+    const uint32_t seconds = static_cast<uint32_t>(unixUs / 1000000ULL + NTP_UNIX_OFFSET_S);
+    const uint32_t fraction = static_cast<uint32_t>(((unixUs % 1000000ULL) << 32) / 1000000ULL);
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<uint8_t>(seconds >> (24 - 8 * i));
+        p[4 + i] = static_cast<uint8_t>(fraction >> (24 - 8 * i));
+    }
+}
+
+Datagram* freeSlot() {
+    for (Datagram& d : inFlight) {
+        if (!d.used) return &d;
+    }
+    return nullptr;
+}
+
+// Client request (mode 3) in, server reply (mode 4) out, with the request's
+// transmit timestamp echoed as the originate timestamp.
+void answerNtp(AsyncUDP* socket, const IPAddress& to, const uint8_t* request) {
+    NativeHal::NtpServer& ntp = server();
+    ntp.requests++;
+    if (!ntp.available || (request[0] & 0x07) != 3) return;
+    Datagram* reply = freeSlot();
+    if (!reply) return;
+
+    const uint64_t sentUs = NativeHal::nowMicros();
+    const uint64_t receivedUs = sentUs + ntp.uplinkUs;
+    uint8_t* p = reply->data;
+    memset(p, 0, NTP_PACKET_SIZE);
+    p[0] = (4 << 3) | 4;  // LI 0, version 4, mode 4 (server)
+    p[1] = ntp.stratum;
+    p[2] = request[2];
+    p[3] = static_cast<uint8_t>(-20);  // precision ~1 us
+    memcpy(p + 12, "SIM\0", 4);
+    memcpy(p + 24, request + 40, 8);
+    putNtpTimestamp(p + 32, NativeHal::referenceEpochMicros(receivedUs));
+    putNtpTimestamp(p + 40, NativeHal::referenceEpochMicros(receivedUs + ntp.processingUs));
+    putNtpTimestamp(p + 16, NativeHal::referenceEpochMicros(receivedUs) - 64000000ULL);  // reference time
+
+    reply->used = true;
+    reply->atUs = receivedUs + ntp.processingUs + ntp.downlinkUs;
+    reply->socket = socket;
+    reply->length = NTP_PACKET_SIZE;
+    reply->from = to;
+    reply->port = NTP_PORT;
+}
+
+}  // namespace
+
+namespace NativeHal {
+
+NtpServer& ntpServer() { return server(); }
+
+uint64_t referenceEpochMicros(uint64_t deviceUs) {
+    const long double scale = 1.0L + static_cast<long double>(server().clockErrorPpm) * 1e-6L;
+    return server().epochAtBootUs + static_cast<uint64_t>(static_cast<long double>(deviceUs) / scale);
+}
+
+bool nextDatagramDue(uint64_t& atUs) {
+    bool found = false;
+    for (const Datagram& d : inFlight) {
+        if (d.used && (!found || d.atUs < atUs)) {
+            atUs = d.atUs;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void deliverNextDatagram() {
+    Datagram* next = nullptr;
+    for (Datagram& d : inFlight) {
+        if (d.used && (!next || d.atUs < next->atUs)) next = &d;
+    }
+    if (!next) return;
+    next->used = false;
+    // Dropped when the station lost the AP meanwhile
+    if (next->socket && wifiAvailable()) next->socket->deliver(next->data, next->length, next->from, next->port);
+}
+
+}  // namespace NativeHal
+
+AsyncUDP::~AsyncUDP() { close(); }
+
+bool AsyncUDP::connect(const IPAddress addr, uint16_t port) {
+    remote = addr;
+    remotePort = port;
+    isConnected = true;
+    return true;
+}
+
+size_t AsyncUDP::write(const uint8_t* data, size_t len) {
+    if (!isConnected || WiFi.status() != WL_CONNECTED) return 0;
+    if (remotePort == NTP_PORT && len >= NTP_PACKET_SIZE) answerNtp(this, remote, data);
+    return len;
+}
+
+void AsyncUDP::close() {
+    isConnected = false;
+    for (Datagram& d : inFlight) {
+        if (d.socket == this) d.used = false;
+    }
+}
+
+void AsyncUDP::deliver(uint8_t* data, size_t len, const IPAddress& from, uint16_t port) {
+    if (!isConnected || !handler) return;
+    AsyncUDPPacket packet(data, len, from, port);
+    handler(packet);
+}
@@ -0,0 +1,149 @@
+#include <WiFi.h>
+#include <cstring>
+
+WiFiClass WiFi;
+
+namespace {
+uint8_t apBssid[6] = {0x24, 0x0A, 0xC4, 0x12, 0x34, 0x56};
+int32_t apChannel = 6;
+}  // namespace
+
+namespace NativeHal {
+
+void setWiFiAccessPoint(const uint8_t* bssid, int32_t channel) {
+    memcpy(apBssid, bssid, sizeof(apBssid));
+    apChannel = channel;
+}
+
+}  // namespace NativeHal
+
+String IPAddress::toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(buf);
+}
+
+// Associated and the AP is still on the air where we joined it
+bool WiFiClass::linkUp() const {
+    return link == Link::CONNECTED && NativeHal::wifiAvailable() && memcmp(linkBssid, apBssid, 6) == 0 &&
+           linkChannel == apChannel;
+}
+
+void WiFiClass::startAttempt(int32_t channel, const uint8_t* bssid) {
+    fastPath = bssid != nullptr && channel > 0;
+    if (fastPath) memcpy(targetBssid, bssid, sizeof(targetBssid));
+    targetChannel = channel;
+    const uint32_t delayMs = fastPath ? NativeHal::costs().wifiFastConnectMs : NativeHal::costs().wifiScanConnectMs;
+    resolveAtUs = NativeHal::nowMicros() + static_cast<uint64_t>(delayMs) * 1000;
+    link = Link::ASSOCIATING;
+}
+
+void WiFiClass::fire(arduino_event_id_t event, uint8_t reason) {
+    arduino_event_info_t info;
+    memset(&info, 0, sizeof(info));
+    const size_t ssidLen = strlen(ssidName);
+    if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+        memcpy(info.wifi_sta_disconnected.ssid, ssidName, ssidLen);
+        info.wifi_sta_disconnected.ssid_len = static_cast<uint8_t>(ssidLen);
+        memcpy(info.wifi_sta_disconnected.bssid, linkBssid, 6);
+        info.wifi_sta_disconnected.reason = reason;
+    } else if (event == ARDUINO_EVENT_WIFI_STA_CONNECTED) {
+        memcpy(info.wifi_sta_connected.ssid, ssidName, ssidLen);
+        info.wifi_sta_connected.ssid_len = static_cast<uint8_t>(ssidLen);
+        memcpy(info.wifi_sta_connected.bssid, linkBssid, 6);
+        info.wifi_sta_connected.channel = static_cast<uint8_t>(linkChannel);
+    }
+    for (const auto& handler : handlers) {
+        if (handler.second == ARDUINO_EVENT_MAX || handler.second == event) handler.first(event, info);
+    }
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* passphrase, int32_t channel,
+                             const uint8_t* bssid, bool connect) {
+    (void)passphrase;
+    snprintf(ssidName, sizeof(ssidName), "%s", ssid ? ssid : "");
+    if (connect) {
+        startAttempt(channel, bssid);
+    } else {
+        link = Link::IDLE;
+    }
+    return WL_DISCONNECTED;
+}
+
+wl_status_t WiFiClass::status() {
+    return linkUp() ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool wifioff, bool eraseap) {
+    (void)eraseap;
+    const bool wasUp = link != Link::IDLE;
+    link = Link::IDLE;
+    if (wifioff) currentMode = WIFI_OFF;
+    if (wasUp) fire(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_ASSOC_LEAVE);
+    return true;
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb callback, arduino_event_id_t event) {
+    handlers.emplace_back(std::move(callback), event);
+    return handlers.size();
+}
+
+bool WiFiClass::nextEventDue(uint64_t& atUs) const {
+    if (link == Link::ASSOCIATING) {
+        atUs = resolveAtUs;
+        return true;
+    }
+    if (link == Link::CONNECTED && !linkUp()) {
+        atUs = NativeHal::nowMicros();
+        return true;
+    }
+    return false;
+}
+
+// A fast attempt only finds the AP at the BSSID and channel it was given;
+// a scan finds it wherever it is.
+void WiFiClass::deliverEvent() {
+    if (link == Link::ASSOCIATING) {
+        const bool found = NativeHal::wifiAvailable() &&
+                           (!fastPath || (memcmp(targetBssid, apBssid, 6) == 0 && targetChannel == apChannel));
+        if (found) {
+            memcpy(linkBssid, apBssid, sizeof(linkBssid));
+            linkChannel = apChannel;
+            link = Link::CONNECTED;
+            fire(ARDUINO_EVENT_WIFI_STA_CONNECTED, 0);
+            if (link == Link::CONNECTED) fire(ARDUINO_EVENT_WIFI_STA_GOT_IP, 0);
+            return;
+        }
+        link = Link::IDLE;
+        if (autoReconnect) startAttempt(0, nullptr);
+        fire(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_NO_AP_FOUND);
+    } else if (link == Link::CONNECTED && !linkUp()) {
+        link = Link::IDLE;
+        if (autoReconnect) startAttempt(0, nullptr);
+        fire(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_BEACON_TIMEOUT);
+    }
+}
+
+IPAddress WiFiClass::localIP() {
+    return status() == WL_CONNECTED ? IPAddress(192, 168, 1, 50) : IPAddress();
+}
+
+// Dotted quads resolve locally; any other name resolves to the NTP/DNS
+// stand-in's address after a modelled lookup.
+int WiFiClass::hostByName(const char* host, IPAddress& result) {
+    unsigned a, b, c, d;
+    char tail;
+    if (host && sscanf(host, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) == 4 && a < 256 && b < 256 && c < 256 &&
+        d < 256) {
+        result = IPAddress(a, b, c, d);
+        return 1;
+    }
+    NativeHal::advanceMicros(NativeHal::costs().dnsLookupUs);
+    if (!host || status() != WL_CONNECTED) return 0;
+    result = IPAddress(10, 0, 0, 123);
+    return 1;
+}
+
+int8_t WiFiClass::RSSI() { return status() == WL_CONNECTED ? -58 : 0; }
+uint8_t* WiFiClass::BSSID() { return linkBssid; }
+int32_t WiFiClass::channel() { return linkChannel; }
@@ -0,0 +1,128 @@
+#include <Wire.h>
+#include <cstring>
+#include "native_hal.h"
+
+namespace {
+
+// SSD1306 controller state as far as the stream of a display flush goes:
+// the page/column window and the write pointer inside it (horizontal
+// addressing mode, which the driver selects at init).
+struct Panel {
+    uint8_t ram[128 * 8] = {};
+    uint8_t columnStart = 0, columnEnd = 127, pageStart = 0, pageEnd = 7;
+    uint8_t column = 0, page = 0;
+    uint8_t command = 0;      // command waiting for arguments
+    uint8_t argsNeeded = 0;
+    uint8_t args[2] = {};
+    uint8_t argCount = 0;
+    uint64_t dataBytes = 0;
+    uint64_t commandBytes = 0;
+};
+
+Panel& panel() {
+    static Panel p;
+    return p;
+}
+
+uint8_t argumentCount(uint8_t command) {
+    switch (command) {
+        case 0x21: case 0x22: return 2;   // column / page address window
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+        case 0xD5: case 0xD9: case 0xDA: case 0xDB: return 1;
+        default: return 0;
+    }
+}
+
+void panelCommand(uint8_t byte) {
+    Panel& p = panel();
+    p.commandBytes++;
+    if (p.argsNeeded == 0) {
+        p.command = byte;
+        p.argsNeeded = argumentCount(byte);
+        p.argCount = 0;
+        return;
+    }
+    if (p.argCount < sizeof(p.args)) p.args[p.argCount] = byte;
+    p.argCount++;
+    if (--p.argsNeeded > 0) return;
+    if (p.command == 0x21) {
+        p.columnStart = p.args[0] & 0x7F;
+        p.columnEnd = p.args[1] & 0x7F;
+        p.column = p.columnStart;
+    } else if (p.command == 0x22) {
+        p.pageStart = p.args[0] & 0x07;
+        p.pageEnd = p.args[1] > 7 ? 7 : p.args[1];   // the driver sends 0xFF for "to the end"
+        p.page = p.pageStart;
+    }
+}
+
+void panelData(uint8_t byte) {
+    Panel& p = panel();
+    p.dataBytes++;
+    p.ram[p.page * 128 + p.column] = byte;
+    if (p.column < p.columnEnd) {
+        ++p.column;
+        return;
+    }
+    p.column = p.columnStart;
+    p.page = p.page < p.pageEnd ? p.page + 1 : p.pageStart;
+}
+
+// Control byte 0x00: commands follow, 0x40: display data follows (Co = 0).
+void panelTransmission(const uint8_t* data, size_t length) {
+    if (length == 0) return;
+    const bool isData = data[0] & 0x40;
+    for (size_t i = 1; i < length; ++i) {
+        if (isData) panelData(data[i]);
+        else panelCommand(data[i]);
+    }
+}
+
+}  // namespace
+
+namespace NativeHal {
+
+const uint8_t* oledPanelRam() { return panel().ram; }
+uint64_t oledPanelDataBytes() { return panel().dataBytes; }
+uint64_t oledPanelCommandBytes() { return panel().commandBytes; }
+
+}  // namespace NativeHal
+
+TwoWire Wire;
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+    (void)sda;
+    (void)scl;
+    if (frequency > 0) clockHz = frequency;
+    return true;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    this->address = address;
+    transmitting = true;
+    pending = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (!transmitting || pending >= sizeof(txBuffer)) return 0;
+    txBuffer[pending++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t length) {
+    if (!transmitting) return 0;
+    if (length > sizeof(txBuffer) - pending) length = sizeof(txBuffer) - pending;
+    memcpy(txBuffer + pending, data, length);
+    pending += length;
+    return length;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    (void)sendStop;
+    if (!transmitting) return 4;
+    NativeHal::noteI2CTransfer(pending + 1, clockHz);   // + address byte
+    if (address == 0x3C || address == 0x3D) panelTransmission(txBuffer, pending);
+    transmitting = false;
+    pending = 0;
+    return 0;
+}
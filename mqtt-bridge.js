@@ -14,6 +14,222 @@ const STATUS_TOPIC =
 const DASHBOARD_API_URL =
   process.env.DASHBOARD_API_URL || 'http://localhost:3000';
 
+// Binary telemetry frames (see src/binary_telemetry.h)
+const BINARY_MAGIC = 0xa7;
+const BINARY_VERSION = 4;
+const BATCH_HEADER_SIZE = 12;
+const RECORD_SIZE = 18; // With one gas channel, 4 more per further channel
+const MAX_GAS_CHANNELS = 8;
+const BATCH_FLAG_GAS_ESTIMATES = 2;
+const MAX_GAS_ESTIMATES = 8;
+// MQ2_GAS_CURVES names (src/config.h), in the device's gas order
+const GAS_ESTIMATE_NAMES = ['lpg', 'propane', 'h2', 'co', 'alcohol', 'smoke'];
+const RECORD_FLAG_UPTIME = 4;
+const RECORD_FLAG_WARMING = 8;
+const RECORD_FLAG_CAL_FAILED = 16;
+const QUALITY_NAMES = [
+  'Excellent',
+  'Good',
+  'Moderate',
+  'Poor',
+  'Very Poor',
+  'Hazardous',
+  'Critical',
+];
+// Names of the device's gas channels after the first, in GAS_CHANNELS order
+// (src/config.h); binary frames carry only their count
+const GAS_CHANNEL_NAMES = (process.env.MQTT_GAS_CHANNELS || '')
+  .split(',')
+  .map((name) => name.trim())
+  .filter((name) => name.length > 0);
+const BOOT_SPAN_SIZE = 9;
+const BOOT_STAGE_NAMES = [
+  'oled',
+  'relay',
+  'alert',
+  'mq2',
+  'dht',
+  'storage',
+  'wifi',
+  'clock',
+  'broker',
+  'first_publish',
+];
+
+// Returns the JSON-equivalent object for a binary frame, or null when the
+// payload is not one (JSON payloads start with '{').
+function decodeBinaryTelemetry(topic, message) {
+  if (message.length < 10 || message[0] !== BINARY_MAGIC) return null;
+  if (message[1] !== BINARY_VERSION) {
+    throw new Error(`Unsupported binary telemetry version ${message[1]}`);
+  }
+  const deviceId = topic.split('/')[1];
+  const schema = message[2];
+  const flags = message[3];
+  const sequence = message.readUInt16LE(4);
+  const uptimeMs = message.readUInt32LE(6);
+
+  if (schema === 1 && message.length === 19) {
+    const temperature = message.readInt16LE(14);
+    const humidity = message.readUInt16LE(16);
+    return {
+      device_id: deviceId,
+      seq: sequence,
+      ppm: message.readFloatLE(10),
+      quality: QUALITY_NAMES[message[18]] || 'Unknown',
+      relay_state: flags & 1 ? 'ON' : 'OFF',
+      temperature: temperature === -32768 ? null : temperature / 100,
+      humidity: humidity === 0xffff ? null : humidity / 100,
+      uptime_ms: uptimeMs,
+    };
+  }
+  // Batch: records of the first channel's reading plus 4 bytes per further
+  // gas channel (byte 11 counts the channels), then with flag 2 the MQ-2's
+  // per-gas estimates of the latest reading (u8 n, n f32)
+  const gas = message.length >= BATCH_HEADER_SIZE ? message[11] : 0;
+  const recordSize = RECORD_SIZE + 4 * (gas - 1);
+  const recordsEnd = BATCH_HEADER_SIZE + recordSize * message[10];
+  const hasEstimates = (flags & BATCH_FLAG_GAS_ESTIMATES) !== 0;
+  const estimates =
+    hasEstimates && message.length > recordsEnd ? message[recordsEnd] : 0;
+  if (
+    schema === 3 &&
+    gas >= 1 &&
+    gas <= MAX_GAS_CHANNELS &&
+    (!hasEstimates || (estimates >= 1 && estimates <= MAX_GAS_ESTIMATES)) &&
+    message.length === recordsEnd + (hasEstimates ? 1 + 4 * estimates : 0)
+  ) {
+    const samples = [];
+    for (let i = 0; i < message[10]; i++) {
+      const offset = BATCH_HEADER_SIZE + i * recordSize;
+      const temperature = message.readInt16LE(offset + 12);
+      const humidity = message.readUInt16LE(offset + 14);
+      const row = [
+        Number(message.readBigUInt64LE(offset)) / 1000,
+        message.readFloatLE(offset + 8),
+        temperature === -32768 ? null : temperature / 100,
+        humidity === 0xffff ? null : humidity / 100,
+        message[offset + 16],
+        message[offset + 17],
+      ];
+      for (let c = 1; c < gas; c++) {
+        const ppm = message.readFloatLE(offset + RECORD_SIZE + 4 * (c - 1));
+        row.push(Number.isNaN(ppm) ? null : ppm);
+      }
+      samples.push(row);
+    }
+    const frame = {
+      device_id: deviceId,
+      seq: sequence,
+      replay: (flags & 1) !== 0,
+      samples,
+    };
+    if (gas > 1) {
+      frame.gas_channels = Array.from(
+        { length: gas - 1 },
+        (_, c) => GAS_CHANNEL_NAMES[c] || `gas${c + 1}`
+      );
+    }
+    if (estimates > 0) {
+      frame.gases = {};
+      for (let g = 0; g < estimates; g++) {
+        const name = GAS_ESTIMATE_NAMES[g] || `gas_estimate${g}`;
+        frame.gases[name] = message.readFloatLE(recordsEnd + 1 + 4 * g);
+      }
+    }
+    return frame;
+  }
+  if (schema === 2 && message.length === 10) {
+    return {
+      device_id: deviceId,
+      seq: sequence,
+      status: flags & 1 ? 'online' : 'offline',
+      uptime_ms: uptimeMs,
+    };
+  }
+  // Status with the boot timeline (flag 2): per stage start and end in us
+  // since boot, end absent while the stage is still running
+  if (
+    schema === 2 &&
+    flags & 2 &&
+    message.length >= 11 &&
+    message.length === 11 + BOOT_SPAN_SIZE * message[10]
+  ) {
+    const boot = [];
+    for (let i = 0; i < message[10]; i++) {
+      const offset = 11 + i * BOOT_SPAN_SIZE;
+      const span = {
+        stage: BOOT_STAGE_NAMES[message[offset] & 0x7f] || 'unknown',
+        start_us: message.readUInt32LE(offset + 1),
+      };
+      const end = message.readUInt32LE(offset + 5);
+      if (end !== 0xffffffff) span.end_us = end;
+      if (message[offset] & 0x80) span.failed = true;
+      boot.push(span);
+    }
+    return {
+      device_id: deviceId,
+      seq: sequence,
+      status: flags & 1 ? 'online' : 'offline',
+      uptime_ms: uptimeMs,
+      boot,
+    };
+  }
+  throw new Error(
+    `Invalid binary telemetry frame (schema ${schema}, ${message.length} bytes)`
+  );
+}
+
+// Batched sensor messages carry every reading since the last publish as
+// [t, ppm, temperature, humidity, quality index, flags, ppm of each further
+// gas channel] rows; t is Unix time in ms, or ms since boot for readings
+// taken before the device's first time sync (flag 4). Flag 8 marks readings
+// taken while the MQ-2 heater was still warming up, flag 16 readings from a
+// gas sensor whose calibration failed. The further channels
+// are named in gas_channels and forwarded as a gas object per reading. A
+// live message's gases (the MQ-2's estimate per datasheet gas) belong to
+// its latest reading.
+// Readings the device held in flash during an outage arrive later with
+// replay set; they are forwarded as replayed history, not as current state.
+function expandSamples(data) {
+  if (!Array.isArray(data.samples)) return [data];
+  const channels = Array.isArray(data.gas_channels) ? data.gas_channels : [];
+  const latest = data.samples.length - 1;
+  return data.samples.map(
+    ([t, ppm, temperature, humidity, quality, flags, ...gasPpm], i) => ({
+      device_id: data.device_id,
+      ppm,
+      quality: QUALITY_NAMES[quality] || 'Unknown',
+      relay_state: flags & 1 ? 'ON' : 'OFF',
+      alert: (flags & 2) !== 0,
+      warming: (flags & RECORD_FLAG_WARMING) !== 0,
+      cal_failed: (flags & RECORD_FLAG_CAL_FAILED) !== 0,
+      temperature,
+      humidity,
+      ...(channels.length > 0
+        ? {
+            gas: Object.fromEntries(
+              channels.map((name, c) => [name, gasPpm[c] ?? null])
+            ),
+          }
+        : {}),
+      ...(i === latest && data.gases && data.replay !== true
+        ? { gases: data.gases }
+        : {}),
+      ...(flags & RECORD_FLAG_UPTIME
+        ? { uptime_ms: t }
+        : { timestamp: new Date(t).toISOString() }),
+      replayed: data.replay === true,
+    })
+  );
+}
+
+function parsePayload(topic, message) {
+  return (
+    decodeBinaryTelemetry(topic, message) || JSON.parse(message.toString())
+  );
+}
+
 // Create MQTT client
 const client = mqtt.connect(`${MQTT_BROKER}:${MQTT_PORT}`);
 
@@ -46,11 +262,13 @@ client.on('message', async (topic, message) => {
   try {
     if (topic === SENSOR_TOPIC) {
       // Forward sensor data to dashboard API
-      const sensorData = JSON.parse(message.toString());
-      await sendSensorData(sensorData);
+      const sensorData = parsePayload(topic, message);
+      for (const reading of expandSamples(sensorData)) {
+        await sendSensorData(reading);
+      }
     } else if (topic === STATUS_TOPIC) {
       // Forward device status to dashboard API
-      const statusData = JSON.parse(message.toString());
+      const statusData = parsePayload(topic, message);
       await updateDeviceStatus(statusData);
     }
   } catch (error) {
@@ -68,7 +286,10 @@ async function sendSensorData(data) {
       },
       body: JSON.stringify({
         ...data,
-        timestamp: new Date().toISOString(),
+        // Acquisition time when the device knows it, else arrival time
+        timestamp: data.timestamp
+          ? new Date(data.timestamp).toISOString()
+          : new Date().toISOString(),
       }),
     });
 
@@ -0,0 +1,69 @@
+#ifndef AIR_QUALITY_H
+#define AIR_QUALITY_H
+
+#include <cstddef>
+#include <cstdint>
+#include "config.h"
+
+// ============================================================================
+// Air-quality bands of the MQ-2 ppm reading.
+//
+// A reading is in band i when it is at or above the first i entries of
+// AQ_THRESHOLDS (config.h). classifyAirQuality() counts the thresholds it
+// has reached instead of walking an if-chain: every compare runs, each adds
+// 0 or 1, so the compiler emits compares and adds without branches, and the
+// result is a constant wherever the reading is. The value is also the
+// quality index of the binary telemetry frames; labels live in one flash
+// table. No String anywhere on the way.
+// ============================================================================
+
+enum class AirQuality : uint8_t {
+    EXCELLENT,
+    GOOD,
+    MODERATE,
+    POOR,
+    VERY_POOR,
+    HAZARDOUS,
+    CRITICAL,
+    COUNT
+};
+
+constexpr size_t AIR_QUALITY_COUNT = static_cast<size_t>(AirQuality::COUNT);
+
+// Indexed by AirQuality; const data stays in flash (.rodata) on the ESP32
+inline constexpr const char* const AIR_QUALITY_LABELS[] = {
+    "Excellent", "Good", "Moderate", "Poor", "Very Poor", "Hazardous", "Critical"
+};
+
+// A NaN reading compares false against every threshold and lands in
+// CRITICAL, as with the if-chain this replaces
+constexpr AirQuality classifyAirQuality(float ppm) {
+    uint8_t band = 0;
+    for (float threshold : AQ_THRESHOLDS) band += !(ppm < threshold);
+    return static_cast<AirQuality>(band);
+}
+
+constexpr const char* airQualityLabel(AirQuality quality) {
+    return quality < AirQuality::COUNT ? AIR_QUALITY_LABELS[static_cast<size_t>(quality)] : "Unknown";
+}
+
+namespace AirQualityCheck {
+constexpr bool ascending() {
+    for (size_t i = 1; i < sizeof(AQ_THRESHOLDS) / sizeof(AQ_THRESHOLDS[0]); ++i) {
+        if (!(AQ_THRESHOLDS[i - 1] < AQ_THRESHOLDS[i])) return false;
+    }
+    return true;
+}
+}  // namespace AirQualityCheck
+
+static_assert(sizeof(AQ_THRESHOLDS) / sizeof(AQ_THRESHOLDS[0]) + 1 == AIR_QUALITY_COUNT,
+              "one AQ_THRESHOLDS entry per band above EXCELLENT");
+static_assert(sizeof(AIR_QUALITY_LABELS) / sizeof(AIR_QUALITY_LABELS[0]) == AIR_QUALITY_COUNT,
+              "every AirQuality needs a label");
+static_assert(AirQualityCheck::ascending(), "AQ_THRESHOLDS must be strictly ascending");
+static_assert(classifyAirQuality(0.0F) == AirQuality::EXCELLENT &&
+              classifyAirQuality(AQ_THRESHOLD_EXCELLENT) == AirQuality::GOOD &&
+              classifyAirQuality(AQ_THRESHOLD_HAZARDOUS) == AirQuality::CRITICAL,
+              "a threshold is the lower bound of its band");
+
+#endif
@@ -1,12 +1,7 @@
 #include "alert_controller.h"
 #include <Arduino.h>
-
-// Import config values
-extern const int LED_PIN;
-extern const int BUZZER_PIN;
-extern const float AQ_ALERT_THRESHOLD;
-extern const uint32_t ALERT_BLINK_INTERVAL_MS;
-extern const uint32_t ALERT_BEEP_INTERVAL_MS;
+#include "config.h"
+#include "trace_log.h"
 
 AlertController::AlertController() 
     : ledPin(LED_PIN)
@@ -25,6 +20,8 @@ AlertController::AlertController()
     , beepInterval(ALERT_BEEP_INTERVAL_MS)
     , ledState(false)
     , buzzerState(false)
+    , selfTesting(false)
+    , selfTestStart(0)
     , relayController(nullptr) {}
 
 bool AlertController::init(RelayController* relay) {
@@ -34,21 +31,29 @@ bool AlertController::init(RelayController* relay) {
     digitalWrite(ledPin, LOW);
     digitalWrite(buzzerPin, LOW);
     
-    // Test buzzer
+    // Test chirp; finishSelfTest() ends it, init() does not wait
     Serial.println(F("Testing buzzer..."));
     digitalWrite(buzzerPin, HIGH);
-    delay(200);
-    digitalWrite(buzzerPin, LOW);
+    selfTesting = true;
+    selfTestStart = millis();
     
     isInitialized = true;
     Serial.println(F("Alert controller initialized"));
     return true;
 }
 
+bool AlertController::finishSelfTest() {
+    if (!selfTesting) return true;
+    if (millis() - selfTestStart < ALERT_SELF_TEST_MS) return false;
+    selfTesting = false;
+    digitalWrite(buzzerPin, buzzerState ? HIGH : LOW);
+    return true;
+}
+
 void AlertController::activate() {
     if (!isInitialized) return;
     isActive = true;
-    Serial.println(F("Alert ACTIVATED"));
+    TRACE(ALERT_ACTIVATED);
 }
 
 void AlertController::deactivate() {
@@ -58,7 +63,7 @@ void AlertController::deactivate() {
     buzzerState = false;
     digitalWrite(ledPin, LOW);
     digitalWrite(buzzerPin, LOW);
-    Serial.println(F("Alert DEACTIVATED"));
+    TRACE(ALERT_DEACTIVATED);
 }
 
 void AlertController::update() {
@@ -110,10 +115,10 @@ void AlertController::checkPPMLevel(float ppm) {
     if (!isInitialized || manualOverride || buzzerManualOverride || ledManualOverride) return;
     
     if (ppm >= AQ_ALERT_THRESHOLD && !isActive) {
-        Serial.printf_P(PSTR("PPM %.1f >= %.1f - ACTIVATING\n"), ppm, AQ_ALERT_THRESHOLD);
+        TRACE(ALERT_RAISED, ppm, AQ_ALERT_THRESHOLD);
         activate();
     } else if (ppm < AQ_ALERT_THRESHOLD && isActive) {
-        Serial.printf_P(PSTR("PPM %.1f < %.1f - DEACTIVATING\n"), ppm, AQ_ALERT_THRESHOLD);
+        TRACE(ALERT_CLEARED, ppm, AQ_ALERT_THRESHOLD);
         deactivate();
     }
 }
@@ -25,12 +25,15 @@ private:
     uint32_t beepInterval;
     bool ledState;
     bool buzzerState;
+    bool selfTesting;
+    uint32_t selfTestStart;
     
     RelayController* relayController;
 
 public:
     AlertController();
     bool init(RelayController* relay);
+    bool finishSelfTest();   // Ends the boot chirp once due; true when over
     void activate();
     void deactivate();
     void update();
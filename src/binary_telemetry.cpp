@@ -0,0 +1,301 @@
+#include "binary_telemetry.h"
+#include <cmath>
+#include <cstring>
+
+namespace BinaryTelemetry {
+
+namespace {
+
+void putU16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void putU32(uint8_t* p, uint32_t v) {
+    putU16(p, static_cast<uint16_t>(v));
+    putU16(p + 2, static_cast<uint16_t>(v >> 16));
+}
+
+void putU64(uint8_t* p, uint64_t v) {
+    putU32(p, static_cast<uint32_t>(v));
+    putU32(p + 4, static_cast<uint32_t>(v >> 32));
+}
+
+uint16_t getU16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t getU32(const uint8_t* p) {
+    return getU16(p) | (static_cast<uint32_t>(getU16(p + 2)) << 16);
+}
+
+uint64_t getU64(const uint8_t* p) {
+    return getU32(p) | (static_cast<uint64_t>(getU32(p + 4)) << 32);
+}
+
+void putFloat(uint8_t* p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    putU32(p, bits);
+}
+
+float getFloat(const uint8_t* p) {
+    const uint32_t bits = getU32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+void putHeader(uint8_t* p, Schema schema, uint8_t flags, uint16_t sequence, uint32_t timestamp) {
+    p[0] = MAGIC;
+    p[1] = VERSION;
+    p[2] = static_cast<uint8_t>(schema);
+    p[3] = flags;
+    putU16(p + 4, sequence);
+    putU32(p + 6, timestamp);
+}
+
+// Fixed-point field with a sentinel for NaN; out-of-range values saturate.
+int16_t toCentiSigned(float v) {
+    if (std::isnan(v)) return TEMPERATURE_UNAVAILABLE;
+    const float scaled = std::round(v * 100.0F);
+    if (scaled <= INT16_MIN + 1) return INT16_MIN + 1;
+    if (scaled >= INT16_MAX) return INT16_MAX;
+    return static_cast<int16_t>(scaled);
+}
+
+uint16_t toCentiUnsigned(float v) {
+    if (std::isnan(v)) return HUMIDITY_UNAVAILABLE;
+    const float scaled = std::round(v * 100.0F);
+    if (scaled <= 0.0F) return 0;
+    if (scaled >= UINT16_MAX - 1) return UINT16_MAX - 1;
+    return static_cast<uint16_t>(scaled);
+}
+
+}  // namespace
+
+uint8_t qualityIndex(const char* name) {
+    if (!name) return QUALITY_UNKNOWN;
+    for (size_t i = 0; i < QUALITY_COUNT; ++i) {
+        if (strcmp(name, AIR_QUALITY_LABELS[i]) == 0) return static_cast<uint8_t>(i);
+    }
+    return QUALITY_UNKNOWN;
+}
+
+const char* qualityName(uint8_t index) {
+    return airQualityLabel(static_cast<AirQuality>(index));
+}
+
+const char* bootStageName(uint8_t stage) {
+    return stage < static_cast<uint8_t>(BootStage::COUNT) ? BOOT_STAGE_NAMES[stage] : "unknown";
+}
+
+size_t encode(const SensorFrame& frame, uint8_t* out, size_t capacity) {
+    if (capacity < SENSOR_FRAME_SIZE) return 0;
+    putHeader(out, Schema::SENSOR, frame.relayOn ? FLAG_RELAY_ON : 0, frame.sequence, frame.timestamp);
+    uint32_t ppmBits;
+    memcpy(&ppmBits, &frame.ppm, sizeof(ppmBits));
+    putU32(out + 10, ppmBits);
+    putU16(out + 14, static_cast<uint16_t>(toCentiSigned(frame.temperature)));
+    putU16(out + 16, toCentiUnsigned(frame.humidity));
+    out[18] = frame.quality;
+    return SENSOR_FRAME_SIZE;
+}
+
+size_t encode(const StatusFrame& frame, uint8_t* out, size_t capacity) {
+    if (frame.bootSpans > MAX_BOOT_SPANS) return 0;
+    const size_t size = frame.bootSpans > 0 ? STATUS_BOOT_HEADER_SIZE + frame.bootSpans * BOOT_SPAN_SIZE
+                                            : STATUS_FRAME_SIZE;
+    if (capacity < size) return 0;
+    const uint8_t flags = (frame.online ? FLAG_ONLINE : 0) | (frame.bootSpans > 0 ? FLAG_BOOT_TIMELINE : 0);
+    putHeader(out, Schema::STATUS, flags, frame.sequence, frame.timestamp);
+    if (frame.bootSpans == 0) return size;
+    out[10] = frame.bootSpans;
+    for (size_t i = 0; i < frame.bootSpans; ++i) {
+        uint8_t* span = out + STATUS_BOOT_HEADER_SIZE + i * BOOT_SPAN_SIZE;
+        span[0] = frame.boot[i].stage;
+        putU32(span + 1, frame.boot[i].startUs);
+        putU32(span + 5, frame.boot[i].endUs);
+    }
+    return size;
+}
+
+size_t encode(const BatchHeader& header, uint8_t* out, size_t capacity) {
+    if (capacity < BATCH_HEADER_SIZE) return 0;
+    const uint8_t flags =
+        (header.replay ? BATCH_FLAG_REPLAY : 0) | (header.gasEstimates > 0 ? BATCH_FLAG_GAS_ESTIMATES : 0);
+    putHeader(out, Schema::SENSOR_BATCH, flags, header.sequence, header.timestamp);
+    out[10] = header.count;
+    out[11] = header.gasChannels;
+    return BATCH_HEADER_SIZE;
+}
+
+size_t encodeGasEstimates(const BatchHeader& header, uint8_t* out, size_t capacity) {
+    const size_t size = 1 + 4 * header.gasEstimates;
+    if (header.gasEstimates == 0 || header.gasEstimates > MAX_GAS_ESTIMATES || capacity < size) return 0;
+    out[0] = header.gasEstimates;
+    for (size_t i = 0; i < header.gasEstimates; ++i) putFloat(out + 1 + 4 * i, header.gasEstimate[i]);
+    return size;
+}
+
+size_t encode(const SampleRecord& record, uint8_t* out, size_t capacity) {
+    return encode(record, record.gasChannels, out, capacity);
+}
+
+size_t encode(const SampleRecord& record, uint8_t gasChannels, uint8_t* out, size_t capacity) {
+    if (gasChannels == 0 || gasChannels > MAX_GAS_CHANNELS || capacity < recordSize(gasChannels)) return 0;
+    putU64(out, record.timestamp);
+    putFloat(out + 8, record.ppm);
+    putU16(out + 12, static_cast<uint16_t>(toCentiSigned(record.temperature)));
+    putU16(out + 14, toCentiUnsigned(record.humidity));
+    out[16] = record.quality;
+    out[17] = record.flags;
+    for (size_t i = 0; i + 1 < gasChannels; ++i) {
+        putFloat(out + BATCH_RECORD_SIZE + 4 * i, i + 1 < record.gasChannels ? record.gasPpm[i] : NAN);
+    }
+    return recordSize(gasChannels);
+}
+
+DecodeError peekSchema(const uint8_t* data, size_t length, Schema& schema) {
+    if (length < 3) return DecodeError::TOO_SHORT;
+    if (data[0] != MAGIC) return DecodeError::BAD_MAGIC;
+    if (data[1] != VERSION) return DecodeError::UNSUPPORTED_VERSION;
+    if (data[2] < static_cast<uint8_t>(Schema::SENSOR) || data[2] > static_cast<uint8_t>(Schema::SENSOR_BATCH)) {
+        return DecodeError::UNKNOWN_SCHEMA;
+    }
+    schema = static_cast<Schema>(data[2]);
+    return DecodeError::NONE;
+}
+
+DecodeError decode(const uint8_t* data, size_t length, SensorFrame& frame) {
+    Schema schema;
+    const DecodeError err = peekSchema(data, length, schema);
+    if (err != DecodeError::NONE) return err;
+    if (schema != Schema::SENSOR) return DecodeError::UNKNOWN_SCHEMA;
+    if (length != SENSOR_FRAME_SIZE) return DecodeError::BAD_LENGTH;
+    if (data[3] & ~FLAG_RELAY_ON) return DecodeError::BAD_VALUE;
+
+    frame.relayOn = (data[3] & FLAG_RELAY_ON) != 0;
+    frame.sequence = getU16(data + 4);
+    frame.timestamp = getU32(data + 6);
+    const uint32_t ppmBits = getU32(data + 10);
+    memcpy(&frame.ppm, &ppmBits, sizeof(frame.ppm));
+    const int16_t t = static_cast<int16_t>(getU16(data + 14));
+    const uint16_t h = getU16(data + 16);
+    frame.temperature = (t == TEMPERATURE_UNAVAILABLE) ? NAN : t / 100.0F;
+    frame.humidity = (h == HUMIDITY_UNAVAILABLE) ? NAN : h / 100.0F;
+    frame.quality = data[18];
+
+    if (!std::isfinite(frame.ppm) || frame.ppm < 0.0F) return DecodeError::BAD_VALUE;
+    if (frame.quality >= QUALITY_COUNT && frame.quality != QUALITY_UNKNOWN) return DecodeError::BAD_VALUE;
+    return DecodeError::NONE;
+}
+
+DecodeError decode(const uint8_t* data, size_t length, StatusFrame& frame) {
+    Schema schema;
+    const DecodeError err = peekSchema(data, length, schema);
+    if (err != DecodeError::NONE) return err;
+    if (schema != Schema::STATUS) return DecodeError::UNKNOWN_SCHEMA;
+    if (data[3] & ~(FLAG_ONLINE | FLAG_BOOT_TIMELINE)) return DecodeError::BAD_VALUE;
+    const bool timeline = (data[3] & FLAG_BOOT_TIMELINE) != 0;
+    if (!timeline && length != STATUS_FRAME_SIZE) return DecodeError::BAD_LENGTH;
+    if (timeline) {
+        if (length < STATUS_BOOT_HEADER_SIZE) return DecodeError::TOO_SHORT;
+        if (length != STATUS_BOOT_HEADER_SIZE + data[10] * BOOT_SPAN_SIZE) return DecodeError::BAD_LENGTH;
+        if (data[10] == 0 || data[10] > MAX_BOOT_SPANS) return DecodeError::BAD_VALUE;
+    }
+
+    frame.online = (data[3] & FLAG_ONLINE) != 0;
+    frame.sequence = getU16(data + 4);
+    frame.timestamp = getU32(data + 6);
+    frame.bootSpans = timeline ? data[10] : 0;
+    for (size_t i = 0; i < frame.bootSpans; ++i) {
+        const uint8_t* span = data + STATUS_BOOT_HEADER_SIZE + i * BOOT_SPAN_SIZE;
+        frame.boot[i].stage = span[0];
+        frame.boot[i].startUs = getU32(span + 1);
+        frame.boot[i].endUs = getU32(span + 5);
+    }
+    return DecodeError::NONE;
+}
+
+DecodeError decode(const uint8_t* data, size_t length, BatchHeader& header) {
+    Schema schema;
+    const DecodeError err = peekSchema(data, length, schema);
+    if (err != DecodeError::NONE) return err;
+    if (schema != Schema::SENSOR_BATCH) return DecodeError::UNKNOWN_SCHEMA;
+    if (length < BATCH_HEADER_SIZE) return DecodeError::TOO_SHORT;
+    if (data[11] == 0 || data[11] > MAX_GAS_CHANNELS) return DecodeError::BAD_VALUE;
+    if (data[3] & ~(BATCH_FLAG_REPLAY | BATCH_FLAG_GAS_ESTIMATES)) return DecodeError::BAD_VALUE;
+    const size_t records = BATCH_HEADER_SIZE + data[10] * recordSize(data[11]);
+    const bool estimates = (data[3] & BATCH_FLAG_GAS_ESTIMATES) != 0;
+    if (estimates) {
+        if (length <= records) return DecodeError::TOO_SHORT;
+        if (data[records] == 0 || data[records] > MAX_GAS_ESTIMATES) return DecodeError::BAD_VALUE;
+    }
+    if (length != records + (estimates ? 1 + 4 * data[records] : 0)) return DecodeError::BAD_LENGTH;
+
+    header.sequence = getU16(data + 4);
+    header.timestamp = getU32(data + 6);
+    header.count = data[10];
+    header.gasChannels = data[11];
+    header.replay = (data[3] & BATCH_FLAG_REPLAY) != 0;
+    header.gasEstimates = estimates ? data[records] : 0;
+    for (size_t i = 0; i < header.gasEstimates; ++i) {
+        header.gasEstimate[i] = getFloat(data + records + 1 + 4 * i);
+        if (!std::isfinite(header.gasEstimate[i]) || header.gasEstimate[i] < 0.0F) return DecodeError::BAD_VALUE;
+    }
+
+    SampleRecord record;
+    for (size_t i = 0; i < header.count; ++i) {
+        const DecodeError recordErr = decodeRecord(data, length, i, record);
+        if (recordErr != DecodeError::NONE) return recordErr;
+    }
+    return DecodeError::NONE;
+}
+
+DecodeError decodeRecord(const uint8_t* data, size_t length, size_t index, SampleRecord& record) {
+    if (length < BATCH_HEADER_SIZE) return DecodeError::TOO_SHORT;
+    if (data[11] == 0 || data[11] > MAX_GAS_CHANNELS) return DecodeError::BAD_VALUE;
+    const size_t size = recordSize(data[11]);
+    const size_t offset = BATCH_HEADER_SIZE + index * size;
+    if (offset + size > length) return DecodeError::BAD_LENGTH;
+    return decode(data + offset, size, record);
+}
+
+DecodeError decode(const uint8_t* p, size_t length, SampleRecord& record) {
+    if (length < BATCH_RECORD_SIZE) return DecodeError::TOO_SHORT;
+    if ((length - BATCH_RECORD_SIZE) % 4 != 0 || length > recordSize(MAX_GAS_CHANNELS)) return DecodeError::BAD_LENGTH;
+
+    record.timestamp = getU64(p);
+    record.ppm = getFloat(p + 8);
+    const int16_t t = static_cast<int16_t>(getU16(p + 12));
+    const uint16_t h = getU16(p + 14);
+    record.temperature = (t == TEMPERATURE_UNAVAILABLE) ? NAN : t / 100.0F;
+    record.humidity = (h == HUMIDITY_UNAVAILABLE) ? NAN : h / 100.0F;
+    record.quality = p[16];
+    record.flags = p[17];
+    record.gasChannels = static_cast<uint8_t>(1 + (length - BATCH_RECORD_SIZE) / 4);
+    for (size_t i = 0; i + 1 < record.gasChannels; ++i) {
+        record.gasPpm[i] = getFloat(p + BATCH_RECORD_SIZE + 4 * i);
+        if (std::isinf(record.gasPpm[i]) || record.gasPpm[i] < 0.0F) return DecodeError::BAD_VALUE;
+    }
+
+    if (!std::isfinite(record.ppm) || record.ppm < 0.0F) return DecodeError::BAD_VALUE;
+    if (record.quality >= QUALITY_COUNT && record.quality != QUALITY_UNKNOWN) return DecodeError::BAD_VALUE;
+    return DecodeError::NONE;
+}
+
+const char* errorName(DecodeError error) {
+    switch (error) {
+        case DecodeError::NONE: return "ok";
+        case DecodeError::TOO_SHORT: return "too short";
+        case DecodeError::BAD_MAGIC: return "bad magic";
+        case DecodeError::UNSUPPORTED_VERSION: return "unsupported version";
+        case DecodeError::UNKNOWN_SCHEMA: return "unknown schema";
+        case DecodeError::BAD_LENGTH: return "bad length";
+        case DecodeError::BAD_VALUE: return "bad value";
+    }
+    return "unknown error";
+}
+
+}  // namespace BinaryTelemetry
@@ -0,0 +1,225 @@
+#ifndef BINARY_TELEMETRY_H
+#define BINARY_TELEMETRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include "air_quality.h"
+
+// ============================================================================
+// Compact binary payload for the sensor and status topics.
+//
+// Fixed little-endian layout, versioned by a magic byte, a format version and
+// a schema id. The first byte can never be '{', so consumers can accept JSON
+// and binary payloads on the same topic. The device id is not repeated in the
+// frame; it is already part of the topic.
+//
+//   Sensor (schema 1, 19 bytes)         Status (schema 2, 10 bytes)
+//   0  u8   magic 0xA7                  0  u8   magic 0xA7
+//   1  u8   version                     1  u8   version
+//   2  u8   schema = 1                  2  u8   schema = 2
+//   3  u8   flags (bit0 relay ON)       3  u8   flags (bit0 online, bit1 boot timeline)
+//   4  u16  sequence                    4  u16  sequence
+//   6  u32  uptime, ms since boot       6  u32  uptime, ms since boot
+//   10 f32  ppm                         with bit1, 11 + 9 * count bytes:
+//                                       10 u8   count
+//                                       11 count stages, in boot order:
+//                                          +0 u8  stage, index into BOOT_STAGE_NAMES
+//                                                 (bit7 set = failed or skipped)
+//                                          +1 u32 start, us since boot
+//                                          +5 u32 end, us since boot
+//                                                 (0xFFFFFFFF = still running)
+//   14 i16  temperature, 0.01 °C (INT16_MIN = not available)
+//   16 u16  humidity, 0.01 %    (UINT16_MAX = not available)
+//   18 u8   quality index, an AirQuality (0xFF = unknown)
+//
+//   Sensor batch (schema 3, 12 + (14 + 4 * gas) * count bytes, + 1 + 4 * n
+//   with bit1)
+//   0  header as above, flags (bit0 replayed from flash, bit1 gas estimates),
+//      uptime = time of publish
+//   10 u8   count
+//   11 u8   gas, gas channels per record (1-8)
+//   12 count records, oldest first:
+//      +0  u64  acquisition time, us since the Unix epoch (bit2 clear) or
+//               us since boot when the clock was not yet synced (bit2 set)
+//      +8  f32  ppm of the first gas channel
+//      +12 i16  temperature (as above)
+//      +14 u16  humidity (as above)
+//      +16 u8   quality index
+//      +17 u8   flags (bit0 relay ON, bit1 alert active, bit2 uptime timestamp,
+//               bit3 gas sensor warming up, ppm indicative only, bit4 gas
+//               sensor calibration failed, ppm on an old R0 or 0)
+//      +18 f32  ppm of each further gas channel, gas - 1 of them, in the
+//               device's channel order (NaN = not available)
+//   with bit1, after the records, the first channel's per-gas estimates of
+//   the latest reading (live batches only):
+//      +0  u8   n (1-8)
+//      +1  f32  ppm per gas, n of them, in the device's gas order
+//
+// Version 1 carried a u32 ms-since-boot record timestamp (14-byte records),
+// version 2 a single gas channel (no gas byte, 18-byte records), version 3
+// no gas estimates. Record flag bits are additive: bit3 arrived within
+// version 2, bit4 within version 4, and decoders must ignore record flags
+// they do not know.
+//
+// Shared with the host decoder (tools/telemetry_decode), so this file must not
+// depend on the Arduino core.
+// ============================================================================
+namespace BinaryTelemetry {
+
+constexpr uint8_t MAGIC = 0xA7;
+constexpr uint8_t VERSION = 4;
+
+enum class Schema : uint8_t {
+    SENSOR = 1,
+    STATUS = 2,
+    SENSOR_BATCH = 3
+};
+
+constexpr size_t SENSOR_FRAME_SIZE = 19;
+constexpr size_t STATUS_FRAME_SIZE = 10;
+constexpr size_t STATUS_BOOT_HEADER_SIZE = 11;
+constexpr size_t BOOT_SPAN_SIZE = 9;
+constexpr size_t MAX_BOOT_SPANS = 16;
+constexpr size_t BATCH_HEADER_SIZE = 12;
+constexpr size_t BATCH_RECORD_SIZE = 18;      // With one gas channel
+constexpr size_t MAX_BATCH_RECORDS = 255;
+constexpr size_t MAX_GAS_CHANNELS = 8;        // One per ADC1 channel
+constexpr size_t MAX_GAS_ESTIMATES = 8;
+
+constexpr size_t recordSize(size_t gasChannels) { return BATCH_RECORD_SIZE + 4 * (gasChannels - 1); }
+
+constexpr uint8_t FLAG_RELAY_ON = 0x01;
+constexpr uint8_t FLAG_ONLINE = 0x01;
+constexpr uint8_t FLAG_BOOT_TIMELINE = 0x02;
+constexpr uint8_t RECORD_FLAG_RELAY_ON = 0x01;
+constexpr uint8_t RECORD_FLAG_ALERT = 0x02;
+constexpr uint8_t RECORD_FLAG_UPTIME = 0x04;    // timestamp is us since boot, not wall clock
+constexpr uint8_t RECORD_FLAG_WARMING = 0x08;   // MQ-2 heater not yet stable, ppm indicative only
+constexpr uint8_t RECORD_FLAG_CAL_FAILED = 0x10;   // a gas sensor could not calibrate, ppm stale or 0
+constexpr uint8_t RECORD_STATE_FLAGS = RECORD_FLAG_RELAY_ON | RECORD_FLAG_ALERT | RECORD_FLAG_CAL_FAILED;
+constexpr uint8_t BATCH_FLAG_REPLAY = 0x01;
+constexpr uint8_t BATCH_FLAG_GAS_ESTIMATES = 0x02;
+
+constexpr int16_t TEMPERATURE_UNAVAILABLE = INT16_MIN;
+constexpr uint16_t HUMIDITY_UNAVAILABLE = UINT16_MAX;
+constexpr uint8_t QUALITY_UNKNOWN = 0xFF;
+
+// The quality index is the AirQuality value (air_quality.h)
+constexpr size_t QUALITY_COUNT = AIR_QUALITY_COUNT;
+
+// Boot stages as numbered in the status frame's timeline
+enum class BootStage : uint8_t {
+    OLED = 0,
+    RELAY,
+    ALERT,
+    MQ2,
+    DHT,
+    STORAGE,
+    WIFI,
+    CLOCK,
+    BROKER,
+    FIRST_PUBLISH,
+    COUNT
+};
+
+constexpr const char* BOOT_STAGE_NAMES[] = {
+    "oled", "relay", "alert", "mq2", "dht", "storage", "wifi", "clock", "broker", "first_publish"
+};
+static_assert(sizeof(BOOT_STAGE_NAMES) / sizeof(BOOT_STAGE_NAMES[0]) == static_cast<size_t>(BootStage::COUNT),
+              "one name per boot stage");
+
+constexpr uint32_t BOOT_SPAN_RUNNING = UINT32_MAX;
+constexpr uint8_t BOOT_SPAN_FAILED = 0x80;
+
+struct BootSpan {
+    uint8_t stage;      // BootStage, | BOOT_SPAN_FAILED
+    uint32_t startUs;
+    uint32_t endUs;     // BOOT_SPAN_RUNNING while the stage has not finished
+};
+
+struct SensorFrame {
+    uint16_t sequence;
+    uint32_t timestamp;
+    float ppm;
+    float temperature;  // NaN when not available
+    float humidity;     // NaN when not available
+    uint8_t quality;
+    bool relayOn;
+};
+
+// One reading inside a sensor batch
+struct SampleRecord {
+    uint64_t timestamp;  // us, see RECORD_FLAG_UPTIME
+    float ppm;           // First gas channel
+    float temperature;  // NaN when not available
+    float humidity;     // NaN when not available
+    uint8_t quality;
+    uint8_t flags;      // RECORD_FLAG_*
+    uint8_t gasChannels = 1;                    // ppm plus gasPpm[0 .. gasChannels - 2]
+    float gasPpm[MAX_GAS_CHANNELS - 1] = {};    // Further gas channels; NaN when not available
+    // Per-gas estimates of the first channel; not part of the record, only
+    // sent with the latest reading of a live batch
+    uint8_t gasEstimates = 0;
+    float gasEstimate[MAX_GAS_ESTIMATES] = {};
+};
+
+struct BatchHeader {
+    uint16_t sequence;
+    uint32_t timestamp;
+    uint8_t count;
+    uint8_t gasChannels;  // Per record; records with fewer are padded with NaN
+    bool replay;        // readings held back during an outage, not live
+    uint8_t gasEstimates = 0;                   // 0 = none follow the records
+    float gasEstimate[MAX_GAS_ESTIMATES] = {};
+};
+
+struct StatusFrame {
+    uint16_t sequence;
+    uint32_t timestamp;
+    bool online;
+    uint8_t bootSpans;  // 0 = no timeline
+    BootSpan boot[MAX_BOOT_SPANS];
+};
+
+enum class DecodeError : uint8_t {
+    NONE = 0,
+    TOO_SHORT,
+    BAD_MAGIC,
+    UNSUPPORTED_VERSION,
+    UNKNOWN_SCHEMA,
+    BAD_LENGTH,
+    BAD_VALUE
+};
+
+uint8_t qualityIndex(const char* name);
+const char* qualityName(uint8_t index);
+const char* bootStageName(uint8_t stage);
+
+// Return the number of bytes written, or 0 if capacity is too small.
+size_t encode(const SensorFrame& frame, uint8_t* out, size_t capacity);
+size_t encode(const StatusFrame& frame, uint8_t* out, size_t capacity);
+// A batch is a header followed by header.count records written in order,
+// then encodeGasEstimates() when header.gasEstimates > 0.
+size_t encode(const BatchHeader& header, uint8_t* out, size_t capacity);
+size_t encodeGasEstimates(const BatchHeader& header, uint8_t* out, size_t capacity);
+size_t encode(const SampleRecord& record, uint8_t* out, size_t capacity);
+// Exactly gasChannels channels: missing ones as NaN, extra ones left out
+size_t encode(const SampleRecord& record, uint8_t gasChannels, uint8_t* out, size_t capacity);
+
+// Reads the schema byte after checking magic and version.
+DecodeError peekSchema(const uint8_t* data, size_t length, Schema& schema);
+DecodeError decode(const uint8_t* data, size_t length, SensorFrame& frame);
+DecodeError decode(const uint8_t* data, size_t length, StatusFrame& frame);
+// Validates the whole batch and reads the gas estimates; records are then
+// read with decodeRecord().
+DecodeError decode(const uint8_t* data, size_t length, BatchHeader& header);
+DecodeError decodeRecord(const uint8_t* data, size_t length, size_t index, SampleRecord& record);
+// A single record as written by encode(const SampleRecord&, ...); the gas
+// channel count follows from the length.
+DecodeError decode(const uint8_t* data, size_t length, SampleRecord& record);
+
+const char* errorName(DecodeError error);
+
+}  // namespace BinaryTelemetry
+
+#endif
@@ -0,0 +1,93 @@
+#include "boot_sequence.h"
+#include <Arduino.h>
+#include "time_service.h"
+
+BootSequence::BootSequence(const BootStep* steps, size_t count)
+    : steps(steps)
+    , count(count > MAX_STEPS ? MAX_STEPS : count)
+    , startUs{0}
+    , endUs{0}
+    , started(0)
+    , finished(0)
+    , failed(0)
+    , all(static_cast<uint16_t>((1UL << this->count) - 1))
+    , reported(false) {}
+
+void BootSequence::end(size_t step, bool ok, uint64_t now) {
+    endUs[step] = now;
+    finished |= bootBit(step);
+    if (!ok) failed |= bootBit(step);
+}
+
+// Sweeps until nothing changes, so a chain of stages that complete at once
+// runs in a single call.
+bool BootSequence::update() {
+    bool progressed = true;
+    while (progressed) {
+        progressed = false;
+        for (size_t i = 0; i < count; ++i) {
+            const uint16_t bit = bootBit(i);
+            const BootStep& step = steps[i];
+            if (finished & bit) continue;
+
+            if (started & bit) {
+                if (step.ready && step.ready()) {
+                    end(i, true, TimeService::monotonicUs());
+                    progressed = true;
+                }
+                continue;
+            }
+
+            if (step.after & failed) {
+                // Skipped: never started, ends failed
+                startUs[i] = TimeService::monotonicUs();
+                started |= bit;
+                end(i, false, startUs[i]);
+                Serial.printf_P(PSTR("Boot: %s skipped\n"), step.name);
+                progressed = true;
+                continue;
+            }
+            if ((step.after & finished) != step.after) continue;
+
+            startUs[i] = TimeService::monotonicUs();
+            started |= bit;
+            progressed = true;
+            if (!step.start) continue;   // Milestone, ended by finish()
+            if (!step.start()) {
+                end(i, false, TimeService::monotonicUs());
+                Serial.printf_P(PSTR("Boot: %s failed\n"), step.name);
+            } else if (!step.ready) {
+                end(i, true, TimeService::monotonicUs());
+            }
+        }
+    }
+
+    if (reported || !isComplete()) return false;
+    reported = true;
+    return true;
+}
+
+void BootSequence::finish(size_t step) {
+    if (step >= count || !isStarted(step) || isFinished(step)) return;
+    end(step, true, TimeService::monotonicUs());
+}
+
+size_t BootSequence::finishedCount() const {
+    return static_cast<size_t>(__builtin_popcount(finished));
+}
+
+void BootSequence::printTimeline() const {
+    Serial.println(F("Boot timeline (us since boot):"));
+    for (size_t i = 0; i < count; ++i) {
+        if (!isStarted(i)) {
+            Serial.printf_P(PSTR("  %-14s waiting\n"), steps[i].name);
+        } else if (!isFinished(i)) {
+            Serial.printf_P(PSTR("  %-14s %10llu ..    running\n"), steps[i].name,
+                            static_cast<unsigned long long>(startUs[i]));
+        } else {
+            Serial.printf_P(PSTR("  %-14s %10llu .. %10llu %s\n"), steps[i].name,
+                            static_cast<unsigned long long>(startUs[i]), static_cast<unsigned long long>(endUs[i]),
+                            isFailed(i) ? "failed" : "");
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef BOOT_SEQUENCE_H
+#define BOOT_SEQUENCE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// One bring-up stage. start() runs once every stage in `after` has finished;
+// ready(), if set, is then polled until the stage is done. A stage without
+// start() is a milestone: it begins with its dependencies and ends when the
+// caller reports it through finish().
+struct BootStep {
+    const char* name;
+    uint16_t after;      // Stages that must finish first, bootBit() of each
+    bool (*start)();     // False if the stage failed
+    bool (*ready)();     // nullptr if start() completes the stage
+};
+
+constexpr uint16_t bootBit(size_t step) { return static_cast<uint16_t>(1U << step); }
+
+// ============================================================================
+// Boot as a dependency graph instead of a fixed call order.
+//
+// update() starts every stage whose dependencies are done and polls the ones
+// still running; setup() calls it once and the loop keeps calling it, so a
+// slow stage (WiFi association, MQ-2 heater) never holds up the stages that
+// do not need it. Stages that depend on a failed stage are skipped. Each
+// stage's start and end are kept, in us since boot, for the timeline.
+// ============================================================================
+class BootSequence {
+public:
+    static constexpr size_t MAX_STEPS = 16;
+
+private:
+    const BootStep* steps;
+    size_t count;
+    uint64_t startUs[MAX_STEPS];
+    uint64_t endUs[MAX_STEPS];
+    uint16_t started;
+    uint16_t finished;
+    uint16_t failed;
+    uint16_t all;
+    bool reported;
+
+    void end(size_t step, bool ok, uint64_t now);
+
+public:
+    BootSequence(const BootStep* steps, size_t count);
+    bool update();   // Non-blocking; true on the call that finished the last stage
+    void finish(size_t step);   // Ends a running milestone
+
+    size_t size() const { return count; }
+    const char* name(size_t step) const { return steps[step].name; }
+    bool isStarted(size_t step) const { return started & bootBit(step); }
+    bool isFinished(size_t step) const { return finished & bootBit(step); }
+    bool isFailed(size_t step) const { return failed & bootBit(step); }
+    bool isComplete() const { return finished == all; }
+    size_t finishedCount() const;
+    uint64_t getStartUs(size_t step) const { return startUs[step]; }   // Valid once started
+    uint64_t getEndUs(size_t step) const { return endUs[step]; }       // Valid once finished
+
+    void printTimeline() const;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// ============================================================================
+// Single-producer / single-consumer ring of preallocated command slots.
+//
+// The producer (MQTT or WebSocket callback) copies each payload into the next
+// free slot with one memcpy; the consumer reads it in place through front()
+// and releases it with pop(). Only the producer writes `tail` and only the
+// consumer writes `head`, so the two sides may run on different tasks or
+// cores without a lock. A full queue rejects the new command and a payload
+// longer than SLOT_BYTES is rejected outright; both are counted rather than
+// silently overwriting an older command. No heap.
+// ============================================================================
+template <size_t SLOTS, size_t SLOT_BYTES>
+class CommandQueue {
+    static_assert(SLOTS >= 2 && (SLOTS & (SLOTS - 1)) == 0, "slot count must be a power of two");
+    static_assert(SLOT_BYTES <= UINT16_MAX, "slot length must fit in 16 bits");
+
+private:
+    struct Slot {
+        uint16_t length;
+        char data[SLOT_BYTES + 1];   // NUL-terminated for convenience
+    };
+
+    Slot slots[SLOTS];
+    std::atomic<uint32_t> head;      // next slot to read (consumer)
+    std::atomic<uint32_t> tail;      // next slot to write (producer)
+    std::atomic<uint32_t> dropped;   // rejected because the queue was full
+    std::atomic<uint32_t> oversized; // rejected because the payload did not fit a slot
+
+public:
+    CommandQueue() : slots{}, head(0), tail(0), dropped(0), oversized(0) {}
+
+    // Producer side
+    bool push(const uint8_t* payload, size_t length) {
+        if (length > SLOT_BYTES) {
+            oversized.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        const uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == SLOTS) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        Slot& slot = slots[t & (SLOTS - 1)];
+        memcpy(slot.data, payload, length);
+        slot.data[length] = '\0';
+        slot.length = static_cast<uint16_t>(length);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: oldest pending command, or nullptr when empty. The data
+    // stays valid until pop().
+    const char* front(size_t& length) const {
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return nullptr;
+        const Slot& slot = slots[h & (SLOTS - 1)];
+        length = slot.length;
+        return slot.data;
+    }
+
+    void pop() {
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        if (h != tail.load(std::memory_order_acquire)) head.store(h + 1, std::memory_order_release);
+    }
+
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return SLOTS; }
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+    uint32_t getOversized() const { return oversized.load(std::memory_order_relaxed); }
+};
+
+#endif
@@ -0,0 +1,308 @@
+#include "command_table.h"
+#include <Arduino.h>
+#include <cstring>
+
+namespace {
+
+struct Cursor {
+    const char* p;
+    const char* end;
+};
+
+void skipSpace(Cursor& c) {
+    while (c.p < c.end && (*c.p == ' ' || *c.p == '\t' || *c.p == '\n' || *c.p == '\r')) ++c.p;
+}
+
+bool consume(Cursor& c, char expected) {
+    skipSpace(c);
+    if (c.p >= c.end || *c.p != expected) return false;
+    ++c.p;
+    return true;
+}
+
+bool literal(Cursor& c, const char* word) {
+    const size_t n = strlen(word);
+    if (static_cast<size_t>(c.end - c.p) < n || memcmp(c.p, word, n) != 0) return false;
+    c.p += n;
+    return true;
+}
+
+int hexDigit(char h) {
+    if (h >= '0' && h <= '9') return h - '0';
+    if (h >= 'a' && h <= 'f') return h - 'a' + 10;
+    if (h >= 'A' && h <= 'F') return h - 'A' + 10;
+    return -1;
+}
+
+// Reads a string token (cursor on the opening quote) and unescapes it into
+// out. Characters past capacity are dropped and reported through `fits`;
+// pass capacity 0 to skip the string.
+bool readString(Cursor& c, char* out, size_t capacity, size_t& length, bool& fits) {
+    length = 0;
+    fits = true;
+    ++c.p;
+    auto put = [&](char ch) {
+        if (length < capacity) out[length] = ch;
+        else fits = false;
+        ++length;
+    };
+    while (c.p < c.end) {
+        char ch = *c.p++;
+        if (ch == '"') return true;
+        if (static_cast<unsigned char>(ch) < 0x20) return false;
+        if (ch != '\\') {
+            put(ch);
+            continue;
+        }
+        if (c.p >= c.end) return false;
+        ch = *c.p++;
+        switch (ch) {
+            case '"': case '\\': case '/': put(ch); break;
+            case 'b': put('\b'); break;
+            case 'f': put('\f'); break;
+            case 'n': put('\n'); break;
+            case 'r': put('\r'); break;
+            case 't': put('\t'); break;
+            case 'u': {
+                if (c.end - c.p < 4) return false;
+                uint32_t cp = 0;
+                for (int i = 0; i < 4; ++i) {
+                    const int d = hexDigit(*c.p++);
+                    if (d < 0) return false;
+                    cp = (cp << 4) | static_cast<uint32_t>(d);
+                }
+                // UTF-8; a surrogate half has no meaning on the OLED, keep a placeholder
+                if (cp >= 0xD800 && cp <= 0xDFFF) {
+                    put('?');
+                } else if (cp < 0x80) {
+                    put(static_cast<char>(cp));
+                } else if (cp < 0x800) {
+                    put(static_cast<char>(0xC0 | (cp >> 6)));
+                    put(static_cast<char>(0x80 | (cp & 0x3F)));
+                } else {
+                    put(static_cast<char>(0xE0 | (cp >> 12)));
+                    put(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                    put(static_cast<char>(0x80 | (cp & 0x3F)));
+                }
+                break;
+            }
+            default: return false;
+        }
+    }
+    return false;
+}
+
+// JSON number without strtod (newlib's allocates for long mantissas).
+bool readNumber(Cursor& c, double& value) {
+    bool negative = false;
+    if (c.p < c.end && *c.p == '-') { negative = true; ++c.p; }
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int digits = 0;
+    auto accumulate = [&](char d, bool fraction) {
+        if (mantissa < 100000000000000000ULL) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(d - '0');
+            if (fraction) --exponent;
+        } else if (!fraction) {
+            ++exponent;
+        }
+        ++digits;
+    };
+    while (c.p < c.end && *c.p >= '0' && *c.p <= '9') accumulate(*c.p++, false);
+    if (digits == 0) return false;
+    if (c.p < c.end && *c.p == '.') {
+        ++c.p;
+        const int before = digits;
+        while (c.p < c.end && *c.p >= '0' && *c.p <= '9') accumulate(*c.p++, true);
+        if (digits == before) return false;
+    }
+    if (c.p < c.end && (*c.p == 'e' || *c.p == 'E')) {
+        ++c.p;
+        bool expNegative = false;
+        if (c.p < c.end && (*c.p == '+' || *c.p == '-')) expNegative = *c.p++ == '-';
+        if (c.p >= c.end || *c.p < '0' || *c.p > '9') return false;
+        int e = 0;
+        while (c.p < c.end && *c.p >= '0' && *c.p <= '9') {
+            if (e < 1000) e = e * 10 + (*c.p - '0');
+            ++c.p;
+        }
+        exponent += expNegative ? -e : e;
+    }
+    double v = static_cast<double>(mantissa);
+    for (; exponent > 0 && v < 1e300; --exponent) v *= 10.0;
+    for (; exponent < 0 && v > 0.0; ++exponent) v /= 10.0;
+    value = negative ? -v : v;
+    return true;
+}
+
+// Skips an object or array value the schema has no use for.
+bool skipContainer(Cursor& c) {
+    int depth = 0;
+    while (c.p < c.end) {
+        const char ch = *c.p;
+        if (ch == '"') {
+            size_t length;
+            bool fits;
+            if (!readString(c, nullptr, 0, length, fits)) return false;
+            continue;
+        }
+        ++c.p;
+        if (ch == '{' || ch == '[') ++depth;
+        else if ((ch == '}' || ch == ']') && --depth == 0) return true;
+    }
+    return false;
+}
+
+int32_t truncateToInt(double v) {
+    if (v >= 2147483647.0) return INT32_MAX;
+    if (v <= -2147483648.0) return INT32_MIN;
+    return static_cast<int32_t>(v);
+}
+
+}  // namespace
+
+void CommandArgs::set(CommandKey key, const Value& value) {
+    const uint8_t index = static_cast<uint8_t>(key);
+    if (!has(key)) order[orderCount++] = index;
+    present |= 1UL << index;
+    values[index] = value;
+}
+
+bool CommandArgs::getBool(CommandKey key, bool fallback) const {
+    return has(key) ? values[static_cast<uint8_t>(key)].boolean : fallback;
+}
+
+int32_t CommandArgs::getInt(CommandKey key, int32_t fallback) const {
+    return has(key) ? values[static_cast<uint8_t>(key)].integer : fallback;
+}
+
+float CommandArgs::getFloat(CommandKey key, float fallback) const {
+    return has(key) ? values[static_cast<uint8_t>(key)].number : fallback;
+}
+
+const char* CommandArgs::getString(CommandKey key, const char* fallback) const {
+    return has(key) ? text + values[static_cast<uint8_t>(key)].textOffset : fallback;
+}
+
+size_t CommandArgs::getLength(CommandKey key) const {
+    return has(key) ? values[static_cast<uint8_t>(key)].textLength : 0;
+}
+
+CommandDispatcher::CommandDispatcher(const CommandBinding* bindings, size_t count)
+    : actions{}
+    , stats{}
+    , args()
+    , parseErrors(0)
+    , unknownKeys(0) {
+    for (size_t i = 0; i < count; ++i) {
+        actions[static_cast<uint8_t>(bindings[i].key)] = bindings[i].action;
+    }
+}
+
+const CommandSpec* CommandDispatcher::find(const char* name, size_t length) {
+    size_t lo = 0;
+    size_t hi = COMMAND_KEY_COUNT;
+    while (lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        const char* candidate = COMMAND_TABLE[mid].name;
+        int cmp = strncmp(candidate, name, length);
+        if (cmp == 0 && candidate[length] != '\0') cmp = 1;
+        if (cmp == 0) return &COMMAND_TABLE[mid];
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return nullptr;
+}
+
+bool CommandDispatcher::parse(const char* json, size_t length) {
+    Cursor c{json, json + length};
+    args.clear();
+    if (!consume(c, '{')) return false;
+    skipSpace(c);
+    if (c.p < c.end && *c.p == '}') {
+        ++c.p;
+    } else {
+        for (;;) {
+            skipSpace(c);
+            if (c.p >= c.end || *c.p != '"') return false;
+            char key[COMMAND_KEY_MAX_LENGTH + 1];
+            size_t keyLength;
+            bool keyFits;
+            if (!readString(c, key, sizeof(key), keyLength, keyFits)) return false;
+            if (!consume(c, ':')) return false;
+            skipSpace(c);
+            if (c.p >= c.end) return false;
+
+            const CommandSpec* spec = keyFits && keyLength <= COMMAND_KEY_MAX_LENGTH ? find(key, keyLength) : nullptr;
+            if (!spec) ++unknownKeys;
+
+            // Parse the value by what it is, then check it against the schema
+            CommandArgs::Value value{};
+            bool typeOk = false;
+            const char ch = *c.p;
+            if (ch == '"') {
+                char* out = args.text + args.textUsed;
+                const size_t room = spec ? sizeof(args.text) - 1 - args.textUsed : 0;
+                size_t textLength;
+                bool fits;
+                if (!readString(c, out, room, textLength, fits)) return false;
+                if (spec && spec->type == CommandArgType::STRING && fits) {
+                    out[textLength] = '\0';
+                    value.textOffset = static_cast<uint16_t>(args.textUsed);
+                    value.textLength = static_cast<uint16_t>(textLength);
+                    args.textUsed += textLength + 1;
+                    typeOk = true;
+                }
+            } else if (ch == 't' || ch == 'f') {
+                const bool truth = ch == 't';
+                if (!literal(c, truth ? "true" : "false")) return false;
+                value.boolean = truth;
+                typeOk = spec && spec->type == CommandArgType::BOOL;
+            } else if (ch == 'n') {
+                if (!literal(c, "null")) return false;
+                spec = nullptr;   // null reads as absent
+            } else if (ch == '{' || ch == '[') {
+                if (!skipContainer(c)) return false;
+            } else {
+                double number;
+                if (!readNumber(c, number)) return false;
+                value.number = static_cast<float>(number);
+                value.integer = truncateToInt(number);
+                value.boolean = number != 0.0;
+                typeOk = spec && spec->type != CommandArgType::STRING;
+            }
+
+            if (spec) {
+                if (typeOk) args.set(spec->id, value);
+                else stats[static_cast<uint8_t>(spec->id)].errors++;
+            }
+
+            skipSpace(c);
+            if (c.p < c.end && *c.p == ',') { ++c.p; continue; }
+            if (c.p < c.end && *c.p == '}') { ++c.p; break; }
+            return false;
+        }
+    }
+    skipSpace(c);
+    return c.p == c.end || (*c.p == '\0' && c.p + 1 == c.end);
+}
+
+bool CommandDispatcher::dispatch(const char* json, size_t length) {
+    if (!parse(json, length)) {
+        ++parseErrors;
+        return false;
+    }
+    for (uint8_t i = 0; i < args.orderCount; ++i) {
+        const uint8_t index = args.order[i];
+        if (!actions[index]) continue;
+        CommandStats& s = stats[index];
+        const unsigned long start = micros();
+        const bool ok = actions[index](args);
+        const uint32_t elapsed = static_cast<uint32_t>(micros() - start);
+        s.calls++;
+        if (!ok) s.errors++;
+        s.totalUs += elapsed;
+        if (elapsed > s.maxUs) s.maxUs = elapsed;
+    }
+    return true;
+}
@@ -0,0 +1,181 @@
+#ifndef COMMAND_TABLE_H
+#define COMMAND_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "config.h"
+
+// ============================================================================
+// Compile-time command registry and single-pass dispatcher.
+//
+// Every key a command payload may carry is listed once in COMMAND_TABLE,
+// sorted by name, with the argument type it must parse to. dispatch() walks
+// the JSON object once, binary-searches each key, converts its value straight
+// into a typed slot and then runs the bound action of every key present, in
+// payload order. Keys without an action are arguments of another command
+// (e.g. buzzer_state for buzzer_override). No document, no String, no heap;
+// lookups stay O(log n) as commands are added.
+// ============================================================================
+
+enum class CommandKey : uint8_t {
+    BUZZER_OVERRIDE,
+    BUZZER_STATE,
+    CALIBRATE,
+    CHECK_PINS,
+    CLEAR_OVERRIDE,
+    COMMAND_STATS,
+    DISPLAY_VIEW,
+    LED_OVERRIDE,
+    LED_STATE,
+    METRICS,
+    OLED_MESSAGE,
+    PAYLOAD_FORMAT,
+    RELAY_STATE,
+    REPORT_DEADBAND_PCT,
+    REPORT_DEADBAND_PPM,
+    REPORT_HEARTBEAT,
+    SAMPLING_INTERVAL,
+    TEST_BUZZER,
+    TEST_LED,
+    COUNT
+};
+
+enum class CommandArgType : uint8_t {
+    BOOL,     // true/false, or a number (non-zero is true)
+    INT,      // any number, truncated toward zero
+    FLOAT,
+    STRING
+};
+
+struct CommandSpec {
+    CommandKey id;
+    const char* name;
+    CommandArgType type;
+};
+
+inline constexpr CommandSpec COMMAND_TABLE[] = {
+    {CommandKey::BUZZER_OVERRIDE, "buzzer_override", CommandArgType::BOOL},
+    {CommandKey::BUZZER_STATE, "buzzer_state", CommandArgType::BOOL},
+    {CommandKey::CALIBRATE, "calibrate", CommandArgType::BOOL},
+    {CommandKey::CHECK_PINS, "check_pins", CommandArgType::BOOL},
+    {CommandKey::CLEAR_OVERRIDE, "clear_override", CommandArgType::BOOL},
+    {CommandKey::COMMAND_STATS, "command_stats", CommandArgType::BOOL},
+    {CommandKey::DISPLAY_VIEW, "display_view", CommandArgType::STRING},
+    {CommandKey::LED_OVERRIDE, "led_override", CommandArgType::BOOL},
+    {CommandKey::LED_STATE, "led_state", CommandArgType::BOOL},
+    {CommandKey::METRICS, "metrics", CommandArgType::BOOL},
+    {CommandKey::OLED_MESSAGE, "oled_message", CommandArgType::STRING},
+    {CommandKey::PAYLOAD_FORMAT, "payload_format", CommandArgType::STRING},
+    {CommandKey::RELAY_STATE, "relay_state", CommandArgType::STRING},
+    {CommandKey::REPORT_DEADBAND_PCT, "report_deadband_pct", CommandArgType::FLOAT},
+    {CommandKey::REPORT_DEADBAND_PPM, "report_deadband_ppm", CommandArgType::FLOAT},
+    {CommandKey::REPORT_HEARTBEAT, "report_heartbeat", CommandArgType::INT},
+    {CommandKey::SAMPLING_INTERVAL, "sampling_interval", CommandArgType::INT},
+    {CommandKey::TEST_BUZZER, "test_buzzer", CommandArgType::BOOL},
+    {CommandKey::TEST_LED, "test_led", CommandArgType::BOOL},
+};
+
+constexpr size_t COMMAND_KEY_COUNT = static_cast<size_t>(CommandKey::COUNT);
+constexpr size_t COMMAND_KEY_MAX_LENGTH = 31;
+
+namespace CommandTableCheck {
+constexpr int compare(const char* a, const char* b) {
+    while (*a && *a == *b) { ++a; ++b; }
+    return static_cast<unsigned char>(*a) - static_cast<unsigned char>(*b);
+}
+constexpr size_t length(const char* s) {
+    size_t n = 0;
+    while (s[n]) ++n;
+    return n;
+}
+constexpr bool valid() {
+    for (size_t i = 0; i < COMMAND_KEY_COUNT; ++i) {
+        if (static_cast<size_t>(COMMAND_TABLE[i].id) != i) return false;
+        if (length(COMMAND_TABLE[i].name) > COMMAND_KEY_MAX_LENGTH) return false;
+        if (i > 0 && compare(COMMAND_TABLE[i - 1].name, COMMAND_TABLE[i].name) >= 0) return false;
+    }
+    return true;
+}
+}  // namespace CommandTableCheck
+
+static_assert(sizeof(COMMAND_TABLE) / sizeof(COMMAND_TABLE[0]) == COMMAND_KEY_COUNT,
+              "every CommandKey needs a COMMAND_TABLE row");
+static_assert(CommandTableCheck::valid(),
+              "COMMAND_TABLE rows must follow CommandKey order, be sorted by name and fit the key buffer");
+static_assert(COMMAND_KEY_COUNT <= 32, "presence mask is 32 bits");
+
+// Typed arguments of one payload. String values are unescaped into an
+// internal buffer and stay valid until the next parse.
+class CommandArgs {
+    friend class CommandDispatcher;
+
+private:
+    struct Value {
+        bool boolean;
+        int32_t integer;
+        float number;
+        uint16_t textOffset;
+        uint16_t textLength;
+    };
+
+    uint32_t present;
+    Value values[COMMAND_KEY_COUNT];
+    uint8_t order[COMMAND_KEY_COUNT];   // keys in the order they appeared
+    uint8_t orderCount;
+    char text[COMMAND_MAX_BYTES + 1];
+    size_t textUsed;
+
+    void clear() { present = 0; orderCount = 0; textUsed = 0; }
+    void set(CommandKey key, const Value& value);
+
+public:
+    CommandArgs() : present(0), values{}, order{}, orderCount(0), text{}, textUsed(0) {}
+
+    bool has(CommandKey key) const { return present & (1UL << static_cast<uint8_t>(key)); }
+    bool getBool(CommandKey key, bool fallback = false) const;
+    int32_t getInt(CommandKey key, int32_t fallback = 0) const;
+    float getFloat(CommandKey key, float fallback = 0.0F) const;
+    const char* getString(CommandKey key, const char* fallback = "") const;
+    size_t getLength(CommandKey key) const;
+};
+
+// An action returns false when its arguments are out of range; that counts
+// as an error for the command.
+using CommandAction = bool (*)(const CommandArgs& args);
+
+struct CommandBinding {
+    CommandKey key;
+    CommandAction action;
+};
+
+struct CommandStats {
+    uint32_t calls;
+    uint32_t errors;    // wrong argument type or rejected by the action
+    uint32_t totalUs;
+    uint32_t maxUs;
+};
+
+class CommandDispatcher {
+private:
+    CommandAction actions[COMMAND_KEY_COUNT];
+    CommandStats stats[COMMAND_KEY_COUNT];
+    CommandArgs args;
+    uint32_t parseErrors;
+    uint32_t unknownKeys;
+
+    bool parse(const char* json, size_t length);
+
+public:
+    CommandDispatcher(const CommandBinding* bindings, size_t count);
+
+    // Returns false if the payload is not a well-formed JSON object; nothing
+    // is run in that case.
+    bool dispatch(const char* json, size_t length);
+
+    const CommandStats& getStats(CommandKey key) const { return stats[static_cast<uint8_t>(key)]; }
+    uint32_t getParseErrors() const { return parseErrors; }
+    uint32_t getUnknownKeys() const { return unknownKeys; }
+    static const CommandSpec* find(const char* name, size_t length);
+};
+
+#endif
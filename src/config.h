@@ -2,6 +2,8 @@
 #define CONFIG_H
 
 #include <cstdint>
+#include "streaming_window.h"
+#include "trace_events.h"
 
 // ============================================================================
 // Device Identity
@@ -13,7 +15,14 @@ constexpr const char* DEVICE_ID = "esp32_01";
 // ============================================================================
 constexpr const char* WIFI_SSID = "Hotspot1";
 constexpr const char* WIFI_PASSWORD = "12345678";
-constexpr uint32_t WIFI_CONNECTION_TIMEOUT_MS = 20000;
+// Connection runs from WiFi events in the loop, never blocking it. A fast
+// attempt goes straight to the BSSID/channel cached in NVS; if that fails a
+// full scan follows, and a failed scan backs off exponentially with jitter.
+constexpr uint32_t WIFI_CONNECTION_TIMEOUT_MS = 20000;  // Full scan attempt watchdog
+constexpr uint32_t WIFI_FAST_CONNECT_TIMEOUT_MS = 2000; // Cached BSSID/channel attempt watchdog
+constexpr uint32_t WIFI_BACKOFF_MIN_MS = 1000;          // First retry after a failed scan
+constexpr uint32_t WIFI_BACKOFF_MAX_MS = 60000;         // Retry delay cap (doubles per failure)
+constexpr const char* WIFI_CACHE_NAMESPACE = "wifi";    // NVS namespace of the cached AP
 
 // ============================================================================
 // Hardware Pin Configuration (ESP32)
@@ -33,6 +42,23 @@ constexpr int LED_BUILTIN = 2;    // Built-in LED pin
 constexpr int SCREEN_WIDTH = 128;
 constexpr int SCREEN_HEIGHT = 64;
 constexpr uint8_t OLED_ADDRESS = 0x3C;
+constexpr uint32_t OLED_I2C_CLOCK_HZ = 400000;  // SSD1306 fast mode; Wire defaults to 100 kHz
+
+// Screen shown between custom messages (switchable at runtime via "display_view")
+enum class DisplayView : uint8_t {
+    ROTATE = 0,      // Live reading, then the hour and day trends, DISPLAY_PAGE_MS each
+    LIVE = 1,        // Current ppm, quality and relay state
+    TREND_HOUR = 2,  // Min/max graph of the last 60 minutes
+    TREND_DAY = 3    // Min/max graph of the last 24 hours
+};
+constexpr DisplayView DISPLAY_VIEW_DEFAULT = DisplayView::ROTATE;
+constexpr uint32_t DISPLAY_PAGE_MS = 10000;   // Time per screen when rotating
+
+// Trend history: one min/max bucket per pixel column and range, fixed RAM of
+// TREND_COLUMNS x 2 ranges x 8 B = 2 KB (see trend_history.h)
+constexpr size_t TREND_COLUMNS = SCREEN_WIDTH;
+constexpr uint32_t TREND_HOUR_COLUMN_MS = 28125;    // 128 columns = 60 min
+constexpr uint32_t TREND_DAY_COLUMN_MS = 675000;    // 128 columns = 24 h
 
 // ============================================================================
 // MQ-2 Sensor Configuration
@@ -42,6 +68,104 @@ constexpr float MQ2_LOAD_RESISTANCE_KOHM = 10.0F;
 constexpr float MQ2_VCC = 3.3F;
 constexpr int MQ2_ADC_RESOLUTION = 4095;
 constexpr float MQ2_BASELINE_PPM = 15.0F;
+constexpr float MQ2_CURVE_A = 50.0F;      // ppm = A * (Rs/R0)^B, combustible gas (not gases.lpg)
+constexpr float MQ2_CURVE_B = -2.5F;
+constexpr size_t MQ2_SMOOTHING_SAMPLES = 10;
+constexpr SmoothingFilter MQ2_SMOOTHING_FILTER = SmoothingFilter::ADAPTIVE;
+constexpr float MQ2_EWMA_ALPHA = 0.3F;           // weight of the newest reading in the EWMA filter
+constexpr float MQ2_ADAPTIVE_THRESHOLD = 0.3F;   // median/mean divergence that switches to the median
+
+// Warm-up runs in the background: readings are flagged "warming" until Rs
+// settles (MQ2_WARMUP_STABLE_COUNT checks in a row within MQ2_WARMUP_STABLE_REL)
+// or MQ2_WARMUP_MAX_MS passes. R0 is kept in NVS with its context and reused
+// at boot; calibration only runs without one, on request or on drift.
+constexpr uint32_t MQ2_WARMUP_MIN_MS = 20000;
+constexpr uint32_t MQ2_WARMUP_MAX_MS = 180000;
+constexpr uint32_t MQ2_WARMUP_CHECK_MS = 1000;      // Interval between Rs stability checks
+constexpr float MQ2_WARMUP_STABLE_REL = 0.01F;
+constexpr uint8_t MQ2_WARMUP_STABLE_COUNT = 10;
+constexpr uint32_t MQ2_UPDATE_MS = 100;             // update() period while warming or calibrating
+constexpr size_t MQ2_CALIBRATION_SAMPLES = 100;     // One per update(), at least 10 ms apart
+constexpr float MQ2_CALIBRATION_MAX_SPREAD = 0.05F; // (max - min) / mean of the ADC samples; air not steady beyond
+constexpr uint8_t MQ2_CALIBRATION_ATTEMPTS = 5;     // Unsteady calibrations in a row that count as failed
+constexpr uint32_t MQ2_CALIBRATION_RETRY_MS = 10000; // Wait after the first unsteady one, doubling up to the failure
+
+// Drift: gas only lowers Rs, so the highest Rs/R0 of each window is clean
+// air. MQ2_DRIFT_WINDOWS windows in a row off 1.0 by more than
+// MQ2_DRIFT_LIMIT schedule a recalibration at the next clean reading.
+constexpr uint32_t MQ2_DRIFT_WINDOW_MS = 3600000;
+constexpr uint8_t MQ2_DRIFT_WINDOWS = 3;
+constexpr float MQ2_DRIFT_LIMIT = 0.25F;
+
+// Per-gas estimates from the one MQ-2 Rs/R0 (mq2_gases.h), fitted to the
+// datasheet's sensitivity chart, in Mq2Gas order. The datasheet's R0 is Rs
+// at 1000 ppm H2, MQ2_DATASHEET_CLEAN_AIR_RATIO times below Rs in the clean
+// air R0 is calibrated in here.
+struct GasCurveSpec {
+    const char* name;       // JSON key
+    float a;                // ppm = a * (Rs/R0)^b
+    float b;
+};
+constexpr float MQ2_DATASHEET_CLEAN_AIR_RATIO = 9.83F;
+constexpr GasCurveSpec MQ2_GAS_CURVES[] = {
+    {"lpg", 574.25F, -2.222F},
+    {"propane", 658.71F, -2.168F},
+    {"h2", 987.99F, -2.162F},
+    {"co", 36974.0F, -3.109F},
+    {"alcohol", 3616.1F, -2.675F},
+    {"smoke", 3196.0F, -2.273F},
+};
+
+// Rs drift with temperature and humidity (datasheet Fig. 4) as Rs(T, RH) over
+// Rs at 20 °C/33 %RH, on evenly spaced temperature columns and humidity rows.
+// Readings are corrected back to the conditions R0 was calibrated in
+// (gas_compensation.h); outside the grid the nearest edge applies.
+struct CompensationGrid {
+    float temperatureMin;   // °C of the first column
+    float temperatureStep;
+    float humidityMin;      // %RH of the first row
+    float humidityStep;
+    size_t columns;         // >= 2
+    size_t rows;            // >= 2
+    const float* factors;   // rows x columns, row by row
+};
+constexpr float MQ2_COMPENSATION_FACTORS[] = {
+    // -10   0      10     20     30     40     50 °C
+    1.32F, 1.18F, 1.07F, 1.00F, 0.95F, 0.91F, 0.88F,   // 33 %RH
+    1.20F, 1.08F, 0.98F, 0.92F, 0.87F, 0.83F, 0.80F,   // 85 %RH
+};
+constexpr CompensationGrid MQ2_COMPENSATION = {-10.0F, 10.0F, 33.0F, 52.0F, 7, 2, MQ2_COMPENSATION_FACTORS};
+
+// ============================================================================
+// Gas Sensor Channels
+// ============================================================================
+// One line per MQ sensor on the board (gas_channel.h); adding a sensor is a
+// line here. Pins must be on ADC1, as ADC2 is unusable while WiFi is up. The
+// first channel drives the air-quality band, the alert and the display; all
+// of them are published. Warm-up, calibration and drift use the MQ-2
+// settings above; each channel keeps its own R0 in the NVS namespace named
+// after it. Curves are for R0 taken in clean air. Only list sensors that are
+// wired: a floating pin never settles, holds the warming flag until
+// MQ2_WARMUP_MAX_MS and publishes noise.
+struct GasChannelSpec {
+    const char* name;       // JSON key, NVS namespace
+    int pin;
+    float loadKohm;         // RL on the module
+    float curveA;           // ppm = A * (Rs/R0)^B for the target gas
+    float curveB;
+    float baselinePpm;      // Reported while Rs/R0 stays near 1
+    SmoothingFilter filter;
+    size_t window;          // Samples in the smoothing window (>= 5)
+    const CompensationGrid* compensation;   // Rs temperature/humidity correction, nullptr for none
+};
+constexpr GasChannelSpec GAS_CHANNELS[] = {
+    {"mq2", MQ2_PIN, MQ2_LOAD_RESISTANCE_KOHM, MQ2_CURVE_A, MQ2_CURVE_B, MQ2_BASELINE_PPM, MQ2_SMOOTHING_FILTER,
+     MQ2_SMOOTHING_SAMPLES, &MQ2_COMPENSATION},                              // LPG, ADC1_CH6
+    // Further sensors, once wired:
+    // {"mq7", 35, 10.0F, 0.65F, -1.518F, 0.5F, SmoothingFilter::EWMA, 8, nullptr},      // CO (clean-air Rs/R0(100 ppm) 27.5), ADC1_CH7
+    // {"mq135", 32, 20.0F, 4.3F, -2.473F, 3.0F, SmoothingFilter::MEDIAN, 5, nullptr},   // NH3 (clean-air Rs/R0(100 ppm) 3.6), ADC1_CH4
+};
+constexpr size_t GAS_CHANNEL_COUNT = sizeof(GAS_CHANNELS) / sizeof(GAS_CHANNELS[0]);
 
 // ============================================================================
 // DHT Sensor Configuration
@@ -50,8 +174,8 @@ constexpr float MQ2_BASELINE_PPM = 15.0F;
 
 constexpr float DHT_TEMP_OFFSET_C = -2.0F;
 constexpr float DHT_HUMID_OFFSET_PCT = 5.0F;
-constexpr int DHT_READING_SAMPLES = 5;
-constexpr int DHT_READING_DELAY_MS = 2000;
+constexpr int DHT_READING_SAMPLES = 5;              // Samples averaged per reported reading
+constexpr uint32_t DHT_SAMPLE_INTERVAL_MS = 2000;   // One bus read per interval (sensor limit)
 
 constexpr float DHT_TEMP_MIN_C = -40.0F;
 constexpr float DHT_TEMP_MAX_C = 80.0F;
@@ -72,6 +196,51 @@ constexpr uint32_t MQTT_RECONNECT_INTERVAL_MS = 5000;
 constexpr uint32_t CUSTOM_MESSAGE_TIMEOUT_MS = 10000;
 constexpr uint32_t RELAY_DEBOUNCE_MS = 100;
 
+// ============================================================================
+// Task Layout
+// ============================================================================
+// Acquisition, alert evaluation, actuation and the display run in the Arduino
+// loop task (APP_CPU, core 1). WiFi, SNTP, MQTT and the outage log run in the
+// network task on PRO_CPU (core 0), next to the WiFi and lwIP tasks, so a
+// slow connect or publish never delays a reading or the alarm.
+constexpr int NETWORK_TASK_CORE = 0;
+constexpr uint32_t NETWORK_TASK_STACK_BYTES = 8192;
+constexpr unsigned NETWORK_TASK_PRIORITY = 1;       // Same as the loop task
+constexpr size_t SAMPLE_RING_SLOTS = 32;            // Readings on their way to the network task
+
+// ============================================================================
+// Loop Metrics
+// ============================================================================
+// Per-stage durations in log-bucketed histograms (see latency_histogram.h),
+// cumulative since boot, published as JSON on MQTT_METRICS_TOPIC and dumped
+// on serial by the "metrics" command. A scheduler pass longer than the
+// budget counts as an overrun: it holds up the next alert blink.
+constexpr uint32_t METRICS_PUBLISH_INTERVAL_MS = 300000;
+constexpr uint32_t METRICS_PASS_BUDGET_MS = 100;
+
+// ============================================================================
+// Trace Logging
+// ============================================================================
+// Routine log lines are deferred: a log site stores its event id and packed
+// arguments in a ring (trace_log.h) and the last job of the network task
+// writes them out only as fast as the UART FIFO takes them, so no task
+// blocks on the serial line. Binary frames are turned back into text on the
+// host by tools/trace_decode; text mode formats them in the drain instead.
+constexpr TraceLevel TRACE_LEVELS[] = {
+    TraceLevel::INFO,   // SYSTEM
+    TraceLevel::INFO,   // SENSOR
+    TraceLevel::INFO,   // ALERT
+    TraceLevel::INFO,   // NETWORK
+    TraceLevel::INFO,   // MQTT
+    TraceLevel::INFO,   // STORAGE
+};
+static_assert(sizeof(TRACE_LEVELS) / sizeof(TRACE_LEVELS[0]) == static_cast<size_t>(TraceModule::COUNT),
+              "one level per trace module");
+constexpr size_t TRACE_RING_SLOTS = 64;              // 36 B each
+constexpr uint32_t TRACE_DRAIN_INTERVAL_MS = 2000;   // On the broker job's grid: no wakeups of its own
+constexpr uint32_t TRACE_DRAIN_RETRY_MS = 12;        // Time to empty the 128-byte UART FIFO at 115200 baud
+constexpr bool TRACE_SERIAL_BINARY = true;           // false: text lines, formatted by the drain
+
 // ============================================================================
 // System Configuration
 // ============================================================================
@@ -87,6 +256,13 @@ enum class CommProtocol : uint8_t {
 };
 constexpr CommProtocol COMM_PROTOCOL = CommProtocol::MQTT;
 
+// Telemetry payload encoding (switchable at runtime via "payload_format")
+enum class PayloadFormat : uint8_t {
+    JSON = 1,
+    BINARY = 2       // Compact frame, see binary_telemetry.h
+};
+constexpr PayloadFormat TELEMETRY_PAYLOAD_FORMAT = PayloadFormat::JSON;
+
 // ============================================================================
 // MQTT Configuration
 // ============================================================================
@@ -95,6 +271,51 @@ constexpr uint16_t MQTT_PORT = 1883;
 constexpr const char* MQTT_DEVICE_TOPIC = "airquality/esp32_01/sensor";
 constexpr const char* MQTT_STATUS_TOPIC = "airquality/esp32_01/status";
 constexpr const char* MQTT_COMMAND_TOPIC = "airquality/esp32_01/command";
+constexpr const char* MQTT_METRICS_TOPIC = "airquality/esp32_01/metrics";
+constexpr size_t COMMAND_QUEUE_SLOTS = 8;          // Commands buffered between polls (power of two)
+constexpr size_t COMMAND_MAX_BYTES = 256;          // Longest accepted command payload
+constexpr size_t TELEMETRY_TX_BUFFER_SIZE = 1920;  // Preallocated frame buffer (batch JSON worst case: rows, extra gas channels, gas estimates)
+constexpr size_t TELEMETRY_BATCH_CAPACITY = 16;    // Readings held between publishes
+constexpr size_t TELEMETRY_BATCH_FLUSH_SAMPLES = 16;  // Publish early once this many are buffered
+constexpr uint16_t MQTT_PACKET_BUFFER_SIZE = TELEMETRY_TX_BUFFER_SIZE + 64;  // Payload + topic + header
+
+// ============================================================================
+// Report-by-Exception Publishing
+// ============================================================================
+// Every reading goes into the batch. It is published at once when a channel
+// leaves its dead-band around the last reported value (ppm: the larger of the
+// absolute and relative band) or the air-quality band or relay/alert state
+// changes; otherwise it waits for the batch window or the heartbeat.
+constexpr float REPORT_PPM_DEADBAND_ABS = 5.0F;
+constexpr float REPORT_PPM_DEADBAND_REL = 0.10F;         // Fraction of the last published ppm
+constexpr float REPORT_TEMP_DEADBAND_C = 0.5F;
+constexpr float REPORT_HUMID_DEADBAND_PCT = 2.0F;
+constexpr uint32_t REPORT_HEARTBEAT_MS = 300000;         // Publish at least this often
+
+// ============================================================================
+// Store-and-Forward Log (LittleFS)
+// ============================================================================
+constexpr const char* TELEMETRY_LOG_DIR = "/tlog";
+// One 4 KB flash block per segment: 20 B records, 4 B more per extra gas channel
+constexpr size_t TELEMETRY_LOG_SEGMENT_RECORDS = 4096 / (20 + 4 * (GAS_CHANNEL_COUNT - 1));
+constexpr size_t TELEMETRY_LOG_MAX_SEGMENTS = 32;       // 128 KB, ~6.5 h at 5 s with three channels; oldest dropped beyond
+constexpr size_t TELEMETRY_REPLAY_BATCH = 16;           // Readings per replay message
+constexpr uint32_t TELEMETRY_REPLAY_INTERVAL_MS = 1000; // At most one replay message per interval
+
+// ============================================================================
+// Time Service (SNTP)
+// ============================================================================
+// One request per sync, answered asynchronously; samples are stamped from the
+// monotonic esp_timer clock plus the offset learnt here, so nothing blocks on
+// the network. A dotted-quad NTP_SERVER skips DNS (e.g. a LAN stand-in).
+constexpr const char* NTP_SERVER = "pool.ntp.org";
+constexpr uint16_t NTP_PORT = 123;
+constexpr uint32_t NTP_RESYNC_INTERVAL_MS = 3600000;  // After a good sync
+constexpr uint32_t NTP_RETRY_INTERVAL_MS = 15000;     // Before the first sync / after a failure
+constexpr uint32_t NTP_REPLY_TIMEOUT_MS = 2000;
+constexpr uint32_t NTP_MAX_ROUND_TRIP_MS = 500;       // Longer exchanges are too asymmetric to trust
+constexpr uint32_t NTP_MIN_DRIFT_BASELINE_MS = 600000;  // Shortest interval used to estimate drift
+constexpr int32_t NTP_MAX_DRIFT_PPB = 500000;         // Crystal error clamp (500 ppm)
 
 // ============================================================================
 // WebSocket Configuration
@@ -117,6 +338,11 @@ constexpr float AQ_THRESHOLD_MODERATE = 200.0F;
 constexpr float AQ_THRESHOLD_POOR = 500.0F;
 constexpr float AQ_THRESHOLD_VERY_POOR = 1000.0F;
 constexpr float AQ_THRESHOLD_HAZARDOUS = 5000.0F;
+// Lower bound of each band above Excellent, ascending (air_quality.h)
+constexpr float AQ_THRESHOLDS[] = {
+    AQ_THRESHOLD_EXCELLENT, AQ_THRESHOLD_GOOD, AQ_THRESHOLD_MODERATE,
+    AQ_THRESHOLD_POOR, AQ_THRESHOLD_VERY_POOR, AQ_THRESHOLD_HAZARDOUS
+};
 constexpr float AQ_ALERT_THRESHOLD = 1000.0F;
 
 // ============================================================================
@@ -124,5 +350,6 @@ constexpr float AQ_ALERT_THRESHOLD = 1000.0F;
 // ============================================================================
 constexpr uint32_t ALERT_BLINK_INTERVAL_MS = 500;
 constexpr uint32_t ALERT_BEEP_INTERVAL_MS = 1000;
+constexpr uint32_t ALERT_SELF_TEST_MS = 200;   // Buzzer chirp at boot
 
 #endif // CONFIG_H
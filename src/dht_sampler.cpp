@@ -0,0 +1,60 @@
+#include "dht_sampler.h"
+#include <Arduino.h>
+#include "config.h"
+
+DHTSampler::DHTSampler()
+    : dht(DHT_PIN, DHT_TYPE)
+    , tempSum(0.0F)
+    , humidSum(0.0F)
+    , taken(0)
+    , valid(0)
+    , lastSampleTime(0)
+    , hasSampled(false)
+    , temperature(0.0F)
+    , humidity(0.0F)
+    , lastValidCount(0) {}
+
+void DHTSampler::begin() {
+    dht.begin();
+    resetWindow();
+}
+
+void DHTSampler::resetWindow() {
+    tempSum = 0.0F;
+    humidSum = 0.0F;
+    taken = 0;
+    valid = 0;
+}
+
+bool DHTSampler::update() {
+    const uint32_t now = millis();
+    if (hasSampled && now - lastSampleTime < DHT_SAMPLE_INTERVAL_MS) return false;
+    lastSampleTime = now;
+    hasSampled = true;
+
+    // One frame per call: the humidity read is served from the driver's cache.
+    float t = dht.readTemperature();
+    float h = dht.readHumidity();
+    taken++;
+
+    if (!isnan(t) && !isnan(h) &&
+        t >= DHT_TEMP_MIN_C && t <= DHT_TEMP_MAX_C &&
+        h >= DHT_HUMID_MIN_PCT && h <= DHT_HUMID_MAX_PCT) {
+        t = constrain(t + DHT_TEMP_OFFSET_C, DHT_TEMP_CLAMP_MIN_C, DHT_TEMP_CLAMP_MAX_C);
+        h = constrain(h + DHT_HUMID_OFFSET_PCT, DHT_HUMID_CLAMP_MIN_PCT, DHT_HUMID_CLAMP_MAX_PCT);
+        tempSum += t;
+        humidSum += h;
+        valid++;
+    }
+
+    if (taken < DHT_READING_SAMPLES) return false;
+
+    const bool ready = valid > 0;
+    if (ready) {
+        temperature = tempSum / valid;
+        humidity = humidSum / valid;
+    }
+    lastValidCount = valid;
+    resetWindow();
+    return ready;
+}
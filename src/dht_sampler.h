@@ -0,0 +1,34 @@
+#ifndef DHT_SAMPLER_H
+#define DHT_SAMPLER_H
+
+#include <Arduino.h>
+#include "DHT.h"
+
+// Incremental DHT acquisition: update() performs at most one bus transaction
+// per call, spaced by DHT_SAMPLE_INTERVAL_MS, and reports a new averaged
+// reading once DHT_READING_SAMPLES samples have been taken.
+class DHTSampler {
+private:
+    DHT dht;
+    float tempSum;
+    float humidSum;
+    int taken;
+    int valid;
+    uint32_t lastSampleTime;
+    bool hasSampled;
+    float temperature;
+    float humidity;
+    int lastValidCount;
+
+    void resetWindow();
+
+public:
+    DHTSampler();
+    void begin();
+    bool update();
+    float getTemperature() const { return temperature; }
+    float getHumidity() const { return humidity; }
+    int getValidCount() const { return lastValidCount; }
+};
+
+#endif
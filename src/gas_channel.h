@@ -0,0 +1,243 @@
+#ifndef GAS_CHANNEL_H
+#define GAS_CHANNEL_H
+
+#include <Arduino.h>
+#include <tuple>
+#include <utility>
+#include "config.h"
+#include "gas_sensor.h"
+#include "ppm_curve.h"
+#include "streaming_window.h"
+
+constexpr size_t ADC1_CHANNELS = 8;
+
+// ADC1 channel of an ESP32 GPIO, -1 if the pin is not on ADC1
+constexpr int adc1Channel(int pin) {
+    switch (pin) {
+        case 36: return 0;
+        case 37: return 1;
+        case 38: return 2;
+        case 39: return 3;
+        case 32: return 4;
+        case 33: return 5;
+        case 34: return 6;
+        case 35: return 7;
+        default: return -1;
+    }
+}
+
+// Smoothing policy: one StreamingWindow filter over the last N readings
+template <SmoothingFilter KIND, size_t N>
+class WindowFilter {
+private:
+    StreamingWindow<float, N> window;
+
+public:
+    WindowFilter() : window(MQ2_EWMA_ALPHA, MQ2_ADAPTIVE_THRESHOLD) {}
+    float apply(float x) {
+        window.push(x);
+        return window.filtered(KIND);
+    }
+    void reset() { window.reset(); }
+    float variance() const { return window.variance(); }
+    float min() const { return window.min(); }
+    float max() const { return window.max(); }
+};
+
+// One MQ sensor: the shared warm-up/calibration/drift handling of GasSensor
+// plus its own curve (a type with static constexpr double A and B, turned
+// into a PowerCurveTable at compile time) and smoothing policy.
+template <typename Curve, typename Filter>
+class GasSensorChannel : public GasSensor {
+private:
+    Filter filter;
+    float ppm;
+    uint32_t filteredCalibrations;   // R0 the filtered readings were taken against
+
+public:
+    using CurveTable = PowerCurveTable<Curve>;
+
+    explicit GasSensorChannel(const GasChannelSpec& spec)
+        : GasSensor(spec)
+        , filter()
+        , ppm(0.0F)
+        , filteredCalibrations(0) {}
+
+    // Power law, pulled towards the baseline near clean air, clamped to the
+    // sensor's range
+    float toPPM(float ratio) const {
+        if (ratio <= 0.01F) return 0.0F;
+        float value = CurveTable::eval(ratio);
+        if (ratio > 0.8F && ratio < 1.2F) value = value * 0.3F + getSpec().baselinePpm * 0.7F;
+        return constrain(value, 0.0F, 10000.0F);
+    }
+
+    // One reading from an ADC sample the caller took (see GasChannelRegistry)
+    float sample(int adc) {
+        const float ratio = measure(adc);
+        if (getCalibrationCount() != filteredCalibrations) {
+            filter.reset();   // Readings against the old R0
+            filteredCalibrations = getCalibrationCount();
+        }
+        ppm = filter.apply(toPPM(ratio));
+        return ppm;
+    }
+
+    float readPPM() { return sample(analogRead(getPin())); }
+    float getPPM() const { return ppm; }
+    // The last reading without temperature/humidity correction, unsmoothed
+    float getRawPPM() const { return toPPM(getRawRatio()); }
+    const Filter& getFilter() const { return filter; }
+};
+
+// ============================================================================
+// Every gas channel of the board, read in one ADC1 pass per sample.
+//
+// scan() reads all channels back to back, then converts each sample with its
+// own channel's curve and filter, unrolled at compile time. The SAR ADC's
+// sample capacitor still holds part of the previous channel's voltage when
+// the mux switches, so channels are read sorted by their last reading and the
+// order is walked up and down on alternate scans: every switch is the
+// smallest step there is, and a scan starts on the channel the last one
+// ended on. Channels are independent, so a scan costs the same per channel
+// however many there are.
+// ============================================================================
+template <typename... Channels>
+class GasChannelRegistry {
+public:
+    static constexpr size_t SIZE = sizeof...(Channels);
+    static_assert(SIZE >= 1 && SIZE <= ADC1_CHANNELS, "one to eight gas channels, all on ADC1");
+
+private:
+    std::tuple<Channels...> channels;
+    GasSensor* sensors[SIZE];
+    uint8_t order[SIZE];     // By last ADC reading, ascending
+    uint16_t adc[SIZE];
+    float ppm[SIZE];
+    bool descending;
+
+    template <size_t... I>
+    GasChannelRegistry(const GasChannelSpec* specs, std::index_sequence<I...>)
+        : channels(specs[I]...)
+        , sensors{&std::get<I>(channels)...}
+        , order{static_cast<uint8_t>(I)...}
+        , adc{}
+        , ppm{}
+        , descending(false) {}
+
+    template <size_t... I>
+    void convert(std::index_sequence<I...>) {
+        ((ppm[I] = std::get<I>(channels).sample(adc[I])), ...);
+    }
+
+    // Insertion sort: nearly in order already from one scan to the next
+    void sortOrder() {
+        for (size_t i = 1; i < SIZE; ++i) {
+            const uint8_t c = order[i];
+            size_t j = i;
+            for (; j > 0 && adc[order[j - 1]] > adc[c]; --j) order[j] = order[j - 1];
+            order[j] = c;
+        }
+    }
+
+public:
+    // specs: SIZE entries, in the order of Channels
+    explicit GasChannelRegistry(const GasChannelSpec* specs = GAS_CHANNELS)
+        : GasChannelRegistry(specs, std::index_sequence_for<Channels...>()) {}
+    GasChannelRegistry(const GasChannelRegistry&) = delete;
+    GasChannelRegistry& operator=(const GasChannelRegistry&) = delete;
+
+    void init() {
+        for (GasSensor* s : sensors) s->init();
+    }
+    void update(uint64_t epochUs, float temperature, float humidity) {
+        for (GasSensor* s : sensors) s->update(epochUs, temperature, humidity);
+    }
+    void requestCalibration() {
+        for (GasSensor* s : sensors) s->requestCalibration();
+    }
+    void setConditions(float temperature, float humidity) {
+        for (GasSensor* s : sensors) s->setConditions(temperature, humidity);
+    }
+
+    void scan() {
+        for (size_t k = 0; k < SIZE; ++k) {
+            const uint8_t i = order[descending ? SIZE - 1 - k : k];
+            adc[i] = analogRead(sensors[i]->getPin());
+        }
+        descending = !descending;
+        convert(std::index_sequence_for<Channels...>());
+        sortOrder();
+    }
+
+    size_t size() const { return SIZE; }
+    float getPPM(size_t i) const { return ppm[i]; }
+    uint16_t getAdc(size_t i) const { return adc[i]; }
+    const GasSensor& sensor(size_t i) const { return *sensors[i]; }
+    template <size_t I>
+    auto& channel() { return std::get<I>(channels); }
+
+    bool isWarming() const {
+        for (const GasSensor* s : sensors) {
+            if (s->isWarming()) return true;
+        }
+        return false;
+    }
+    bool isCalibrating() const {
+        for (const GasSensor* s : sensors) {
+            if (s->isCalibrating()) return true;
+        }
+        return false;
+    }
+    bool isCalibrationFailed() const {
+        for (const GasSensor* s : sensors) {
+            if (s->isCalibrationFailed()) return true;
+        }
+        return false;
+    }
+    bool isSampling() const {
+        for (const GasSensor* s : sensors) {
+            if (s->isSampling()) return true;
+        }
+        return false;
+    }
+};
+
+// The board's channels as configured in GAS_CHANNELS
+template <size_t I>
+struct GasChannelCurve {
+    static constexpr double A = GAS_CHANNELS[I].curveA;
+    static constexpr double B = GAS_CHANNELS[I].curveB;
+};
+
+template <size_t I>
+using ConfiguredGasChannel =
+    GasSensorChannel<GasChannelCurve<I>, WindowFilter<GAS_CHANNELS[I].filter, GAS_CHANNELS[I].window>>;
+
+namespace GasChannelCheck {
+
+template <typename Sequence>
+struct Configured;
+
+template <size_t... I>
+struct Configured<std::index_sequence<I...>> {
+    using Registry = GasChannelRegistry<ConfiguredGasChannel<I>...>;
+};
+
+constexpr bool onDistinctAdc1Pins() {
+    for (size_t i = 0; i < GAS_CHANNEL_COUNT; ++i) {
+        if (adc1Channel(GAS_CHANNELS[i].pin) < 0) return false;
+        for (size_t j = 0; j < i; ++j) {
+            if (GAS_CHANNELS[j].pin == GAS_CHANNELS[i].pin) return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace GasChannelCheck
+
+static_assert(GasChannelCheck::onDistinctAdc1Pins(), "GAS_CHANNELS pins must be distinct ADC1 pins");
+
+using GasChannels = GasChannelCheck::Configured<std::make_index_sequence<GAS_CHANNEL_COUNT>>::Registry;
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef GAS_COMPENSATION_H
+#define GAS_COMPENSATION_H
+
+#include <cstddef>
+#include "config.h"
+
+// ============================================================================
+// Temperature/humidity correction of an MQ sensor's Rs.
+//
+// A CompensationGrid (config.h) holds Rs(T, RH) relative to one reference
+// condition on evenly spaced axes, so the cell is found with one divide per
+// axis rather than a search, and the factor is two lerps along temperature
+// and one along humidity. Nothing transcendental: GasSensor looks it up once
+// per DHT window, and a reading pays one multiply for it.
+// ============================================================================
+
+namespace GasCompensation {
+
+// Cell index along one axis (last cell for the far edge) and the fraction
+// into it, clamped to the grid; NaN lands on the first cell
+constexpr float locate(float value, float min, float step, size_t count, size_t& cell) {
+    const float last = static_cast<float>(count - 1);
+    float x = (value - min) / step;
+    x = !(x > 0.0F) ? 0.0F : (x < last ? x : last);
+    cell = static_cast<size_t>(x);
+    if (cell > count - 2) cell = count - 2;
+    return x - static_cast<float>(cell);
+}
+
+}  // namespace GasCompensation
+
+// Rs(temperature, humidity) / Rs(reference), bilinear between grid nodes
+constexpr float compensationFactor(const CompensationGrid& grid, float temperature, float humidity) {
+    size_t column = 0;
+    size_t row = 0;
+    const float fx =
+        GasCompensation::locate(temperature, grid.temperatureMin, grid.temperatureStep, grid.columns, column);
+    const float fy = GasCompensation::locate(humidity, grid.humidityMin, grid.humidityStep, grid.rows, row);
+    const float* lower = grid.factors + row * grid.columns + column;
+    const float* upper = lower + grid.columns;
+    const float dry = lower[0] + fx * (lower[1] - lower[0]);
+    const float humid = upper[0] + fx * (upper[1] - upper[0]);
+    return dry + fy * (humid - dry);
+}
+
+namespace GasCompensationCheck {
+
+constexpr bool isValid(const CompensationGrid& grid) {
+    if (grid.columns < 2 || grid.rows < 2 || !(grid.temperatureStep > 0.0F) || !(grid.humidityStep > 0.0F)) {
+        return false;
+    }
+    for (size_t i = 0; i < grid.columns * grid.rows; ++i) {
+        if (!(grid.factors[i] > 0.0F)) return false;
+    }
+    return true;
+}
+
+constexpr bool isValid(const GasChannelSpec* specs, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (specs[i].compensation != nullptr && !isValid(*specs[i].compensation)) return false;
+    }
+    return true;
+}
+
+}  // namespace GasCompensationCheck
+
+static_assert(sizeof(MQ2_COMPENSATION_FACTORS) / sizeof(MQ2_COMPENSATION_FACTORS[0]) ==
+                  MQ2_COMPENSATION.columns * MQ2_COMPENSATION.rows,
+              "one MQ2_COMPENSATION_FACTORS entry per grid node");
+static_assert(compensationFactor(MQ2_COMPENSATION, 20.0F, 33.0F) == 1.0F,
+              "MQ2_COMPENSATION is relative to Rs at 20 °C/33 %RH");
+static_assert(GasCompensationCheck::isValid(GAS_CHANNELS, GAS_CHANNEL_COUNT),
+              "compensation grids need two or more nodes per axis, rising axes and positive factors");
+
+#endif
@@ -0,0 +1,248 @@
+#include "gas_sensor.h"
+#include <Arduino.h>
+#include <Preferences.h>
+#include <cmath>
+#include "config.h"
+#include "gas_compensation.h"
+#include "trace_log.h"
+
+GasSensor::GasSensor(const GasChannelSpec& spec)
+    : spec(&spec)
+    , r0(0.0F)
+    , voltage(0.0F)
+    , rs(0.0F)
+    , rawRatio(0.0F)
+    , ratio(0.0F)
+    , compensation(1.0F)
+    , ambientTemperature(NAN)
+    , ambientHumidity(NAN)
+    , warmStart(0)
+    , warming(false)
+    , lastWarmCheck(0)
+    , warmRs(0.0F)
+    , warmAdcSum(0.0F)
+    , warmAdcCount(0)
+    , stableChecks(0)
+    , calibrating(false)
+    , calibrationPending(false)
+    , waitForCleanAir(false)
+    , calSamples(0)
+    , calSum(0.0F)
+    , calMin(0.0F)
+    , calMax(0.0F)
+    , lastCalSample(0)
+    , calAttempts(0)
+    , calRetryStart(0)
+    , calRetryDelay(0)
+    , calibrationFailed(false)
+    , calibration{0.0F, NAN, NAN, 0}
+    , calibrations(0)
+    , driftWindowStart(0)
+    , windowMaxRatio(0.0F)
+    , lastWindowMaxRatio(0.0F)
+    , driftWindows(0) {}
+
+void GasSensor::init() {
+    pinMode(spec->pin, INPUT);
+    Serial.printf_P(PSTR("Gas sensor %s initializing...\n"), spec->name);
+    
+    warmStart = millis();
+    warming = true;
+    lastWarmCheck = warmStart;
+    warmRs = 0.0F;
+    warmAdcSum = 0.0F;
+    warmAdcCount = 0;
+    stableChecks = 0;
+    driftWindowStart = warmStart;
+    
+    if (loadCalibration()) {
+        r0 = calibration.r0;
+        updateCompensation();
+        Serial.printf_P(PSTR("%s R0 %.2f kΩ from NVS (%.1f°C, %.0f%%), warming up\n"), spec->name, r0,
+                        calibration.temperature, calibration.humidity);
+    } else {
+        calibrationPending = true;
+        Serial.printf_P(PSTR("%s has no stored R0, calibrating after warm-up\n"), spec->name);
+    }
+}
+
+void GasSensor::update(uint64_t epochUs, float temperature, float humidity) {
+    const uint32_t now = millis();
+    if (warming) {
+        updateWarmup(now);
+        return;
+    }
+    if (calibrationPending && now - calRetryStart >= calRetryDelay &&
+        (!waitForCleanAir || ratio >= lastWindowMaxRatio * 0.95F)) {
+        calibrationPending = false;
+        waitForCleanAir = false;
+        calibrating = true;
+        calSamples = 0;
+        calSum = 0.0F;
+        Serial.printf_P(PSTR("Calibrating %s in clean air...\n"), spec->name);
+    }
+    if (calibrating) sampleCalibration(now, epochUs, temperature, humidity);
+}
+
+// Warm once Rs, averaged over each check interval to keep ADC noise out,
+// has held still for MQ2_WARMUP_STABLE_COUNT checks in a row
+void GasSensor::updateWarmup(uint32_t now) {
+    warmAdcSum += analogRead(spec->pin);
+    ++warmAdcCount;
+    if (now - lastWarmCheck < MQ2_WARMUP_CHECK_MS) return;
+    lastWarmCheck = now;
+    
+    voltage = (warmAdcSum / warmAdcCount / MQ2_ADC_RESOLUTION) * MQ2_VCC;
+    warmAdcSum = 0.0F;
+    warmAdcCount = 0;
+    const float r = calculateResistance();
+    if (warmRs > 0.0F && fabsf(r - warmRs) <= MQ2_WARMUP_STABLE_REL * warmRs) {
+        if (stableChecks < MQ2_WARMUP_STABLE_COUNT) ++stableChecks;
+    } else {
+        stableChecks = 0;
+    }
+    warmRs = r;
+    
+    const uint32_t elapsed = now - warmStart;
+    if ((elapsed >= MQ2_WARMUP_MIN_MS && stableChecks >= MQ2_WARMUP_STABLE_COUNT) || elapsed >= MQ2_WARMUP_MAX_MS) {
+        warming = false;
+        driftWindowStart = now;
+        TRACE(GAS_WARM, spec->name, static_cast<unsigned>(elapsed / 1000));
+    }
+}
+
+// One ADC sample per call; the average becomes R0 unless the air moved
+// while sampling. Unsteady air is retried with a doubling wait. After
+// MQ2_CALIBRATION_ATTEMPTS in a row the calibration counts as failed: a
+// sensor with an R0 keeps it and stops trying, one without (a first boot)
+// has no reading at all and keeps trying at the longest wait.
+void GasSensor::sampleCalibration(uint32_t now, uint64_t epochUs, float temperature, float humidity) {
+    if (calSamples > 0 && now - lastCalSample < 10) return;
+    lastCalSample = now;
+    
+    const float adc = static_cast<float>(analogRead(spec->pin));
+    calMin = (calSamples == 0 || adc < calMin) ? adc : calMin;
+    calMax = (calSamples == 0 || adc > calMax) ? adc : calMax;
+    calSum += adc;
+    if (++calSamples < MQ2_CALIBRATION_SAMPLES) return;
+    
+    calibrating = false;
+    const float avgAdc = calSum / MQ2_CALIBRATION_SAMPLES;
+    if (avgAdc <= 0.0F || (calMax - calMin) / avgAdc > MQ2_CALIBRATION_MAX_SPREAD) {
+        if (calAttempts < MQ2_CALIBRATION_ATTEMPTS) ++calAttempts;
+        if (calAttempts == MQ2_CALIBRATION_ATTEMPTS && !calibrationFailed) {
+            TRACE(GAS_CAL_FAILED, spec->name, static_cast<unsigned>(calAttempts), r0);
+            calibrationFailed = true;
+        }
+        if (calibrationFailed && r0 > 0.0F) {
+            calAttempts = 0;
+            calRetryDelay = 0;
+            return;
+        }
+        calRetryStart = now;
+        calRetryDelay = MQ2_CALIBRATION_RETRY_MS << (calAttempts - 1);
+        TRACE(GAS_NOT_STEADY, spec->name, static_cast<unsigned>(calRetryDelay / 1000));
+        calibrationPending = true;
+        return;
+    }
+    calAttempts = 0;
+    calRetryDelay = 0;
+    calibrationFailed = false;
+    
+    voltage = (avgAdc / MQ2_ADC_RESOLUTION) * MQ2_VCC;
+    
+    // Rs = ((Vcc - Vout) / Vout) * RL
+    rs = calculateResistance();
+    r0 = rs;  // Clean air calibration
+    calibration = {r0, temperature, humidity, epochUs};
+    ++calibrations;
+    saveCalibration();
+    updateCompensation();
+    
+    driftWindows = 0;
+    windowMaxRatio = 0.0F;
+    lastWindowMaxRatio = 0.0F;
+    driftWindowStart = now;
+    Serial.printf_P(PSTR("Calibration %s: R0=%.2f, RS=%.2f, V=%.2fV\n"), spec->name, r0, rs, voltage);
+}
+
+void GasSensor::requestCalibration() {
+    calibrationPending = true;
+    waitForCleanAir = false;
+    calibrationFailed = false;
+    calAttempts = 0;
+    calRetryDelay = 0;
+}
+
+// Gas only lowers Rs, so a window's highest Rs/R0 is its clean air; it should
+// stay near 1.0 for as long as R0 holds.
+void GasSensor::trackDrift(uint32_t now) {
+    if (ratio > windowMaxRatio) windowMaxRatio = ratio;
+    if (now - driftWindowStart < MQ2_DRIFT_WINDOW_MS) return;
+    
+    driftWindowStart = now;
+    lastWindowMaxRatio = windowMaxRatio;
+    windowMaxRatio = 0.0F;
+    driftWindows = fabsf(lastWindowMaxRatio - 1.0F) > MQ2_DRIFT_LIMIT ? driftWindows + 1 : 0;
+    if (driftWindows >= MQ2_DRIFT_WINDOWS && !calibrationPending) {
+        TRACE(GAS_DRIFT, spec->name, lastWindowMaxRatio);
+        calibrationPending = true;
+        waitForCleanAir = true;
+        driftWindows = 0;
+    }
+}
+
+void GasSensor::setConditions(float temperature, float humidity) {
+    ambientTemperature = temperature;
+    ambientHumidity = humidity;
+    updateCompensation();
+}
+
+// Rs(calibration) / Rs(now) from the grid: scales a reading back to the air
+// R0 was taken in
+void GasSensor::updateCompensation() {
+    const CompensationGrid* grid = spec->compensation;
+    if (grid == nullptr || !std::isfinite(ambientTemperature) || !std::isfinite(ambientHumidity) ||
+        !std::isfinite(calibration.temperature) || !std::isfinite(calibration.humidity)) {
+        compensation = 1.0F;
+        return;
+    }
+    compensation = compensationFactor(*grid, calibration.temperature, calibration.humidity) /
+                   compensationFactor(*grid, ambientTemperature, ambientHumidity);
+}
+
+bool GasSensor::loadCalibration() {
+    Preferences prefs;
+    if (!prefs.begin(spec->name, true)) return false;
+    GasCalibration stored;
+    const bool ok = prefs.getBytes("cal", &stored, sizeof(stored)) == sizeof(stored) && std::isfinite(stored.r0) &&
+                    stored.r0 > 0.1F && stored.r0 < 1000.0F;
+    prefs.end();
+    if (ok) calibration = stored;
+    return ok;
+}
+
+void GasSensor::saveCalibration() {
+    Preferences prefs;
+    if (!prefs.begin(spec->name)) return;
+    prefs.putBytes("cal", &calibration, sizeof(calibration));
+    prefs.end();
+}
+
+float GasSensor::measure(int adc) {
+    voltage = (adc / static_cast<float>(MQ2_ADC_RESOLUTION)) * MQ2_VCC;
+    rs = calculateResistance();
+    rawRatio = calculateRatio();
+    ratio = rawRatio * compensation;
+    if (!warming && !calibrating && r0 > 0.0F) trackDrift(millis());
+    return ratio;
+}
+
+float GasSensor::calculateResistance() const {
+    const float v = (voltage <= 0.01F) ? 0.01F : voltage;
+    return ((MQ2_VCC - v) / v) * spec->loadKohm;
+}
+
+float GasSensor::calculateRatio() const {
+    return (r0 <= 0.01F) ? 0.0F : (rs / r0);
+}
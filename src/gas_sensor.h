@@ -0,0 +1,114 @@
+#ifndef GAS_SENSOR_H
+#define GAS_SENSOR_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "ppm_curve.h"
+
+// Clean-air reference as stored in NVS, with the conditions it was taken in
+struct GasCalibration {
+    float r0;             // kOhm
+    float temperature;    // °C, NAN if unknown
+    float humidity;       // %RH, NAN if unknown
+    uint64_t epochUs;     // Wall-clock time of the calibration, 0 if the clock was not set
+};
+
+// The part of an MQ sensor every channel shares: heater warm-up, clean-air
+// R0 calibration, drift tracking and Rs/R0 from an ADC sample, corrected for
+// temperature and humidity when the spec has a grid. The curve and the
+// smoothing are the channel's (GasSensorChannel in gas_channel.h).
+//
+// init() returns at once: a stored R0 is used straight away, the heater warms
+// up while readings run (isWarming()), and calibration, when needed, collects
+// its samples one per update() call.
+class GasSensor {
+private:
+    const GasChannelSpec* spec;
+    float r0;
+    float voltage;
+    float rs;
+    float rawRatio;             // Rs/R0 as measured
+    float ratio;                // Rs/R0 corrected to the calibration's temperature and humidity
+    float compensation;         // ratio / rawRatio
+    float ambientTemperature;   // Last setConditions(), NAN if unknown
+    float ambientHumidity;
+
+    // Warm-up
+    uint32_t warmStart;
+    bool warming;
+    uint32_t lastWarmCheck;
+    float warmRs;          // Rs of the last check
+    float warmAdcSum;      // ADC samples since the last check, one per update()
+    uint16_t warmAdcCount;
+    uint8_t stableChecks;
+
+    // Background calibration
+    bool calibrating;
+    bool calibrationPending;
+    bool waitForCleanAir;   // Drift recalibration: only start on a clean-air reading
+    size_t calSamples;
+    float calSum;
+    float calMin;
+    float calMax;
+    uint32_t lastCalSample;
+    uint8_t calAttempts;       // Unsteady calibrations in a row
+    uint32_t calRetryStart;
+    uint32_t calRetryDelay;    // Backoff before the next attempt
+    bool calibrationFailed;    // MQ2_CALIBRATION_ATTEMPTS unsteady in a row, until one succeeds
+    GasCalibration calibration;
+    uint32_t calibrations;
+
+    // Drift: highest Rs/R0 per window
+    uint32_t driftWindowStart;
+    float windowMaxRatio;
+    float lastWindowMaxRatio;
+    uint8_t driftWindows;
+
+    float calculateResistance() const;
+    float calculateRatio() const;
+    void updateWarmup(uint32_t now);
+    void sampleCalibration(uint32_t now, uint64_t epochUs, float temperature, float humidity);
+    void trackDrift(uint32_t now);
+    void updateCompensation();
+    bool loadCalibration();
+    void saveCalibration();
+
+protected:
+    // Rs and Rs/R0 from one ADC sample; returns Rs/R0, 0 while uncalibrated
+    float measure(int adc);
+
+public:
+    explicit GasSensor(const GasChannelSpec& spec);
+    void init();
+    // One non-blocking step of warm-up or calibration; call every
+    // MQ2_UPDATE_MS while isSampling(), and after each reading while a
+    // calibration waits to start. The context is stored with a new R0.
+    void update(uint64_t epochUs, float temperature, float humidity);
+    void requestCalibration();
+    // Ambient conditions for the compensation grid of the spec, NAN if
+    // unknown; readings stay uncorrected until both sides are known.
+    void setConditions(float temperature, float humidity);
+    const GasChannelSpec& getSpec() const { return *spec; }
+    const char* getName() const { return spec->name; }
+    int getPin() const { return spec->pin; }
+    float getVoltage() const { return voltage; }
+    float getResistance() const { return rs; }
+    float getRatio() const { return ratio; }
+    float getRawRatio() const { return rawRatio; }
+    float getCompensation() const { return compensation; }
+    // Every curve of the set from the last Rs/R0 (unsmoothed), ppm[0 .. N-1]
+    template <size_t N>
+    void estimate(const PowerCurveSet<N>& curves, float* ppm) const { curves.eval(ratio, ppm); }
+    float getR0() const { return r0; }
+    bool isCalibrated() const { return r0 > 0.0F; }
+    bool isWarming() const { return warming; }
+    bool isCalibrating() const { return calibrating || calibrationPending; }
+    bool isSampling() const { return warming || calibrating; }   // update() has samples to take
+    // MQ2_CALIBRATION_ATTEMPTS unsteady calibrations in a row; cleared by
+    // the next one that succeeds or by requestCalibration()
+    bool isCalibrationFailed() const { return calibrationFailed; }
+    const GasCalibration& getCalibration() const { return calibration; }
+    uint32_t getCalibrationCount() const { return calibrations; }
+};
+
+#endif
@@ -1,27 +1,63 @@
 #include "iot_protocol.h"
 #include <Arduino.h>
-
-// Import config values
-extern const char* MQTT_SERVER;
-extern const uint16_t MQTT_PORT;
-extern const char* MQTT_DEVICE_TOPIC;
-extern const char* MQTT_STATUS_TOPIC;
-extern const char* MQTT_COMMAND_TOPIC;
-extern const uint32_t MQTT_RECONNECT_INTERVAL_MS;
+#include "config.h"
+#include "mq2_gases.h"
+#include "trace_log.h"
 
 static IoTProtocol* g_instance = nullptr;
 
+// Worst-case JSON batch row: [4294967295,10000.00,-327.7,655.3,255,3],
+// padded, plus ",10000.00" per further gas channel; 256 bytes cover the
+// envelope with the latest reading, each further channel adds its name
+// twice and its latest value, and each gas estimate "name":10000.00.
+constexpr size_t JSON_BATCH_ROW_MAX = 64;
+constexpr size_t JSON_GAS_COLUMN_MAX = 12;
+constexpr size_t JSON_GAS_ENVELOPE_MAX = 48;
+constexpr size_t JSON_GAS_ESTIMATE_MAX = 24;
+static_assert(TELEMETRY_BATCH_CAPACITY * (JSON_BATCH_ROW_MAX + (GAS_CHANNEL_COUNT - 1) * JSON_GAS_COLUMN_MAX) + 256 +
+                      (GAS_CHANNEL_COUNT - 1) * JSON_GAS_ENVELOPE_MAX + MQ2_GAS_COUNT * JSON_GAS_ESTIMATE_MAX <=
+                  TELEMETRY_TX_BUFFER_SIZE,
+              "TX buffer too small for a full JSON batch");
+static_assert(BinaryTelemetry::BATCH_HEADER_SIZE +
+                      TELEMETRY_BATCH_CAPACITY * BinaryTelemetry::recordSize(GAS_CHANNEL_COUNT) + 1 +
+                      4 * MQ2_GAS_COUNT <=
+                  TELEMETRY_TX_BUFFER_SIZE,
+              "TX buffer too small for a full binary batch");
+static_assert(GAS_CHANNEL_COUNT <= BinaryTelemetry::MAX_GAS_CHANNELS, "gas channels must fit a record");
+static_assert(MQ2_GAS_COUNT <= BinaryTelemetry::MAX_GAS_ESTIMATES, "gas estimates must fit a batch");
+static_assert(TELEMETRY_BATCH_CAPACITY <= BinaryTelemetry::MAX_BATCH_RECORDS, "batch count must fit in a byte");
+static_assert(TELEMETRY_REPLAY_BATCH <= TELEMETRY_BATCH_CAPACITY, "replay chunk must fit the TX buffer");
+// Worst-case metrics row: "network_pass":[4294967295 x6], padded
+constexpr size_t JSON_METRICS_ROW_MAX = 96;
+static_assert(LoopMetrics::STAGE_COUNT * JSON_METRICS_ROW_MAX + 256 <= TELEMETRY_TX_BUFFER_SIZE,
+              "TX buffer too small for the metrics report");
+static_assert(BinaryTelemetry::STATUS_BOOT_HEADER_SIZE + BinaryTelemetry::MAX_BOOT_SPANS * BinaryTelemetry::BOOT_SPAN_SIZE <=
+                  TELEMETRY_TX_BUFFER_SIZE,
+              "TX buffer too small for the boot timeline");
+
+// Boot times on the wire are u32 us; a stage past ~71 min saturates
+static uint32_t spanUs(uint64_t us) {
+    return us < BinaryTelemetry::BOOT_SPAN_RUNNING ? static_cast<uint32_t>(us) : BinaryTelemetry::BOOT_SPAN_RUNNING - 1;
+}
+
+// Copied once into the command queue; PubSubClient reuses its buffer for
+// the next packet.
 void IoTProtocol::mqttCallback(char* topic, byte* payload, unsigned int length) {
-    String msg;
-    for (unsigned int i = 0; i < length; ++i) msg += (char)payload[i];
-    Serial.printf_P(PSTR("MQTT [%s]: %s\n"), topic, msg.c_str());
-    if (g_instance) g_instance->lastReceivedCommand = msg;
+    (void)topic;   // Only the command topic is subscribed
+    TRACE(BROKER_MESSAGE, length);
+    if (g_instance && !g_instance->commandQueue.push(payload, length)) {
+        TRACE(COMMAND_DROPPED, length, static_cast<unsigned>(g_instance->commandQueue.size()),
+              static_cast<unsigned>(COMMAND_QUEUE_SLOTS));
+    }
 }
 
 IoTProtocol::IoTProtocol() 
     : mqttClient(espClient)
     , protocolType(ProtocolType::MQTT)
-    , isConnected(false) {
+    , payloadFormat(TELEMETRY_PAYLOAD_FORMAT)
+    , frameSequence(0)
+    , isConnected(false)
+    , lastConnectAttempt(0) {
     g_instance = this;
 }
 
@@ -32,6 +68,7 @@ bool IoTProtocol::init(ProtocolType protocol, const String& server) {
         case ProtocolType::MQTT:
             mqttClient.setServer(MQTT_SERVER, MQTT_PORT);
             mqttClient.setCallback(mqttCallback);
+            mqttClient.setBufferSize(MQTT_PACKET_BUFFER_SIZE);
             Serial.println(F("MQTT initialized"));
             break;
         case ProtocolType::WEBSOCKET:
@@ -59,8 +96,8 @@ void IoTProtocol::webSocketEvent(WStype_t type, uint8_t* payload, size_t length)
             Serial.printf_P(PSTR("[WS] Connected: %s\n"), payload);
             break;
         case WStype_TEXT:
-            Serial.printf_P(PSTR("[WS] Received: %s\n"), payload);
-            lastReceivedCommand = String((char*)payload);
+            Serial.printf_P(PSTR("[WS] Received: %.*s\n"), static_cast<int>(length), reinterpret_cast<const char*>(payload));
+            if (!commandQueue.push(payload, length)) Serial.println(F("[WS] Command dropped"));
             break;
         default:
             break;
@@ -71,14 +108,15 @@ bool IoTProtocol::connect() {
     switch (protocolType) {
         case ProtocolType::MQTT:
             if (!mqttClient.connected()) {
+                lastConnectAttempt = millis();
                 String clientId = "ESP32-" + String(random(0xffff), HEX);
                 if (mqttClient.connect(clientId.c_str())) {
-                    Serial.println(F("MQTT connected"));
+                    TRACE(BROKER_CONNECTED);
                     mqttClient.subscribe(MQTT_COMMAND_TOPIC);
                     isConnected = true;
                     return true;
                 }
-                Serial.printf_P(PSTR("MQTT failed: %d\n"), mqttClient.state());
+                TRACE(BROKER_FAILED, mqttClient.state());
                 isConnected = false;
                 return false;
             }
@@ -95,69 +133,300 @@ bool IoTProtocol::connect() {
     return false;
 }
 
-bool IoTProtocol::publishSensorData(float ppm, const String& quality, bool relayState,
-                                    float temperature, float humidity) {
-    DynamicJsonDocument doc(512);
-    doc["device_id"] = "esp32_01";
-    doc["ppm"] = ppm;
-    doc["quality"] = quality;
-    doc["relay_state"] = relayState ? "ON" : "OFF";
-    doc["temperature"] = temperature;
-    doc["humidity"] = humidity;
-    doc["timestamp"] = millis();
-    
-    String json;
-    serializeJson(doc, json);
-    
+bool IoTProtocol::sendPayload(const char* topic, const uint8_t* data, size_t length, bool binary) {
     switch (protocolType) {
         case ProtocolType::MQTT:
-            if (mqttClient.connected()) {
-                bool ok = mqttClient.publish(MQTT_DEVICE_TOPIC, json.c_str());
-                Serial.println(ok ? F("MQTT publish OK") : F("MQTT publish FAIL"));
-                return ok;
-            }
-            break;
+            return mqttClient.connected() &&
+                   mqttClient.publish(topic, data, static_cast<unsigned int>(length));
         case ProtocolType::WEBSOCKET:
-            if (isConnected) return webSocket.sendTXT(json);
-            break;
-        case ProtocolType::HTTP:
+            if (!isConnected) return false;
+            return binary ? webSocket.sendBIN(data, length)
+                          : webSocket.sendTXT(reinterpret_cast<const char*>(data), length);
+        case ProtocolType::HTTP: {
             httpClient.begin("http://192.168.1.100:3000/api/sensor-data");
-            httpClient.addHeader("Content-Type", "application/json");
-            int code = httpClient.POST(json);
+            httpClient.addHeader("Content-Type", binary ? "application/octet-stream" : "application/json");
+            int code = httpClient.POST(data, length);
             httpClient.end();
             return code > 0 && code < 300;
+        }
     }
     return false;
 }
 
-bool IoTProtocol::updateDeviceStatus(bool online) {
-    DynamicJsonDocument doc(256);
-    doc["device_id"] = "esp32_01";
-    doc["status"] = online ? "online" : "offline";
-    doc["timestamp"] = millis();
+bool IoTProtocol::publishSensorData(float ppm, AirQuality quality, bool relayState,
+                                    float temperature, float humidity) {
+    // Serialized straight into txBuffer: no heap traffic per publish
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(txBuffer);
+    size_t length = 0;
+    // Read once: the loop task may switch formats while this frame is built
+    const bool binary = payloadFormat.load() == PayloadFormat::BINARY;
     
-    String json;
-    serializeJson(doc, json);
+    if (binary) {
+        BinaryTelemetry::SensorFrame frame;
+        frame.sequence = frameSequence++;
+        frame.timestamp = millis();
+        frame.ppm = ppm;
+        frame.temperature = temperature;
+        frame.humidity = humidity;
+        frame.quality = static_cast<uint8_t>(quality);
+        frame.relayOn = relayState;
+        length = BinaryTelemetry::encode(frame, reinterpret_cast<uint8_t*>(txBuffer), sizeof(txBuffer));
+    } else {
+        JsonWriter frame(txBuffer, sizeof(txBuffer));
+        frame.beginObject();
+        frame.add("device_id", DEVICE_ID);
+        frame.add("ppm", ppm, 2);
+        frame.add("quality", airQualityLabel(quality));
+        frame.add("relay_state", relayState ? "ON" : "OFF");
+        frame.add("temperature", temperature, 1);
+        frame.add("humidity", humidity, 1);
+        frame.add("timestamp", static_cast<uint32_t>(millis()));
+        frame.endObject();
+        length = frame.ok() ? frame.size() : 0;
+    }
     
-    switch (protocolType) {
-        case ProtocolType::MQTT:
-            return mqttClient.connected() && 
-                   mqttClient.publish(MQTT_STATUS_TOPIC, json.c_str());
-        case ProtocolType::WEBSOCKET:
-            return isConnected && webSocket.sendTXT("status:" + json);
-        default:
-            return false;
+    if (length == 0) {
+        TRACE(FRAME_TOO_BIG);
+        return false;
+    }
+    
+    const bool ok = sendPayload(MQTT_DEVICE_TOPIC, data, length, binary);
+    if (protocolType == ProtocolType::MQTT && mqttClient.connected()) {
+        TRACE(BROKER_PUBLISH, ok ? "OK" : "FAIL");
+    }
+    return ok;
+}
+
+// Publishes every buffered reading as one message. The envelope keeps the
+// single-reading JSON fields (taken from the latest sample) so existing
+// consumers still work; "samples" rows are [t, ppm, temperature, humidity,
+// quality index, flags, ppm of each further gas channel], t in ms (Unix
+// time, or since boot when flags has RECORD_FLAG_UPTIME). The further
+// channels are named in "gas_channels", and "gas" has their latest values.
+// Returns the number of samples published.
+size_t IoTProtocol::publishSensorBatch(const TelemetryBatch& batch) {
+    return publishSamples(batch.data(), batch.size(), false);
+}
+
+// Replayed readings carry no top-level "latest" fields (JSON) and set the
+// replay flag (binary), so consumers store them without mistaking them for
+// the current state.
+size_t IoTProtocol::publishSamples(const TelemetrySample* samples, size_t count, bool replay) {
+    if (count == 0) return 0;
+    if (count > TELEMETRY_BATCH_CAPACITY) count = TELEMETRY_BATCH_CAPACITY;
+    
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(txBuffer);
+    uint8_t* out = reinterpret_cast<uint8_t*>(txBuffer);
+    size_t length = 0;
+    
+    // Every row as wide as the widest reading
+    uint8_t gasChannels = 1;
+    for (size_t i = 0; i < count; ++i) {
+        if (samples[i].gasChannels > gasChannels) gasChannels = samples[i].gasChannels;
+    }
+    if (gasChannels > GAS_CHANNEL_COUNT) gasChannels = GAS_CHANNEL_COUNT;
+    const bool binary = payloadFormat.load() == PayloadFormat::BINARY;   // Once, as above
+    
+    if (binary) {
+        BinaryTelemetry::BatchHeader header;
+        header.sequence = frameSequence++;
+        header.timestamp = millis();
+        header.count = static_cast<uint8_t>(count);
+        header.gasChannels = gasChannels;
+        header.replay = replay;
+        if (!replay) {
+            const TelemetrySample& latest = samples[count - 1];
+            header.gasEstimates = latest.gasEstimates;
+            memcpy(header.gasEstimate, latest.gasEstimate, sizeof(header.gasEstimate));
+        }
+        length = BinaryTelemetry::encode(header, out, sizeof(txBuffer));
+        for (size_t i = 0; i < count && length > 0; ++i) {
+            const size_t n = BinaryTelemetry::encode(samples[i], gasChannels, out + length, sizeof(txBuffer) - length);
+            length = (n > 0) ? length + n : 0;
+        }
+        if (header.gasEstimates > 0 && length > 0) {
+            const size_t n = BinaryTelemetry::encodeGasEstimates(header, out + length, sizeof(txBuffer) - length);
+            length = (n > 0) ? length + n : 0;
+        }
+    } else {
+        const TelemetrySample& latest = samples[count - 1];
+        JsonWriter frame(txBuffer, sizeof(txBuffer));
+        frame.beginObject();
+        frame.add("device_id", DEVICE_ID);
+        if (replay) {
+            frame.add("replay", true);
+        } else {
+            frame.add("ppm", latest.ppm, 2);
+            frame.add("quality", BinaryTelemetry::qualityName(latest.quality));
+            frame.add("relay_state", (latest.flags & BinaryTelemetry::RECORD_FLAG_RELAY_ON) ? "ON" : "OFF");
+            frame.add("temperature", latest.temperature, 1);
+            frame.add("humidity", latest.humidity, 1);
+            if (latest.flags & BinaryTelemetry::RECORD_FLAG_WARMING) frame.add("warming", true);
+            if (latest.flags & BinaryTelemetry::RECORD_FLAG_CAL_FAILED) frame.add("cal_failed", true);
+            // Wall-clock ms once the time service has synced, else uptime
+            if (latest.flags & BinaryTelemetry::RECORD_FLAG_UPTIME) {
+                frame.add("uptime_ms", static_cast<uint32_t>(latest.timestamp / 1000U));
+            } else {
+                frame.addScaled("timestamp", latest.timestamp / 1000U, 0);
+            }
+            if (gasChannels > 1) {
+                frame.beginObject("gas");
+                for (size_t c = 1; c < gasChannels; ++c) {
+                    frame.add(GAS_CHANNELS[c].name, c < latest.gasChannels ? latest.gasPpm[c - 1] : NAN, 2);
+                }
+                frame.endObject();
+            }
+            if (latest.gasEstimates > 0) {
+                frame.beginObject("gases");
+                for (size_t g = 0; g < latest.gasEstimates && g < MQ2_GAS_COUNT; ++g) {
+                    frame.add(MQ2_GAS_CURVES[g].name, latest.gasEstimate[g], 2);
+                }
+                frame.endObject();
+            }
+        }
+        if (gasChannels > 1) {
+            frame.beginArray("gas_channels");
+            for (size_t c = 1; c < gasChannels; ++c) frame.add(GAS_CHANNELS[c].name);
+            frame.endArray();
+        }
+        frame.beginArray("samples");
+        for (size_t i = 0; i < count; ++i) {
+            const TelemetrySample& s = samples[i];
+            frame.beginArray();
+            frame.addScaled(s.timestamp, 3);   // ms with us resolution
+            frame.add(s.ppm, 2);
+            frame.add(s.temperature, 1);
+            frame.add(s.humidity, 1);
+            frame.add(static_cast<uint32_t>(s.quality));
+            frame.add(static_cast<uint32_t>(s.flags));
+            for (size_t c = 1; c < gasChannels; ++c) frame.add(c < s.gasChannels ? s.gasPpm[c - 1] : NAN, 2);
+            frame.endArray();
+        }
+        frame.endArray();
+        frame.endObject();
+        length = frame.ok() ? frame.size() : 0;
+    }
+    
+    if (length == 0) {
+        TRACE(FRAME_TOO_BIG);
+        return 0;
     }
+    
+    const bool ok = sendPayload(MQTT_DEVICE_TOPIC, data, length, binary);
+    if (protocolType == ProtocolType::MQTT && mqttClient.connected()) {
+        TRACE(BROKER_BATCH, replay ? "replay" : "batch", ok ? "OK" : "FAIL", static_cast<unsigned>(count),
+              static_cast<unsigned>(length));
+    }
+    return ok ? count : 0;
 }
 
-String IoTProtocol::receiveCommand() {
-    String cmd;
+// epochUs is the current wall-clock time, 0 if the clock is not set yet.
+// The boot timeline lists the stages started so far; stage i of the sequence
+// is BinaryTelemetry::BootStage i.
+bool IoTProtocol::updateDeviceStatus(bool online, uint64_t epochUs, const BootSequence* boot) {
+    if (protocolType == ProtocolType::HTTP) return false;
+    
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(txBuffer);
+    size_t length = 0;
+    const bool binary = payloadFormat.load() == PayloadFormat::BINARY;   // Once, as above
+    
+    if (binary) {
+        BinaryTelemetry::StatusFrame frame;
+        frame.sequence = frameSequence++;
+        frame.timestamp = millis();
+        frame.online = online;
+        frame.bootSpans = 0;
+        for (size_t i = 0; boot && i < boot->size() && i < BinaryTelemetry::MAX_BOOT_SPANS; ++i) {
+            if (!boot->isStarted(i)) continue;
+            BinaryTelemetry::BootSpan& span = frame.boot[frame.bootSpans++];
+            span.stage = static_cast<uint8_t>(i) | (boot->isFailed(i) ? BinaryTelemetry::BOOT_SPAN_FAILED : 0);
+            span.startUs = spanUs(boot->getStartUs(i));
+            span.endUs = boot->isFinished(i) ? spanUs(boot->getEndUs(i)) : BinaryTelemetry::BOOT_SPAN_RUNNING;
+        }
+        length = BinaryTelemetry::encode(frame, reinterpret_cast<uint8_t*>(txBuffer), sizeof(txBuffer));
+    } else {
+        // WebSocket peers expect JSON status prefixed with "status:"
+        static constexpr char WS_STATUS_PREFIX[] = "status:";
+        const size_t prefix = (protocolType == ProtocolType::WEBSOCKET) ? sizeof(WS_STATUS_PREFIX) - 1 : 0;
+        memcpy(txBuffer, WS_STATUS_PREFIX, prefix);
+        
+        JsonWriter frame(txBuffer + prefix, sizeof(txBuffer) - prefix);
+        frame.beginObject();
+        frame.add("device_id", DEVICE_ID);
+        frame.add("status", online ? "online" : "offline");
+        if (epochUs > 0) frame.addScaled("timestamp", epochUs / 1000U, 0);
+        else frame.add("uptime_ms", static_cast<uint32_t>(millis()));
+        if (boot) {
+            frame.beginArray("boot");
+            for (size_t i = 0; i < boot->size(); ++i) {
+                if (!boot->isStarted(i)) continue;
+                frame.beginObject();
+                frame.add("stage", boot->name(i));
+                frame.addScaled("start_us", boot->getStartUs(i), 0);
+                if (boot->isFinished(i)) frame.addScaled("end_us", boot->getEndUs(i), 0);
+                if (boot->isFailed(i)) frame.add("failed", true);
+                frame.endObject();
+            }
+            frame.endArray();
+        }
+        frame.endObject();
+        length = frame.ok() ? prefix + frame.size() : 0;
+    }
+    
+    return length > 0 && sendPayload(MQTT_STATUS_TOPIC, data, length, binary);
+}
+
+// Diagnostics, always JSON whatever the payload format. Each stage is
+// [count, mean, p50, p90, p99, max] in us since boot; stages that never ran
+// are left out.
+bool IoTProtocol::publishMetrics(const LoopMetrics& metrics, uint64_t epochUs) {
+    if (protocolType == ProtocolType::HTTP) return false;
+    
+    JsonWriter frame(txBuffer, sizeof(txBuffer));
+    frame.beginObject();
+    frame.add("device_id", DEVICE_ID);
+    if (epochUs > 0) frame.addScaled("timestamp", epochUs / 1000U, 0);
+    frame.add("uptime_ms", static_cast<uint32_t>(millis()));
+    frame.beginObject("stages");
+    for (size_t i = 0; i < LoopMetrics::STAGE_COUNT; ++i) {
+        const LatencyHistogram& h = metrics.histogram(static_cast<MetricStage>(i));
+        if (h.count() == 0) continue;
+        frame.beginArray(LoopMetrics::name(i));
+        frame.add(h.count());
+        frame.add(h.mean());
+        frame.add(h.percentile(0.50F));
+        frame.add(h.percentile(0.90F));
+        frame.add(h.percentile(0.99F));
+        frame.add(h.max());
+        frame.endArray();
+    }
+    frame.endObject();
+    frame.beginObject("overruns");
+    frame.add("budget_ms", METRICS_PASS_BUDGET_MS);
+    frame.add("loop", metrics.getOverruns(MetricStage::LOOP_PASS));
+    frame.add("network", metrics.getOverruns(MetricStage::NETWORK_PASS));
+    frame.endObject();
+    const MetricWatermarks w = metrics.watermarks();
+    frame.beginObject("heap");
+    frame.add("free", w.freeHeap);
+    frame.add("min_free", w.minFreeHeap);
+    frame.add("largest_block", w.largestBlock);
+    frame.endObject();
+    frame.beginObject("stack_free");
+    frame.add("loop", w.loopStackFree);
+    frame.add("network", w.networkStackFree);
+    frame.endObject();
+    frame.endObject();
+    
+    return frame.ok() && sendPayload(MQTT_METRICS_TOPIC, reinterpret_cast<const uint8_t*>(txBuffer), frame.size(), false);
+}
+
+// Services the transport, then hands every queued command to handler, oldest
+// first. Returns the number of commands handled.
+size_t IoTProtocol::receiveCommands(CommandHandler handler) {
     switch (protocolType) {
         case ProtocolType::MQTT:
-            if (mqttClient.connected()) {
-                mqttClient.loop();
-                cmd = std::move(lastReceivedCommand);
-            }
+            if (mqttClient.connected()) mqttClient.loop();
             break;
         case ProtocolType::WEBSOCKET:
             webSocket.loop();
@@ -165,10 +434,23 @@ String IoTProtocol::receiveCommand() {
         default:
             break;
     }
-    return cmd;
+    return handleCommands(handler);
 }
 
-bool IoTProtocol::isConnectedToServer() const {
+// The consumer side of the command queue only: the transport is serviced by
+// loop() or receiveCommands() on the network task.
+size_t IoTProtocol::handleCommands(CommandHandler handler) {
+    size_t handled = 0;
+    size_t length = 0;
+    while (const char* payload = commandQueue.front(length)) {
+        handler(payload, length);
+        commandQueue.pop();
+        ++handled;
+    }
+    return handled;
+}
+
+bool IoTProtocol::isConnectedToServer() {
     switch (protocolType) {
         case ProtocolType::MQTT:
             return mqttClient.connected();
@@ -181,14 +463,13 @@ bool IoTProtocol::isConnectedToServer() const {
 }
 
 void IoTProtocol::loop() {
-    static uint32_t lastReconnect = 0;
-    
     switch (protocolType) {
         case ProtocolType::MQTT:
+            // Without WiFi a connect attempt could only time out
             if (mqttClient.connected()) {
                 mqttClient.loop();
-            } else if (millis() - lastReconnect >= MQTT_RECONNECT_INTERVAL_MS) {
-                lastReconnect = millis();
+            } else if (WiFi.status() == WL_CONNECTED &&
+                       millis() - lastConnectAttempt >= MQTT_RECONNECT_INTERVAL_MS) {
                 connect();
             }
             break;
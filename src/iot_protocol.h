@@ -7,8 +7,17 @@
 #include <WebSocketsClient.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
+#include <atomic>
+#include "boot_sequence.h"
+#include "loop_metrics.h"
+#include "config.h"
+#include "json_writer.h"
+#include "binary_telemetry.h"
+#include "telemetry_batch.h"
+#include "command_queue.h"
 
-enum class ProtocolType : uint8_t { MQTT, WEBSOCKET, HTTP };
+using ProtocolType = CommProtocol;
+using CommandHandler = void (*)(const char* payload, size_t length);
 
 class IoTProtocol {
 private:
@@ -18,21 +27,34 @@ private:
     HTTPClient httpClient;
     
     ProtocolType protocolType;
+    std::atomic<PayloadFormat> payloadFormat;   // Set by the command handler's task
+    uint16_t frameSequence;
     bool isConnected;
-    String lastReceivedCommand;
+    uint32_t lastConnectAttempt;
+    CommandQueue<COMMAND_QUEUE_SLOTS, COMMAND_MAX_BYTES> commandQueue;
+    char txBuffer[TELEMETRY_TX_BUFFER_SIZE];
     
     static void mqttCallback(char* topic, byte* payload, unsigned int length);
     void webSocketEvent(WStype_t type, uint8_t* payload, size_t length);
+    bool sendPayload(const char* topic, const uint8_t* data, size_t length, bool binary);
 
 public:
     IoTProtocol();
     bool init(ProtocolType protocol, const String& server = "");
     bool connect();
-    bool publishSensorData(float ppm, const String& quality, bool relayState, 
+    bool publishSensorData(float ppm, AirQuality quality, bool relayState,
                           float temperature, float humidity);
-    bool updateDeviceStatus(bool online);
-    String receiveCommand();
-    bool isConnectedToServer() const;
+    size_t publishSensorBatch(const TelemetryBatch& batch);
+    size_t publishSamples(const TelemetrySample* samples, size_t count, bool replay);
+    bool updateDeviceStatus(bool online, uint64_t epochUs = 0, const BootSequence* boot = nullptr);
+    bool publishMetrics(const LoopMetrics& metrics, uint64_t epochUs = 0);
+    void setPayloadFormat(PayloadFormat format) { payloadFormat = format; }
+    PayloadFormat getPayloadFormat() const { return payloadFormat; }
+    size_t receiveCommands(CommandHandler handler);
+    size_t handleCommands(CommandHandler handler);   // Queue only; safe from a task other than loop()'s
+    size_t pendingCommands() const { return commandQueue.size(); }
+    uint32_t getDroppedCommands() const { return commandQueue.getDropped() + commandQueue.getOversized(); }
+    bool isConnectedToServer();
     void loop();
 };
 
@@ -0,0 +1,215 @@
+#include "json_writer.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t POW10[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+constexpr uint8_t MAX_DECIMALS = sizeof(POW10) / sizeof(POW10[0]) - 1;
+constexpr float MAX_FIXED_MAGNITUDE = 1e12F;  // keeps value * 10^decimals in uint64_t
+
+}  // namespace
+
+JsonWriter::JsonWriter(char* buffer, size_t capacity)
+    : buffer(buffer)
+    , capacity(capacity)
+    , length(0)
+    , overflow(capacity == 0)
+    , needComma(false)
+    , commaStack(0)
+    , depth(0) {
+    if (capacity > 0) buffer[0] = '\0';
+}
+
+void JsonWriter::append(char c) {
+    if (overflow) return;
+    if (length + 1 >= capacity) {
+        overflow = true;
+        return;
+    }
+    buffer[length++] = c;
+    buffer[length] = '\0';
+}
+
+void JsonWriter::append(const char* s, size_t n) {
+    if (overflow) return;
+    if (length + n >= capacity) {
+        overflow = true;
+        return;
+    }
+    memcpy(buffer + length, s, n);
+    length += n;
+    buffer[length] = '\0';
+}
+
+void JsonWriter::appendSeparator() {
+    if (needComma) append(',');
+    needComma = true;
+}
+
+void JsonWriter::appendKey(const char* key) {
+    appendSeparator();
+    appendString(key);
+    append(':');
+}
+
+void JsonWriter::open(char bracket) {
+    if (depth >= 32) {
+        overflow = true;
+        return;
+    }
+    commaStack = (commaStack << 1) | (needComma ? 1u : 0u);
+    depth++;
+    append(bracket);
+    needComma = false;
+}
+
+void JsonWriter::close(char bracket) {
+    append(bracket);
+    if (depth == 0) return;
+    depth--;
+    needComma = (commaStack & 1u) != 0;
+    commaStack >>= 1;
+}
+
+void JsonWriter::appendString(const char* s) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    append('"');
+    for (; *s; ++s) {
+        const char c = *s;
+        if (c == '"' || c == '\\') {
+            append('\\');
+            append(c);
+        } else if (static_cast<uint8_t>(c) < 0x20) {
+            const char escaped[] = {'\\', 'u', '0', '0', HEX_DIGITS[(c >> 4) & 0xF], HEX_DIGITS[c & 0xF]};
+            append(escaped, sizeof(escaped));
+        } else {
+            append(c);
+        }
+    }
+    append('"');
+}
+
+void JsonWriter::appendUnsigned(uint64_t value) {
+    char digits[20];
+    size_t start = sizeof(digits);
+    do {
+        digits[--start] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    append(digits + start, sizeof(digits) - start);
+}
+
+void JsonWriter::appendFixed(float value, uint8_t decimals) {
+    if (!std::isfinite(value) || std::fabs(value) >= MAX_FIXED_MAGNITUDE) {
+        append("null", 4);
+        return;
+    }
+    if (decimals > MAX_DECIMALS) decimals = MAX_DECIMALS;
+
+    const uint64_t scaled = static_cast<uint64_t>(std::fabs(static_cast<double>(value)) * POW10[decimals] + 0.5);
+    if (value < 0.0F && scaled > 0) append('-');
+    appendScaled(scaled, decimals);
+}
+
+// Integer fixed point: scaled / 10^decimals, exact for any uint64_t.
+void JsonWriter::appendScaled(uint64_t scaled, uint8_t decimals) {
+    if (decimals > MAX_DECIMALS) decimals = MAX_DECIMALS;
+    const uint32_t scale = POW10[decimals];
+    appendUnsigned(scaled / scale);
+    if (decimals == 0) return;
+
+    append('.');
+    uint32_t frac = static_cast<uint32_t>(scaled % scale);
+    char digits[MAX_DECIMALS];
+    for (int i = decimals - 1; i >= 0; --i) {
+        digits[i] = static_cast<char>('0' + frac % 10);
+        frac /= 10;
+    }
+    append(digits, decimals);
+}
+
+void JsonWriter::beginObject() {
+    if (depth > 0) appendSeparator();
+    open('{');
+}
+
+void JsonWriter::beginObject(const char* key) {
+    appendKey(key);
+    open('{');
+}
+
+void JsonWriter::endObject() {
+    close('}');
+}
+
+void JsonWriter::beginArray(const char* key) {
+    appendKey(key);
+    open('[');
+}
+
+void JsonWriter::beginArray() {
+    if (depth > 0) appendSeparator();
+    open('[');
+}
+
+void JsonWriter::endArray() {
+    close(']');
+}
+
+void JsonWriter::add(const char* key, const char* value) {
+    appendKey(key);
+    if (value) {
+        appendString(value);
+    } else {
+        append("null", 4);
+    }
+}
+
+void JsonWriter::add(const char* key, bool value) {
+    appendKey(key);
+    if (value) {
+        append("true", 4);
+    } else {
+        append("false", 5);
+    }
+}
+
+void JsonWriter::add(const char* key, uint32_t value) {
+    appendKey(key);
+    appendUnsigned(value);
+}
+
+void JsonWriter::add(const char* key, float value, uint8_t decimals) {
+    appendKey(key);
+    appendFixed(value, decimals);
+}
+
+void JsonWriter::addScaled(const char* key, uint64_t scaled, uint8_t decimals) {
+    appendKey(key);
+    appendScaled(scaled, decimals);
+}
+
+void JsonWriter::add(const char* value) {
+    appendSeparator();
+    if (value) {
+        appendString(value);
+    } else {
+        append("null", 4);
+    }
+}
+
+void JsonWriter::add(uint32_t value) {
+    appendSeparator();
+    appendUnsigned(value);
+}
+
+void JsonWriter::add(float value, uint8_t decimals) {
+    appendSeparator();
+    appendFixed(value, decimals);
+}
+
+void JsonWriter::addScaled(uint64_t scaled, uint8_t decimals) {
+    appendSeparator();
+    appendScaled(scaled, decimals);
+}
@@ -0,0 +1,66 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================================
+// Streaming JSON writer over a caller-owned buffer.
+//
+// Used for the telemetry and status frames so a publish never touches the
+// heap: no JsonDocument, no String, and no printf("%f") (newlib's float
+// formatting allocates). Floats are written in fixed point with a given
+// number of decimals; non-finite values become null. On overflow the writer
+// stops appending and ok() turns false, so a truncated frame is never sent.
+// ============================================================================
+class JsonWriter {
+private:
+    char* buffer;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+    bool needComma;
+    uint32_t commaStack;  // needComma of enclosing containers, one bit per level
+    uint8_t depth;
+
+    void append(char c);
+    void append(const char* s, size_t n);
+    void appendKey(const char* key);
+    void appendSeparator();
+    void open(char bracket);
+    void close(char bracket);
+    void appendString(const char* s);
+    void appendUnsigned(uint64_t value);
+    void appendFixed(float value, uint8_t decimals);
+    void appendScaled(uint64_t scaled, uint8_t decimals);
+
+public:
+    JsonWriter(char* buffer, size_t capacity);
+
+    void beginObject();
+    void beginObject(const char* key);
+    void endObject();
+    void beginArray(const char* key);
+    void beginArray();
+    void endArray();
+
+    // Object members
+    void add(const char* key, const char* value);
+    void add(const char* key, bool value);
+    void add(const char* key, uint32_t value);
+    void add(const char* key, float value, uint8_t decimals);
+    // Exact fixed point for wide integers, e.g. microseconds as "ms.uuu"
+    void addScaled(const char* key, uint64_t scaled, uint8_t decimals);
+
+    // Array elements
+    void add(const char* value);
+    void add(uint32_t value);
+    void add(float value, uint8_t decimals);
+    void addScaled(uint64_t scaled, uint8_t decimals);
+
+    bool ok() const { return !overflow; }
+    size_t size() const { return length; }
+    const char* c_str() const { return buffer; }
+};
+
+#endif
@@ -0,0 +1,31 @@
+#include "latency_histogram.h"
+
+uint32_t LatencyHistogram::bucketTop(size_t i) {
+    if (i < SUB_BUCKETS) return static_cast<uint32_t>(i);
+    if (i >= BUCKETS - 1) return UINT32_MAX;   // Everything from 2^MAX_BITS up
+    const uint32_t shift = static_cast<uint32_t>(i >> SUB_BITS) - 1;
+    const uint32_t bottom = (SUB_BUCKETS + (i & (SUB_BUCKETS - 1))) << shift;
+    return bottom + (1UL << shift) - 1;
+}
+
+void LatencyHistogram::reset() {
+    for (uint32_t& c : counts) c = 0;
+    samples = 0;
+    maxUs = 0;
+    totalUs = 0;
+}
+
+uint32_t LatencyHistogram::percentile(float fraction) const {
+    if (samples == 0) return 0;
+    uint32_t rank = static_cast<uint32_t>(fraction * samples + 0.999999F);
+    if (rank < 1) rank = 1;
+    uint32_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            const uint32_t top = bucketTop(i);
+            return top < maxUs ? top : maxUs;
+        }
+    }
+    return maxUs;
+}
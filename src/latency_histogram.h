@@ -0,0 +1,63 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================================
+// Log-bucketed histogram of durations in microseconds (HDR-style).
+//
+// Values below SUB_BUCKETS get a bucket each; above that every power of two
+// is split into SUB_BUCKETS equal buckets, so a bucket is never wider than
+// 1/SUB_BUCKETS (12.5%) of the values it holds. Values from 2^MAX_BITS us
+// (16.8 s) up land in the last bucket; max() stays exact. record() is a
+// count-leading-zeros, a shift and three adds; memory is fixed at
+// BUCKETS * 4 B plus a few words.
+//
+// One writer; a reader on another task may see a sample counted in total but
+// not yet in its bucket, which only shifts a percentile by one sample.
+// ============================================================================
+class LatencyHistogram {
+public:
+    static constexpr uint8_t SUB_BITS = 3;
+    static constexpr uint32_t SUB_BUCKETS = 1UL << SUB_BITS;
+    static constexpr uint8_t MAX_BITS = 24;
+    static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+private:
+    uint32_t counts[BUCKETS];
+    uint32_t samples;
+    uint32_t maxUs;
+    uint64_t totalUs;
+
+public:
+    LatencyHistogram() : counts{}, samples(0), maxUs(0), totalUs(0) {}
+
+    static size_t bucketOf(uint32_t us) {
+        if (us < SUB_BUCKETS) return us;
+        if (us >> MAX_BITS) return BUCKETS - 1;
+        const uint32_t msb = 31 - __builtin_clz(us);
+        const uint32_t shift = msb - SUB_BITS;
+        return ((shift + 1) << SUB_BITS) | ((us >> shift) & (SUB_BUCKETS - 1));
+    }
+    // Largest value that falls into bucket i
+    static uint32_t bucketTop(size_t i);
+
+    void record(uint32_t us) {
+        ++counts[bucketOf(us)];
+        ++samples;
+        totalUs += us;
+        if (us > maxUs) maxUs = us;
+    }
+    void reset();
+
+    // Smallest bucket top at or below which `fraction` of the samples fall,
+    // capped at max(); 0 when empty
+    uint32_t percentile(float fraction) const;
+    uint32_t count() const { return samples; }
+    uint32_t max() const { return maxUs; }
+    uint32_t mean() const { return samples ? static_cast<uint32_t>(totalUs / samples) : 0; }
+    uint32_t bucketCount(size_t i) const { return counts[i]; }
+};
+
+#endif
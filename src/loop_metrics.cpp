@@ -0,0 +1,68 @@
+#include "loop_metrics.h"
+
+namespace {
+
+const char* const STAGE_NAMES[] = {
+    "loop_pass", "network_pass", "dht_read", "ppm_read", "sample",
+    "display", "commands", "broker_poll", "publish", "replay",
+};
+static_assert(sizeof(STAGE_NAMES) / sizeof(STAGE_NAMES[0]) == LoopMetrics::STAGE_COUNT, "one name per stage");
+
+// ESP-IDF counts stack in bytes
+uint32_t stackFree(TaskHandle_t task) {
+    return task ? static_cast<uint32_t>(uxTaskGetStackHighWaterMark(task)) : 0;
+}
+
+}  // namespace
+
+LoopMetrics::LoopMetrics()
+    : stages{}
+    , overruns{}
+    , loopTask(nullptr)
+    , networkTask(nullptr) {}
+
+void LoopMetrics::setTasks(TaskHandle_t loop, TaskHandle_t network) {
+    loopTask = loop;
+    networkTask = network;
+}
+
+void LoopMetrics::recordPass(MetricStage stage, uint64_t startUs) {
+    const uint64_t took = TimeService::monotonicUs() - startUs;
+    if (took > METRICS_PASS_BUDGET_MS * 1000ULL) ++overruns[index(stage)];
+    stages[index(stage)].record(took > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(took));
+}
+
+MetricWatermarks LoopMetrics::watermarks() const {
+    MetricWatermarks w;
+    w.freeHeap = ESP.getFreeHeap();
+    w.minFreeHeap = ESP.getMinFreeHeap();
+    w.largestBlock = ESP.getMaxAllocHeap();
+    w.loopStackFree = stackFree(loopTask);
+    w.networkStackFree = stackFree(networkTask);
+    return w;
+}
+
+const char* LoopMetrics::name(MetricStage stage) {
+    return index(stage) < STAGE_COUNT ? STAGE_NAMES[index(stage)] : "?";
+}
+
+void LoopMetrics::print() const {
+    Serial.println(F("Loop metrics since boot (us):"));
+    Serial.printf_P(PSTR("  %-13s %8s %8s %8s %8s %8s %8s\n"), "stage", "count", "mean", "p50", "p90", "p99", "max");
+    for (size_t i = 0; i < STAGE_COUNT; ++i) {
+        const LatencyHistogram& h = stages[i];
+        if (h.count() == 0) continue;
+        Serial.printf_P(PSTR("  %-13s %8u %8u %8u %8u %8u %8u\n"), STAGE_NAMES[i], static_cast<unsigned>(h.count()),
+                        static_cast<unsigned>(h.mean()), static_cast<unsigned>(h.percentile(0.50F)),
+                        static_cast<unsigned>(h.percentile(0.90F)), static_cast<unsigned>(h.percentile(0.99F)),
+                        static_cast<unsigned>(h.max()));
+    }
+    const MetricWatermarks w = watermarks();
+    Serial.printf_P(PSTR("Overruns (> %u ms): loop %u, network %u\n"), static_cast<unsigned>(METRICS_PASS_BUDGET_MS),
+                    static_cast<unsigned>(getOverruns(MetricStage::LOOP_PASS)),
+                    static_cast<unsigned>(getOverruns(MetricStage::NETWORK_PASS)));
+    Serial.printf_P(PSTR("Heap: %u free, %u min free, %u largest block; stack free: loop %u, network %u\n"),
+                    static_cast<unsigned>(w.freeHeap), static_cast<unsigned>(w.minFreeHeap),
+                    static_cast<unsigned>(w.largestBlock), static_cast<unsigned>(w.loopStackFree),
+                    static_cast<unsigned>(w.networkStackFree));
+}
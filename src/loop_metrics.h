@@ -0,0 +1,76 @@
+#ifndef LOOP_METRICS_H
+#define LOOP_METRICS_H
+
+#include <Arduino.h>
+#include <cstddef>
+#include <cstdint>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+#include "latency_histogram.h"
+#include "time_service.h"
+
+// Timed stages; each is recorded by one task only
+enum class MetricStage : uint8_t {
+    LOOP_PASS,       // Loop task: one scheduler pass that ran jobs
+    NETWORK_PASS,    // Network task: same
+    DHT_READ,
+    PPM_READ,
+    SAMPLE,          // Whole sample job: read, alert, report decision
+    DISPLAY,
+    COMMANDS,
+    BROKER_POLL,     // iotProtocol.loop()
+    PUBLISH,
+    REPLAY,
+    COUNT
+};
+
+struct MetricWatermarks {
+    uint32_t freeHeap;
+    uint32_t minFreeHeap;        // Lowest since boot
+    uint32_t largestBlock;
+    uint32_t loopStackFree;      // Least free stack the task has had, bytes
+    uint32_t networkStackFree;
+};
+
+// ============================================================================
+// Where the time goes: a LatencyHistogram per stage, overrun counters for
+// the two scheduler passes, and heap and stack watermarks read on demand.
+//
+// record() costs a clock read and LatencyHistogram::record(). Histograms are
+// written only by the task that runs their stage and read by whichever task
+// reports them; they are cumulative since boot, so a consumer diffs counts.
+// ============================================================================
+class LoopMetrics {
+public:
+    static constexpr size_t STAGE_COUNT = static_cast<size_t>(MetricStage::COUNT);
+
+private:
+    LatencyHistogram stages[STAGE_COUNT];
+    uint32_t overruns[STAGE_COUNT];   // Only the pass stages count them
+    TaskHandle_t loopTask;
+    TaskHandle_t networkTask;
+
+    static size_t index(MetricStage stage) { return static_cast<size_t>(stage); }
+
+public:
+    LoopMetrics();
+    void setTasks(TaskHandle_t loop, TaskHandle_t network);
+
+    void record(MetricStage stage, uint64_t startUs) {
+        const uint64_t took = TimeService::monotonicUs() - startUs;
+        stages[index(stage)].record(took > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(took));
+    }
+    // A pass over METRICS_PASS_BUDGET_MS also counts as an overrun
+    void recordPass(MetricStage stage, uint64_t startUs);
+
+    const LatencyHistogram& histogram(MetricStage stage) const { return stages[index(stage)]; }
+    uint32_t getOverruns(MetricStage stage) const { return overruns[index(stage)]; }
+    MetricWatermarks watermarks() const;
+    static const char* name(MetricStage stage);
+    static const char* name(size_t i) { return name(static_cast<MetricStage>(i)); }
+
+    void print() const;   // Serial dump
+};
+
+#endif
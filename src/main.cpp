@@ -1,256 +1,813 @@
 #include <Arduino.h>
 #include <WiFi.h>
-#include "DHT.h"
+#include <LittleFS.h>
+#include <atomic>
 #include "config.h"
+#include "boot_sequence.h"
+#include "dht_sampler.h"
 #include "wifi_manager.h"
 #include "iot_protocol.h"
-#include "sensor_mq2.h"
+#include "loop_metrics.h"
+#include "gas_channel.h"
+#include "mq2_gases.h"
 #include "oled_display.h"
 #include "relay_controller.h"
 #include "alert_controller.h"
+#include "telemetry_batch.h"
+#include "telemetry_log.h"
+#include "report_policy.h"
+#include "scheduler.h"
+#include "spsc_ring.h"
+#include "command_table.h"
+#include "time_service.h"
+#include "trace_log.h"
+#include "trend_history.h"
 
 // Global objects
 WiFiManager wifiManager;
 IoTProtocol iotProtocol;
-MQ2Sensor sensor;
+GasChannels gasChannels;
 OLEDDisplay display;
 RelayController relay;
 AlertController alert;
-DHT dht(DHT_PIN, DHT_TYPE);
+DHTSampler dhtSampler;
+TelemetryBatch telemetryBatch;
+TelemetryLog telemetryLog;
+ReportPolicy reportPolicy;
+TimeService timeService;
+TrendHistory trendHistory;
+LoopMetrics loopMetrics;
 
-// State variables
+// ============================================================================
+// Task layout. The loop task (APP_CPU) reads the sensors, evaluates the
+// alert, drives the relay, buzzer and display and runs commands; the network
+// task (PRO_CPU) owns WiFi, SNTP, MQTT and the outage log. Readings go across
+// in sampleRing, commands come back through the protocol's command queue,
+// and the link state the boot stages wait on is published in netLink. Each
+// task runs its own scheduler and touches only its own objects.
+// ============================================================================
+
+// Loop task state
 struct SystemState {
     unsigned long lastSensorRead = 0;
-    unsigned long lastMQTTUpdate = 0;
-    unsigned long lastCommandCheck = 0;
     unsigned long customMessageTime = 0;
     float ppm = 0.0F;
-    String quality;
+    AirQuality quality = AirQuality::EXCELLENT;
     bool relayState = false;
     int samplingInterval = 5;
     String customMessage;
     float temperature = 0.0F;
     float humidity = 0.0F;
-    bool dhtInitialized = false;
+    DisplayView displayView = DISPLAY_VIEW_DEFAULT;
 };
 
-SystemState state;
+// Network task state
+struct NetworkState {
+    bool serverOnline = false;
+    uint16_t started = 0;         // Boot stages started on this task, bootBit() of each
+};
 
-// DHT calibration
-struct DHTCalibration {
-    float temp[DHT_READING_SAMPLES] = {0};
-    float humidity[DHT_READING_SAMPLES] = {0};
-    int index = 0;
+// Written by the network task, read by the loop task
+struct LinkState {
+    std::atomic<bool> wifiUp{false};
+    std::atomic<bool> synced{false};
+    std::atomic<bool> brokerUp{false};
+    std::atomic<bool> published{false};       // A live batch reached the broker
+    std::atomic<bool> bootComplete{false};    // Set by the loop task: the timeline is final
+    std::atomic<uint32_t> epochAtBootS{0};    // Unix time at monotonic 0, once synced
+    std::atomic<uint16_t> startRequests{0};   // Set by the loop task: boot stages to start
+    std::atomic<bool> reportRequested{false}; // Set by the loop task: publish the batch now
 };
 
-DHTCalibration dhtCal;
+SystemState state;
+NetworkState net;
+LinkState netLink;
+SpscRing<TelemetrySample, SAMPLE_RING_SLOTS> sampleRing;   // Loop task -> network task
+bool brokerConfigured = false;
 
-void readCalibratedDHT() {
-    float tempSum = 0.0F, humidSum = 0.0F;
-    int valid = 0;
-    
-    for (int i = 0; i < DHT_READING_SAMPLES; ++i) {
-        float t = dht.readTemperature();
-        float h = dht.readHumidity();
-        
-        if (!isnan(t) && !isnan(h) &&
-            t >= DHT_TEMP_MIN_C && t <= DHT_TEMP_MAX_C &&
-            h >= DHT_HUMID_MIN_PCT && h <= DHT_HUMID_MAX_PCT) {
-            
-            t = constrain(t + DHT_TEMP_OFFSET_C, DHT_TEMP_CLAMP_MIN_C, DHT_TEMP_CLAMP_MAX_C);
-            h = constrain(h + DHT_HUMID_OFFSET_PCT, DHT_HUMID_CLAMP_MIN_PCT, DHT_HUMID_CLAMP_MAX_PCT);
-            
-            tempSum += t;
-            humidSum += h;
-            valid++;
-            delay(DHT_READING_DELAY_MS / DHT_READING_SAMPLES);
-        }
-    }
-    
-    if (valid > 0) {
-        state.temperature = tempSum / valid;
-        state.humidity = humidSum / valid;
-        Serial.printf_P(PSTR("DHT11: %.1f°C, %.1f%% (%d readings)\n"), 
-                       state.temperature, state.humidity, valid);
-    }
+// ============================================================================
+// Jobs. Each runs when its deadline comes up or when an event posts it; in
+// between its task sleeps. Registered in setup() in this order, which is also
+// the order jobs with equal deadlines run in.
+// ============================================================================
+Scheduler scheduler;      // Loop task
+JobId dhtJob = Scheduler::NO_JOB;
+JobId mq2Job = Scheduler::NO_JOB;
+JobId alertJob = Scheduler::NO_JOB;
+JobId sampleJob = Scheduler::NO_JOB;
+JobId commandJob = Scheduler::NO_JOB;
+JobId displayJob = Scheduler::NO_JOB;
+
+Scheduler netScheduler;   // Network task
+JobId startJob = Scheduler::NO_JOB;
+JobId wifiJob = Scheduler::NO_JOB;
+JobId clockJob = Scheduler::NO_JOB;
+JobId publishJob = Scheduler::NO_JOB;
+JobId replayJob = Scheduler::NO_JOB;
+JobId brokerJob = Scheduler::NO_JOB;
+JobId statusJob = Scheduler::NO_JOB;
+JobId metricsJob = Scheduler::NO_JOB;
+JobId traceJob = Scheduler::NO_JOB;
+TaskHandle_t networkTaskHandle = nullptr;
+
+void runDht();
+void runMq2();
+void runAlert();
+void runSample();
+void runCommand();
+void runDisplay();
+
+void runStart();
+void runWifi();
+void runClock();
+void runPublish();
+void runReplay();
+void runBroker();
+void runStatus();
+void runMetrics();
+void runTrace();
+
+// Called from the WiFi and lwIP tasks
+void wakeWifi() { netScheduler.post(wifiJob); }
+void wakeClock() { netScheduler.post(clockJob); }
+
+// Called by whichever task fills the trace ring halfway
+void wakeTrace() { netScheduler.post(traceJob); }
+
+// ============================================================================
+// Bring-up stages. Entry i is BinaryTelemetry::BootStage i, the numbering the
+// status frame reports the timeline in. The sequence runs on the loop task;
+// network stages are handed to the network task and followed through netLink.
+// ============================================================================
+using BinaryTelemetry::BootStage;
+
+constexpr size_t stageIndex(BootStage stage) { return static_cast<size_t>(stage); }
+constexpr const char* stageName(BootStage stage) { return BinaryTelemetry::BOOT_STAGE_NAMES[stageIndex(stage)]; }
+constexpr uint16_t stageBit(BootStage stage) { return bootBit(stageIndex(stage)); }
+constexpr uint16_t afterStage(BootStage stage) { return stageBit(stage); }
+
+void startOnNetwork(BootStage stage) {
+    netLink.startRequests.fetch_or(stageBit(stage));
+    netScheduler.post(startJob);
 }
 
-void processCommands(const String& json);
+bool bootOled() {
+    if (!display.init()) return false;
+    scheduler.every(displayJob, DISPLAY_PAGE_MS);
+    return true;
+}
 
-void setup() {
-    Serial.begin(115200);
-    Serial.println(F("\n=== ESP32 AQ Monitor Starting ==="));
-    
-    // Initialize components
-    display.init();
-    display.showWelcome();
-    
+bool bootRelay() {
     relay.init();
-    alert.init(&relay);
     relay.turnOn();
     state.relayState = true;
-    
-    sensor.init();
-    dht.begin();
-    
-    // Init DHT calibration array
-    for (int i = 0; i < DHT_READING_SAMPLES; ++i) {
-        dhtCal.temp[i] = 0.0F;
-        dhtCal.humidity[i] = 0.0F;
-    }
-    state.dhtInitialized = true;
+    return true;
+}
+
+bool bootAlert() {
+    if (!alert.init(&relay)) return false;
+    scheduler.schedule(alertJob, ALERT_SELF_TEST_MS);
+    return true;
+}
+bool alertReady() { return alert.finishSelfTest(); }
+
+bool bootMq2() {
+    gasChannels.init();
+    scheduler.every(mq2Job, MQ2_UPDATE_MS);
+    scheduler.every(sampleJob, static_cast<uint32_t>(state.samplingInterval) * 1000UL);
+    return true;
+}
+bool mq2Ready() { return !gasChannels.isWarming(); }
+
+bool bootDht() {
+    dhtSampler.begin();
+    scheduler.every(dhtJob, DHT_SAMPLE_INTERVAL_MS);
     Serial.println(F("DHT11 initialized"));
-    
-    // WiFi
-    if (!wifiManager.connect()) {
-        Serial.println(F("WiFi failed - offline mode"));
-        display.showMessage(F("WiFi Failed"));
+    return true;
+}
+
+// Store-and-forward log for readings the broker never saw. Mounted before
+// the network task touches it: the network stages start after this one.
+bool bootStorage() {
+    if (LittleFS.begin(true) && telemetryLog.begin(LittleFS)) return true;
+    Serial.println(F("LittleFS failed - outage readings kept in RAM only"));
+    return false;
+}
+
+bool bootWifi() {
+    startOnNetwork(BootStage::WIFI);
+    return true;
+}
+bool wifiReady() { return netLink.wifiUp.load(); }
+
+// Wall clock; readings taken before the first sync are stamped with uptime
+bool bootClock() {
+    startOnNetwork(BootStage::CLOCK);
+    return true;
+}
+bool clockReady() { return netLink.synced.load(); }
+
+bool bootBroker() {
+    if (!brokerConfigured) return false;
+    startOnNetwork(BootStage::BROKER);
+    return true;
+}
+bool brokerReady() { return netLink.brokerUp.load(); }
+
+// The first reading as soon as the broker is up, so the first publish does
+// not wait out a whole sampling interval
+bool bootFirstPublish() {
+    scheduler.post(sampleJob);
+    return true;
+}
+bool firstPublishReady() { return netLink.published.load(); }
+
+const BootStep BOOT_STEPS[] = {
+    {stageName(BootStage::OLED), 0, bootOled, nullptr},
+    {stageName(BootStage::RELAY), 0, bootRelay, nullptr},
+    {stageName(BootStage::ALERT), afterStage(BootStage::RELAY), bootAlert, alertReady},
+    {stageName(BootStage::MQ2), 0, bootMq2, mq2Ready},
+    {stageName(BootStage::DHT), 0, bootDht, nullptr},
+    {stageName(BootStage::STORAGE), 0, bootStorage, nullptr},
+    {stageName(BootStage::WIFI), 0, bootWifi, wifiReady},
+    {stageName(BootStage::CLOCK), afterStage(BootStage::WIFI), bootClock, clockReady},
+    {stageName(BootStage::BROKER), afterStage(BootStage::WIFI), bootBroker, brokerReady},
+    {stageName(BootStage::FIRST_PUBLISH), afterStage(BootStage::BROKER), bootFirstPublish, firstPublishReady},
+};
+static_assert(sizeof(BOOT_STEPS) / sizeof(BOOT_STEPS[0]) == stageIndex(BootStage::COUNT), "one step per boot stage");
+BootSequence bootSequence(BOOT_STEPS, sizeof(BOOT_STEPS) / sizeof(BOOT_STEPS[0]));
+
+void processCommands(const char* json, size_t length);
+void handleCommand(const char* payload, size_t length);
+void showReadings(unsigned long now);
+
+bool cmdBuzzerOverride(const CommandArgs& args);
+bool cmdLedOverride(const CommandArgs& args);
+bool cmdClearOverride(const CommandArgs& args);
+bool cmdRelayState(const CommandArgs& args);
+bool cmdSamplingInterval(const CommandArgs& args);
+bool cmdReportHeartbeat(const CommandArgs& args);
+bool cmdReportDeadband(const CommandArgs& args);
+bool cmdPayloadFormat(const CommandArgs& args);
+bool cmdDisplayView(const CommandArgs& args);
+bool cmdOledMessage(const CommandArgs& args);
+bool cmdTestBuzzer(const CommandArgs& args);
+bool cmdTestLed(const CommandArgs& args);
+bool cmdCheckPins(const CommandArgs& args);
+bool cmdCommandStats(const CommandArgs& args);
+bool cmdMetrics(const CommandArgs& args);
+bool cmdCalibrate(const CommandArgs& args);
+
+// buzzer_state, led_state and report_deadband_pct are arguments only
+const CommandBinding COMMAND_BINDINGS[] = {
+    {CommandKey::BUZZER_OVERRIDE, cmdBuzzerOverride},
+    {CommandKey::LED_OVERRIDE, cmdLedOverride},
+    {CommandKey::CLEAR_OVERRIDE, cmdClearOverride},
+    {CommandKey::RELAY_STATE, cmdRelayState},
+    {CommandKey::SAMPLING_INTERVAL, cmdSamplingInterval},
+    {CommandKey::REPORT_HEARTBEAT, cmdReportHeartbeat},
+    {CommandKey::REPORT_DEADBAND_PPM, cmdReportDeadband},
+    {CommandKey::PAYLOAD_FORMAT, cmdPayloadFormat},
+    {CommandKey::OLED_MESSAGE, cmdOledMessage},
+    {CommandKey::DISPLAY_VIEW, cmdDisplayView},
+    {CommandKey::TEST_BUZZER, cmdTestBuzzer},
+    {CommandKey::TEST_LED, cmdTestLed},
+    {CommandKey::CHECK_PINS, cmdCheckPins},
+    {CommandKey::COMMAND_STATS, cmdCommandStats},
+    {CommandKey::METRICS, cmdMetrics},
+    {CommandKey::CALIBRATE, cmdCalibrate},
+};
+CommandDispatcher commandDispatcher(COMMAND_BINDINGS, sizeof(COMMAND_BINDINGS) / sizeof(COMMAND_BINDINGS[0]));
+
+// Same shape as loop(): due jobs, then sleep until the next deadline, a WiFi
+// event, an SNTP reply or a post from the loop task
+void networkTask(void* arg) {
+    (void)arg;
+    for (;;) {
+        const uint64_t passUs = TimeService::monotonicUs();
+        if (netScheduler.runDue() > 0) loopMetrics.recordPass(MetricStage::NETWORK_PASS, passUs);
+        netScheduler.sleep();
     }
-    
-    // IoT Protocol
-    if (!iotProtocol.init(COMM_PROTOCOL)) {
-        Serial.println(F("IoT init failed"));
-        display.showMessage(F("IoT Error"));
-    } else if (iotProtocol.connect()) {
-        Serial.println(F("MQTT connected"));
-        iotProtocol.updateDeviceStatus(true);
-    } else {
-        Serial.println(F("MQTT connect failed"));
+}
+
+void setup() {
+    Serial.begin(115200);
+    Serial.println(F("\n=== ESP32 AQ Monitor Starting ==="));
+
+    dhtJob = scheduler.add("dht", runDht);
+    mq2Job = scheduler.add("mq2", runMq2);
+    alertJob = scheduler.add("alert", runAlert);
+    sampleJob = scheduler.add("sample", runSample);
+    commandJob = scheduler.add("command", runCommand);
+    displayJob = scheduler.add("display", runDisplay);
+
+    startJob = netScheduler.add("start", runStart);
+    wifiJob = netScheduler.add("wifi", runWifi);
+    clockJob = netScheduler.add("clock", runClock);
+    publishJob = netScheduler.add("publish", runPublish);
+    replayJob = netScheduler.add("replay", runReplay);
+    brokerJob = netScheduler.add("broker", runBroker);
+    statusJob = netScheduler.add("status", runStatus);
+    metricsJob = netScheduler.add("metrics", runMetrics);
+    netScheduler.every(metricsJob, METRICS_PUBLISH_INTERVAL_MS);
+    traceJob = netScheduler.add("trace", runTrace);
+    netScheduler.every(traceJob, TRACE_DRAIN_INTERVAL_MS);
+    traceLog.onBacklog(wakeTrace);
+
+    // Client setup only, nothing goes on the network yet
+    brokerConfigured = iotProtocol.init(COMM_PROTOCOL);
+    if (!brokerConfigured) Serial.println(F("IoT init failed"));
+
+    // Both schedulers are complete before the network task can run
+    if (xTaskCreatePinnedToCore(networkTask, "network", NETWORK_TASK_STACK_BYTES, nullptr, NETWORK_TASK_PRIORITY,
+                                &networkTaskHandle, NETWORK_TASK_CORE) != pdPASS) {
+        Serial.println(F("Network task failed to start"));
     }
-    
-    display.showMessage(F("System Ready"));
-    delay(2000);
+    loopMetrics.setTasks(xTaskGetCurrentTaskHandle(), networkTaskHandle);
+
+    // Every stage that waits on nothing starts now; WiFi association and the
+    // gas sensor warm-up carry on in the background, and the stages that depend on
+    // them start from the loop once they are done
+    bootSequence.update();
+    display.showBootProgress(bootSequence);
 }
 
 void loop() {
-    const unsigned long now = millis();
-    
-    // Sensor reading
-    if (now - state.lastSensorRead >= static_cast<unsigned long>(state.samplingInterval) * 1000UL) {
-        state.lastSensorRead = now;
-        
-        state.ppm = sensor.readPPM();
-        state.quality = sensor.getAirQuality(state.ppm);
-        
-        if (state.dhtInitialized) readCalibratedDHT();
-        
-        Serial.printf_P(PSTR("PPM: %.1f, Quality: %s\n"), state.ppm, state.quality.c_str());
-        
-        alert.checkPPMLevel(state.ppm);
-        alert.update();
-        
-        // Display update
-        if (state.customMessage.length() > 0) {
-            display.showCustomMessage(state.customMessage);
-            if (now - state.customMessageTime > 10000UL) {
-                state.customMessage = "";
-            }
-        } else {
-            display.showAirQuality(state.ppm, state.quality, state.relayState);
+    const uint64_t passUs = TimeService::monotonicUs();
+    if (scheduler.runDue() > 0) loopMetrics.recordPass(MetricStage::LOOP_PASS, passUs);
+
+    // Bring-up: every stage ends in a job or a link change, which wakes this
+    // task, so one update() after the jobs starts the stages whose
+    // dependencies just finished
+    if (!bootSequence.isComplete()) {
+        if (bootSequence.update()) {
+            bootSequence.printTimeline();
+            netLink.bootComplete.store(true);
+            netScheduler.post(statusJob);
         }
+        if (state.lastSensorRead == 0) display.showBootProgress(bootSequence);
     }
-    
-    // MQTT publish
-    if (now - state.lastMQTTUpdate >= MQTT_UPDATE_INTERVAL_MS) {
-        state.lastMQTTUpdate = now;
-        
-        if (iotProtocol.publishSensorData(state.ppm, state.quality, state.relayState,
-                                         state.temperature, state.humidity)) {
-            Serial.println(F("MQTT publish OK"));
-        } else {
-            Serial.println(F("MQTT publish FAIL"));
-        }
+
+    // Until the next deadline or a post from the network task
+    scheduler.sleep();
+}
+
+// ============================================================================
+// Loop task jobs
+// ============================================================================
+
+// One DHT sample per run, averaged result when the window completes
+void runDht() {
+    const uint64_t startUs = TimeService::monotonicUs();
+    const bool complete = dhtSampler.update();
+    loopMetrics.record(MetricStage::DHT_READ, startUs);
+    if (!complete) return;
+    state.temperature = dhtSampler.getTemperature();
+    state.humidity = dhtSampler.getHumidity();
+    TRACE(DHT_READING, state.temperature, state.humidity, dhtSampler.getValidCount());
+    const bool valid = dhtSampler.getValidCount() > 0;
+    gasChannels.setConditions(valid ? state.temperature : NAN, valid ? state.humidity : NAN);
+}
+
+// Wall-clock time for the calibration record, to the second the network
+// task last published
+uint64_t wallClockUs() {
+    const uint32_t epochAtBootS = netLink.epochAtBootS.load();
+    return epochAtBootS ? epochAtBootS * 1000000ULL + TimeService::monotonicUs() : 0;
+}
+
+// Gas sensor warm-up and calibration samples; idle otherwise. A calibration
+// that waits for clean air is checked after each reading instead.
+void runMq2() {
+    gasChannels.update(wallClockUs(), dhtSampler.getValidCount() > 0 ? state.temperature : NAN,
+                       dhtSampler.getValidCount() > 0 ? state.humidity : NAN);
+    if (!gasChannels.isSampling()) {
+        scheduler.cancel(mq2Job);
+    } else if (!scheduler.isScheduled(mq2Job)) {
+        scheduler.every(mq2Job, MQ2_UPDATE_MS);
     }
-    
-    // Command check
-    if (now - state.lastCommandCheck >= COMMAND_CHECK_INTERVAL_MS) {
-        state.lastCommandCheck = now;
-        
-        String cmd = iotProtocol.receiveCommand();
-        if (cmd.length() > 0) {
-            Serial.println(F("=== COMMAND ==="));
-            Serial.println(cmd);
-            processCommands(cmd);
-            Serial.println(F("=== END ==="));
+}
+
+// Ends the boot chirp, then blinks and beeps while an alert is active
+void runAlert() {
+    alert.finishSelfTest();
+    alert.update();
+    if (!alert.isAlertActive()) {
+        scheduler.cancel(alertJob);
+    } else if (!scheduler.isScheduled(alertJob)) {
+        scheduler.every(alertJob, ALERT_BLINK_INTERVAL_MS);
+    }
+}
+
+// The alert is evaluated and actuated here, whatever the network task is
+// doing; every reading is handed over through sampleRing
+void runSample() {
+    const unsigned long now = millis();
+    state.lastSensorRead = now;
+
+    // Stamped at acquisition, not at publish
+    const uint64_t acquiredUs = TimeService::monotonicUs();
+    gasChannels.scan();
+    state.ppm = gasChannels.getPPM(0);
+    loopMetrics.record(MetricStage::PPM_READ, acquiredUs);
+    state.quality = classifyAirQuality(state.ppm);
+    trendHistory.add(acquiredUs / 1000U, state.ppm);
+
+    TRACE(PPM_READING, state.ppm, airQualityLabel(state.quality));
+
+    alert.checkPPMLevel(state.ppm);
+    if (alert.isAlertActive() != scheduler.isScheduled(alertJob)) scheduler.post(alertJob);
+    if (gasChannels.isCalibrating() && !scheduler.isScheduled(mq2Job)) scheduler.post(mq2Job);
+
+    // Every reading is queued for the batch; one outside the dead-band, a
+    // band or state change or a heartbeat has the batch published right away
+    TelemetrySample sample;
+    sample.timestamp = acquiredUs;   // Converted to wall-clock time by the network task
+    sample.ppm = state.ppm;
+    sample.temperature = state.temperature;
+    sample.humidity = state.humidity;
+    sample.quality = static_cast<uint8_t>(state.quality);
+    sample.gasChannels = GAS_CHANNEL_COUNT;
+    for (size_t c = 1; c < GAS_CHANNEL_COUNT; ++c) sample.gasPpm[c - 1] = gasChannels.getPPM(c);
+    gasChannels.sensor(0).estimate(MQ2_GAS_SET, sample.gasEstimate);
+    sample.gasEstimates = MQ2_GAS_COUNT;
+    sample.flags = (state.relayState ? BinaryTelemetry::RECORD_FLAG_RELAY_ON : 0) |
+                   (alert.isAlertActive() ? BinaryTelemetry::RECORD_FLAG_ALERT : 0) |
+                   (gasChannels.isWarming() ? BinaryTelemetry::RECORD_FLAG_WARMING : 0) |
+                   (gasChannels.isCalibrationFailed() ? BinaryTelemetry::RECORD_FLAG_CAL_FAILED : 0);
+    if (!sampleRing.push(sample)) TRACE(SAMPLE_RING_FULL);
+    if (reportPolicy.evaluate(sample, now) != ReportReason::NONE) {
+        netLink.reportRequested.store(true);
+        netScheduler.post(publishJob);
+    } else if (sampleRing.size() >= TELEMETRY_BATCH_FLUSH_SAMPLES) {
+        netScheduler.post(publishJob);
+    }
+    scheduler.post(displayJob);
+    loopMetrics.record(MetricStage::SAMPLE, acquiredUs);
+}
+
+// Commands the network task received, run on this task next to what they
+// drive
+void runCommand() {
+    const uint64_t startUs = TimeService::monotonicUs();
+    iotProtocol.handleCommands(handleCommand);
+    loopMetrics.record(MetricStage::COMMANDS, startUs);
+}
+
+// Posted after each reading; its own period turns the rotating pages
+void runDisplay() {
+    const uint64_t startUs = TimeService::monotonicUs();
+    const unsigned long now = millis();
+    if (state.customMessage.length() > 0 && now - state.customMessageTime > CUSTOM_MESSAGE_TIMEOUT_MS) {
+        state.customMessage = "";
+    }
+    if (state.customMessage.length() > 0) {
+        display.showCustomMessage(state.customMessage);
+    } else if (state.lastSensorRead != 0) {
+        showReadings(now);
+    }
+    loopMetrics.record(MetricStage::DISPLAY, startUs);
+}
+
+// ============================================================================
+// Network task jobs
+// ============================================================================
+
+// Wakes the loop task when a flag its boot stages wait on changes
+void setLink(std::atomic<bool>& flag, bool value) {
+    if (flag.exchange(value) != value) scheduler.wake();
+}
+
+// Boot stages the loop task handed over, started on the task that owns them
+void runStart() {
+    const uint16_t requested = netLink.startRequests.exchange(0);
+    if (requested & stageBit(BootStage::WIFI)) {
+        wifiManager.onChange(wakeWifi);
+        wifiManager.begin();
+        netScheduler.schedule(wifiJob, wifiManager.msUntilDue());
+    }
+    if (requested & stageBit(BootStage::CLOCK)) {
+        timeService.onReply(wakeClock);
+        timeService.begin();
+        netScheduler.post(clockJob);
+    }
+    if (requested & stageBit(BootStage::BROKER)) {
+        iotProtocol.connect();
+        netScheduler.every(brokerJob, COMMAND_CHECK_INTERVAL_MS);
+        netScheduler.post(brokerJob);
+    }
+    net.started |= requested;
+}
+
+// Posted by WiFi events, otherwise due at the manager's next timeout; the
+// broker is dialled as soon as the link has an address
+void runWifi() {
+    if (wifiManager.update()) {
+        if (net.started & stageBit(BootStage::BROKER)) {
+            iotProtocol.connect();
+            netScheduler.post(brokerJob);
         }
+        if (net.started & stageBit(BootStage::CLOCK)) netScheduler.post(clockJob);
     }
-    
-    iotProtocol.loop();
-    delay(100);
+    setLink(netLink.wifiUp, wifiManager.isConnectedToWiFi());
+    netScheduler.schedule(wifiJob, wifiManager.msUntilDue());
 }
 
-void processCommands(const String& jsonStr) {
-    DynamicJsonDocument doc(1024);
-    DeserializationError err = deserializeJson(doc, jsonStr);
-    
-    if (err) {
-        Serial.println(F("JSON parse failed"));
+// SNTP; readings still waiting in RAM get their wall-clock stamp
+void runClock() {
+    if (timeService.update()) {
+        const size_t resolved = telemetryBatch.resolveUptimeStamps(timeService);
+        const uint64_t monoUs = TimeService::monotonicUs();
+        netLink.epochAtBootS.store(static_cast<uint32_t>((timeService.toEpochUs(monoUs) - monoUs) / 1000000ULL));
+        TRACE(TIME_SYNCED, timeService.getLastRoundTripUs() / 1000.0F, timeService.getDriftPpb() / 1000.0F,
+              static_cast<unsigned>(resolved));
+    }
+    setLink(netLink.synced, timeService.isSynced());
+    netScheduler.schedule(clockJob, timeService.msUntilDue());
+}
+
+// Readings from the loop task into the batch. The wall-clock stamp is worked
+// out from the acquisition time, so it is the one the reading would have had
+// if stamped when taken.
+void takeReadings() {
+    TelemetrySample sample;
+    while (sampleRing.pop(sample)) {
+        if (!timeService.isSynced()) sample.flags |= BinaryTelemetry::RECORD_FLAG_UPTIME;
+        sample.timestamp = timeService.timestampUs(sample.timestamp);
+        telemetryBatch.add(sample);
+    }
+}
+
+// Spilled readings are replayed while the broker is up
+void armReplay() {
+    if (telemetryLog.pending() > 0 && iotProtocol.isConnectedToServer() && !netScheduler.isScheduled(replayJob)) {
+        netScheduler.every(replayJob, TELEMETRY_REPLAY_INTERVAL_MS);
+    }
+}
+
+// MQTT publish, once per flush window or as soon as the loop task asks for
+// it; a batch the broker did not take is spilled to flash, and what is left
+// goes with the next flush window
+void runPublish() {
+    const uint64_t startUs = TimeService::monotonicUs();
+    const bool reportNow = netLink.reportRequested.exchange(false);   // Before the ring: its reading is in
+    takeReadings();
+    const unsigned long now = millis();
+    if (telemetryBatch.empty()) telemetryBatch.consume(0, now);   // The window starts with the next reading
+    if (!telemetryBatch.empty() && (reportNow || telemetryBatch.shouldFlush(now))) {
+        size_t sent = iotProtocol.publishSensorBatch(telemetryBatch);
+        if (sent > 0) setLink(netLink.published, true);
+        if (sent == 0) sent = telemetryLog.append(telemetryBatch.data(), telemetryBatch.size());
+        telemetryBatch.consume(sent, now);
+        armReplay();
+        loopMetrics.record(MetricStage::PUBLISH, startUs);
+    }
+    netScheduler.schedule(publishJob, telemetryBatch.msUntilFlush(now));
+}
+
+// Spilled readings, oldest first, rate limited behind live traffic
+void runReplay() {
+    if (telemetryLog.pending() == 0 || !iotProtocol.isConnectedToServer()) {
+        netScheduler.cancel(replayJob);
         return;
     }
-    
-    // Buzzer override
-    if (doc.containsKey("buzzer_override")) {
-        bool override = doc["buzzer_override"];
-        bool on = doc["buzzer_state"];
-        if (!state.relayState) {
-            relay.turnOn();
-            state.relayState = true;
-        }
-        alert.setBuzzerManualOverride(override, on);
+    const uint64_t startUs = TimeService::monotonicUs();
+    TelemetrySample chunk[TELEMETRY_REPLAY_BATCH];
+    const size_t n = telemetryLog.peek(chunk, TELEMETRY_REPLAY_BATCH);
+    telemetryLog.consume(iotProtocol.publishSamples(chunk, n, true));
+    loopMetrics.record(MetricStage::REPLAY, startUs);
+}
+
+// PubSubClient only reads the socket when polled, so commands wait up to
+// COMMAND_CHECK_INTERVAL_MS; they are run by the loop task. Online status
+// goes out on every (re)connect.
+void runBroker() {
+    const uint64_t startUs = TimeService::monotonicUs();
+    iotProtocol.loop();
+    loopMetrics.record(MetricStage::BROKER_POLL, startUs);
+    if (iotProtocol.pendingCommands() > 0) scheduler.post(commandJob);
+
+    const bool online = iotProtocol.isConnectedToServer();
+    if (online && !net.serverOnline) {
+        runStatus();
+        armReplay();
     }
-    
-    // LED override
-    if (doc.containsKey("led_override")) {
-        alert.setLedManualOverride(doc["led_override"], doc["led_state"]);
+    net.serverOnline = online;
+    setLink(netLink.brokerUp, online);
+}
+
+// Online status, with the boot timeline once the loop task has finished it
+void runStatus() {
+    if (!iotProtocol.isConnectedToServer()) return;
+    iotProtocol.updateDeviceStatus(true, timeService.nowEpochUs(), netLink.bootComplete.load() ? &bootSequence : nullptr);
+}
+
+// Stage histograms, overruns and watermarks, cumulative since boot
+void runMetrics() {
+    if (iotProtocol.isConnectedToServer()) iotProtocol.publishMetrics(loopMetrics, timeService.nowEpochUs());
+}
+
+// Trace records out to the UART, as many as its FIFO takes without waiting.
+// Registered last, so it runs after everything else due at the same time;
+// a backlog is picked up again once the FIFO has drained (~11 ms at 115200)
+void runTrace() {
+    if (traceLog.drain(Serial)) {
+        netScheduler.schedule(traceJob, TRACE_DRAIN_RETRY_MS);
+    } else {
+        netScheduler.every(traceJob, TRACE_DRAIN_INTERVAL_MS);
     }
-    
-    // Clear overrides
-    if (doc["clear_override"]) {
-        alert.clearManualOverride();
+}
+
+void handleCommand(const char* payload, size_t length) {
+    Serial.println(F("=== COMMAND ==="));
+    Serial.printf_P(PSTR("%.*s\n"), static_cast<int>(length), payload);
+    processCommands(payload, length);
+    Serial.println(F("=== END ==="));
+}
+
+void processCommands(const char* json, size_t length) {
+    if (!commandDispatcher.dispatch(json, length)) {
+        Serial.println(F("JSON parse failed"));
     }
-    
-    // Relay control
-    if (doc.containsKey("relay_state")) {
-        bool newState = (String(doc["relay_state"]) == "ON");
-        if (newState != state.relayState) {
-            state.relayState = newState;
-            relay.setState(newState);
-            display.showAirQuality(state.ppm, state.quality, state.relayState);
-        }
+}
+
+// Live reading or trend graph per the selected view; an active alert always
+// shows the live reading.
+void showReadings(unsigned long now) {
+    DisplayView view = state.displayView;
+    if (alert.isAlertActive()) {
+        view = DisplayView::LIVE;
+    } else if (view == DisplayView::ROTATE) {
+        static constexpr DisplayView PAGES[] = {DisplayView::LIVE, DisplayView::TREND_HOUR, DisplayView::TREND_DAY};
+        view = PAGES[(now / DISPLAY_PAGE_MS) % (sizeof(PAGES) / sizeof(PAGES[0]))];
     }
     
-    // Sampling interval
-    if (doc.containsKey("sampling_interval")) {
-        int val = doc["sampling_interval"];
-        if (val >= 1 && val <= 300) {
-            state.samplingInterval = val;
-            Serial.printf_P(PSTR("Interval: %ds\n"), val);
-        }
+    switch (view) {
+        case DisplayView::TREND_HOUR:
+            display.showTrend(trendHistory, TrendRange::HOUR, state.ppm);
+            break;
+        case DisplayView::TREND_DAY:
+            display.showTrend(trendHistory, TrendRange::DAY, state.ppm);
+            break;
+        default:
+            display.showAirQuality(state.ppm, state.quality, state.relayState, gasChannels.isCalibrationFailed());
+            break;
     }
-    
-    // OLED message
-    if (doc.containsKey("oled_message")) {
-        state.customMessage = doc["oled_message"];
-        state.customMessageTime = millis();
-        if (state.customMessage == "CLEAR") state.customMessage = "";
+}
+
+
+// ============================================================================
+// Command actions, bound to COMMAND_TABLE keys below
+// ============================================================================
+
+bool cmdBuzzerOverride(const CommandArgs& args) {
+    if (!state.relayState) {
+        relay.turnOn();
+        state.relayState = true;
     }
-    
-    // Direct tests
-    if (doc["test_buzzer"]) {
-        if (!state.relayState) { relay.turnOn(); state.relayState = true; }
-        digitalWrite(BUZZER_PIN, HIGH);
-        digitalWrite(LED_PIN, HIGH);
-        Serial.println(F("Direct test: ON"));
+    alert.setBuzzerManualOverride(args.getBool(CommandKey::BUZZER_OVERRIDE),
+                                  args.getBool(CommandKey::BUZZER_STATE));
+    return true;
+}
+
+bool cmdLedOverride(const CommandArgs& args) {
+    alert.setLedManualOverride(args.getBool(CommandKey::LED_OVERRIDE), args.getBool(CommandKey::LED_STATE));
+    return true;
+}
+
+bool cmdClearOverride(const CommandArgs& args) {
+    if (args.getBool(CommandKey::CLEAR_OVERRIDE)) alert.clearManualOverride();
+    return true;
+}
+
+bool cmdRelayState(const CommandArgs& args) {
+    const char* value = args.getString(CommandKey::RELAY_STATE);
+    const bool on = strcmp(value, "ON") == 0;
+    if (!on && strcmp(value, "OFF") != 0) return false;
+    if (on != state.relayState) {
+        state.relayState = on;
+        relay.setState(on);
+        display.showAirQuality(state.ppm, state.quality, state.relayState);
     }
-    
-    if (doc["test_led"]) {
-        digitalWrite(LED_PIN, doc["test_led"] ? HIGH : LOW);
+    return true;
+}
+
+bool cmdSamplingInterval(const CommandArgs& args) {
+    const int32_t val = args.getInt(CommandKey::SAMPLING_INTERVAL);
+    if (val < 1 || val > 300) return false;
+    state.samplingInterval = val;
+    scheduler.every(sampleJob, static_cast<uint32_t>(val) * 1000UL);
+    Serial.printf_P(PSTR("Interval: %ds\n"), static_cast<int>(val));
+    return true;
+}
+
+// Report-by-exception tuning
+bool cmdReportHeartbeat(const CommandArgs& args) {
+    const int32_t val = args.getInt(CommandKey::REPORT_HEARTBEAT);
+    if (val < 10 || val > 3600) return false;
+    reportPolicy.setHeartbeat(static_cast<uint32_t>(val) * 1000UL);
+    Serial.printf_P(PSTR("Heartbeat: %ds\n"), static_cast<int>(val));
+    return true;
+}
+
+bool cmdReportDeadband(const CommandArgs& args) {
+    const float absolute = args.getFloat(CommandKey::REPORT_DEADBAND_PPM);
+    const float relative = args.getFloat(CommandKey::REPORT_DEADBAND_PCT, REPORT_PPM_DEADBAND_REL * 100.0F);
+    if (absolute < 0.0F || relative < 0.0F || relative > 100.0F) return false;
+    reportPolicy.setPpmDeadband(absolute, relative / 100.0F);
+    Serial.printf_P(PSTR("PPM dead-band: %.1f ppm / %.0f%%\n"), absolute, relative);
+    return true;
+}
+
+// Telemetry payload format
+bool cmdPayloadFormat(const CommandArgs& args) {
+    const char* format = args.getString(CommandKey::PAYLOAD_FORMAT);
+    if (strcmp(format, "binary") == 0) {
+        iotProtocol.setPayloadFormat(PayloadFormat::BINARY);
+        Serial.println(F("Payload format: binary"));
+    } else if (strcmp(format, "json") == 0) {
+        iotProtocol.setPayloadFormat(PayloadFormat::JSON);
+        Serial.println(F("Payload format: json"));
+    } else {
+        return false;
     }
-    
-    if (doc["check_pins"]) {
-        Serial.printf_P(PSTR("LED:%d=%d BUZ:%d=%d REL:%d\n"),
-                       LED_PIN, digitalRead(LED_PIN),
-                       BUZZER_PIN, digitalRead(BUZZER_PIN),
-                       RELAY_PIN, digitalRead(RELAY_PIN));
+    return true;
+}
+
+// Screen selection: "auto" rotates, the others pin one screen
+bool cmdDisplayView(const CommandArgs& args) {
+    const char* view = args.getString(CommandKey::DISPLAY_VIEW);
+    if (strcmp(view, "auto") == 0) state.displayView = DisplayView::ROTATE;
+    else if (strcmp(view, "live") == 0) state.displayView = DisplayView::LIVE;
+    else if (strcmp(view, "trend_hour") == 0) state.displayView = DisplayView::TREND_HOUR;
+    else if (strcmp(view, "trend_day") == 0) state.displayView = DisplayView::TREND_DAY;
+    else return false;
+    scheduler.post(displayJob);
+    Serial.printf_P(PSTR("Display view: %s\n"), view);
+    return true;
+}
+
+// OLED message
+bool cmdOledMessage(const CommandArgs& args) {
+    const char* message = args.getString(CommandKey::OLED_MESSAGE);
+    state.customMessage = strcmp(message, "CLEAR") == 0 ? "" : message;
+    state.customMessageTime = millis();
+    scheduler.post(displayJob);
+    return true;
+}
+
+// Direct tests
+bool cmdTestBuzzer(const CommandArgs& args) {
+    if (!args.getBool(CommandKey::TEST_BUZZER)) return true;
+    if (!state.relayState) { relay.turnOn(); state.relayState = true; }
+    digitalWrite(BUZZER_PIN, HIGH);
+    digitalWrite(LED_PIN, HIGH);
+    Serial.println(F("Direct test: ON"));
+    return true;
+}
+
+bool cmdTestLed(const CommandArgs& args) {
+    digitalWrite(LED_PIN, args.getBool(CommandKey::TEST_LED) ? HIGH : LOW);
+    return true;
+}
+
+bool cmdCheckPins(const CommandArgs& args) {
+    if (!args.getBool(CommandKey::CHECK_PINS)) return true;
+    Serial.printf_P(PSTR("LED:%d=%d BUZ:%d=%d REL:%d\n"),
+                   LED_PIN, digitalRead(LED_PIN),
+                   BUZZER_PIN, digitalRead(BUZZER_PIN),
+                   RELAY_PIN, digitalRead(RELAY_PIN));
+    return true;
+}
+
+bool cmdCommandStats(const CommandArgs& args) {
+    if (!args.getBool(CommandKey::COMMAND_STATS)) return true;
+    Serial.printf_P(PSTR("Commands: %u parse errors, %u unknown keys, %u dropped\n"),
+                   static_cast<unsigned>(commandDispatcher.getParseErrors()),
+                   static_cast<unsigned>(commandDispatcher.getUnknownKeys()),
+                   static_cast<unsigned>(iotProtocol.getDroppedCommands()));
+    for (const CommandSpec& spec : COMMAND_TABLE) {
+        const CommandStats& s = commandDispatcher.getStats(spec.id);
+        if (s.calls == 0 && s.errors == 0) continue;
+        Serial.printf_P(PSTR("  %-20s %5u calls %3u errors avg %5u us max %5u us\n"), spec.name,
+                       static_cast<unsigned>(s.calls), static_cast<unsigned>(s.errors),
+                       static_cast<unsigned>(s.calls ? s.totalUs / s.calls : 0),
+                       static_cast<unsigned>(s.maxUs));
     }
+    return true;
+}
+
+bool cmdMetrics(const CommandArgs& args) {
+    if (args.getBool(CommandKey::METRICS)) loopMetrics.print();
+    return true;
+}
+
+// Only in clean air: the average of the next samples becomes R0 and is stored
+bool cmdCalibrate(const CommandArgs& args) {
+    if (!args.getBool(CommandKey::CALIBRATE)) return true;
+    gasChannels.requestCalibration();
+    scheduler.post(mq2Job);
+    Serial.println(gasChannels.isWarming() ? F("Gas sensor calibration queued until warm")
+                                           : F("Gas sensor calibration requested"));
+    return true;
 }
@@ -0,0 +1,79 @@
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// ============================================================================
+// Multi-producer / single-consumer ring of fixed-size records, for tasks that
+// all hand data to one drain without a lock.
+//
+// Each slot carries a sequence number (bounded MPMC queue after D. Vyukov):
+// a producer claims the next slot with a compare-and-swap on `tail`, copies
+// the record in and then publishes it by advancing the slot's sequence, so
+// the consumer never reads a slot that is still being written. Producers on
+// different cores never wait for each other beyond a retried CAS. A full
+// ring rejects the new record and counts it. No heap.
+// ============================================================================
+template <typename T, size_t SLOTS>
+class MpscRing {
+    static_assert(SLOTS >= 2 && (SLOTS & (SLOTS - 1)) == 0, "slot count must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "records are copied in and out");
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence;   // == position: free; == position + 1: holds a record
+        T record;
+    };
+
+    Slot slots[SLOTS];
+    std::atomic<uint32_t> tail;      // next position to claim (producers)
+    std::atomic<uint32_t> head;      // next position to read (consumer)
+    std::atomic<uint32_t> dropped;   // rejected because the ring was full
+
+public:
+    MpscRing() : tail(0), head(0), dropped(0) {
+        for (uint32_t i = 0; i < SLOTS; ++i) slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Any task
+    bool push(const T& record) {
+        uint32_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[pos & (SLOTS - 1)];
+            const int32_t lag = static_cast<int32_t>(slot.sequence.load(std::memory_order_acquire) - pos);
+            if (lag == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.record = record;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer side: oldest published record, false when empty
+    bool pop(T& record) {
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        Slot& slot = slots[h & (SLOTS - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != h + 1) return false;
+        record = slot.record;
+        slot.sequence.store(h + SLOTS, std::memory_order_release);
+        head.store(h + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Claimed slots, including ones still being written
+    size_t size() const { return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_relaxed); }
+    static constexpr size_t capacity() { return SLOTS; }
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef MQ2_GASES_H
+#define MQ2_GASES_H
+
+#include <cstddef>
+#include <cstdint>
+#include "config.h"
+#include "ppm_curve.h"
+
+// ============================================================================
+// Every gas on the MQ-2 datasheet from one Rs/R0 reading.
+//
+// The MQ-2 answers to LPG, propane, H2, CO, alcohol and smoke alike; which
+// one is in the air it cannot tell, but each curve turns the same ratio into
+// the ppm that gas would have to be at. MQ2_GAS_SET holds the curves of
+// MQ2_GAS_CURVES (config.h) as one PowerCurveSet: the ratio is split once
+// and every gas is a lerp and a multiply in the same vector lanes.
+// ============================================================================
+
+enum class Mq2Gas : uint8_t {
+    LPG,
+    PROPANE,
+    H2,
+    CO,
+    ALCOHOL,
+    SMOKE,
+    COUNT
+};
+
+constexpr size_t MQ2_GAS_COUNT = static_cast<size_t>(Mq2Gas::COUNT);
+
+static_assert(sizeof(MQ2_GAS_CURVES) / sizeof(MQ2_GAS_CURVES[0]) == MQ2_GAS_COUNT,
+              "one MQ2_GAS_CURVES entry per Mq2Gas");
+
+inline constexpr PowerCurveSet<MQ2_GAS_COUNT> MQ2_GAS_SET(MQ2_GAS_CURVES, MQ2_DATASHEET_CLEAN_AIR_RATIO);
+
+constexpr const char* mq2GasName(Mq2Gas gas) {
+    return gas < Mq2Gas::COUNT ? MQ2_GAS_CURVES[static_cast<size_t>(gas)].name : "unknown";
+}
+
+#endif
@@ -1,19 +1,32 @@
 #include "oled_display.h"
 #include <Arduino.h>
+#include <cstring>
+#include "config.h"
 
-// Import config values
-extern const int SCREEN_WIDTH;
-extern const int SCREEN_HEIGHT;
-extern const int OLED_SDA;
-extern const int OLED_SCL;
-extern const uint8_t OLED_ADDRESS;
+namespace {
 
+// Display bytes per I2C transaction after the control byte, sized to the
+// Wire buffer the same way the Adafruit driver does.
+#ifdef I2C_BUFFER_LENGTH
+constexpr size_t OLED_WIRE_CHUNK = (I2C_BUFFER_LENGTH < 256 ? I2C_BUFFER_LENGTH : 256) - 1;
+#else
+constexpr size_t OLED_WIRE_CHUNK = 31;
+#endif
+
+}  // namespace
+
+// The driver switches the bus to clkDuring for its own transfers and back
+// to clkAfter; both are set to the fast clock so flush() runs at it too.
 OLEDDisplay::OLEDDisplay() 
-    : display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1)
-    , isInitialized(false) {}
+    : display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1, OLED_I2C_CLOCK_HZ, OLED_I2C_CLOCK_HZ)
+    , isInitialized(false)
+    , panel{}
+    , panelKnown(false)
+    , lastFlushBytes(0)
+    , flushes(0) {}
 
 bool OLEDDisplay::init() {
-    Wire.begin(OLED_SDA, OLED_SCL);
+    Wire.begin(OLED_SDA, OLED_SCL, OLED_I2C_CLOCK_HZ);
     
     if (!display.begin(SSD1306_SWITCHCAPVCC, OLED_ADDRESS)) {
         Serial.println(F("SSD1306 allocation failed"));
@@ -21,6 +34,7 @@ bool OLEDDisplay::init() {
     }
     
     isInitialized = true;
+    panelKnown = false;
     clear();
     Serial.println(F("OLED initialized"));
     return true;
@@ -46,10 +60,10 @@ void OLEDDisplay::showWelcome() {
     display.setCursor(30, 55);
     display.println(F("Starting..."));
     
-    display.display();
+    flush();
 }
 
-void OLEDDisplay::showAirQuality(float ppm, const String& quality, bool relayState) {
+void OLEDDisplay::showAirQuality(float ppm, AirQuality quality, bool relayState, bool calibrationFailed) {
     if (!isInitialized) return;
     clear();
     
@@ -57,6 +71,10 @@ void OLEDDisplay::showAirQuality(float ppm, const String& quality, bool relaySta
     display.setTextSize(1);
     display.setCursor(0, 0);
     display.println(F("Air Quality"));
+    if (calibrationFailed) {
+        display.setCursor(72, 0);
+        display.print(F("NO CAL"));   // ppm is on an old R0, or 0 without one
+    }
     display.drawLine(0, 12, 127, 12, SSD1306_WHITE);
     
     // PPM
@@ -69,7 +87,7 @@ void OLEDDisplay::showAirQuality(float ppm, const String& quality, bool relaySta
     // Quality
     display.setCursor(10, 40);
     display.print(F("Q: "));
-    display.println(quality);
+    display.println(airQualityLabel(quality));
     
     // Relay
     display.setCursor(10, 52);
@@ -80,30 +98,79 @@ void OLEDDisplay::showAirQuality(float ppm, const String& quality, bool relaySta
     display.drawCircle(120, 8, 3, SSD1306_WHITE);
     if (relayState) display.fillCircle(120, 8, 2, SSD1306_WHITE);
     
-    display.display();
+    flush();
 }
 
 void OLEDDisplay::showMessage(const String& message) {
     if (!isInitialized) return;
     clear();
     
+    display.setTextSize(1);
+    
+    // 21 columns x 8 lines of 6x8 text; each line goes out in one write
+    constexpr size_t COLUMNS = SCREEN_WIDTH / 6;
+    constexpr int LINES = SCREEN_HEIGHT / 8;
+    char line[COLUMNS];
+    size_t length = 0;
+    int row = 0;
+    auto emit = [&]() {
+        display.setCursor(0, row * 8);
+        display.write(reinterpret_cast<const uint8_t*>(line), length);
+        length = 0;
+        ++row;
+    };
+    for (size_t i = 0; i < message.length() && row < LINES; ++i) {
+        const char c = message.charAt(i);
+        if (c == '\n') {
+            emit();
+            continue;
+        }
+        if (length == COLUMNS) {
+            emit();
+            if (row == LINES) break;
+        }
+        line[length++] = c;
+    }
+    if (length > 0 && row < LINES) emit();
+    
+    flush();
+}
+
+// Progress bar over the finished stages, then the ones still running
+void OLEDDisplay::showBootProgress(const BootSequence& boot) {
+    if (!isInitialized) return;
+    clear();
+    
     display.setTextSize(1);
     display.setCursor(0, 0);
+    display.println(F("Starting..."));
+    display.drawLine(0, 12, 127, 12, SSD1306_WHITE);
+    
+    const size_t done = boot.finishedCount();
+    display.drawRect(0, 18, SCREEN_WIDTH, 8, SSD1306_WHITE);
+    display.fillRect(0, 18, static_cast<int16_t>(SCREEN_WIDTH * done / boot.size()), 8, SSD1306_WHITE);
+    display.setCursor(0, 30);
+    display.print(done);
+    display.print('/');
+    display.print(boot.size());
+    display.print(F(" ready"));
     
-    int line = 0, col = 0;
-    for (size_t i = 0; i < message.length() && line < 8; ++i) {
-        char c = message.charAt(i);
-        if (c == '\n' || col > 20) {
-            line++;
-            col = 0;
-            if (c == '\n') continue;
+    int16_t x = 0;
+    int16_t y = 42;
+    for (size_t i = 0; i < boot.size() && y < SCREEN_HEIGHT; ++i) {
+        if (!boot.isStarted(i) || boot.isFinished(i)) continue;
+        const int16_t width = static_cast<int16_t>((strlen(boot.name(i)) + 1) * 6);
+        if (x > 0 && x + width > SCREEN_WIDTH) {
+            x = 0;
+            y += 10;
+            if (y >= SCREEN_HEIGHT) break;
         }
-        display.setCursor(col * 6, line * 8);
-        display.print(c);
-        col++;
+        display.setCursor(x, y);
+        display.print(boot.name(i));
+        x += width;
     }
     
-    display.display();
+    flush();
 }
 
 void OLEDDisplay::showWiFiStatus(const String& ip) {
@@ -125,9 +192,97 @@ void OLEDDisplay::showWiFiStatus(const String& ip) {
     display.setCursor(0, 45);
     display.println(F("System Ready"));
     
-    display.display();
+    flush();
+}
+
+// Header with the range, the current ppm and the graph's scale, then one
+// vertical bar per column from its minimum to its maximum. The scale follows
+// the extremes of the visible range, so a flat hour still shows its ripple.
+void OLEDDisplay::showTrend(const TrendHistory& history, TrendRange range, float ppm) {
+    if (!isInitialized) return;
+    clear();
+    
+    display.setTextSize(1);
+    display.setCursor(0, 0);
+    float lo = 0.0F;
+    float hi = 0.0F;
+    const bool any = history.bounds(range, lo, hi);
+    char header[32];
+    if (any) {
+        snprintf(header, sizeof(header), "%s %.0f (%.0f-%.0f)", range == TrendRange::HOUR ? "1h" : "24h", ppm, lo, hi);
+    } else {
+        snprintf(header, sizeof(header), "%s  no readings yet", range == TrendRange::HOUR ? "1h" : "24h");
+    }
+    display.print(header);
+    
+    constexpr int GRAPH_TOP = 10;
+    constexpr int GRAPH_HEIGHT = SCREEN_HEIGHT - GRAPH_TOP;
+    display.drawFastHLine(0, SCREEN_HEIGHT - 1, SCREEN_WIDTH, SSD1306_WHITE);
+    if (any) {
+        const float span = (hi - lo) > 1.0F ? (hi - lo) : 1.0F;
+        const float scale = (GRAPH_HEIGHT - 1) / span;
+        for (size_t x = 0; x < TREND_COLUMNS; ++x) {
+            const TrendColumn& c = history.column(range, x);
+            if (c.empty()) continue;
+            const int top = SCREEN_HEIGHT - 1 - static_cast<int>((c.max - lo) * scale + 0.5F);
+            const int bottom = SCREEN_HEIGHT - 1 - static_cast<int>((c.min - lo) * scale + 0.5F);
+            display.drawFastVLine(static_cast<int16_t>(x), static_cast<int16_t>(top),
+                                  static_cast<int16_t>(bottom - top + 1), SSD1306_WHITE);
+        }
+    }
+    
+    flush();
 }
 
 void OLEDDisplay::update() {
-    if (isInitialized) display.display();
+    if (isInitialized) flush();
+}
+
+// Each changed page is sent as its own address window: one command
+// transaction (page and column range), then the data in Wire-sized chunks.
+// With horizontal addressing the controller advances through the window by
+// itself, so unchanged columns and pages are never touched.
+size_t OLEDDisplay::flush() {
+    if (!isInitialized) return 0;
+    const uint8_t* frame = display.getBuffer();
+    if (!frame) return 0;
+    
+    size_t sent = 0;
+    for (uint8_t page = 0; page < SCREEN_HEIGHT / 8; ++page) {
+        const size_t offset = static_cast<size_t>(page) * SCREEN_WIDTH;
+        const uint8_t* next = frame + offset;
+        uint8_t* shown = panel + offset;
+        int first = 0;
+        int last = SCREEN_WIDTH - 1;
+        if (panelKnown) {
+            while (first < SCREEN_WIDTH && next[first] == shown[first]) ++first;
+            if (first == SCREEN_WIDTH) continue;
+            while (next[last] == shown[last]) --last;
+        }
+        sendWindow(page, static_cast<uint8_t>(first), static_cast<uint8_t>(last), next + first);
+        memcpy(shown + first, next + first, last - first + 1);
+        const size_t chunks = (last - first + 1 + OLED_WIRE_CHUNK - 1) / OLED_WIRE_CHUNK;
+        sent += 7 + (last - first + 1) + chunks;   // window command + data + control bytes
+    }
+    panelKnown = true;
+    lastFlushBytes = static_cast<uint32_t>(sent);
+    if (sent > 0) ++flushes;
+    return sent;
+}
+
+void OLEDDisplay::sendWindow(uint8_t page, uint8_t firstColumn, uint8_t lastColumn, const uint8_t* data) {
+    const uint8_t window[] = {0x00, SSD1306_PAGEADDR, page, page, SSD1306_COLUMNADDR, firstColumn, lastColumn};
+    Wire.beginTransmission(OLED_ADDRESS);
+    Wire.write(window, sizeof(window));
+    Wire.endTransmission();
+    
+    for (size_t length = lastColumn - firstColumn + 1; length > 0;) {
+        const size_t chunk = length < OLED_WIRE_CHUNK ? length : OLED_WIRE_CHUNK;
+        Wire.beginTransmission(OLED_ADDRESS);
+        Wire.write(static_cast<uint8_t>(0x40));
+        Wire.write(data, chunk);
+        Wire.endTransmission();
+        data += chunk;
+        length -= chunk;
+    }
 }
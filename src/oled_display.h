@@ -3,22 +3,46 @@
 
 #include <Adafruit_SSD1306.h>
 #include <Wire.h>
+#include "air_quality.h"
+#include "boot_sequence.h"
+#include "config.h"
+#include "trend_history.h"
 
+// Screens are still drawn in full into the driver's framebuffer (cheap, in
+// RAM), but flush() compares it with a copy of what the panel already shows
+// and sends only the changed column range of each changed 8-row page. A ppm
+// update then costs a few dozen bytes on the bus instead of the whole 1 KB
+// frame.
 class OLEDDisplay {
 private:
+    static constexpr size_t FRAME_BYTES = SCREEN_WIDTH * SCREEN_HEIGHT / 8;
+
     Adafruit_SSD1306 display;
     bool isInitialized;
+    uint8_t panel[FRAME_BYTES];   // last frame sent to the controller
+    bool panelKnown;              // false until the first full flush
+    uint32_t lastFlushBytes;
+    uint32_t flushes;
+
+    void sendWindow(uint8_t page, uint8_t firstColumn, uint8_t lastColumn, const uint8_t* data);
 
 public:
     OLEDDisplay();
     bool init();
     void clear();
     void showWelcome();
-    void showAirQuality(float ppm, const String& quality, bool relayState);
+    void showAirQuality(float ppm, AirQuality quality, bool relayState, bool calibrationFailed = false);
     void showMessage(const String& message);
     void showCustomMessage(const String& message) { showMessage(message); }
+    void showBootProgress(const BootSequence& boot);
     void showWiFiStatus(const String& ip);
+    void showTrend(const TrendHistory& history, TrendRange range, float ppm);
     void update();
+    size_t flush();   // Returns the bytes written to the bus, 0 if nothing changed
+
+    const uint8_t* getFrame() { return display.getBuffer(); }   // SCREEN_WIDTH x 8 pages
+    uint32_t getLastFlushBytes() const { return lastFlushBytes; }
+    uint32_t getFlushCount() const { return flushes; }
 };
 
 #endif
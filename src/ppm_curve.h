@@ -0,0 +1,197 @@
+#ifndef PPM_CURVE_H
+#define PPM_CURVE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// ============================================================================
+// Table-driven power-law gas curves: ppm = A * (Rs/R0)^B
+//
+// The ratio is split into its binary exponent e and mantissa m in [1, 2):
+//   A * ratio^B = (A * 2^(B*e)) * m^B
+// Both factors come from tables generated at compile time; m^B is linearly
+// interpolated over 2^MANTISSA_BITS segments. No pow()/log()/exp() runs on
+// the device, only a bit split, two loads, one lerp and one multiply.
+//
+// Linear interpolation of m^B on [1, 2) with step h = 1/SEGMENTS has relative
+// error <= h^2/8 * |B(B-1)| (|f''/f| peaks at m = 1), exposed as
+// MAX_RELATIVE_ERROR. For the MQ-2 curve (B = -2.5, 64 segments) that is
+// 0.027%, well inside the sensor's own accuracy.
+// ============================================================================
+
+namespace ppm_curve_detail {
+
+// Compile-time exp/log for table generation only.
+constexpr double cexp(double x) {
+    int halvings = 0;
+    while (x > 0.5 || x < -0.5) {
+        x /= 2.0;
+        ++halvings;
+    }
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 30; ++n) {
+        term *= x / n;
+        sum += term;
+    }
+    while (halvings-- > 0) sum *= sum;
+    return sum;
+}
+
+constexpr double clog(double x) {
+    int e = 0;
+    while (x > 1.5) { x /= 2.0; ++e; }
+    while (x < 0.75) { x *= 2.0; --e; }
+    // log(x) = 2 * atanh((x - 1) / (x + 1))
+    const double y = (x - 1.0) / (x + 1.0);
+    const double y2 = y * y;
+    double term = y;
+    double sum = 0.0;
+    for (int n = 1; n < 61; n += 2) {
+        sum += term / n;
+        term *= y2;
+    }
+    return 2.0 * sum + e * 0.69314718055994531;
+}
+
+constexpr double cpow(double x, double y) { return cexp(y * clog(x)); }
+
+constexpr double cabs(double x) { return x < 0.0 ? -x : x; }
+
+}  // namespace ppm_curve_detail
+
+// Curve: a type with static constexpr double A and B.
+template <typename Curve, int MANTISSA_BITS = 6, int MIN_EXP = -8, int MAX_EXP = 8>
+class PowerCurveTable {
+public:
+    static constexpr int SEGMENTS = 1 << MANTISSA_BITS;
+    static constexpr double MAX_RELATIVE_ERROR =
+        ppm_curve_detail::cabs(Curve::B * (Curve::B - 1.0)) / (8.0 * SEGMENTS * SEGMENTS);
+
+    // Valid for ratio > 0; ratios outside [2^MIN_EXP, 2^(MAX_EXP+1)) are
+    // clamped to the table ends.
+    static float eval(float ratio) {
+        uint32_t bits;
+        memcpy(&bits, &ratio, sizeof(bits));
+        int e = static_cast<int>((bits >> 23) & 0xFF) - 127;
+        if (e < MIN_EXP) return scale[0] * mantissa[0];
+        if (e > MAX_EXP) return scale[MAX_EXP - MIN_EXP] * mantissa[SEGMENTS];
+
+        constexpr int FRAC_BITS = 23 - MANTISSA_BITS;
+        const uint32_t k = (bits >> FRAC_BITS) & (SEGMENTS - 1);
+        const float frac = static_cast<float>(bits & ((1u << FRAC_BITS) - 1)) * (1.0F / (1u << FRAC_BITS));
+        const float m = mantissa[k] + frac * (mantissa[k + 1] - mantissa[k]);
+        return scale[e - MIN_EXP] * m;
+    }
+
+private:
+    static constexpr std::array<float, SEGMENTS + 1> buildMantissa() {
+        std::array<float, SEGMENTS + 1> t{};
+        for (int k = 0; k <= SEGMENTS; ++k) {
+            t[k] = static_cast<float>(ppm_curve_detail::cpow(1.0 + static_cast<double>(k) / SEGMENTS, Curve::B));
+        }
+        return t;
+    }
+
+    static constexpr std::array<float, MAX_EXP - MIN_EXP + 1> buildScale() {
+        std::array<float, MAX_EXP - MIN_EXP + 1> t{};
+        for (int e = MIN_EXP; e <= MAX_EXP; ++e) {
+            t[e - MIN_EXP] = static_cast<float>(Curve::A * ppm_curve_detail::cpow(2.0, Curve::B * e));
+        }
+        return t;
+    }
+
+    static constexpr std::array<float, SEGMENTS + 1> mantissa = buildMantissa();
+    static constexpr std::array<float, MAX_EXP - MIN_EXP + 1> scale = buildScale();
+};
+
+// ============================================================================
+// Several power-law curves of one sensor from the same ratio.
+//
+// The PowerCurveTable split, shared by every curve: the ratio's binary
+// exponent e and mantissa m are taken once, then for each curve i
+//   A_i * ratio^B_i = (A_i * 2^(B_i*e)) * m^B_i
+// Both factors are tables of structure-of-arrays rows, one lane per curve, so
+// the per-curve work is the same lerp and multiply on whole rows: straight
+// float arithmetic over SIMD-width lanes, no branches, which the compiler
+// vectorises. The table ranges and error bound are PowerCurveTable's, for
+// the steepest curve of the set.
+// ============================================================================
+template <size_t N, int MANTISSA_BITS = 6, int MIN_EXP = -8, int MAX_EXP = 8>
+class PowerCurveSet {
+public:
+    static constexpr size_t SIZE = N;
+    static constexpr int SEGMENTS = 1 << MANTISSA_BITS;
+
+    // Curve: anything with float members a and b (ppm = a * ratio^b).
+    // ratioScale converts the caller's ratio to the one the curves were
+    // fitted against; outputs are clamped to [0, maxPpm].
+    template <typename Curve>
+    constexpr PowerCurveSet(const Curve (&curves)[N], double ratioScale = 1.0, double maxPpm = 10000.0)
+        : mantissa{}
+        , scale{}
+        , maxRelativeError(0.0)
+        , ppmLimit(static_cast<float>(maxPpm)) {
+        for (size_t i = 0; i < N; ++i) {
+            const double b = curves[i].b;
+            const double a = curves[i].a * ppm_curve_detail::cpow(ratioScale, b);
+            for (int k = 0; k <= SEGMENTS; ++k) {
+                mantissa[k][i] = static_cast<float>(ppm_curve_detail::cpow(1.0 + static_cast<double>(k) / SEGMENTS, b));
+            }
+            for (int e = MIN_EXP; e <= MAX_EXP; ++e) {
+                scale[e - MIN_EXP][i] = static_cast<float>(a * ppm_curve_detail::cpow(2.0, b * e));
+            }
+            const double error = ppm_curve_detail::cabs(b * (b - 1.0)) / (8.0 * SEGMENTS * SEGMENTS);
+            if (error > maxRelativeError) maxRelativeError = error;
+        }
+    }
+
+    // ppm[0 .. N-1], all 0 for a ratio that is not positive (uncalibrated).
+    // Ratios outside [2^MIN_EXP, 2^(MAX_EXP+1)) are clamped to the table ends.
+    void eval(float ratio, float* ppm) const {
+        if (!(ratio > 0.0F)) {
+            for (size_t i = 0; i < N; ++i) ppm[i] = 0.0F;
+            return;
+        }
+        uint32_t bits;
+        memcpy(&bits, &ratio, sizeof(bits));
+        const int e = static_cast<int>((bits >> 23) & 0xFF) - 127;
+        constexpr int FRAC_BITS = 23 - MANTISSA_BITS;
+        uint32_t k = (bits >> FRAC_BITS) & (SEGMENTS - 1);
+        float frac = static_cast<float>(bits & ((1u << FRAC_BITS) - 1)) * (1.0F / (1u << FRAC_BITS));
+        int row = e - MIN_EXP;
+        if (e < MIN_EXP) {
+            row = 0;
+            k = 0;
+            frac = 0.0F;
+        } else if (e > MAX_EXP) {
+            row = MAX_EXP - MIN_EXP;
+            k = SEGMENTS - 1;
+            frac = 1.0F;
+        }
+
+        const float* lo = mantissa[k];
+        const float* hi = mantissa[k + 1];
+        const float* s = scale[row];
+        float out[LANES];
+        for (size_t i = 0; i < LANES; ++i) out[i] = std::min(s[i] * (lo[i] + frac * (hi[i] - lo[i])), ppmLimit);
+        memcpy(ppm, out, N * sizeof(float));
+    }
+
+    // Relative error bound of the steepest curve
+    constexpr double getMaxRelativeError() const { return maxRelativeError; }
+
+private:
+    // Rows padded to whole SIMD lanes; spare lanes compute a curve nobody reads
+    static constexpr size_t LANES = (N + 3) / 4 * 4;
+
+    float mantissa[SEGMENTS + 1][LANES];    // m^B_i at the segment knots
+    float scale[MAX_EXP - MIN_EXP + 1][LANES];   // A_i * 2^(B_i * e)
+    double maxRelativeError;
+    float ppmLimit;
+};
+
+#endif
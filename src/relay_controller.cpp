@@ -1,9 +1,7 @@
 #include "relay_controller.h"
 #include <Arduino.h>
-
-// Import config values
-extern const int RELAY_PIN;
-extern const uint32_t RELAY_DEBOUNCE_MS;
+#include "config.h"
+#include "trace_log.h"
 
 RelayController::RelayController() 
     : relayPin(RELAY_PIN)
@@ -16,6 +14,7 @@ bool RelayController::init() {
     pinMode(relayPin, OUTPUT);
     digitalWrite(relayPin, HIGH);  // Active LOW relay
     currentState = false;
+    lastToggleTime = millis() - debounceDelay;   // The first switch is not debounced
     isInitialized = true;
     Serial.println(F("Relay initialized: OFF"));
     return true;
@@ -31,7 +30,7 @@ void RelayController::setState(bool state) {
         currentState = state;
         digitalWrite(relayPin, state ? LOW : HIGH);
         lastToggleTime = now;
-        Serial.printf_P(PSTR("Relay: %s\n"), state ? F("ON") : F("OFF"));
+        TRACE(RELAY_SWITCHED, state ? "ON" : "OFF");
     }
 }
 
@@ -0,0 +1,76 @@
+#include "report_policy.h"
+#include <Arduino.h>
+#include <cmath>
+#include "config.h"
+
+ReportPolicy::ReportPolicy()
+    : lastReported{}
+    , lastReportMs(0)
+    , hasReported(false)
+    , ppmDeadbandAbs(REPORT_PPM_DEADBAND_ABS)
+    , ppmDeadbandRel(REPORT_PPM_DEADBAND_REL)
+    , tempDeadband(REPORT_TEMP_DEADBAND_C)
+    , humidDeadband(REPORT_HUMID_DEADBAND_PCT)
+    , heartbeatMs(REPORT_HEARTBEAT_MS)
+    , suppressed(0) {}
+
+// A channel that becomes available or unavailable (NaN) counts as a change.
+bool ReportPolicy::outsideDeadband(float value, float reference, float deadband) {
+    const bool valueNan = std::isnan(value);
+    const bool referenceNan = std::isnan(reference);
+    if (valueNan || referenceNan) return valueNan != referenceNan;
+    return std::fabs(value - reference) > deadband;
+}
+
+float ReportPolicy::ppmDeadband(float reference) const {
+    const float relative = ppmDeadbandRel * std::fabs(reference);
+    return relative > ppmDeadbandAbs ? relative : ppmDeadbandAbs;
+}
+
+// The further gas channels share the ppm dead-band
+bool ReportPolicy::gasOutsideDeadband(const TelemetrySample& sample) const {
+    if (sample.gasChannels != lastReported.gasChannels) return true;
+    for (size_t i = 0; i + 1 < sample.gasChannels; ++i) {
+        const float reference = lastReported.gasPpm[i];
+        if (outsideDeadband(sample.gasPpm[i], reference, ppmDeadband(reference))) return true;
+    }
+    return false;
+}
+
+ReportReason ReportPolicy::evaluate(const TelemetrySample& sample, uint32_t now) {
+    ReportReason reason = ReportReason::NONE;
+    if (!hasReported) {
+        reason = ReportReason::FIRST;
+    } else if (sample.quality != lastReported.quality) {
+        reason = ReportReason::BAND_CHANGE;
+    } else if ((sample.flags ^ lastReported.flags) & BinaryTelemetry::RECORD_STATE_FLAGS) {
+        reason = ReportReason::STATE_CHANGE;
+    } else if (outsideDeadband(sample.ppm, lastReported.ppm, ppmDeadband(lastReported.ppm)) ||
+               outsideDeadband(sample.temperature, lastReported.temperature, tempDeadband) ||
+               outsideDeadband(sample.humidity, lastReported.humidity, humidDeadband) || gasOutsideDeadband(sample)) {
+        reason = ReportReason::DEADBAND;
+    } else if (now - lastReportMs >= heartbeatMs) {
+        reason = ReportReason::HEARTBEAT;
+    }
+
+    if (reason == ReportReason::NONE) {
+        ++suppressed;
+    } else {
+        lastReported = sample;
+        lastReportMs = now;
+        hasReported = true;
+    }
+    return reason;
+}
+
+const char* ReportPolicy::reasonName(ReportReason reason) {
+    switch (reason) {
+        case ReportReason::NONE: return "none";
+        case ReportReason::FIRST: return "first";
+        case ReportReason::BAND_CHANGE: return "band";
+        case ReportReason::STATE_CHANGE: return "state";
+        case ReportReason::DEADBAND: return "deadband";
+        case ReportReason::HEARTBEAT: return "heartbeat";
+    }
+    return "?";
+}
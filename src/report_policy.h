@@ -0,0 +1,46 @@
+#ifndef REPORT_POLICY_H
+#define REPORT_POLICY_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "telemetry_batch.h"
+
+enum class ReportReason : uint8_t {
+    NONE = 0,         // Within every dead-band: waits for the batch window
+    FIRST,            // Nothing published yet
+    BAND_CHANGE,      // Air-quality band (AQ_THRESHOLD_*) crossed
+    STATE_CHANGE,     // Relay or alert flag changed
+    DEADBAND,         // A channel moved past its dead-band
+    HEARTBEAT         // REPORT_HEARTBEAT_MS without a publish
+};
+
+// Report-by-exception: decides per sample whether it is worth publishing the
+// batch for now rather than at the end of its window.
+// Dead-bands are measured against the last reported value, not the previous
+// sample, so a slow drift is still reported once it adds up.
+class ReportPolicy {
+private:
+    TelemetrySample lastReported;
+    uint32_t lastReportMs;
+    bool hasReported;
+    float ppmDeadbandAbs;
+    float ppmDeadbandRel;
+    float tempDeadband;
+    float humidDeadband;
+    uint32_t heartbeatMs;
+    uint32_t suppressed;
+
+    static bool outsideDeadband(float value, float reference, float deadband);
+    float ppmDeadband(float reference) const;
+    bool gasOutsideDeadband(const TelemetrySample& sample) const;
+
+public:
+    ReportPolicy();
+    ReportReason evaluate(const TelemetrySample& sample, uint32_t now);
+    void setPpmDeadband(float absolute, float relative) { ppmDeadbandAbs = absolute; ppmDeadbandRel = relative; }
+    void setHeartbeat(uint32_t ms) { heartbeatMs = ms; }
+    uint32_t getSuppressed() const { return suppressed; }
+    static const char* reasonName(ReportReason reason);
+};
+
+#endif
@@ -0,0 +1,208 @@
+#include "scheduler.h"
+#include "time_service.h"
+
+namespace {
+
+constexpr uint32_t jobBit(JobId id) { return 1UL << id; }
+
+}  // namespace
+
+Scheduler::RunHook Scheduler::runHook = nullptr;
+
+Scheduler::Scheduler()
+    : jobs{}
+    , heap{}
+    , jobCount(0)
+    , queued(0)
+    , posted(0)
+    , owner(nullptr)
+    , wakeups(0) {
+    for (uint8_t& s : slot) s = NOT_QUEUED;
+}
+
+JobId Scheduler::add(const char* name, JobFn fn) {
+    if (jobCount >= MAX_JOBS) return NO_JOB;
+    jobs[jobCount] = {name, fn, 0, 0, 0, 0};
+    return static_cast<JobId>(jobCount++);
+}
+
+// Equal deadlines run in registration order
+bool Scheduler::earlier(JobId a, JobId b) const {
+    return jobs[a].dueUs < jobs[b].dueUs || (jobs[a].dueUs == jobs[b].dueUs && a < b);
+}
+
+void Scheduler::swapSlots(size_t i, size_t j) {
+    const JobId a = heap[i];
+    heap[i] = heap[j];
+    heap[j] = a;
+    slot[heap[i]] = static_cast<uint8_t>(i);
+    slot[heap[j]] = static_cast<uint8_t>(j);
+}
+
+void Scheduler::siftUp(size_t i) {
+    while (i > 0) {
+        const size_t parent = (i - 1) / 2;
+        if (!earlier(heap[i], heap[parent])) return;
+        swapSlots(i, parent);
+        i = parent;
+    }
+}
+
+void Scheduler::siftDown(size_t i) {
+    for (;;) {
+        size_t first = i;
+        const size_t left = 2 * i + 1;
+        const size_t right = left + 1;
+        if (left < queued && earlier(heap[left], heap[first])) first = left;
+        if (right < queued && earlier(heap[right], heap[first])) first = right;
+        if (first == i) return;
+        swapSlots(i, first);
+        i = first;
+    }
+}
+
+void Scheduler::arm(JobId id, uint64_t dueUs) {
+    jobs[id].dueUs = dueUs;
+    if (slot[id] == NOT_QUEUED) {
+        heap[queued] = id;
+        slot[id] = static_cast<uint8_t>(queued++);
+        siftUp(queued - 1);
+        return;
+    }
+    siftUp(slot[id]);
+    siftDown(slot[id]);
+}
+
+void Scheduler::disarm(JobId id) {
+    if (id >= jobCount || slot[id] == NOT_QUEUED) return;
+    const size_t i = slot[id];
+    swapSlots(i, --queued);
+    slot[id] = NOT_QUEUED;
+    if (i < queued) {
+        siftUp(i);
+        siftDown(i);
+    }
+}
+
+void Scheduler::schedule(JobId id, uint32_t delayMs, uint32_t periodMs) {
+    if (id >= jobCount) return;
+    if (delayMs == NEVER) {
+        disarm(id);
+        return;
+    }
+    jobs[id].periodUs = periodMs * 1000UL;
+    arm(id, TimeService::monotonicUs() + delayMs * 1000ULL);
+}
+
+void Scheduler::every(JobId id, uint32_t periodMs) {
+    if (id >= jobCount || periodMs == 0) return;
+    const uint64_t periodUs = periodMs * 1000ULL;
+    jobs[id].periodUs = static_cast<uint32_t>(periodUs);
+    arm(id, (TimeService::monotonicUs() / periodUs + 1) * periodUs);
+}
+
+void Scheduler::setPeriod(JobId id, uint32_t periodMs) {
+    if (id < jobCount) jobs[id].periodUs = periodMs * 1000UL;
+}
+
+// The loop task's own posts are picked up by runDue() without a notification
+void Scheduler::post(JobId id) {
+    if (id >= jobCount) return;
+    posted.fetch_or(jobBit(id));
+    const TaskHandle_t task = owner.load();
+    if (task && task != xTaskGetCurrentTaskHandle()) xTaskNotifyGive(task);
+}
+
+void Scheduler::wake() {
+    const TaskHandle_t task = owner.load();
+    if (task && task != xTaskGetCurrentTaskHandle()) xTaskNotifyGive(task);
+}
+
+void IRAM_ATTR Scheduler::postFromISR(JobId id) {
+    if (id >= jobCount) return;
+    posted.fetch_or(jobBit(id));
+    const TaskHandle_t task = owner.load();
+    if (!task) return;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(task, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+void Scheduler::run(JobId id, uint64_t dueUs, bool timed) {
+    Job& job = jobs[id];
+    if (timed) {
+        const uint64_t late = TimeService::monotonicUs() - dueUs;
+        const uint32_t lateUs = late > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(late);
+        if (lateUs > job.maxLateUs) job.maxLateUs = lateUs;
+        if (runHook) runHook(id, job.name, lateUs);
+    }
+    ++job.runs;
+    job.fn();
+}
+
+// Each posted job once; a job posted again while it runs is left for the
+// next pass.
+size_t Scheduler::runPosted(uint32_t& done) {
+    size_t ran = 0;
+    for (;;) {
+        uint32_t pending = posted.load() & ~done;
+        if (!pending) return ran;
+        posted.fetch_and(~pending);
+        while (pending) {
+            const JobId id = static_cast<JobId>(__builtin_ctz(pending));
+            pending &= pending - 1;
+            done |= jobBit(id);
+            run(id, 0, false);
+            ++ran;
+        }
+    }
+}
+
+// Posted jobs first, then the due ones by deadline, then whatever those
+// posted. A job is re-armed before it runs, so it can reschedule or cancel
+// itself, and runs at most once per call, so one that outlasts its period
+// cannot hold the loop.
+size_t Scheduler::runDue() {
+    uint32_t postedDone = 0;
+    size_t ran = runPosted(postedDone);
+
+    uint32_t done = 0;
+    while (queued > 0) {
+        const JobId id = heap[0];
+        const Job& job = jobs[id];
+        const uint64_t now = TimeService::monotonicUs();
+        if (job.dueUs > now || (done & jobBit(id))) break;
+
+        // Missed periods are skipped, the job stays on its grid
+        const uint64_t due = job.dueUs;
+        if (job.periodUs > 0) {
+            arm(id, due + ((now - due) / job.periodUs + 1) * job.periodUs);
+        } else {
+            disarm(id);
+        }
+        done |= jobBit(id);
+        run(id, due, true);
+        ++ran;
+    }
+    return ran + runPosted(postedDone);
+}
+
+// A post() between the check and the wait leaves the notification pending,
+// so the wait returns at once.
+void Scheduler::sleep() {
+    owner.store(xTaskGetCurrentTaskHandle());
+    if (posted.load() != 0) return;
+
+    TickType_t ticks = portMAX_DELAY;
+    if (queued > 0) {
+        const uint64_t now = TimeService::monotonicUs();
+        const uint64_t due = jobs[heap[0]].dueUs;
+        if (due <= now) return;
+        // Rounded up: waking early would only cost an empty pass
+        const uint64_t tickUs = portTICK_PERIOD_MS * 1000ULL;
+        const uint64_t waitTicks = (due - now + tickUs - 1) / tickUs;
+        ticks = waitTicks >= portMAX_DELAY ? portMAX_DELAY - 1 : static_cast<TickType_t>(waitTicks);
+    }
+    ulTaskNotifyTake(pdTRUE, ticks);
+    ++wakeups;
+}
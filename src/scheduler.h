@@ -0,0 +1,92 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+using JobFn = void (*)();
+using JobId = uint8_t;
+
+// ============================================================================
+// Tickless deadline scheduler for the loop task.
+//
+// Jobs sit in a fixed min-heap ordered by deadline. runDue() runs the jobs
+// that are due, earliest first; sleep() then blocks the task on its FreeRTOS
+// notification until the next deadline, or until post() (from another task
+// or an ISR) asks for a job to run now. Nothing is allocated after add().
+//
+// Periodic jobs keep a fixed rate: the next deadline is the previous one plus
+// the period, so lateness does not accumulate. every() puts a job on its
+// period's grid (multiples of the period since boot), so jobs with related
+// periods share wakeups.
+// ============================================================================
+class Scheduler {
+public:
+    static constexpr size_t MAX_JOBS = 16;
+    static constexpr JobId NO_JOB = 0xFF;
+    static constexpr uint32_t NEVER = UINT32_MAX;   // schedule() delay that disarms the job
+
+    // Instrumentation: called before each job with its lateness against the
+    // deadline (posted runs have none and are not reported)
+    using RunHook = void (*)(JobId id, const char* name, uint32_t lateUs);
+
+private:
+    struct Job {
+        const char* name;
+        JobFn fn;
+        uint64_t dueUs;
+        uint32_t periodUs;   // 0 for a one-shot
+        uint32_t runs;
+        uint32_t maxLateUs;
+    };
+
+    static constexpr uint8_t NOT_QUEUED = 0xFF;
+
+    Job jobs[MAX_JOBS];
+    JobId heap[MAX_JOBS];      // Armed jobs, heap[0] has the earliest deadline
+    uint8_t slot[MAX_JOBS];    // Index of each job in heap, or NOT_QUEUED
+    size_t jobCount;
+    size_t queued;
+    std::atomic<uint32_t> posted;   // Bit per job, set by post()
+    std::atomic<TaskHandle_t> owner;
+    uint32_t wakeups;
+    static RunHook runHook;
+
+    bool earlier(JobId a, JobId b) const;
+    void swapSlots(size_t i, size_t j);
+    void siftUp(size_t i);
+    void siftDown(size_t i);
+    void arm(JobId id, uint64_t dueUs);
+    void disarm(JobId id);
+    void run(JobId id, uint64_t dueUs, bool timed);
+    size_t runPosted(uint32_t& done);
+
+public:
+    Scheduler();
+    JobId add(const char* name, JobFn fn);   // Registered disarmed; NO_JOB when full
+    void schedule(JobId id, uint32_t delayMs, uint32_t periodMs = 0);
+    void every(JobId id, uint32_t periodMs);   // Periodic, first run on the next grid point
+    void setPeriod(JobId id, uint32_t periodMs);   // From the next run on; 0 makes it a one-shot
+    void cancel(JobId id) { disarm(id); }
+    void post(JobId id);   // Any task: run id in the loop's next pass
+    void postFromISR(JobId id);
+    void wake();           // Any task: end sleep() without a job, for state another task changed
+
+    size_t runDue();   // Non-blocking; number of jobs run
+    void sleep();      // Blocks until the next deadline or a post()
+
+    bool isScheduled(JobId id) const { return id < jobCount && slot[id] != NOT_QUEUED; }
+    size_t size() const { return jobCount; }
+    const char* name(JobId id) const { return jobs[id].name; }
+    uint32_t getRuns(JobId id) const { return jobs[id].runs; }
+    uint32_t getMaxLateUs(JobId id) const { return jobs[id].maxLateUs; }
+    uint32_t getWakeups() const { return wakeups; }
+
+    static void setRunHook(RunHook hook) { runHook = hook; }
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// ============================================================================
+// Single-producer / single-consumer ring of fixed-size records, for handing
+// data from one task to another, on the same core or not, without a lock.
+//
+// Only the producer writes `tail` and only the consumer writes `head`. A
+// record is copied into its slot before tail is released and copied out
+// before head is released, so neither side ever sees a half-written slot.
+// A full ring rejects the new record and counts it instead of overwriting an
+// older one. No heap.
+// ============================================================================
+template <typename T, size_t SLOTS>
+class SpscRing {
+    static_assert(SLOTS >= 2 && (SLOTS & (SLOTS - 1)) == 0, "slot count must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "records are copied in and out");
+
+private:
+    T slots[SLOTS];
+    std::atomic<uint32_t> head;        // next slot to read (consumer)
+    std::atomic<uint32_t> tail;        // next slot to write (producer)
+    std::atomic<uint32_t> dropped;     // rejected because the ring was full
+    std::atomic<uint32_t> highWater;   // most records ever waiting (producer)
+
+public:
+    SpscRing() : slots{}, head(0), tail(0), dropped(0), highWater(0) {}
+
+    // Producer side
+    bool push(const T& record) {
+        const uint32_t t = tail.load(std::memory_order_relaxed);
+        const uint32_t used = t - head.load(std::memory_order_acquire);
+        if (used == SLOTS) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots[t & (SLOTS - 1)] = record;
+        tail.store(t + 1, std::memory_order_release);
+        if (used + 1 > highWater.load(std::memory_order_relaxed)) {
+            highWater.store(used + 1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // Consumer side: oldest record, false when empty
+    bool pop(T& record) {
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        record = slots[h & (SLOTS - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return SLOTS; }
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+    uint32_t getHighWater() const { return highWater.load(std::memory_order_relaxed); }
+};
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef STREAMING_WINDOW_H
+#define STREAMING_WINDOW_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Smoothing applied by StreamingWindow::filtered()
+enum class SmoothingFilter : uint8_t {
+    MOVING_AVERAGE = 1,  // Mean of the last N samples
+    EWMA = 2,            // Exponentially weighted moving average
+    MEDIAN = 3,          // Median of the last MEDIAN_N samples
+    ADAPTIVE = 4         // Mean while the median agrees with it, median when they diverge
+};
+
+// ============================================================================
+// Fixed-size sliding window with O(1) statistics per sample:
+//   - mean / variance: sliding Welford update, re-derived exactly from the
+//     ring once every N samples so float rounding cannot accumulate
+//   - min / max: monotonic queues of (sequence, value)
+//   - EWMA: runtime-configurable alpha
+//   - median of the last MEDIAN_N samples (small, odd; insertion sort)
+// filtered() picks one of these per channel (SmoothingFilter).
+// No heap; footprint is a few arrays of N elements.
+// ============================================================================
+template <typename T, size_t N, size_t MEDIAN_N = 5>
+class StreamingWindow {
+    static_assert(N > 0, "window must hold at least one sample");
+    static_assert(MEDIAN_N % 2 == 1 && MEDIAN_N <= N, "median window must be odd and fit in the window");
+
+private:
+    struct MonotonicQueue {
+        uint32_t seq[N];
+        T value[N];
+        size_t head = 0;
+        size_t size = 0;
+
+        void expire(uint32_t oldestSeq) {
+            while (size > 0 && static_cast<int32_t>(seq[head] - oldestSeq) < 0) {
+                head = (head + 1) % N;
+                --size;
+            }
+        }
+
+        // Drops queued values dominated by x, then appends it.
+        template <typename Dominates>
+        void push(uint32_t s, T x, Dominates dominates) {
+            while (size > 0 && dominates(x, value[(head + size - 1) % N])) --size;
+            const size_t tail = (head + size) % N;
+            seq[tail] = s;
+            value[tail] = x;
+            ++size;
+        }
+
+        T front() const { return value[head]; }
+    };
+
+    T ring[N];
+    size_t next;
+    size_t count;
+    uint32_t sequence;
+    size_t sinceResync;
+
+    T runningMean;
+    T m2;
+
+    MonotonicQueue minQueue;
+    MonotonicQueue maxQueue;
+
+    T ewmaValue;
+    T ewmaAlpha;
+    T adaptiveThreshold;
+
+    void resync() {
+        T sum = 0;
+        for (size_t i = 0; i < count; ++i) sum += ring[i];
+        runningMean = sum / static_cast<T>(count);
+        T sq = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const T d = ring[i] - runningMean;
+            sq += d * d;
+        }
+        m2 = sq;
+        sinceResync = 0;
+    }
+
+public:
+    explicit StreamingWindow(T alpha = static_cast<T>(0.3), T threshold = static_cast<T>(0.3))
+        : ring{}
+        , next(0)
+        , count(0)
+        , sequence(0)
+        , sinceResync(0)
+        , runningMean(0)
+        , m2(0)
+        , ewmaValue(0)
+        , ewmaAlpha(alpha)
+        , adaptiveThreshold(threshold) {}
+
+    void push(T x) {
+        if (count < N) {
+            // Welford growth phase
+            ++count;
+            const T delta = x - runningMean;
+            runningMean += delta / static_cast<T>(count);
+            m2 += delta * (x - runningMean);
+        } else {
+            // Sliding Welford: replace the oldest sample
+            const T old = ring[next];
+            const T oldMean = runningMean;
+            runningMean += (x - old) / static_cast<T>(N);
+            m2 += (x - old) * (x - runningMean + old - oldMean);
+            if (m2 < 0) m2 = 0;
+        }
+        ring[next] = x;
+        next = (next + 1) % N;
+
+        const uint32_t s = sequence++;
+        const uint32_t oldest = sequence - static_cast<uint32_t>(count);
+        minQueue.expire(oldest);
+        maxQueue.expire(oldest);
+        minQueue.push(s, x, [](T a, T b) { return a <= b; });
+        maxQueue.push(s, x, [](T a, T b) { return a >= b; });
+
+        ewmaValue = (count == 1) ? x : ewmaValue + ewmaAlpha * (x - ewmaValue);
+
+        if (count == N && ++sinceResync >= N) resync();
+    }
+
+    void reset() {
+        next = 0;
+        count = 0;
+        sinceResync = 0;
+        runningMean = 0;
+        m2 = 0;
+        minQueue.size = 0;
+        maxQueue.size = 0;
+    }
+
+    void setEwmaAlpha(T alpha) { ewmaAlpha = alpha; }
+    void setAdaptiveThreshold(T threshold) { adaptiveThreshold = threshold; }
+
+    size_t size() const { return count; }
+    bool full() const { return count == N; }
+    T latest() const { return ring[(next + N - 1) % N]; }
+    T mean() const { return runningMean; }
+    T variance() const { return count > 1 ? m2 / static_cast<T>(count) : 0; }
+    T min() const { return minQueue.size ? minQueue.front() : 0; }
+    T max() const { return maxQueue.size ? maxQueue.front() : 0; }
+    T ewma() const { return ewmaValue; }
+
+    T median() const {
+        const size_t n = count < MEDIAN_N ? count : MEDIAN_N;
+        if (n == 0) return 0;
+        T sorted[MEDIAN_N];
+        for (size_t i = 0; i < n; ++i) {
+            const T v = ring[(next + N - 1 - i) % N];
+            size_t j = i;
+            while (j > 0 && sorted[j - 1] > v) {
+                sorted[j] = sorted[j - 1];
+                --j;
+            }
+            sorted[j] = v;
+        }
+        return (n % 2 == 1) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+    }
+
+    T filtered(SmoothingFilter filter) const {
+        switch (filter) {
+            case SmoothingFilter::MOVING_AVERAGE: return mean();
+            case SmoothingFilter::EWMA: return ewma();
+            case SmoothingFilter::MEDIAN: return median();
+            case SmoothingFilter::ADAPTIVE: {
+                // A step or an isolated spike pulls the mean away from the
+                // median: follow the median then, the quieter mean otherwise.
+                const T med = median();
+                const T diff = med > runningMean ? med - runningMean : runningMean - med;
+                const T ref = runningMean < 0 ? -runningMean : runningMean;
+                return diff > ref * adaptiveThreshold ? med : runningMean;
+            }
+        }
+        return latest();
+    }
+};
+
+#endif
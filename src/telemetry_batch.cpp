@@ -0,0 +1,65 @@
+#include "telemetry_batch.h"
+#include <Arduino.h>
+#include "config.h"
+
+TelemetryBatch::TelemetryBatch()
+    : samples{}
+    , count(0)
+    , windowStart(0)
+    , dropped(0) {}
+
+void TelemetryBatch::add(const TelemetrySample& sample) {
+    if (count == TELEMETRY_BATCH_CAPACITY) {
+        consume(1);
+        ++dropped;
+    }
+    samples[count++] = sample;
+}
+
+// Flush once the publish interval has elapsed, or early when the batch
+// reaches TELEMETRY_BATCH_FLUSH_SAMPLES.
+bool TelemetryBatch::shouldFlush(uint32_t now) const {
+    if (count == 0) return false;
+    if (count >= TELEMETRY_BATCH_FLUSH_SAMPLES) return true;
+    return now - windowStart >= MQTT_UPDATE_INTERVAL_MS;
+}
+
+// Until the window closes or the batch fills to TELEMETRY_BATCH_FLUSH_SAMPLES;
+// an empty batch waits out its window too
+uint32_t TelemetryBatch::msUntilFlush(uint32_t now) const {
+    if (count >= TELEMETRY_BATCH_FLUSH_SAMPLES) return 0;
+    const uint32_t elapsed = now - windowStart;
+    return elapsed >= MQTT_UPDATE_INTERVAL_MS ? 0 : MQTT_UPDATE_INTERVAL_MS - elapsed;
+}
+
+// Drops the n oldest samples once they were published and starts a new flush
+// window. Called with n = 0 after a failed publish, so the samples are retried
+// next window instead of on every loop pass.
+void TelemetryBatch::consume(size_t n, uint32_t now) {
+    consume(n);
+    windowStart = now;
+}
+
+// Readings taken before the first time sync carry us-since-boot stamps.
+// Once the clock is known they convert exactly, as long as they are still
+// in RAM; anything already spilled to flash keeps the uptime flag.
+size_t TelemetryBatch::resolveUptimeStamps(const TimeService& clock) {
+    if (!clock.isSynced()) return 0;
+    size_t resolved = 0;
+    for (size_t i = 0; i < count; ++i) {
+        TelemetrySample& s = samples[i];
+        if (!(s.flags & BinaryTelemetry::RECORD_FLAG_UPTIME)) continue;
+        s.timestamp = clock.toEpochUs(s.timestamp);
+        s.flags &= ~BinaryTelemetry::RECORD_FLAG_UPTIME;
+        ++resolved;
+    }
+    return resolved;
+}
+
+// The buffer holds at most a few hundred bytes, so shifting the remainder
+// down is cheaper than keeping ring indices in every reader.
+void TelemetryBatch::consume(size_t n) {
+    if (n > count) n = count;
+    count -= n;
+    memmove(samples, samples + n, count * sizeof(TelemetrySample));
+}
@@ -0,0 +1,42 @@
+#ifndef TELEMETRY_BATCH_H
+#define TELEMETRY_BATCH_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "binary_telemetry.h"
+#include "time_service.h"
+
+// One timestamped reading as captured by the sensor tick; the same record
+// the binary batch frame carries.
+using TelemetrySample = BinaryTelemetry::SampleRecord;
+
+// Fixed buffer of readings waiting to be published as one batch, oldest
+// first and contiguous so it can be handed to the encoder as an array. When
+// the backend is unreachable long enough for it to fill, the oldest readings
+// are discarded and counted in getDropped().
+class TelemetryBatch {
+private:
+    TelemetrySample samples[TELEMETRY_BATCH_CAPACITY];
+    size_t count;
+    uint32_t windowStart;
+    uint32_t dropped;
+
+    void consume(size_t n);
+
+public:
+    TelemetryBatch();
+    void add(const TelemetrySample& sample);
+    bool shouldFlush(uint32_t now) const;
+    uint32_t msUntilFlush(uint32_t now) const;
+    void consume(size_t n, uint32_t now);   // n = 0 just restarts the flush window
+    size_t resolveUptimeStamps(const TimeService& clock);
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const TelemetrySample* data() const { return samples; }
+    const TelemetrySample& at(size_t i) const { return samples[i]; }
+    const TelemetrySample& latest() const { return at(count - 1); }
+    uint32_t getDropped() const { return dropped; }
+};
+
+#endif
@@ -0,0 +1,312 @@
+#include "telemetry_log.h"
+#include <Arduino.h>
+#include "config.h"
+#include "trace_log.h"
+
+namespace {
+
+constexpr uint8_t GAS_CHANNELS_PER_RECORD = GAS_CHANNEL_COUNT;
+constexpr size_t RECORD_SIZE = BinaryTelemetry::recordSize(GAS_CHANNELS_PER_RECORD) + 2;  // record + CRC-16
+static_assert(TELEMETRY_LOG_SEGMENT_RECORDS * RECORD_SIZE <= 4096, "a segment must fit one flash block");
+constexpr size_t IO_RECORDS = 16;                                       // records per read/write call
+constexpr size_t CURSOR_SIZE = 8;                                       // u32 segment, u16 record, u16 CRC
+
+// CRC-16/CCITT-FALSE
+uint16_t crc16(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF) {
+    while (length--) {
+        crc ^= static_cast<uint16_t>(*data++) << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? static_cast<uint16_t>(crc << 1 ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// The record CRC also covers the binary format version and the gas channel
+// count, so segments written with another record layout read as corrupt
+// instead of being misparsed.
+uint16_t recordCrc(const uint8_t* record) {
+    const uint16_t layout = crc16(&GAS_CHANNELS_PER_RECORD, 1, crc16(&BinaryTelemetry::VERSION, 1));
+    return crc16(record, RECORD_SIZE - 2, layout);
+}
+
+bool recordValid(const uint8_t* record) {
+    const uint16_t stored = static_cast<uint16_t>(record[RECORD_SIZE - 2] | record[RECORD_SIZE - 1] << 8);
+    return recordCrc(record) == stored;
+}
+
+// "0000002a.seg" -> 42
+bool parseSegmentName(const char* name, uint32_t& segment) {
+    if (!name || strlen(name) != 12 || strcmp(name + 8, ".seg") != 0) return false;
+    char* end = nullptr;
+    segment = static_cast<uint32_t>(strtoul(name, &end, 16));
+    return end == name + 8;
+}
+
+}  // namespace
+
+TelemetryLog::TelemetryLog(const char* dir)
+    : fs(nullptr)
+    , dir(dir)
+    , ready(false)
+    , firstSegment(0)
+    , nextSegment(0)
+    , segmentCount(0)
+    , segmentRecords{}
+    , appendable(false)
+    , readRecord(0)
+    , pendingRecords(0)
+    , dropped(0) {}
+
+void TelemetryLog::segmentPath(uint32_t segment, char* out, size_t size) const {
+    snprintf(out, size, "%s/%08lx.seg", dir, static_cast<unsigned long>(segment));
+}
+
+// Valid records from the start of a segment up to the first torn or corrupt one.
+uint16_t TelemetryLog::countValidRecords(uint32_t segment) {
+    char path[48];
+    segmentPath(segment, path, sizeof(path));
+    File file = fs->open(path, FILE_READ);
+    if (!file) return 0;
+
+    uint8_t buffer[IO_RECORDS * RECORD_SIZE];
+    uint16_t valid = 0;
+    while (valid < TELEMETRY_LOG_SEGMENT_RECORDS) {
+        const size_t n = file.read(buffer, sizeof(buffer)) / RECORD_SIZE;
+        size_t i = 0;
+        while (i < n && recordValid(buffer + i * RECORD_SIZE)) ++i;
+        valid += static_cast<uint16_t>(i);
+        if (i < IO_RECORDS) break;
+    }
+    return valid > TELEMETRY_LOG_SEGMENT_RECORDS ? TELEMETRY_LOG_SEGMENT_RECORDS : valid;
+}
+
+bool TelemetryLog::begin(fs::FS& filesystem) {
+    fs = &filesystem;
+    ready = false;
+    segmentCount = 0;
+    appendable = false;
+    readRecord = 0;
+    pendingRecords = 0;
+
+    if (!fs->exists(dir) && !fs->mkdir(dir)) return false;
+    File root = fs->open(dir, FILE_READ);
+    if (!root || !root.isDirectory()) return false;
+
+    bool found = false;
+    uint32_t lowest = UINT32_MAX;
+    uint32_t highest = 0;
+    for (File entry = root.openNextFile(); entry; entry = root.openNextFile()) {
+        uint32_t segment;
+        if (entry.isDirectory() || !parseSegmentName(entry.name(), segment)) continue;
+        found = true;
+        if (segment < lowest) lowest = segment;
+        if (segment > highest) highest = segment;
+    }
+    root.close();
+
+    char path[48];
+    if (found) {
+        // Left over from a larger TELEMETRY_LOG_MAX_SEGMENTS
+        while (highest - lowest >= TELEMETRY_LOG_MAX_SEGMENTS) {
+            dropped += countValidRecords(lowest);
+            segmentPath(lowest++, path, sizeof(path));
+            fs->remove(path);
+        }
+        firstSegment = lowest;
+        nextSegment = highest + 1;
+        segmentCount = highest - lowest + 1;
+        for (size_t i = 0; i < segmentCount; ++i) {
+            segmentRecords[i] = countValidRecords(firstSegment + i);
+            pendingRecords += segmentRecords[i];
+        }
+    }
+
+    loadCursor();
+    if (segmentCount == 0) firstSegment = nextSegment;
+    ready = true;
+    consume(0);  // discard segments a power cut left fully replayed but not yet deleted
+
+    if (pendingRecords > 0) {
+        Serial.printf_P(PSTR("Telemetry log: %lu readings pending in %u segments\n"),
+                        static_cast<unsigned long>(pendingRecords), static_cast<unsigned>(segmentCount));
+    }
+    return true;
+}
+
+void TelemetryLog::loadCursor() {
+    char path[48];
+    snprintf(path, sizeof(path), "%s/cursor", dir);
+    File file = fs->open(path, FILE_READ);
+    uint8_t cursor[CURSOR_SIZE];
+    if (!file || file.read(cursor, sizeof(cursor)) != sizeof(cursor)) return;
+    if (crc16(cursor, CURSOR_SIZE - 2) != static_cast<uint16_t>(cursor[6] | cursor[7] << 8)) return;
+
+    const uint32_t segment = static_cast<uint32_t>(cursor[0]) | static_cast<uint32_t>(cursor[1]) << 8 |
+                             static_cast<uint32_t>(cursor[2]) << 16 | static_cast<uint32_t>(cursor[3]) << 24;
+    const uint16_t record = static_cast<uint16_t>(cursor[4] | cursor[5] << 8);
+
+    // Segment ids keep increasing across boots, so a stale cursor can never
+    // point into a newer segment.
+    if (segment > nextSegment) nextSegment = segment;
+    // Segments before the cursor were replayed but not yet deleted.
+    while (segmentCount > 0 && firstSegment < segment) dropFirstSegment(false);
+    if (segmentCount > 0 && firstSegment == segment) {
+        readRecord = record < segmentRecords[0] ? record : segmentRecords[0];
+        pendingRecords -= readRecord;
+    }
+}
+
+bool TelemetryLog::saveCursor() {
+    uint8_t cursor[CURSOR_SIZE];
+    cursor[0] = static_cast<uint8_t>(firstSegment);
+    cursor[1] = static_cast<uint8_t>(firstSegment >> 8);
+    cursor[2] = static_cast<uint8_t>(firstSegment >> 16);
+    cursor[3] = static_cast<uint8_t>(firstSegment >> 24);
+    cursor[4] = static_cast<uint8_t>(readRecord);
+    cursor[5] = static_cast<uint8_t>(readRecord >> 8);
+    const uint16_t crc = crc16(cursor, CURSOR_SIZE - 2);
+    cursor[6] = static_cast<uint8_t>(crc);
+    cursor[7] = static_cast<uint8_t>(crc >> 8);
+
+    char tmpPath[48];
+    char path[48];
+    snprintf(tmpPath, sizeof(tmpPath), "%s/cursor.tmp", dir);
+    snprintf(path, sizeof(path), "%s/cursor", dir);
+    File file = fs->open(tmpPath, FILE_WRITE);
+    if (!file) return false;
+    const bool written = file.write(cursor, sizeof(cursor)) == sizeof(cursor);
+    file.close();
+    return written && fs->rename(tmpPath, path);
+}
+
+// Removes the oldest segment. Unreplayed readings in it are counted as
+// dropped when it is evicted for space.
+void TelemetryLog::dropFirstSegment(bool evicted) {
+    if (segmentCount == 0) return;
+    const uint32_t unread = segmentRecords[0] - readRecord;
+    pendingRecords -= unread;
+    if (evicted) dropped += unread;
+
+    char path[48];
+    segmentPath(firstSegment, path, sizeof(path));
+    fs->remove(path);
+
+    --segmentCount;
+    memmove(segmentRecords, segmentRecords + 1, segmentCount * sizeof(segmentRecords[0]));
+    ++firstSegment;
+    readRecord = 0;
+    if (segmentCount == 0) {
+        firstSegment = nextSegment;
+        appendable = false;
+    }
+}
+
+void TelemetryLog::startSegment() {
+    if (segmentCount == TELEMETRY_LOG_MAX_SEGMENTS) {
+        dropFirstSegment(true);
+        TRACE(LOG_FULL, static_cast<unsigned>(dropped));
+    }
+    if (segmentCount == 0) firstSegment = nextSegment;
+    segmentRecords[segmentCount++] = 0;
+    ++nextSegment;
+    appendable = true;
+}
+
+size_t TelemetryLog::append(const TelemetrySample* samples, size_t count) {
+    if (!ready) return 0;
+
+    uint8_t buffer[IO_RECORDS * RECORD_SIZE];
+    char path[48];
+    size_t stored = 0;
+    while (stored < count) {
+        if (!appendable || segmentRecords[segmentCount - 1] >= TELEMETRY_LOG_SEGMENT_RECORDS) startSegment();
+        uint16_t& records = segmentRecords[segmentCount - 1];
+        segmentPath(firstSegment + segmentCount - 1, path, sizeof(path));
+        File file = fs->open(path, FILE_APPEND);
+        if (!file) {
+            appendable = false;
+            break;
+        }
+
+        size_t room = TELEMETRY_LOG_SEGMENT_RECORDS - records;
+        while (room > 0 && stored < count) {
+            size_t n = count - stored;
+            if (n > room) n = room;
+            if (n > IO_RECORDS) n = IO_RECORDS;
+            for (size_t i = 0; i < n; ++i) {
+                uint8_t* record = buffer + i * RECORD_SIZE;
+                BinaryTelemetry::encode(samples[stored + i], GAS_CHANNELS_PER_RECORD, record, RECORD_SIZE);
+                const uint16_t crc = recordCrc(record);
+                record[RECORD_SIZE - 2] = static_cast<uint8_t>(crc);
+                record[RECORD_SIZE - 1] = static_cast<uint8_t>(crc >> 8);
+            }
+            const size_t written = file.write(buffer, n * RECORD_SIZE);
+            const size_t complete = written / RECORD_SIZE;
+            records += static_cast<uint16_t>(complete);
+            pendingRecords += complete;
+            stored += complete;
+            room -= complete;
+            if (written != n * RECORD_SIZE) {
+                // Never append behind a torn record; continue in a new segment.
+                appendable = false;
+                break;
+            }
+        }
+        file.close();
+        if (!appendable) break;
+    }
+    return stored;
+}
+
+// Oldest unreplayed readings, at most one segment's worth per call.
+size_t TelemetryLog::peek(TelemetrySample* out, size_t max) {
+    if (!ready || pendingRecords == 0 || segmentCount == 0) return 0;
+
+    size_t n = segmentRecords[0] - readRecord;
+    if (n > max) n = max;
+    if (n > IO_RECORDS) n = IO_RECORDS;
+    if (n == 0) return 0;
+
+    char path[48];
+    segmentPath(firstSegment, path, sizeof(path));
+    File file = fs->open(path, FILE_READ);
+    uint8_t buffer[IO_RECORDS * RECORD_SIZE];
+    size_t valid = 0;
+    if (file && file.seek(static_cast<uint32_t>(readRecord) * RECORD_SIZE)) {
+        const size_t read = file.read(buffer, n * RECORD_SIZE) / RECORD_SIZE;
+        while (valid < read && recordValid(buffer + valid * RECORD_SIZE) &&
+               BinaryTelemetry::decode(buffer + valid * RECORD_SIZE, RECORD_SIZE - 2, out[valid]) ==
+                   BinaryTelemetry::DecodeError::NONE) {
+            ++valid;
+        }
+    }
+
+    // Records that went bad since they were counted: give up on the rest of
+    // the segment rather than stalling the replay on it.
+    if (valid < n) {
+        const uint32_t lost = segmentRecords[0] - readRecord - valid;
+        dropped += lost;
+        pendingRecords -= lost;
+        segmentRecords[0] = static_cast<uint16_t>(readRecord + valid);
+        if (segmentCount == 1) appendable = false;
+    }
+    return valid;
+}
+
+// Advances the cursor past readings that were delivered.
+void TelemetryLog::consume(size_t count) {
+    if (!ready) return;
+    bool moved = count > 0;
+    while (segmentCount > 0) {
+        const size_t unread = segmentRecords[0] - readRecord;
+        const size_t n = count < unread ? count : unread;
+        readRecord += static_cast<uint16_t>(n);
+        pendingRecords -= n;
+        count -= n;
+        if (readRecord < segmentRecords[0] || (segmentCount == 1 && appendable)) break;
+        dropFirstSegment(false);
+        moved = true;
+    }
+    if (moved) saveCursor();
+}
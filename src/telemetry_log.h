@@ -0,0 +1,51 @@
+#ifndef TELEMETRY_LOG_H
+#define TELEMETRY_LOG_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "config.h"
+#include "telemetry_batch.h"
+
+// Bounded append log in flash for readings that could not be published.
+//
+// Records live in numbered segment files under the log directory, each a
+// BinaryTelemetry sample record followed by a CRC-16. A segment is only ever
+// appended to during the boot that created it, so after a power cut the only
+// damage is a torn tail on the newest segment, which the CRC rejects. The read
+// cursor is replaced atomically (write + rename); fully replayed segments are
+// deleted. When TELEMETRY_LOG_MAX_SEGMENTS would be exceeded the oldest
+// segment is discarded and its unsent readings are counted in getDropped().
+class TelemetryLog {
+private:
+    fs::FS* fs;
+    const char* dir;
+    bool ready;
+    uint32_t firstSegment;                          // oldest segment on flash
+    uint32_t nextSegment;                           // id for the next new segment
+    size_t segmentCount;
+    uint16_t segmentRecords[TELEMETRY_LOG_MAX_SEGMENTS];
+    bool appendable;                                // last segment created this boot
+    uint16_t readRecord;                            // cursor within firstSegment
+    uint32_t pendingRecords;
+    uint32_t dropped;
+
+    void segmentPath(uint32_t segment, char* out, size_t size) const;
+    uint16_t countValidRecords(uint32_t segment);
+    void loadCursor();
+    bool saveCursor();
+    void dropFirstSegment(bool evicted);
+    void startSegment();
+
+public:
+    explicit TelemetryLog(const char* dir = TELEMETRY_LOG_DIR);
+    bool begin(fs::FS& filesystem);
+    size_t append(const TelemetrySample* samples, size_t count);   // returns readings stored
+    size_t peek(TelemetrySample* out, size_t max);
+    void consume(size_t count);
+
+    bool isReady() const { return ready; }
+    uint32_t pending() const { return pendingRecords; }
+    uint32_t getDropped() const { return dropped; }
+};
+
+#endif
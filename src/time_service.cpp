@@ -0,0 +1,197 @@
+#include "time_service.h"
+
+namespace {
+
+constexpr uint64_t NTP_UNIX_OFFSET_S = 2208988800ULL;  // 1900-01-01 to 1970-01-01
+
+uint32_t getU32BE(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+           static_cast<uint32_t>(p[2]) << 8 | p[3];
+}
+
+uint64_t getU64BE(const uint8_t* p) {
+    return static_cast<uint64_t>(getU32BE(p)) << 32 | getU32BE(p + 4);
+}
+
+void putU64BE(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<uint8_t>(v >> (56 - 8 * i));
+}
+
+// NTP 32.32 fixed point to Unix microseconds; 0 for an unset field. Seconds
+// below 2^31 belong to era 1 (after February 2036), per RFC 4330.
+uint64_t ntpToUnixUs(const uint8_t* p) {
+    uint64_t seconds = getU32BE(p);
+    const uint64_t fraction = getU32BE(p + 4);
+    if (seconds == 0 && fraction == 0) return 0;
+    if (seconds < 0x80000000ULL) seconds += 0x100000000ULL;
+    return (seconds - NTP_UNIX_OFFSET_S) * 1000000ULL + ((fraction * 1000000ULL) >> 32);
+}
+
+}  // namespace
+
+TimeService::TimeService(const char* server, uint16_t port)
+    : server(server)
+    , port(port)
+    , resolved(false)
+    , waiting(false)
+    , replyReady(false)
+    , requestUs(0)
+    , replyUs(0)
+    , reply{}
+    , nextAttemptUs(0)
+    , replied(nullptr)
+    , synced(false)
+    , anchorUs(0)
+    , anchorEpochUs(0)
+    , driftPpb(0)
+    , lastIssuedUs(0)
+    , syncs(0)
+    , failures(0)
+    , lastCorrectionUs(0)
+    , lastRoundTripUs(0) {}
+
+void TimeService::begin() {
+    udp.onPacket([this](AsyncUDPPacket& packet) { onPacket(packet); });
+    nextAttemptUs = monotonicUs();
+}
+
+// Network task: stamp first, then hand the packet over.
+void TimeService::onPacket(AsyncUDPPacket& packet) {
+    const uint64_t arrivedUs = monotonicUs();
+    if (!waiting.load(std::memory_order_acquire) || replyReady.load(std::memory_order_acquire)) return;
+    if (packet.length() < PACKET_SIZE) return;
+    memcpy(reply, packet.data(), PACKET_SIZE);
+    replyUs = arrivedUs;
+    replyReady.store(true, std::memory_order_release);
+    if (replied) replied();
+}
+
+bool TimeService::update() {
+    const uint64_t now = monotonicUs();
+    if (waiting.load(std::memory_order_acquire)) {
+        if (replyReady.load(std::memory_order_acquire)) {
+            const bool ok = acceptReply();
+            waiting.store(false, std::memory_order_release);
+            replyReady.store(false, std::memory_order_release);
+            if (!ok) {
+                fail(now);
+                return false;
+            }
+            nextAttemptUs = now + NTP_RESYNC_INTERVAL_MS * 1000ULL;
+            return true;
+        }
+        if (now - requestUs >= NTP_REPLY_TIMEOUT_MS * 1000ULL) {
+            waiting.store(false, std::memory_order_release);
+            fail(now);
+        }
+        return false;
+    }
+    if (now < nextAttemptUs || WiFi.status() != WL_CONNECTED) return false;
+    sendRequest(now);
+    return false;
+}
+
+// An attempt needs the link, so with WiFi down there is nothing to wait for
+// until it comes back.
+uint32_t TimeService::msUntilDue() const {
+    uint64_t dueUs;
+    if (waiting.load(std::memory_order_acquire)) {
+        if (replyReady.load(std::memory_order_acquire)) return 0;
+        dueUs = requestUs + NTP_REPLY_TIMEOUT_MS * 1000ULL;
+    } else {
+        if (WiFi.status() != WL_CONNECTED) return UINT32_MAX;
+        dueUs = nextAttemptUs;
+    }
+    const uint64_t now = monotonicUs();
+    return dueUs <= now ? 0 : static_cast<uint32_t>((dueUs - now + 999) / 1000);
+}
+
+void TimeService::sendRequest(uint64_t now) {
+    if (!resolved) {
+        if (!WiFi.hostByName(server, serverIp)) {
+            fail(now);
+            return;
+        }
+        resolved = true;
+    }
+    if (!udp.connected() && !udp.connect(serverIp, port)) {
+        fail(now);
+        return;
+    }
+
+    // Client mode, version 4. The transmit timestamp only has to come back
+    // unchanged as the originate timestamp, so it carries the send time.
+    uint8_t request[PACKET_SIZE] = {};
+    request[0] = (4 << 3) | 3;
+    requestUs = monotonicUs();
+    putU64BE(request + 40, requestUs);
+    waiting.store(true, std::memory_order_release);
+    if (udp.write(request, sizeof(request)) != sizeof(request)) {
+        waiting.store(false, std::memory_order_release);
+        fail(now);
+    }
+}
+
+// t1/t4 are monotonic send/receive times, t2/t3 the server's receive and
+// transmit times. The midpoint of the exchange on our clock corresponds to
+// the midpoint of t2..t3 on the server's.
+bool TimeService::acceptReply() {
+    const uint8_t leap = reply[0] >> 6;
+    const uint8_t version = (reply[0] >> 3) & 0x07;
+    const uint8_t mode = reply[0] & 0x07;
+    const uint8_t stratum = reply[1];
+    if (mode != 4 || leap == 3 || version < 3 || stratum == 0 || stratum > 15) return false;
+    if (getU64BE(reply + 24) != requestUs) return false;
+
+    const uint64_t t2 = ntpToUnixUs(reply + 32);
+    const uint64_t t3 = ntpToUnixUs(reply + 40);
+    if (t2 == 0 || t3 < t2) return false;
+    const uint64_t t1 = requestUs;
+    const uint64_t t4 = replyUs;
+    const uint64_t onWire = t4 - t1;
+    if (onWire < t3 - t2) return false;
+    const uint64_t roundTrip = onWire - (t3 - t2);
+    if (roundTrip > NTP_MAX_ROUND_TRIP_MS * 1000ULL) return false;
+
+    applyMeasurement(t1 + onWire / 2, t2 + (t3 - t2) / 2);
+    lastRoundTripUs = static_cast<uint32_t>(roundTrip);
+    ++syncs;
+    return true;
+}
+
+void TimeService::applyMeasurement(uint64_t monoUs, uint64_t epochUs) {
+    if (synced) {
+        const int64_t residual = static_cast<int64_t>(epochUs - toEpochUs(monoUs));
+        const uint64_t baseline = monoUs - anchorUs;
+        // A residual over a second is a step (server change, not drift)
+        if (baseline >= NTP_MIN_DRIFT_BASELINE_MS * 1000ULL && residual > -1000000 && residual < 1000000) {
+            int64_t drift = driftPpb - residual * 1000000000LL / static_cast<int64_t>(baseline);
+            if (drift > NTP_MAX_DRIFT_PPB) drift = NTP_MAX_DRIFT_PPB;
+            if (drift < -NTP_MAX_DRIFT_PPB) drift = -NTP_MAX_DRIFT_PPB;
+            driftPpb = static_cast<int32_t>(drift);
+        }
+        lastCorrectionUs = residual;
+    }
+    anchorUs = monoUs;
+    anchorEpochUs = epochUs;
+    synced = true;
+}
+
+void TimeService::fail(uint64_t now) {
+    ++failures;
+    resolved = false;   // look the name up again, the pool may have moved
+    nextAttemptUs = now + NTP_RETRY_INTERVAL_MS * 1000ULL;
+}
+
+uint64_t TimeService::toEpochUs(uint64_t monoUs) const {
+    if (!synced) return 0;
+    const int64_t elapsed = static_cast<int64_t>(monoUs - anchorUs);   // negative before the anchor
+    return anchorEpochUs + elapsed - elapsed / 1000 * driftPpb / 1000000;
+}
+
+uint64_t TimeService::nowEpochUs() const {
+    uint64_t now = toEpochUs(monotonicUs());
+    if (now < lastIssuedUs) now = lastIssuedUs;
+    lastIssuedUs = now;
+    return now;
+}
@@ -0,0 +1,87 @@
+#ifndef TIME_SERVICE_H
+#define TIME_SERVICE_H
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include <WiFi.h>
+#include <esp_timer.h>
+#include <atomic>
+#include "config.h"
+
+// ============================================================================
+// Wall clock for sample timestamps.
+//
+// A minimal SNTP client: one request per sync, the reply is stamped with
+// esp_timer in the network task on arrival, and update() turns it into a
+// mapping from the monotonic microsecond clock to Unix time. Nothing on the
+// publish path touches the network or the system clock; a sample stamped at
+// acquisition converts with toEpochUs() at any later point of the same boot.
+//
+// Between syncs the mapping is corrected for the crystal's frequency error,
+// estimated from successive syncs at least NTP_MIN_DRIFT_BASELINE_MS apart.
+//
+// onReply() is called from the network task when a reply is ready and
+// msUntilDue() gives the next timer (resend, reply timeout), so update() need
+// only run when one of them fires.
+// ============================================================================
+class TimeService {
+private:
+    static constexpr size_t PACKET_SIZE = 48;
+
+    AsyncUDP udp;
+    const char* server;
+    uint16_t port;
+    IPAddress serverIp;
+    bool resolved;
+
+    // Exchange in flight; reply and replyUs are written by the network task
+    // only while waiting is set and replyReady is clear.
+    std::atomic<bool> waiting;
+    std::atomic<bool> replyReady;
+    uint64_t requestUs;
+    uint64_t replyUs;
+    uint8_t reply[PACKET_SIZE];
+    uint64_t nextAttemptUs;
+    void (*replied)();
+
+    // epoch(m) = anchorEpochUs + (m - anchorUs) * (1 - driftPpb / 1e9)
+    bool synced;
+    uint64_t anchorUs;
+    uint64_t anchorEpochUs;
+    int32_t driftPpb;
+    mutable uint64_t lastIssuedUs;
+
+    uint32_t syncs;
+    uint32_t failures;
+    int64_t lastCorrectionUs;
+    uint32_t lastRoundTripUs;
+
+    void onPacket(AsyncUDPPacket& packet);
+    void sendRequest(uint64_t now);
+    bool acceptReply();
+    void applyMeasurement(uint64_t monoUs, uint64_t epochUs);
+    void fail(uint64_t now);
+
+public:
+    explicit TimeService(const char* server = NTP_SERVER, uint16_t port = NTP_PORT);
+    void begin();
+    bool update();   // Non-blocking; true on the call that completed a sync
+    void onReply(void (*notify)()) { replied = notify; }   // Set before begin()
+    uint32_t msUntilDue() const;   // Until update()'s next timer; UINT32_MAX while WiFi is down
+
+    static uint64_t monotonicUs() { return static_cast<uint64_t>(esp_timer_get_time()); }
+    bool isSynced() const { return synced; }
+    uint64_t toEpochUs(uint64_t monoUs) const;   // 0 while unsynced
+    uint64_t nowEpochUs() const;                 // Never goes backwards; 0 while unsynced
+    // Wall-clock time of a monotonic reading, or the reading itself (us since
+    // boot) while unsynced.
+    uint64_t timestampUs(uint64_t monoUs) const { return synced ? toEpochUs(monoUs) : monoUs; }
+
+    uint32_t getSyncCount() const { return syncs; }
+    uint32_t getFailures() const { return failures; }
+    int32_t getDriftPpb() const { return driftPpb; }
+    int64_t getLastCorrectionUs() const { return lastCorrectionUs; }
+    uint32_t getLastRoundTripUs() const { return lastRoundTripUs; }
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include "trace_events.h"
+#include <cstdio>
+#include <cstring>
+
+namespace TraceWire {
+
+uint8_t crc8(const uint8_t* data, size_t length) {
+    uint8_t crc = 0;
+    while (length--) {
+        crc ^= *data++;
+        for (int bit = 0; bit < 8; ++bit) crc = (crc & 0x80) ? static_cast<uint8_t>(crc << 1 ^ 0x07) : static_cast<uint8_t>(crc << 1);
+    }
+    return crc;
+}
+
+namespace {
+
+uint32_t readU32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16 |
+           static_cast<uint32_t>(p[3]) << 24;
+}
+
+}  // namespace
+
+// Each conversion is handed to snprintf with its flags, width and precision
+// but without length modifiers, since every value is unpacked to 32 bits.
+size_t format(uint16_t id, const uint8_t* args, size_t length, char* out, size_t capacity) {
+    if (capacity == 0) return 0;
+    size_t n = 0;
+    auto room = [&] { return n < capacity ? capacity - n : 0; };
+    auto put = [&](int written) {
+        if (written > 0) n += static_cast<size_t>(written);
+        if (n >= capacity) n = capacity - 1;
+    };
+    if (id >= TRACE_EVENT_COUNT) {
+        put(snprintf(out, capacity, "unknown trace event %u", static_cast<unsigned>(id)));
+        return n;
+    }
+
+    const char* p = TRACE_EVENT_TABLE[id].format;
+    size_t used = 0;
+    out[0] = '\0';
+    while (*p && n + 1 < capacity) {
+        if (*p != '%') {
+            out[n++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[n++] = '%';
+            p += 2;
+            continue;
+        }
+        char spec[16];
+        size_t s = 0;
+        spec[s++] = *p++;
+        while (isModifier(*p)) {
+            if (*p != 'l' && *p != 'h' && *p != 'z' && s < sizeof(spec) - 2) spec[s++] = *p;
+            ++p;
+        }
+        const char conversion = *p;
+        if (conversion) ++p;
+        spec[s++] = conversion;
+        spec[s] = '\0';
+
+        switch (argKind(conversion)) {
+            case Arg::INT:
+            case Arg::UINT:
+            case Arg::FLOAT: {
+                if (used + 4 > length) {
+                    put(snprintf(out + n, room(), "?"));
+                    break;
+                }
+                const uint32_t raw = readU32(args + used);
+                used += 4;
+                if (argKind(conversion) == Arg::INT) {
+                    put(snprintf(out + n, room(), spec, static_cast<int>(static_cast<int32_t>(raw))));
+                } else if (argKind(conversion) == Arg::UINT) {
+                    put(snprintf(out + n, room(), spec, static_cast<unsigned>(raw)));
+                } else {
+                    float value;
+                    memcpy(&value, &raw, sizeof(value));
+                    put(snprintf(out + n, room(), spec, static_cast<double>(value)));
+                }
+                break;
+            }
+            case Arg::STRING: {
+                char text[MAX_ARG_BYTES + 1];
+                size_t len = 0;
+                if (used < length) {
+                    len = args[used++];
+                    if (len > length - used) len = length - used;
+                    memcpy(text, args + used, len);
+                    used += len;
+                }
+                text[len] = '\0';
+                put(snprintf(out + n, room(), spec, text));
+                break;
+            }
+            default:
+                put(snprintf(out + n, room(), "?"));
+                break;
+        }
+    }
+    out[n] = '\0';
+    return n;
+}
+
+}  // namespace TraceWire
@@ -0,0 +1,203 @@
+#ifndef TRACE_EVENTS_H
+#define TRACE_EVENTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// ============================================================================
+// Deferred trace log: the events, their format strings and the wire format.
+//
+// A log site names an event; only its id, a timestamp and the packed
+// arguments are stored, and the text is put together later by the drain
+// (text mode) or on the host (tools/trace_decode). Arguments are packed by
+// the conversions of the format: %d %i as i32, %u %x as u32, %f as f32, %s as
+// a u8 length and that many bytes, truncated to what fits.
+//
+//   Frame on the serial line (10 + n bytes)
+//   0  u8   sync 0xFE (never part of UTF-8 text, so frames and plain
+//           Serial.print output can share the line)
+//   1  u8   n, packed argument bytes
+//   2  u16  event id, index into TRACE_EVENT_TABLE
+//   4  u32  timestamp, us since boot (wraps after 71 min)
+//   8  n    arguments
+//   8+n u8  CRC-8 (poly 0x07) of bytes 1 .. 7+n
+//
+// Events are numbered by their position here: add new ones at the end so
+// older captures still decode. Shared with the host decoder, so this file
+// must not depend on the Arduino core.
+// ============================================================================
+
+enum class TraceModule : uint8_t {
+    SYSTEM,
+    SENSOR,
+    ALERT,
+    NETWORK,   // WiFi, SNTP
+    MQTT,
+    STORAGE,
+    COUNT
+};
+
+// An event is kept when its level is at or below its module's level in
+// TRACE_LEVELS (config.h); OFF compiles the module's log sites out
+enum class TraceLevel : uint8_t {
+    OFF = 0,
+    ERROR = 1,
+    WARN = 2,
+    INFO = 3,
+    DEBUG = 4
+};
+
+enum class TraceEvent : uint16_t {
+    TRACE_DROPPED,
+    SAMPLE_RING_FULL,
+    DHT_READING,
+    PPM_READING,
+    MQ2_WARM,         // Reserved, unused (GAS_* replaced them); kept so later
+    MQ2_NOT_STEADY,   // event ids stay stable and older captures still decode
+    MQ2_DRIFT,
+    ALERT_RAISED,
+    ALERT_CLEARED,
+    ALERT_ACTIVATED,
+    ALERT_DEACTIVATED,
+    RELAY_SWITCHED,
+    WIFI_LOST,
+    WIFI_FAILED,
+    WIFI_CONNECTED,
+    TIME_SYNCED,
+    BROKER_CONNECTED,
+    BROKER_FAILED,
+    BROKER_MESSAGE,
+    COMMAND_DROPPED,
+    BROKER_PUBLISH,
+    BROKER_BATCH,
+    FRAME_TOO_BIG,
+    LOG_FULL,
+    GAS_WARM,
+    GAS_NOT_STEADY,
+    GAS_DRIFT,
+    GAS_CAL_FAILED,
+    COUNT
+};
+
+struct TraceEventSpec {
+    TraceEvent id;
+    TraceModule module;
+    TraceLevel level;
+    const char* format;
+};
+
+inline constexpr TraceEventSpec TRACE_EVENT_TABLE[] = {
+    {TraceEvent::TRACE_DROPPED, TraceModule::SYSTEM, TraceLevel::WARN, "Trace: %u records dropped"},
+    {TraceEvent::SAMPLE_RING_FULL, TraceModule::SYSTEM, TraceLevel::WARN, "Sample ring full - reading dropped"},
+    {TraceEvent::DHT_READING, TraceModule::SENSOR, TraceLevel::INFO, "DHT11: %.1f°C, %.1f%% (%d readings)"},
+    {TraceEvent::PPM_READING, TraceModule::SENSOR, TraceLevel::INFO, "PPM: %.1f, Quality: %s"},
+    {TraceEvent::MQ2_WARM, TraceModule::SENSOR, TraceLevel::INFO, "MQ-2 warm after %u s"},
+    {TraceEvent::MQ2_NOT_STEADY, TraceModule::SENSOR, TraceLevel::WARN, "MQ-2 calibration: air not steady, retrying"},
+    {TraceEvent::MQ2_DRIFT, TraceModule::SENSOR, TraceLevel::WARN, "MQ-2 drift: clean-air Rs/R0 %.2f, recalibrating"},
+    {TraceEvent::ALERT_RAISED, TraceModule::ALERT, TraceLevel::WARN, "PPM %.1f >= %.1f - ACTIVATING"},
+    {TraceEvent::ALERT_CLEARED, TraceModule::ALERT, TraceLevel::INFO, "PPM %.1f < %.1f - DEACTIVATING"},
+    {TraceEvent::ALERT_ACTIVATED, TraceModule::ALERT, TraceLevel::INFO, "Alert ACTIVATED"},
+    {TraceEvent::ALERT_DEACTIVATED, TraceModule::ALERT, TraceLevel::INFO, "Alert DEACTIVATED"},
+    {TraceEvent::RELAY_SWITCHED, TraceModule::ALERT, TraceLevel::INFO, "Relay: %s"},
+    {TraceEvent::WIFI_LOST, TraceModule::NETWORK, TraceLevel::WARN, "WiFi lost (reason %u), reconnecting"},
+    {TraceEvent::WIFI_FAILED, TraceModule::NETWORK, TraceLevel::WARN, "WiFi failed (reason %u), retry in %u ms"},
+    {TraceEvent::WIFI_CONNECTED, TraceModule::NETWORK, TraceLevel::INFO, "WiFi connected in %u ms, IP: %u.%u.%u.%u"},
+    {TraceEvent::TIME_SYNCED, TraceModule::NETWORK, TraceLevel::INFO,
+     "Time synced: rtt %.1f ms, drift %.1f ppm, %u readings restamped"},
+    {TraceEvent::BROKER_CONNECTED, TraceModule::MQTT, TraceLevel::INFO, "MQTT connected"},
+    {TraceEvent::BROKER_FAILED, TraceModule::MQTT, TraceLevel::WARN, "MQTT failed: %d"},
+    {TraceEvent::BROKER_MESSAGE, TraceModule::MQTT, TraceLevel::INFO, "MQTT message: %u bytes"},
+    {TraceEvent::COMMAND_DROPPED, TraceModule::MQTT, TraceLevel::WARN, "Command dropped (%u bytes, queue %u/%u)"},
+    {TraceEvent::BROKER_PUBLISH, TraceModule::MQTT, TraceLevel::INFO, "MQTT publish %s"},
+    {TraceEvent::BROKER_BATCH, TraceModule::MQTT, TraceLevel::INFO, "MQTT %s %s (%u samples, %u bytes)"},
+    {TraceEvent::FRAME_TOO_BIG, TraceModule::MQTT, TraceLevel::ERROR, "Frame exceeds TX buffer"},
+    {TraceEvent::LOG_FULL, TraceModule::STORAGE, TraceLevel::WARN, "Telemetry log full: %u readings dropped"},
+    {TraceEvent::GAS_WARM, TraceModule::SENSOR, TraceLevel::INFO, "%s warm after %u s"},
+    {TraceEvent::GAS_NOT_STEADY, TraceModule::SENSOR, TraceLevel::WARN,
+     "%s calibration: air not steady, retry in %u s"},
+    {TraceEvent::GAS_DRIFT, TraceModule::SENSOR, TraceLevel::WARN, "%s drift: clean-air Rs/R0 %.2f, recalibrating"},
+    {TraceEvent::GAS_CAL_FAILED, TraceModule::SENSOR, TraceLevel::ERROR,
+     "%s calibration failed after %u attempts, R0 %.2f (0: none, still retrying)"},
+};
+
+constexpr size_t TRACE_EVENT_COUNT = static_cast<size_t>(TraceEvent::COUNT);
+
+namespace TraceWire {
+
+constexpr uint8_t SYNC = 0xFE;
+constexpr size_t HEADER_SIZE = 8;
+constexpr size_t MAX_ARG_BYTES = 24;
+constexpr size_t MAX_FRAME_SIZE = HEADER_SIZE + MAX_ARG_BYTES + 1;
+
+enum class Arg : uint8_t {
+    NONE,      // No conversion at that position
+    INT,
+    UINT,
+    FLOAT,
+    STRING,
+    INVALID    // A conversion the log cannot pack
+};
+
+constexpr bool isModifier(char c) {
+    return c == '-' || c == '+' || c == ' ' || c == '#' || c == '.' || c == 'l' || c == 'h' || c == 'z' ||
+           (c >= '0' && c <= '9');
+}
+
+constexpr Arg argKind(char conversion) {
+    switch (conversion) {
+        case 'd': case 'i': return Arg::INT;
+        case 'u': case 'x': case 'X': return Arg::UINT;
+        case 'f': case 'g': case 'e': return Arg::FLOAT;
+        case 's': return Arg::STRING;
+        default: return Arg::INVALID;
+    }
+}
+
+// Kind of the index-th conversion of format
+constexpr Arg argAt(const char* format, size_t index) {
+    for (const char* p = format; *p; ++p) {
+        if (*p != '%') continue;
+        if (*++p == '%') continue;
+        while (isModifier(*p)) ++p;
+        if (index == 0) return argKind(*p);
+        --index;
+        if (!*p) break;
+    }
+    return Arg::NONE;
+}
+
+// How a value of type T is packed
+template <typename T>
+constexpr Arg argOf() {
+    using U = std::decay_t<T>;
+    if (std::is_floating_point<U>::value) return Arg::FLOAT;
+    if (std::is_same<U, const char*>::value || std::is_same<U, char*>::value) return Arg::STRING;
+    if (std::is_integral<U>::value) return std::is_signed<U>::value ? Arg::INT : Arg::UINT;
+    return Arg::INVALID;
+}
+
+uint8_t crc8(const uint8_t* data, size_t length);
+
+// Text of one record into out (always terminated); returns its length
+size_t format(uint16_t id, const uint8_t* args, size_t length, char* out, size_t capacity);
+
+}  // namespace TraceWire
+
+namespace TraceTableCheck {
+constexpr bool valid() {
+    for (size_t i = 0; i < TRACE_EVENT_COUNT; ++i) {
+        if (static_cast<size_t>(TRACE_EVENT_TABLE[i].id) != i) return false;
+        for (size_t a = 0; TraceWire::argAt(TRACE_EVENT_TABLE[i].format, a) != TraceWire::Arg::NONE; ++a) {
+            if (TraceWire::argAt(TRACE_EVENT_TABLE[i].format, a) == TraceWire::Arg::INVALID) return false;
+        }
+    }
+    return true;
+}
+}  // namespace TraceTableCheck
+
+static_assert(sizeof(TRACE_EVENT_TABLE) / sizeof(TRACE_EVENT_TABLE[0]) == TRACE_EVENT_COUNT,
+              "every TraceEvent needs a TRACE_EVENT_TABLE row");
+static_assert(TraceTableCheck::valid(), "TRACE_EVENT_TABLE rows must follow TraceEvent order and use packable conversions");
+
+#endif
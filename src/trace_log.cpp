@@ -0,0 +1,63 @@
+#include "trace_log.h"
+
+TraceLog traceLog;
+
+TraceLog::TraceLog()
+    : pending()
+    , hasPending(false)
+    , reportedDrops(0)
+    , backlogHook(nullptr) {
+}
+
+size_t TraceLog::encode(const TraceRecord& r, uint8_t* out) const {
+    out[0] = TraceWire::SYNC;
+    out[1] = r.length;
+    out[2] = static_cast<uint8_t>(r.id);
+    out[3] = static_cast<uint8_t>(r.id >> 8);
+    for (int i = 0; i < 4; ++i) out[4 + i] = static_cast<uint8_t>(r.timestampUs >> (8 * i));
+    memcpy(out + TraceWire::HEADER_SIZE, r.args, r.length);
+    const size_t n = TraceWire::HEADER_SIZE + r.length;
+    out[n] = TraceWire::crc8(out + 1, n - 1);
+    return n + 1;
+}
+
+// All or nothing: a record is only written once it fits the FIFO whole
+bool TraceLog::send(HardwareSerial& out, const TraceRecord& r) {
+    if (TRACE_SERIAL_BINARY) {
+        uint8_t frame[TraceWire::MAX_FRAME_SIZE];
+        const size_t n = encode(r, frame);
+        if (out.availableForWrite() < static_cast<int>(n)) return false;
+        out.write(frame, n);
+        return true;
+    }
+
+    // Short enough to fit an empty FIFO
+    char line[120];
+    int n = snprintf(line, sizeof(line), "[%lu.%06lu] ", static_cast<unsigned long>(r.timestampUs / 1000000UL),
+                     static_cast<unsigned long>(r.timestampUs % 1000000UL));
+    n += static_cast<int>(TraceWire::format(r.id, r.args, r.length, line + n, sizeof(line) - n - 2));
+    line[n++] = '\r';
+    line[n++] = '\n';
+    if (out.availableForWrite() < n) return false;
+    out.write(reinterpret_cast<const uint8_t*>(line), n);
+    return true;
+}
+
+bool TraceLog::drain(HardwareSerial& out) {
+    if constexpr (enabled(TraceEvent::TRACE_DROPPED)) {
+        const uint32_t dropped = ring.getDropped();
+        if (!hasPending && dropped != reportedDrops) {
+            pending = record<TraceEvent::TRACE_DROPPED>(dropped - reportedDrops);
+            hasPending = true;
+            reportedDrops = dropped;
+        }
+    }
+    for (;;) {
+        if (!hasPending) {
+            if (!ring.pop(pending)) return false;
+            hasPending = true;
+        }
+        if (!send(out, pending)) return true;
+        hasPending = false;
+    }
+}
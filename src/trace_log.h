@@ -0,0 +1,124 @@
+#ifndef TRACE_LOG_H
+#define TRACE_LOG_H
+
+#include <Arduino.h>
+#include <cstring>
+#include "config.h"
+#include "mpsc_ring.h"
+#include "time_service.h"
+#include "trace_events.h"
+
+// One log site's worth: event, when, and the packed arguments
+struct TraceRecord {
+    uint32_t timestampUs;
+    uint16_t id;
+    uint8_t length;
+    uint8_t args[TraceWire::MAX_ARG_BYTES];
+};
+
+// ============================================================================
+// Deferred logging (events and wire format in trace_events.h).
+//
+// TRACE(EVENT, args...) checks the arguments against the event's format at
+// compile time, packs them into a TraceRecord and pushes it onto a lock-free
+// ring that any task may write. No formatting, no Serial call and no heap on
+// the caller's side; an event whose module level is below its own compiles
+// to nothing, arguments included. drain() runs in one low-priority place and
+// writes records out only while the UART FIFO has room, so it never blocks
+// either. Records that find the ring full are counted and reported by the
+// drain as a TRACE_DROPPED event.
+// ============================================================================
+class TraceLog {
+private:
+    MpscRing<TraceRecord, TRACE_RING_SLOTS> ring;
+    TraceRecord pending;   // Popped, waiting for room in the UART FIFO
+    bool hasPending;
+    uint32_t reportedDrops;
+    void (*backlogHook)();
+
+    static void put32(TraceRecord& r, uint32_t value) {
+        if (r.length + 4U > TraceWire::MAX_ARG_BYTES) return;   // Decoded as "?"
+        for (int i = 0; i < 4; ++i) r.args[r.length++] = static_cast<uint8_t>(value >> (8 * i));
+    }
+    static void putString(TraceRecord& r, const char* s) {
+        if (r.length + 1U > TraceWire::MAX_ARG_BYTES) return;
+        size_t n = s ? strlen(s) : 0;
+        if (n > TraceWire::MAX_ARG_BYTES - r.length - 1) n = TraceWire::MAX_ARG_BYTES - r.length - 1;
+        r.args[r.length++] = static_cast<uint8_t>(n);
+        memcpy(r.args + r.length, s, n);
+        r.length += static_cast<uint8_t>(n);
+    }
+    template <typename T>
+    static void pack(TraceRecord& r, T value) {
+        constexpr TraceWire::Arg kind = TraceWire::argOf<T>();
+        if constexpr (kind == TraceWire::Arg::FLOAT) {
+            const float f = static_cast<float>(value);
+            uint32_t bits;
+            memcpy(&bits, &f, sizeof(bits));
+            put32(r, bits);
+        } else if constexpr (kind == TraceWire::Arg::STRING) {
+            putString(r, value);
+        } else {
+            put32(r, static_cast<uint32_t>(value));
+        }
+    }
+
+    void commit(const TraceRecord& r) {
+        if (ring.push(r) && backlogHook && ring.size() == TRACE_RING_SLOTS / 2) backlogHook();
+    }
+    size_t encode(const TraceRecord& r, uint8_t* out) const;
+    bool send(HardwareSerial& out, const TraceRecord& r);
+
+public:
+    TraceLog();
+
+    static constexpr bool enabled(TraceEvent event) {
+        const TraceEventSpec& spec = TRACE_EVENT_TABLE[static_cast<size_t>(event)];
+        return spec.level != TraceLevel::OFF && spec.level <= TRACE_LEVELS[static_cast<size_t>(spec.module)];
+    }
+
+    template <TraceEvent E, typename... Args>
+    static constexpr bool matches() {
+        constexpr TraceWire::Arg kinds[] = {TraceWire::argOf<Args>()..., TraceWire::Arg::NONE};
+        const char* format = TRACE_EVENT_TABLE[static_cast<size_t>(E)].format;
+        for (size_t i = 0; i <= sizeof...(Args); ++i) {
+            if (TraceWire::argAt(format, i) != kinds[i]) return false;
+        }
+        return true;
+    }
+
+    template <TraceEvent E, typename... Args>
+    static TraceRecord record(Args... args) {
+        static_assert(matches<E, Args...>(), "trace arguments do not match the event's format");
+        TraceRecord r;
+        r.timestampUs = static_cast<uint32_t>(TimeService::monotonicUs());
+        r.id = static_cast<uint16_t>(E);
+        r.length = 0;
+        (pack(r, args), ...);
+        return r;
+    }
+
+    // Any task; use TRACE() so disabled events compile out
+    template <TraceEvent E, typename... Args>
+    void write(Args... args) { commit(record<E>(args...)); }
+
+    // Called by the producer that fills the ring halfway, to pull the drain
+    // forward
+    void onBacklog(void (*hook)()) { backlogHook = hook; }
+
+    // Writes what fits in the UART FIFO; true while records are left
+    bool drain(HardwareSerial& out);
+    size_t pendingRecords() const { return ring.size() + (hasPending ? 1 : 0); }
+    uint32_t getDropped() const { return ring.getDropped(); }
+};
+
+extern TraceLog traceLog;
+
+#define TRACE(event, ...)                                                              \
+    do {                                                                               \
+        if constexpr (TraceLog::enabled(TraceEvent::event)) {                          \
+            traceLog.write<TraceEvent::event>(__VA_ARGS__);                            \
+        }                                                                              \
+    } while (0)
+
+#endif
@@ -0,0 +1,79 @@
+#include "trend_history.h"
+
+TrendHistory::TrendHistory()
+    : levels{} {
+    for (Level& level : levels) {
+        for (TrendColumn& column : level.columns) clearColumn(column);
+        level.newest = 0;
+        level.started = false;
+    }
+}
+
+uint32_t TrendHistory::columnSpanMs(TrendRange range) {
+    return range == TrendRange::HOUR ? TREND_HOUR_COLUMN_MS : TREND_DAY_COLUMN_MS;
+}
+
+void TrendHistory::clearColumn(TrendColumn& column) {
+    column.min = 1.0F;
+    column.max = 0.0F;
+}
+
+// Opens every bucket between the newest and `bucket`; at most a full ring
+// is cleared however long the gap.
+void TrendHistory::advance(Level& level, uint64_t bucket) {
+    if (!level.started) {
+        level.newest = bucket;
+        level.started = true;
+        return;
+    }
+    if (bucket <= level.newest) return;
+    const uint64_t gap = bucket - level.newest;
+    const uint64_t clear = gap < TREND_COLUMNS ? gap : TREND_COLUMNS;
+    for (uint64_t b = bucket - clear + 1; b <= bucket; ++b) clearColumn(level.columns[b % TREND_COLUMNS]);
+    level.newest = bucket;
+}
+
+void TrendHistory::advanceTo(uint64_t nowMs) {
+    for (size_t r = 0; r < RANGES; ++r) {
+        Level& level = levels[r];
+        if (level.started) advance(level, nowMs / columnSpanMs(static_cast<TrendRange>(r)));
+    }
+}
+
+void TrendHistory::add(uint64_t nowMs, float value) {
+    if (value != value) return;   // NaN: sensor fault, leave a gap
+    for (size_t r = 0; r < RANGES; ++r) {
+        Level& level = levels[r];
+        const uint64_t bucket = nowMs / columnSpanMs(static_cast<TrendRange>(r));
+        advance(level, bucket);
+        if (bucket + TREND_COLUMNS <= level.newest) continue;   // older than the window
+        TrendColumn& column = level.columns[bucket % TREND_COLUMNS];
+        if (column.empty()) {
+            column.min = value;
+            column.max = value;
+        } else {
+            if (value < column.min) column.min = value;
+            if (value > column.max) column.max = value;
+        }
+    }
+}
+
+const TrendColumn& TrendHistory::column(TrendRange range, size_t index) const {
+    static const TrendColumn EMPTY = {1.0F, 0.0F};
+    const Level& level = levels[static_cast<size_t>(range)];
+    const uint64_t back = TREND_COLUMNS - 1 - index;
+    if (!level.started || index >= TREND_COLUMNS || back > level.newest) return EMPTY;
+    return level.columns[(level.newest - back) % TREND_COLUMNS];
+}
+
+bool TrendHistory::bounds(TrendRange range, float& lo, float& hi) const {
+    bool any = false;
+    for (size_t i = 0; i < TREND_COLUMNS; ++i) {
+        const TrendColumn& c = column(range, i);
+        if (c.empty()) continue;
+        if (!any || c.min < lo) lo = c.min;
+        if (!any || c.max > hi) hi = c.max;
+        any = true;
+    }
+    return any;
+}
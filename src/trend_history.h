@@ -0,0 +1,64 @@
+#ifndef TREND_HISTORY_H
+#define TREND_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include "config.h"
+
+enum class TrendRange : uint8_t {
+    HOUR = 0,
+    DAY = 1,
+    COUNT
+};
+
+// Smallest and largest reading that fell into one column's time span; a
+// column no reading fell into is empty (min > max).
+struct TrendColumn {
+    float min;
+    float max;
+
+    bool empty() const { return min > max; }
+};
+
+// ============================================================================
+// Multi-resolution min/max history for the trend screen.
+//
+// Each range keeps TREND_COLUMNS buckets in a ring, one per pixel column of
+// the graph, each covering a fixed time span (TREND_*_COLUMN_MS). A reading
+// widens the newest bucket of every range in O(1); time moving past a bucket
+// boundary opens a new one and ages out the oldest. Spikes survive the
+// decimation because buckets keep extremes, not averages. Drawing a range
+// reads each column once, whatever time it covers.
+//
+// RAM is fixed: TREND_COLUMNS * 8 B per range plus a few words, 2 KB total
+// for two ranges of 128 columns.
+// ============================================================================
+class TrendHistory {
+private:
+    static constexpr size_t RANGES = static_cast<size_t>(TrendRange::COUNT);
+
+    struct Level {
+        TrendColumn columns[TREND_COLUMNS];
+        uint64_t newest;   // bucket number (time / span) of the newest column
+        bool started;
+    };
+
+    Level levels[RANGES];
+
+    static void clearColumn(TrendColumn& column);
+    void advance(Level& level, uint64_t bucket);
+
+public:
+    TrendHistory();
+    void add(uint64_t nowMs, float value);
+    void advanceTo(uint64_t nowMs);   // Ages the history when no reading arrives
+
+    // index 0 is the oldest column, TREND_COLUMNS - 1 the newest
+    const TrendColumn& column(TrendRange range, size_t index) const;
+    // Extremes across all columns of the range; false if it holds no reading
+    bool bounds(TrendRange range, float& lo, float& hi) const;
+
+    static uint32_t columnSpanMs(TrendRange range);
+};
+
+#endif
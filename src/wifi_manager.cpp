@@ -1,49 +1,175 @@
 #include "wifi_manager.h"
 #include <Arduino.h>
-
-// Import config values
-extern const char* WIFI_SSID;
-extern const char* WIFI_PASSWORD;
-extern const uint32_t WIFI_CONNECTION_TIMEOUT_MS;
+#include <Preferences.h>
+#include "config.h"
+#include "trace_log.h"
 
 WiFiManager::WiFiManager() 
     : ssid(WIFI_SSID)
     , password(WIFI_PASSWORD)
-    , connectionTimeout(WIFI_CONNECTION_TIMEOUT_MS)
-    , isConnected(false) {}
+    , state(State::IDLE)
+    , isConnected(false)
+    , gotIp(false)
+    , linkDown(false)
+    , lastReason(0)
+    , changed(nullptr)
+    , cached{}
+    , haveCached(false)
+    , attemptStart(0)
+    , attemptTimeout(0)
+    , backoffMs(WIFI_BACKOFF_MIN_MS)
+    , retryDelay(0)
+    , downSince(0)
+    , connects(0)
+    , fastConnects(0)
+    , failedAttempts(0)
+    , lastConnectMs(0) {}
 
-bool WiFiManager::connect() {
-    Serial.println(F("Connecting to WiFi..."));
-    
+void WiFiManager::begin() {
+    // Reconnects are ours: the driver's own would rescan on every drop
     WiFi.mode(WIFI_STA);
-    WiFi.disconnect(true);
-    delay(100);
-    
-    WiFi.begin(ssid, password);
+    WiFi.persistent(false);
+    WiFi.setAutoReconnect(false);
+    WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) { onEvent(event, info); });
+    loadCache();
     
-    const uint32_t startTime = millis();
-    while (WiFi.status() != WL_CONNECTED && 
-           (millis() - startTime) < connectionTimeout) {
-        delay(500);
-        Serial.print('.');
+    const uint32_t now = millis();
+    downSince = now;
+    Serial.println(haveCached ? F("Connecting to WiFi (cached AP)...") : F("Connecting to WiFi..."));
+    startAttempt(haveCached, now);
+}
+
+// WiFi task: record what happened, update() acts on it
+void WiFiManager::onEvent(arduino_event_id_t event, arduino_event_info_t info) {
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            gotIp.store(true, std::memory_order_release);
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            lastReason.store(info.wifi_sta_disconnected.reason, std::memory_order_relaxed);
+            linkDown.store(true, std::memory_order_release);
+            break;
+        default:
+            return;
     }
+    if (changed) changed();
+}
+
+bool WiFiManager::update() {
+    const uint32_t now = millis();
+    const bool up = gotIp.exchange(false, std::memory_order_acq_rel);
+    const bool down = linkDown.exchange(false, std::memory_order_acq_rel);
     
-    if (WiFi.status() == WL_CONNECTED) {
-        isConnected = true;
-        Serial.println(F("\nWiFi connected!"));
-        Serial.printf_P(PSTR("IP: %s\n"), WiFi.localIP().toString().c_str());
-        return true;
+    switch (state) {
+        case State::CONNECTED:
+            if (down) {
+                isConnected = false;
+                downSince = now;
+                TRACE(WIFI_LOST, static_cast<unsigned>(lastReason.load(std::memory_order_relaxed)));
+                startAttempt(haveCached, now);
+            }
+            return false;
+        case State::FAST_CONNECT:
+        case State::SCAN_CONNECT:
+            if (up && WiFi.status() == WL_CONNECTED) {
+                linkUp(now);
+                return true;
+            }
+            if (down || now - attemptStart >= attemptTimeout) attemptFailed(now);
+            return false;
+        case State::BACKOFF:
+            if (now - attemptStart >= retryDelay) startAttempt(haveCached, now);
+            return false;
+        default:
+            return false;
+    }
+}
+
+uint32_t WiFiManager::msUntilDue() const {
+    uint32_t wait;
+    switch (state) {
+        case State::FAST_CONNECT:
+        case State::SCAN_CONNECT:
+            wait = attemptTimeout;
+            break;
+        case State::BACKOFF:
+            wait = retryDelay;
+            break;
+        default:
+            return UINT32_MAX;
     }
+    const uint32_t elapsed = millis() - attemptStart;
+    return elapsed >= wait ? 0 : wait - elapsed;
+}
+
+void WiFiManager::startAttempt(bool fast, uint32_t now) {
+    // Events of an earlier attempt must not settle this one
+    gotIp.store(false, std::memory_order_release);
+    linkDown.store(false, std::memory_order_release);
+    attemptStart = now;
+    if (fast) {
+        state = State::FAST_CONNECT;
+        attemptTimeout = WIFI_FAST_CONNECT_TIMEOUT_MS;
+        WiFi.begin(ssid, password, cached.channel, cached.bssid);
+    } else {
+        state = State::SCAN_CONNECT;
+        attemptTimeout = WIFI_CONNECTION_TIMEOUT_MS;
+        WiFi.begin(ssid, password);
+    }
+}
+
+// A failed fast attempt rescans at once (the AP may have changed channel);
+// a failed scan waits backoff/2 + random(backoff/2), doubling the backoff.
+void WiFiManager::attemptFailed(uint32_t now) {
+    ++failedAttempts;
+    if (state == State::FAST_CONNECT) {
+        startAttempt(false, now);
+        return;
+    }
+    WiFi.disconnect();
+    linkDown.store(false, std::memory_order_release);
+    retryDelay = backoffMs / 2 + static_cast<uint32_t>(random(backoffMs / 2 + 1));
+    backoffMs = backoffMs >= WIFI_BACKOFF_MAX_MS / 2 ? WIFI_BACKOFF_MAX_MS : backoffMs * 2;
+    attemptStart = now;
+    state = State::BACKOFF;
+    TRACE(WIFI_FAILED, static_cast<unsigned>(lastReason.load(std::memory_order_relaxed)),
+          static_cast<unsigned>(retryDelay));
+}
+
+void WiFiManager::linkUp(uint32_t now) {
+    if (state == State::FAST_CONNECT) ++fastConnects;
+    ++connects;
+    state = State::CONNECTED;
+    isConnected = true;
+    backoffMs = WIFI_BACKOFF_MIN_MS;
+    retryDelay = 0;
+    lastConnectMs = now - downSince;
     
-    isConnected = false;
-    Serial.println(F("\nWiFi failed!"));
-    return false;
+    const uint8_t* bssid = WiFi.BSSID();
+    const uint8_t channel = static_cast<uint8_t>(WiFi.channel());
+    if (bssid && (!haveCached || channel != cached.channel || memcmp(bssid, cached.bssid, sizeof(cached.bssid)) != 0)) {
+        saveCache(bssid, channel);
+    }
+    const IPAddress ip = WiFi.localIP();
+    TRACE(WIFI_CONNECTED, static_cast<unsigned>(lastConnectMs), ip[0], ip[1], ip[2], ip[3]);
+}
+
+void WiFiManager::loadCache() {
+    Preferences prefs;
+    if (!prefs.begin(WIFI_CACHE_NAMESPACE, true)) return;
+    haveCached = prefs.getBytes("ap", &cached, sizeof(cached)) == sizeof(cached) && cached.channel > 0;
+    prefs.end();
 }
 
-bool WiFiManager::reconnect() {
-    if (WiFi.status() == WL_CONNECTED) return true;
-    disconnect();
-    return connect();
+// Only written when the AP changed, to spare the flash
+void WiFiManager::saveCache(const uint8_t* bssid, uint8_t channel) {
+    memcpy(cached.bssid, bssid, sizeof(cached.bssid));
+    cached.channel = channel;
+    haveCached = channel > 0;
+    Preferences prefs;
+    if (!prefs.begin(WIFI_CACHE_NAMESPACE)) return;
+    prefs.putBytes("ap", &cached, sizeof(cached));
+    prefs.end();
 }
 
 bool WiFiManager::checkConnection() const {
@@ -59,7 +185,9 @@ int WiFiManager::getSignalStrength() const {
 }
 
 void WiFiManager::disconnect() {
+    state = State::IDLE;
     WiFi.disconnect();
+    linkDown.store(false, std::memory_order_release);
     isConnected = false;
     Serial.println(F("WiFi disconnected"));
 }
@@ -2,23 +2,81 @@
 #define WIFI_MANAGER_H
 
 #include <WiFi.h>
+#include <atomic>
 
+// ============================================================================
+// Non-blocking station connection.
+//
+// begin() starts the first attempt and returns; update(), called from the
+// loop, advances the connection from the events the WiFi task delivers. The
+// AP's BSSID and channel are kept in NVS after each new association, so a
+// reconnect (after a drop or a reboot) skips the scan. A fast attempt that
+// fails (AP moved) falls back to a scan; a failed scan waits an
+// exponentially growing, jittered delay before the next try.
+//
+// update() has work only when an event arrived or a timer is due: onChange()
+// is called from the WiFi task after each event, msUntilDue() gives the next
+// timer, so the caller can sleep in between.
+// ============================================================================
 class WiFiManager {
+public:
+    enum class State : uint8_t { IDLE, FAST_CONNECT, SCAN_CONNECT, CONNECTED, BACKOFF };
+
 private:
+    struct CachedAp {
+        uint8_t bssid[6];
+        uint8_t channel;
+    };
+
     const char* ssid;
     const char* password;
-    uint32_t connectionTimeout;
+    State state;
     bool isConnected;
 
+    // Set by the WiFi event task, consumed by update()
+    std::atomic<bool> gotIp;
+    std::atomic<bool> linkDown;
+    std::atomic<uint8_t> lastReason;
+    void (*changed)();
+
+    CachedAp cached;
+    bool haveCached;
+    uint32_t attemptStart;
+    uint32_t attemptTimeout;
+    uint32_t backoffMs;
+    uint32_t retryDelay;
+    uint32_t downSince;
+
+    uint32_t connects;
+    uint32_t fastConnects;
+    uint32_t failedAttempts;
+    uint32_t lastConnectMs;
+
+    void onEvent(arduino_event_id_t event, arduino_event_info_t info);
+    void startAttempt(bool fast, uint32_t now);
+    void attemptFailed(uint32_t now);
+    void linkUp(uint32_t now);
+    void loadCache();
+    void saveCache(const uint8_t* bssid, uint8_t channel);
+
 public:
     WiFiManager();
-    bool connect();
-    bool reconnect();
+    void begin();
+    bool update();   // Non-blocking; true on the call that brought the link up
+    void onChange(void (*notify)()) { changed = notify; }   // Set before begin()
+    uint32_t msUntilDue() const;   // Until update() has a timer to act on; UINT32_MAX if only events
+    State getState() const { return state; }
     bool checkConnection() const;
     String getLocalIP() const;
     int getSignalStrength() const;
     void disconnect();
     bool isConnectedToWiFi() const { return isConnected; }
+
+    uint32_t getConnectCount() const { return connects; }
+    uint32_t getFastConnectCount() const { return fastConnects; }
+    uint32_t getFailedAttempts() const { return failedAttempts; }
+    uint32_t getLastConnectMs() const { return lastConnectMs; }   // Link down (or boot) to IP
+    uint32_t getRetryDelayMs() const { return retryDelay; }       // Current backoff wait
 };
 
 #endif
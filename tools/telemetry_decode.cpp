@@ -0,0 +1,207 @@
+// Host decoder/validator for the binary telemetry frames (src/binary_telemetry.h).
+//
+// Reads one frame per line as hex, optionally preceded by the topic, which is
+// what `mosquitto_sub -F '%t %x'` prints, and writes each frame back as JSON
+// in the field names the JSON payload uses, one line per reading for sensor
+// batches (marked "replay":true when replayed from the device's outage log). Invalid frames and sequence gaps are reported on stderr. Exits
+// non-zero if any frame fails validation.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/telemetry_decode.cpp src/binary_telemetry.cpp -o telemetry_decode
+//   mosquitto_sub -h broker.hivemq.com -t 'airquality/+/+' -F '%t %x' | ./telemetry_decode
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include "binary_telemetry.h"
+
+using namespace BinaryTelemetry;
+
+namespace {
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool parseHex(const std::string& text, std::vector<uint8_t>& out) {
+    out.clear();
+    int high = -1;
+    for (char c : text) {
+        if (c == ' ' || c == ':' || c == '\r') continue;
+        const int v = hexValue(c);
+        if (v < 0) return false;
+        if (high < 0) {
+            high = v;
+        } else {
+            out.push_back(static_cast<uint8_t>(high << 4 | v));
+            high = -1;
+        }
+    }
+    return high < 0 && !out.empty();
+}
+
+// airquality/<device>/<kind> -> <device>
+std::string deviceFromTopic(const std::string& topic) {
+    const size_t a = topic.find('/');
+    if (a == std::string::npos) return "";
+    const size_t b = topic.find('/', a + 1);
+    return topic.substr(a + 1, b == std::string::npos ? std::string::npos : b - a - 1);
+}
+
+void printNumber(const char* key, float v, int decimals) {
+    if (std::isnan(v)) {
+        printf(",\"%s\":null", key);
+    } else {
+        printf(",\"%s\":%.*f", key, decimals, v);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        fprintf(stderr, "usage: %s < frames.txt   (one '[topic] hex' frame per line)\n", argv[0]);
+        return 2;
+    }
+
+    std::map<std::string, uint16_t> nextSequence;
+    std::vector<uint8_t> bytes;
+    char line[4096];
+    unsigned long lineNo = 0;
+    unsigned long valid = 0;
+    unsigned long invalid = 0;
+    unsigned long gaps = 0;
+
+    while (fgets(line, sizeof(line), stdin)) {
+        lineNo++;
+        std::string text(line);
+        while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+        if (text.empty()) continue;
+
+        std::string topic;
+        const size_t space = text.find(' ');
+        if (space != std::string::npos && text.find('/') < space) {
+            topic = text.substr(0, space);
+            text = text.substr(space + 1);
+        }
+
+        if (!parseHex(text, bytes)) {
+            // JSON payloads share the topics; pass them through untouched.
+            if (!text.empty() && text[0] == '{') {
+                printf("%s\n", text.c_str());
+                continue;
+            }
+            fprintf(stderr, "line %lu: not a hex frame\n", lineNo);
+            invalid++;
+            continue;
+        }
+
+        Schema schema;
+        DecodeError err = peekSchema(bytes.data(), bytes.size(), schema);
+        uint16_t sequence = 0;
+        if (err == DecodeError::NONE && schema == Schema::SENSOR) {
+            SensorFrame f;
+            err = decode(bytes.data(), bytes.size(), f);
+            if (err == DecodeError::NONE) {
+                sequence = f.sequence;
+                printf("{\"device_id\":\"%s\",\"seq\":%u", deviceFromTopic(topic).c_str(), f.sequence);
+                printNumber("ppm", f.ppm, 2);
+                printf(",\"quality\":\"%s\",\"relay_state\":\"%s\"", qualityName(f.quality), f.relayOn ? "ON" : "OFF");
+                printNumber("temperature", f.temperature, 2);
+                printNumber("humidity", f.humidity, 2);
+                printf(",\"timestamp\":%u}\n", f.timestamp);
+            }
+        } else if (err == DecodeError::NONE && schema == Schema::SENSOR_BATCH) {
+            BatchHeader header;
+            err = decode(bytes.data(), bytes.size(), header);
+            if (err == DecodeError::NONE) {
+                sequence = header.sequence;
+                SampleRecord r;
+                for (size_t i = 0; i < header.count; ++i) {
+                    decodeRecord(bytes.data(), bytes.size(), i, r);
+                    printf("{\"device_id\":\"%s\",\"seq\":%u,\"index\":%zu", deviceFromTopic(topic).c_str(),
+                           header.sequence, i);
+                    printNumber("ppm", r.ppm, 2);
+                    printf(",\"quality\":\"%s\",\"relay_state\":\"%s\",\"alert\":%s%s%s", qualityName(r.quality),
+                           (r.flags & RECORD_FLAG_RELAY_ON) ? "ON" : "OFF",
+                           (r.flags & RECORD_FLAG_ALERT) ? "true" : "false",
+                           (r.flags & RECORD_FLAG_WARMING) ? ",\"warming\":true" : "",
+                           (r.flags & RECORD_FLAG_CAL_FAILED) ? ",\"cal_failed\":true" : "");
+                    printNumber("temperature", r.temperature, 2);
+                    printNumber("humidity", r.humidity, 2);
+                    // Further gas channels in the device's channel order
+                    if (r.gasChannels > 1) {
+                        printf(",\"gas\":[");
+                        for (size_t c = 0; c + 1 < r.gasChannels; ++c) {
+                            if (std::isnan(r.gasPpm[c])) {
+                                printf("%snull", c ? "," : "");
+                            } else {
+                                printf("%s%.2f", c ? "," : "", r.gasPpm[c]);
+                            }
+                        }
+                        printf("]");
+                    }
+                    // The latest reading carries the per-gas estimates
+                    if (i + 1 == header.count && header.gasEstimates > 0) {
+                        printf(",\"gases\":{");
+                        for (size_t g = 0; g < header.gasEstimates; ++g) {
+                            if (g < sizeof(MQ2_GAS_CURVES) / sizeof(MQ2_GAS_CURVES[0])) {
+                                printf("%s\"%s\":%.2f", g ? "," : "", MQ2_GAS_CURVES[g].name, header.gasEstimate[g]);
+                            } else {
+                                printf("%s\"gas%zu\":%.2f", g ? "," : "", g, header.gasEstimate[g]);
+                            }
+                        }
+                        printf("}");
+                    }
+                    // Same units as the JSON rows: ms, wall clock unless flagged uptime
+                    printf(",\"%s\":%llu.%03u%s}\n", (r.flags & RECORD_FLAG_UPTIME) ? "uptime_ms" : "timestamp",
+                           static_cast<unsigned long long>(r.timestamp / 1000U),
+                           static_cast<unsigned>(r.timestamp % 1000U), header.replay ? ",\"replay\":true" : "");
+                }
+            }
+        } else if (err == DecodeError::NONE) {
+            StatusFrame f;
+            err = decode(bytes.data(), bytes.size(), f);
+            if (err == DecodeError::NONE) {
+                sequence = f.sequence;
+                printf("{\"device_id\":\"%s\",\"seq\":%u,\"status\":\"%s\",\"timestamp\":%u",
+                       deviceFromTopic(topic).c_str(), f.sequence, f.online ? "online" : "offline", f.timestamp);
+                // Same shape as the JSON status's boot timeline
+                if (f.bootSpans > 0) printf(",\"boot\":[");
+                for (size_t i = 0; i < f.bootSpans; ++i) {
+                    const BootSpan& span = f.boot[i];
+                    printf("%s{\"stage\":\"%s\",\"start_us\":%u", i ? "," : "",
+                           bootStageName(span.stage & ~BOOT_SPAN_FAILED), span.startUs);
+                    if (span.endUs != BOOT_SPAN_RUNNING) printf(",\"end_us\":%u", span.endUs);
+                    printf("%s}", (span.stage & BOOT_SPAN_FAILED) ? ",\"failed\":true" : "");
+                }
+                printf("%s}\n", f.bootSpans > 0 ? "]" : "");
+            }
+        }
+
+        if (err != DecodeError::NONE) {
+            fprintf(stderr, "line %lu: invalid frame (%s, %zu bytes)\n", lineNo, errorName(err), bytes.size());
+            invalid++;
+            continue;
+        }
+        valid++;
+
+        // Sensor and status frames share one per-device counter.
+        const std::string device = deviceFromTopic(topic);
+        auto it = nextSequence.find(device);
+        if (it != nextSequence.end() && it->second != sequence) {
+            fprintf(stderr, "line %lu: %s sequence gap, expected %u got %u\n", lineNo, device.c_str(), it->second,
+                    sequence);
+            gaps++;
+        }
+        nextSequence[device] = static_cast<uint16_t>(sequence + 1);
+    }
+
+    fprintf(stderr, "%lu valid, %lu invalid, %lu sequence gaps\n", valid, invalid, gaps);
+    return invalid > 0 ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+// Host decoder for the deferred trace log (src/trace_events.h).
+//
+// Reads the raw serial stream on stdin, turns each binary trace frame back
+// into its log line, prefixed with the device time, and copies everything
+// else (boot messages, command replies) through unchanged. Frames with a bad
+// length or CRC are reported on stderr and skipped one byte at a time until
+// the next sync byte. Exits non-zero if any frame failed validation.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/trace_decode.cpp src/trace_events.cpp -o trace_decode
+//   stty -F /dev/ttyUSB0 115200 raw && ./trace_decode < /dev/ttyUSB0
+//   .pio/build/native/program --echo --hours 1 | ./trace_decode
+
+#include <cstdio>
+#include <vector>
+#include "trace_events.h"
+
+namespace {
+
+std::vector<uint8_t> pending;   // Read but not yet consumed
+
+bool fill(size_t n) {
+    while (pending.size() < n) {
+        const int c = getchar();
+        if (c == EOF) return false;
+        pending.push_back(static_cast<uint8_t>(c));
+    }
+    return true;
+}
+
+void consume(size_t n) { pending.erase(pending.begin(), pending.begin() + n); }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        fprintf(stderr, "usage: %s < serial-capture\n", argv[0]);
+        return 2;
+    }
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+
+    unsigned long valid = 0;
+    unsigned long invalid = 0;
+    uint32_t lastStamp = 0;
+    uint64_t wraps = 0;   // The u32 us timestamp wraps every 71.6 min
+    char text[256];
+
+    while (fill(1)) {
+        if (pending[0] != TraceWire::SYNC) {
+            putchar(pending[0]);
+            consume(1);
+            continue;
+        }
+        if (!fill(2)) break;
+        const size_t n = pending[1];
+        if (n > TraceWire::MAX_ARG_BYTES) {
+            invalid++;
+            consume(1);
+            continue;
+        }
+        const size_t size = TraceWire::HEADER_SIZE + n + 1;
+        if (!fill(size)) {
+            fprintf(stderr, "truncated frame at end of input\n");
+            invalid++;
+            break;
+        }
+        if (TraceWire::crc8(pending.data() + 1, size - 2) != pending[size - 1]) {
+            fprintf(stderr, "frame with bad CRC skipped\n");
+            invalid++;
+            consume(1);
+            continue;
+        }
+
+        const uint16_t id = static_cast<uint16_t>(pending[2] | pending[3] << 8);
+        const uint32_t stamp = static_cast<uint32_t>(pending[4]) | static_cast<uint32_t>(pending[5]) << 8 |
+                               static_cast<uint32_t>(pending[6]) << 16 | static_cast<uint32_t>(pending[7]) << 24;
+        // Records from different tasks can be a little out of order; only a
+        // step back of more than half the range is a wrap
+        if (stamp < lastStamp && lastStamp - stamp > 0x80000000UL) wraps++;
+        lastStamp = stamp;
+        const uint64_t us = (wraps << 32) + stamp;
+
+        TraceWire::format(id, pending.data() + TraceWire::HEADER_SIZE, n, text, sizeof(text));
+        printf("[%6llu.%06llu] %s\n", static_cast<unsigned long long>(us / 1000000ULL),
+               static_cast<unsigned long long>(us % 1000000ULL), text);
+        valid++;
+        consume(size);
+    }
+
+    fprintf(stderr, "%lu trace frames, %lu invalid\n", valid, invalid);
+    return invalid > 0 ? 1 : 0;
+}